@@ -0,0 +1,85 @@
+#ifndef DEXDUMPER_PLUGIN_H
+#define DEXDUMPER_PLUGIN_H
+
+// Detector plugin header - defines the stable ABI for external detection strategies
+// Plugins are shared libraries loaded with dlopen from the configured plugin directory
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief ABI version implemented by this header
+ *
+ * Increment only on incompatible changes. Detectors reporting a different
+ * version are rejected at load time.
+ */
+#define DEXDUMPER_DETECTOR_ABI_VERSION 1
+
+/**
+ * @brief Maximum length of a detector prefilter pattern in bytes
+ */
+#define DEXDUMPER_MAX_PREFILTER_LENGTH 16
+
+/**
+ * @brief Name of the symbol every plugin must export
+ */
+#define DEXDUMPER_PLUGIN_ENTRY_SYMBOL "dexdumper_get_detectors"
+
+/**
+ * @brief Read-only view of the memory being scanned
+ *
+ * Plugins must never dereference scanned memory directly; all access goes
+ * through read_memory, which is protected against faults.
+ */
+typedef struct {
+    const void* base_address; // Start of the scanned region
+    size_t region_size;       // Size of the scanned region in bytes
+
+    // Copies size bytes at address into buffer, returns 1 on success, 0 on fault
+    int (*read_memory)(const void* address, void* buffer, size_t size);
+} DexDumperMemoryView;
+
+/**
+ * @brief Description of one detection strategy
+ *
+ * The scanner makes a single pass over each region. Whenever the bytes at
+ * an offset (that is a multiple of prefilter_alignment) equal the prefilter
+ * pattern, validate is called; if it accepts, extent returns the payload
+ * size and the payload is dumped through the regular pipeline.
+ */
+typedef struct {
+    uint32_t abi_version;             // Must be DEXDUMPER_DETECTOR_ABI_VERSION
+    const char* detector_name;        // Human-readable name used in logs
+    const uint8_t* prefilter_pattern; // Bytes that must appear at a candidate offset
+    size_t prefilter_length;          // 1..DEXDUMPER_MAX_PREFILTER_LENGTH
+    size_t prefilter_alignment;       // Candidate offsets must be multiples of this (0 or 1 = any)
+
+    // Confirms a candidate, returns nonzero if genuine
+    int (*validate)(const DexDumperMemoryView* memory_view, size_t candidate_offset, void* context);
+
+    // Returns the payload size starting at the candidate, 0 if it cannot be determined
+    size_t (*extent)(const DexDumperMemoryView* memory_view, size_t candidate_offset, void* context);
+
+    void* context;                    // Opaque pointer passed back to the callbacks
+} DexDumperDetector;
+
+/**
+ * @brief Plugin entry point signature
+ *
+ * Returns an array of detectors that stays valid while the plugin is loaded,
+ * storing its length in detector_count. Export it with default visibility:
+ *
+ *   __attribute__((visibility("default")))
+ *   const DexDumperDetector* dexdumper_get_detectors(size_t* detector_count);
+ */
+typedef const DexDumperDetector* (*DexDumperGetDetectorsFunction)(size_t* detector_count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -18,7 +18,30 @@ LOCAL_SRC_FILES := \
 	../src/dex_detector.c \
 	../src/stealth.c \
 	../src/sha1.c \
-	../src/config_manager.c
+	../src/config_manager.c \
+	../src/scan_statistics.c \
+	../src/self_exclusion.c \
+	../src/plugin_loader.c \
+	../src/payload_inflater.c \
+	../src/dump_manifest.c \
+	../src/expansion_engine.c \
+	../src/xor_key_recovery.c \
+	../src/entropy_sampler.c \
+	../src/elf_detector.c \
+	../src/art_heap_walker.c \
+	../src/pointer_discovery.c \
+	../src/protected_region_reader.c \
+	../src/footprint_tracker.c \
+	../src/io_engine.c \
+	../src/region_table.c \
+	../src/scan_arena.c \
+	../src/calibration.c \
+	../src/control_channel.c \
+	../src/shared_dedup_table.c \
+	../src/content_hash.c
+
+# Public headers (detector plugin ABI)
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/../include
 
 # Compiler flags
 LOCAL_CFLAGS := -Wall -Wextra -Wno-unused-parameter -fvisibility=hidden -O2
@@ -26,7 +49,7 @@ LOCAL_CFLAGS := -Wall -Wextra -Wno-unused-parameter -fvisibility=hidden -O2
 # -O2: Optimization for performance
 
 LOCAL_LDFLAGS := -Wl,--build-id=sha1  # Use SHA1 for build IDs
-LOCAL_LDLIBS := -llog -landroid       # Link Android libraries
+LOCAL_LDLIBS := -llog -landroid -ldl -lz  # Link Android libraries, dynamic loader and zlib
 
 # Build as shared library
 include $(BUILD_SHARED_LIBRARY)
\ No newline at end of file
@@ -0,0 +1,237 @@
+#include "art_heap_walker.h"
+#include "dex_detector.h"
+#include "config_manager.h"
+#include "scan_statistics.h"
+
+// Name fragments of the heap space mappings ART creates (anon:/ashmem names)
+static const char* const large_object_space_names[] = {
+    "dalvik-large object space", "dalvik-free list large object space"
+};
+static const char* const object_space_names[] = {
+    "dalvik-main space", "dalvik-region space", "dalvik-non moving space",
+    "dalvik-zygote space", "dalvik-alloc space"
+};
+
+// Side structures named after the space they describe (no objects inside)
+static const char* const heap_metadata_names[] = {
+    "bitmap", "info", "stack", "table"
+};
+
+/**
+ * @brief State of one heap space walk
+ */
+typedef struct {
+    const char* region_start;       // First byte of the heap space
+    size_t region_size;             // Size of the heap space in bytes
+    DexDetectionResult* results;    // Output array for found arrays
+    int max_results;                // Capacity of the output array
+    int result_count;               // Arrays found so far
+    size_t validations_left;        // DEX header validations still allowed
+    size_t resume_offset;           // Offset before which the last found array lies
+} HeapWalkState;
+
+/**
+ * @brief Checks whether a name contains any of the given fragments
+ */
+static int name_contains_any(const char* name, const char* const* fragments, size_t fragment_count) {
+    for (size_t i = 0; i < fragment_count; i++) {
+        if (strstr(name, fragments[i])) return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Classifies a region by the name ART gave its heap space mapping
+ * 
+ * @param memory_region Region to classify
+ * @return Heap space kind, ART_HEAP_SPACE_NONE if the region is no heap space
+ */
+ArtHeapSpaceKind classify_art_heap_region(const MemoryRegion* memory_region) {
+    const char* name = memory_region->path_name;
+    if (strstr(name, "dalvik-") == NULL) return ART_HEAP_SPACE_NONE;
+    if (name_contains_any(name, heap_metadata_names,
+                          sizeof(heap_metadata_names) / sizeof(heap_metadata_names[0]))) {
+        return ART_HEAP_SPACE_NONE;
+    }
+    
+    if (name_contains_any(name, large_object_space_names,
+                          sizeof(large_object_space_names) / sizeof(large_object_space_names[0]))) {
+        return ART_HEAP_SPACE_LARGE_OBJECTS;
+    }
+    if (name_contains_any(name, object_space_names,
+                          sizeof(object_space_names) / sizeof(object_space_names[0]))) {
+        return ART_HEAP_SPACE_OBJECTS;
+    }
+    return ART_HEAP_SPACE_NONE;
+}
+
+/**
+ * @brief Confirms a byte[] array whose elements start at a DEX magic
+ * 
+ * The array header in front of the elements must be plausible: a non-null,
+ * aligned klass reference and a length large enough for the DEX file the
+ * header describes. The DEX header itself is validated last, counted
+ * against the walk's validation budget.
+ * 
+ * @param state Walk state
+ * @param data_offset Offset of the first array element (the DEX magic)
+ * @return 1 if an array was recorded, 0 otherwise
+ */
+static int check_byte_array_candidate(HeapWalkState* state, size_t data_offset) {
+    if (data_offset < ART_BYTE_ARRAY_DATA_OFFSET) return 0;
+    
+    const char* object_start = state->region_start + data_offset - ART_BYTE_ARRAY_DATA_OFFSET;
+    uint32_t array_header[ART_BYTE_ARRAY_DATA_OFFSET / sizeof(uint32_t)];
+    unsigned char dex_magic[DEX_MAGIC_LEN];
+    if (!read_memory_safely(object_start, array_header, sizeof(array_header)) ||
+        !read_memory_safely(state->region_start + data_offset, dex_magic, sizeof(dex_magic))) {
+        return 0;
+    }
+    
+    // klass is a compressed reference to a mirror::Class, itself an aligned heap object
+    uint32_t klass_reference = array_header[0];
+    int32_t array_length = (int32_t)array_header[ART_ARRAY_LENGTH_OFFSET / sizeof(uint32_t)];
+    if (klass_reference == 0 || klass_reference % ART_OBJECT_ALIGNMENT != 0) return 0;
+    if (array_length < DEX_MIN_FILE_SIZE ||
+        (size_t)array_length > state->region_size - data_offset) {
+        return 0;
+    }
+    if (memcmp(dex_magic, DEX_MAGIC_SIGNATURE, 4) != 0 || dex_magic[4] != '0' || dex_magic[7] != '\0') {
+        return 0;
+    }
+    
+    if (state->validations_left == 0) return 0;
+    state->validations_left--;
+    SCAN_STAT_ADD(headers_validated, 1);
+    // Validating against the array bounds also checks that the DEX fits in its array
+    if (!validate_dex_header_structure(state->region_start, data_offset + (size_t)array_length, data_offset)) {
+        SCAN_STAT_ADD(validations_failed, 1);
+        return 0;
+    }
+    
+    uint32_t dex_file_size = 0;
+    if (!read_memory_safely(state->region_start + data_offset + 0x20, &dex_file_size, sizeof(dex_file_size))) {
+        return 0;
+    }
+    
+    DexDetectionResult* result = &state->results[state->result_count++];
+    memset(result, 0, sizeof(*result));
+    result->dex_address = (void*)(state->region_start + data_offset);
+    result->dex_size = dex_file_size;
+    result->detector_name = "ART byte[]";
+    result->payload_encoding = PAYLOAD_ENCODING_PLAIN;
+    state->resume_offset = data_offset + (size_t)array_length;
+    SCAN_STAT_ADD(heap_arrays_found, 1);
+    
+    LOGI("Found DEX in ART byte[] at %p (%u bytes, array length %d)",
+         result->dex_address, dex_file_size, array_length);
+    return 1;
+}
+
+/**
+ * @brief Checks the 8-byte slots of one resident page of an object space
+ * 
+ * This is a stride scan, not an object walk: object sizes would need the
+ * mirror::Class fields, whose offsets change between releases. Objects
+ * are packed at 8-byte alignment, so the elements of a byte[] begin 4
+ * bytes past an alignment boundary and one 32-bit compare per slot finds
+ * the DEX magic. Every byte of the page is still read; the header of a
+ * hit may sit on the previous page.
+ */
+static void scan_object_space_page(HeapWalkState* state, size_t page_offset, size_t page_size) {
+    unsigned char page_buffer[SCAN_CHUNK_SIZE];
+    uint32_t magic_word;
+    memcpy(&magic_word, DEX_MAGIC_SIGNATURE, sizeof(magic_word));
+    
+    for (size_t chunk_offset = 0; chunk_offset < page_size; chunk_offset += sizeof(page_buffer)) {
+        size_t chunk_size = page_size - chunk_offset < sizeof(page_buffer) ?
+                            page_size - chunk_offset : sizeof(page_buffer);
+        size_t chunk_start = page_offset + chunk_offset;
+        if (!read_memory_safely(state->region_start + chunk_start, page_buffer, chunk_size)) {
+            SCAN_STAT_ADD(read_faults, 1);
+            return;
+        }
+        
+        size_t slot_phase = ART_BYTE_ARRAY_DATA_OFFSET % ART_OBJECT_ALIGNMENT;
+        for (size_t position = slot_phase; position + sizeof(uint32_t) <= chunk_size;
+             position += ART_OBJECT_ALIGNMENT) {
+            uint32_t word;
+            memcpy(&word, page_buffer + position, sizeof(word));
+            if (word != magic_word || chunk_start + position < state->resume_offset) continue;
+            
+            SCAN_STAT_ADD(candidates_found, 1);
+            if (check_byte_array_candidate(state, chunk_start + position) &&
+                state->result_count >= state->max_results) {
+                return;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Walks a heap space and collects byte[] arrays holding a DEX file
+ * 
+ * Residency is queried with mincore() a window at a time; pages that were
+ * never touched or were reclaimed are skipped without being read, which
+ * keeps mostly reserved heap spaces cheap. Object spaces have every
+ * 8-byte slot of a resident page checked, so their cost still grows with
+ * the resident size; large object spaces only have the array header at
+ * the start of each page read.
+ * 
+ * @param memory_region Heap space region
+ * @param space_kind Kind returned by classify_art_heap_region()
+ * @param detection_results Output array for found arrays
+ * @param max_results Capacity of detection_results
+ * @return Number of arrays found
+ */
+int walk_art_heap_region(const MemoryRegion* memory_region, ArtHeapSpaceKind space_kind,
+                         DexDetectionResult* detection_results, int max_results) {
+    if (space_kind == ART_HEAP_SPACE_NONE || max_results <= 0) return 0;
+    
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    HeapWalkState state = {
+        .region_start = (const char*)memory_region->start_address,
+        .region_size = (size_t)((char*)memory_region->end_address - (char*)memory_region->start_address),
+        .results = detection_results,
+        .max_results = max_results,
+        .validations_left = (size_t)get_max_validations_per_region()
+    };
+    SCAN_STAT_ADD(heap_spaces_walked, 1);
+    
+    unsigned char residency[RESIDENCY_WINDOW_PAGES];
+    size_t window_size = RESIDENCY_WINDOW_PAGES * page_size;
+    
+    for (size_t window_offset = 0; window_offset < state.region_size; window_offset += window_size) {
+        size_t window_length = state.region_size - window_offset < window_size ?
+                               state.region_size - window_offset : window_size;
+        size_t window_pages = (window_length + page_size - 1) / page_size;
+        
+        // Without residency information every page is read
+        if (mincore((void*)(state.region_start + window_offset), window_length, residency) != 0) {
+            memset(residency, 1, window_pages);
+        }
+        
+        for (size_t page = 0; page < window_pages; page++) {
+            size_t page_offset = window_offset + page * page_size;
+            if (!(residency[page] & 1)) {
+                SCAN_STAT_ADD(heap_pages_skipped, 1);
+                continue;
+            }
+            if (page_offset + page_size <= state.resume_offset) continue;
+            
+            if (space_kind == ART_HEAP_SPACE_LARGE_OBJECTS) {
+                check_byte_array_candidate(&state, page_offset + ART_BYTE_ARRAY_DATA_OFFSET);
+            } else {
+                scan_object_space_page(&state, page_offset, page_size);
+            }
+            
+            if (state.result_count >= state.max_results || state.validations_left == 0) {
+                VLOGD("ART heap walk of %p stopped (%d arrays, %zu validations left)",
+                      state.region_start, state.result_count, state.validations_left);
+                return state.result_count;
+            }
+        }
+    }
+    
+    return state.result_count;
+}
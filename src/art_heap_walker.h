@@ -0,0 +1,41 @@
+#ifndef DEXDUMPER_ART_HEAP_WALKER_H
+#define DEXDUMPER_ART_HEAP_WALKER_H
+
+// ART heap walker header - declares byte[] array discovery in dalvik heap spaces
+
+#include "common.h"
+#include "config.h"
+
+/**
+ * ART Heap Support:
+ * 
+ * DEX files loaded from memory (InMemoryDexClassLoader, packers that
+ * decrypt into a Java byte[]) live in the managed heap. Heap spaces are
+ * hundreds of megabytes, larger than MAX_REGION_SIZE and far larger than
+ * the byte scan window, so they are walked instead of scanned. Every ART
+ * release lays out a primitive array the same way: a 32-bit klass
+ * reference, a 32-bit lock word, a 32-bit length and the elements, with
+ * objects aligned to 8 bytes. A byte[] holding a DEX therefore has its
+ * magic 12 bytes past an 8-byte boundary, and large arrays (the large
+ * object space) start on a page. Only those positions are checked, pages
+ * that are not resident are skipped, and a hit is confirmed by the array
+ * header before the DEX header is validated. Object spaces are not walked
+ * object by object: their resident pages are read in full and compared
+ * once per 8-byte slot, which saves compares but not memory reads.
+ */
+
+// Kind of ART heap space a region maps
+typedef enum {
+    ART_HEAP_SPACE_NONE = 0,     // Not an ART heap space
+    ART_HEAP_SPACE_OBJECTS,      // Objects packed at 8-byte alignment (main, region, non-moving, zygote)
+    ART_HEAP_SPACE_LARGE_OBJECTS // One object per page run (large object space)
+} ArtHeapSpaceKind;
+
+// Classifies a region by the name ART gave its heap space mapping
+ArtHeapSpaceKind classify_art_heap_region(const MemoryRegion* memory_region);
+
+// Walks a heap space and collects byte[] arrays holding a DEX file
+int walk_art_heap_region(const MemoryRegion* memory_region, ArtHeapSpaceKind space_kind,
+                         DexDetectionResult* detection_results, int max_results);
+
+#endif
@@ -0,0 +1,456 @@
+#include "calibration.h"
+#include "config_manager.h"
+#include "content_hash.h"
+#include "entropy_sampler.h"
+#include "footprint_tracker.h"
+#include "region_table.h"
+#include "scan_arena.h"
+#include "self_exclusion.h"
+#include <sys/utsname.h>
+
+// Builds with a NEON or SSE2 kernel can choose between two kernels
+#if defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(__SSE2__)
+#define CALIBRATION_HAS_VECTOR_KERNEL 1
+#define DEFAULT_SIMD_KERNEL SIMD_KERNEL_VECTOR
+#else
+#define DEFAULT_SIMD_KERNEL SIMD_KERNEL_SCALAR
+#endif
+
+// Settings the scanner runs with
+typedef struct {
+    MemoryReaderBackend reader_backend; // Backend of read_memory_safely()
+    size_t scan_chunk_size;             // Bytes per signature-scan chunk
+    SimdKernel simd_kernel;             // Kernel of the byte comparison loops
+    int hash_thread_count;              // Threads sharing one tree hash
+} CalibrationResult;
+
+// Settings in effect, the built-in defaults until calibration runs
+static CalibrationResult active_calibration = {
+    MEMORY_READER_SIGNAL_GUARD, SCAN_CHUNK_SIZE, DEFAULT_SIMD_KERNEL, CONTENT_HASH_MAX_THREADS
+};
+
+// Real regions read by every reader candidate
+typedef struct {
+    const char* sample_starts[CALIBRATION_SAMPLE_REGIONS];
+    size_t sample_sizes[CALIBRATION_SAMPLE_REGIONS];
+    ResidencySnapshot footprints[CALIBRATION_SAMPLE_REGIONS]; // Released once the benchmark is done
+    int sample_count;
+} CalibrationSamples;
+
+/**
+ * @brief Returns the online CPUs, capped at CONTENT_HASH_MAX_THREADS
+ */
+static int get_hash_thread_limit(void) {
+    long online_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return online_cpus < 1 ? 1 : online_cpus > CONTENT_HASH_MAX_THREADS ? CONTENT_HASH_MAX_THREADS : (int)online_cpus;
+}
+
+/**
+ * @brief Returns the monotonic clock in nanoseconds
+ */
+static uint64_t monotonic_nanoseconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+/**
+ * @brief Folds a string into an FNV-1a hash
+ */
+static uint64_t hash_fingerprint_text(uint64_t hash, const char* text) {
+    for (; *text; text++) {
+        hash ^= (uint8_t)*text;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/**
+ * @brief Computes the fingerprint a cached calibration is only valid for
+ * 
+ * Covers the CPU model lines of /proc/cpuinfo (every core, so big.LITTLE
+ * layouts count), the kernel release and machine, the page size and the
+ * kernels compiled into this build.
+ */
+static uint64_t compute_device_fingerprint(void) {
+    static const char* cpu_model_keys[] = {
+        "Hardware", "Processor", "model name", "vendor_id", "CPU implementer", "CPU part", "CPU variant"
+    };
+    uint64_t hash = 14695981039346656037ULL;
+    
+    FILE* cpuinfo_file = fopen("/proc/cpuinfo", "r");
+    if (cpuinfo_file) {
+        char line[256];
+        while (fgets(line, sizeof(line), cpuinfo_file)) {
+            for (size_t i = 0; i < sizeof(cpu_model_keys) / sizeof(cpu_model_keys[0]); i++) {
+                if (strncmp(line, cpu_model_keys[i], strlen(cpu_model_keys[i])) == 0) {
+                    hash = hash_fingerprint_text(hash, line);
+                    break;
+                }
+            }
+        }
+        fclose(cpuinfo_file);
+    }
+    
+    struct utsname kernel_name;
+    if (uname(&kernel_name) == 0) {
+        hash = hash_fingerprint_text(hash, kernel_name.release);
+        hash = hash_fingerprint_text(hash, kernel_name.machine);
+    }
+    
+    char build_text[64];
+    snprintf(build_text, sizeof(build_text), "page=%ld kernel=%d ptr=%zu",
+             sysconf(_SC_PAGESIZE), (int)DEFAULT_SIMD_KERNEL, sizeof(void*));
+    return hash_fingerprint_text(hash, build_text);
+}
+
+/**
+ * @brief Derives the cache file path from the configuration file path
+ * 
+ * @param cache_path Output buffer of MAX_PATH_LENGTH bytes
+ * @return 1 on success, 0 if no configuration file is in use
+ */
+static int get_calibration_cache_path(char* cache_path) {
+    const char* config_path = get_config_file_location();
+    if (config_path == NULL) return 0;
+    
+    const char* file_name = strrchr(config_path, '/');
+    const char* extension = strrchr(file_name ? file_name : config_path, '.');
+    size_t stem_length = extension ? (size_t)(extension - config_path) : strlen(config_path);
+    return snprintf(cache_path, MAX_PATH_LENGTH, "%.*s.calibration", (int)stem_length, config_path) < MAX_PATH_LENGTH;
+}
+
+/**
+ * @brief Reads a cached calibration if it was made on this device
+ * 
+ * @param fingerprint Fingerprint of this device
+ * @param result Output settings
+ * @return 1 if a valid cache entry was found, 0 otherwise
+ */
+static int load_cached_calibration(uint64_t fingerprint, CalibrationResult* result) {
+    char cache_path[MAX_PATH_LENGTH];
+    if (!get_calibration_cache_path(cache_path)) return 0;
+    
+    FILE* cache_file = fopen(cache_path, "r");
+    if (!cache_file) return 0;
+    
+    unsigned long long cached_fingerprint = 0;
+    int reader_backend = -1, simd_kernel = -1, hash_thread_count = 0;
+    unsigned long scan_chunk_size = 0;
+    char line[128];
+    while (fgets(line, sizeof(line), cache_file)) {
+        if (line[0] == '#') continue;
+        sscanf(line, "fingerprint=%llx", &cached_fingerprint);
+        sscanf(line, "reader_backend=%d", &reader_backend);
+        sscanf(line, "scan_chunk_size=%lu", &scan_chunk_size);
+        sscanf(line, "simd_kernel=%d", &simd_kernel);
+        sscanf(line, "hash_thread_count=%d", &hash_thread_count);
+    }
+    fclose(cache_file);
+    
+    if (cached_fingerprint != fingerprint) {
+        LOGI("Calibration cache %s belongs to another device or kernel, recalibrating", cache_path);
+        return 0;
+    }
+    if ((reader_backend != MEMORY_READER_SIGNAL_GUARD && reader_backend != MEMORY_READER_VM_READV) ||
+        (simd_kernel != SIMD_KERNEL_SCALAR && simd_kernel != SIMD_KERNEL_VECTOR) ||
+        scan_chunk_size < SCAN_CHUNK_SIZE || scan_chunk_size > SCAN_CHUNK_MAX_SIZE ||
+        hash_thread_count < 1 || hash_thread_count > CONTENT_HASH_MAX_THREADS) {
+        LOGW("Ignoring malformed calibration cache %s", cache_path);
+        return 0;
+    }
+    
+    result->reader_backend = (MemoryReaderBackend)reader_backend;
+    result->scan_chunk_size = (size_t)scan_chunk_size;
+    result->simd_kernel = (SimdKernel)simd_kernel;
+    result->hash_thread_count = hash_thread_count;
+    return 1;
+}
+
+/**
+ * @brief Stores a calibration for later starts on this device
+ */
+static void save_cached_calibration(uint64_t fingerprint, const CalibrationResult* result) {
+    char cache_path[MAX_PATH_LENGTH];
+    if (!get_calibration_cache_path(cache_path)) return;
+    
+    FILE* cache_file = fopen(cache_path, "w");
+    if (!cache_file) {
+        LOGW("Failed to write calibration cache %s: %s", cache_path, strerror(errno));
+        return;
+    }
+    fprintf(cache_file, "# Startup calibration, redone when the fingerprint (CPU model, kernel) changes\n");
+    fprintf(cache_file, "fingerprint=%016llx\n", (unsigned long long)fingerprint);
+    fprintf(cache_file, "reader_backend=%d\n", (int)result->reader_backend);
+    fprintf(cache_file, "scan_chunk_size=%lu\n", (unsigned long)result->scan_chunk_size);
+    fprintf(cache_file, "simd_kernel=%d\n", (int)result->simd_kernel);
+    fprintf(cache_file, "hash_thread_count=%d\n", result->hash_thread_count);
+    fclose(cache_file);
+}
+
+/**
+ * @brief Reads a range chunk by chunk the way the signature scan does
+ * 
+ * @return Nanoseconds taken, 0 if a read failed
+ */
+static uint64_t time_chunked_reads(MemoryReaderBackend reader_backend, size_t chunk_size,
+                                   const char* range_start, size_t range_size, unsigned char* chunk_buffer) {
+    uint64_t started = monotonic_nanoseconds();
+    for (size_t offset = 0; offset < range_size; offset += chunk_size) {
+        size_t read_size = range_size - offset < chunk_size ? range_size - offset : chunk_size;
+        if (!read_memory_with_backend(reader_backend, range_start + offset, chunk_buffer, read_size)) return 0;
+    }
+    uint64_t elapsed = monotonic_nanoseconds() - started;
+    return elapsed ? elapsed : 1;
+}
+
+/**
+ * @brief Times one reader backend and chunk size on the synthetic buffer and the samples
+ * 
+ * @return Fastest of CALIBRATION_ROUNDS rounds in nanoseconds, UINT64_MAX if a read failed
+ */
+static uint64_t time_reader_candidate(MemoryReaderBackend reader_backend, size_t chunk_size,
+                                      const char* synthetic_buffer, const CalibrationSamples* samples,
+                                      unsigned char* chunk_buffer) {
+    uint64_t fastest_round = UINT64_MAX;
+    for (int round = 0; round < CALIBRATION_ROUNDS; round++) {
+        uint64_t round_time = time_chunked_reads(reader_backend, chunk_size, synthetic_buffer,
+                                                 CALIBRATION_BUFFER_SIZE, chunk_buffer);
+        for (int i = 0; i < samples->sample_count && round_time != 0; i++) {
+            uint64_t sample_time = time_chunked_reads(reader_backend, chunk_size, samples->sample_starts[i],
+                                                      samples->sample_sizes[i], chunk_buffer);
+            round_time = sample_time ? round_time + sample_time : 0;
+        }
+        if (round_time == 0) return UINT64_MAX;
+        if (round_time < fastest_round) fastest_round = round_time;
+    }
+    return fastest_round;
+}
+
+/**
+ * @brief Picks up to CALIBRATION_SAMPLE_REGIONS readable high-priority regions
+ * 
+ * Regions are taken evenly across the selection and read once with the
+ * signal-guarded reader, so every candidate then finds them faulted in.
+ * Their residency is recorded first, so the pages the benchmark pulls in
+ * are given back like those of a scan.
+ * 
+ * @param region_table Regions of the process (self-owned ranges removed)
+ * @param samples Output samples
+ * @param chunk_buffer Scratch buffer of SCAN_CHUNK_MAX_SIZE bytes
+ */
+static void select_calibration_samples(const RegionTable* region_table, CalibrationSamples* samples,
+                                       unsigned char* chunk_buffer) {
+    memset(samples, 0, sizeof(*samples));
+    int* selected_regions = scan_arena_alloc((size_t)(region_table->region_count + 1) * sizeof(int));
+    if (!selected_regions) return;
+    
+    int selected_count = select_table_regions(region_table, REGION_SELECT_PRIORITY, selected_regions);
+    int stride = selected_count / CALIBRATION_SAMPLE_REGIONS;
+    if (stride == 0) stride = 1;
+    
+    for (int i = 0; i < selected_count && samples->sample_count < CALIBRATION_SAMPLE_REGIONS; i += stride) {
+        int region_index = selected_regions[i];
+        const char* region_start = (const char*)region_table->start_addresses[region_index];
+        size_t region_size = region_table->end_addresses[region_index] - region_table->start_addresses[region_index];
+        size_t sample_size = region_size < CALIBRATION_SAMPLE_SIZE ? region_size : CALIBRATION_SAMPLE_SIZE;
+        
+        MemoryRegion sample_region;
+        get_table_region(region_table, region_index, &sample_region);
+        sample_region.end_address = (char*)sample_region.start_address + sample_size;
+        ResidencySnapshot* footprint = &samples->footprints[samples->sample_count];
+        capture_residency_snapshot(&sample_region, footprint);
+        
+        if (time_chunked_reads(MEMORY_READER_SIGNAL_GUARD, SCAN_CHUNK_MAX_SIZE, region_start,
+                               sample_size, chunk_buffer) == 0) {
+            release_scan_footprint(footprint);
+            continue;
+        }
+        samples->sample_starts[samples->sample_count] = region_start;
+        samples->sample_sizes[samples->sample_count] = sample_size;
+        samples->sample_count++;
+    }
+}
+
+/**
+ * @brief Times the scalar and vector kernels on the synthetic buffer
+ * 
+ * @return The faster kernel
+ */
+static SimdKernel choose_simd_kernel(const uint8_t* synthetic_buffer) {
+#if defined(CALIBRATION_HAS_VECTOR_KERNEL)
+    uint64_t kernel_times[2] = { UINT64_MAX, UINT64_MAX };
+    volatile size_t zero_count_sink = 0;
+    for (int round = 0; round < CALIBRATION_ROUNDS; round++) {
+        for (int kernel = SIMD_KERNEL_SCALAR; kernel <= SIMD_KERNEL_VECTOR; kernel++) {
+            uint64_t started = monotonic_nanoseconds();
+            zero_count_sink += count_zero_bytes_with_kernel(synthetic_buffer, CALIBRATION_BUFFER_SIZE,
+                                                            (SimdKernel)kernel);
+            uint64_t elapsed = monotonic_nanoseconds() - started;
+            if (elapsed < kernel_times[kernel]) kernel_times[kernel] = elapsed;
+        }
+    }
+    (void)zero_count_sink;
+    VLOGD("Calibration: zero counting takes %llu ns scalar, %llu ns vector",
+          (unsigned long long)kernel_times[SIMD_KERNEL_SCALAR], (unsigned long long)kernel_times[SIMD_KERNEL_VECTOR]);
+    return kernel_times[SIMD_KERNEL_VECTOR] <= kernel_times[SIMD_KERNEL_SCALAR] ? SIMD_KERNEL_VECTOR : SIMD_KERNEL_SCALAR;
+#else
+    return SIMD_KERNEL_SCALAR;
+#endif
+}
+
+/**
+ * @brief Times the tree hash of a synthetic buffer with every thread count
+ * 
+ * Worker threads only pay off when enough cores are free to run them;
+ * on small or busy cores one thread can beat several.
+ * 
+ * @return Fastest thread count, at most the online CPUs
+ */
+static int choose_hash_thread_count(void) {
+    int thread_limit = get_hash_thread_limit();
+    if (thread_limit == 1) return 1;
+    
+    char* hash_buffer = allocate_tracked_buffer(CALIBRATION_HASH_BUFFER_SIZE);
+    if (!hash_buffer) return thread_limit;
+    for (size_t i = 0; i < CALIBRATION_HASH_BUFFER_SIZE; i++) {
+        hash_buffer[i] = (char)((i * 2654435761u) >> 24);
+    }
+    
+    int fastest_count = thread_limit;
+    uint64_t fastest_time = UINT64_MAX;
+    uint8_t content_id[CONTENT_ID_SIZE];
+    for (int thread_count = 1; thread_count <= thread_limit; thread_count++) {
+        uint64_t candidate_time = UINT64_MAX;
+        for (int round = 0; round < CALIBRATION_ROUNDS; round++) {
+            uint64_t started = monotonic_nanoseconds();
+            compute_content_id_on_threads(hash_buffer, CALIBRATION_HASH_BUFFER_SIZE, thread_count, content_id);
+            uint64_t elapsed = monotonic_nanoseconds() - started;
+            if (elapsed < candidate_time) candidate_time = elapsed;
+        }
+        VLOGD("Calibration: tree hash on %d threads takes %llu ns", thread_count,
+              (unsigned long long)candidate_time);
+        if (candidate_time < fastest_time) {
+            fastest_time = candidate_time;
+            fastest_count = thread_count;
+        }
+    }
+    
+    release_tracked_buffer(hash_buffer, CALIBRATION_HASH_BUFFER_SIZE);
+    return fastest_count;
+}
+
+/**
+ * @brief Benchmarks every reader backend, chunk size and kernel
+ * 
+ * @param result Output settings (left at the defaults for anything that could not be measured)
+ */
+static void benchmark_scanner_settings(CalibrationResult* result) {
+    char* synthetic_buffer = allocate_tracked_buffer(CALIBRATION_BUFFER_SIZE);
+    if (!synthetic_buffer) return;
+    
+    // Mostly structured bytes with runs of zeros, like index tables in a DEX
+    for (size_t i = 0; i < CALIBRATION_BUFFER_SIZE; i++) {
+        synthetic_buffer[i] = (i & 3) == 0 ? 0 : (char)((i * 2654435761u) >> 24);
+    }
+    unsigned char chunk_buffer[SCAN_CHUNK_MAX_SIZE];
+    
+    begin_scan_arena();
+    RegionTable region_table;
+    CalibrationSamples samples;
+    memset(&samples, 0, sizeof(samples));
+    if (build_region_table(&region_table) > 0) {
+        subtract_self_owned_ranges(&region_table);
+        select_calibration_samples(&region_table, &samples, chunk_buffer);
+    }
+    
+    int backend_count = is_vm_readv_supported() ? 2 : 1;
+    uint64_t fastest_time = UINT64_MAX;
+    for (int backend = MEMORY_READER_SIGNAL_GUARD; backend < backend_count; backend++) {
+        for (size_t chunk_size = SCAN_CHUNK_SIZE; chunk_size <= SCAN_CHUNK_MAX_SIZE; chunk_size *= 2) {
+            uint64_t candidate_time = time_reader_candidate((MemoryReaderBackend)backend, chunk_size,
+                                                            synthetic_buffer, &samples, chunk_buffer);
+            VLOGD("Calibration: %s with %zu-byte chunks takes %llu ns",
+                  backend == MEMORY_READER_VM_READV ? "process_vm_readv" : "signal guard",
+                  chunk_size, (unsigned long long)candidate_time);
+            if (candidate_time < fastest_time) {
+                fastest_time = candidate_time;
+                result->reader_backend = (MemoryReaderBackend)backend;
+                result->scan_chunk_size = chunk_size;
+            }
+        }
+    }
+    
+    // Snapshots live in the scan arena, newest on top
+    for (int i = samples.sample_count - 1; i >= 0; i--) {
+        release_scan_footprint(&samples.footprints[i]);
+    }
+    end_scan_arena();
+    
+    result->simd_kernel = choose_simd_kernel((const uint8_t*)synthetic_buffer);
+    release_tracked_buffer(synthetic_buffer, CALIBRATION_BUFFER_SIZE);
+    if (should_enable_tree_content_hash()) {
+        result->hash_thread_count = choose_hash_thread_count();
+    }
+    LOGI("Calibration sampled %d real regions", samples.sample_count);
+}
+
+/**
+ * @brief Loads the cached calibration for this device or benchmarks and caches a new one
+ * 
+ * Takes a few tens of milliseconds when the benchmark runs. With
+ * calibration disabled the built-in defaults stay in effect.
+ */
+void run_startup_calibration(void) {
+    if (!should_enable_calibration()) {
+        LOGI("Startup calibration disabled, using default reader and chunk size");
+        return;
+    }
+    
+    uint64_t started = monotonic_nanoseconds();
+    uint64_t fingerprint = compute_device_fingerprint();
+    CalibrationResult result = active_calibration;
+    int cached = load_cached_calibration(fingerprint, &result);
+    if (!cached) {
+        benchmark_scanner_settings(&result);
+        save_cached_calibration(fingerprint, &result);
+    }
+    
+    set_memory_reader_backend(result.reader_backend);
+    active_calibration = result;
+    LOGI("Calibration (%s, %.1f ms): reader %s, %zu-byte scan chunks, %s kernels, %d hash threads",
+         cached ? "cached" : "measured", (double)(monotonic_nanoseconds() - started) / 1e6,
+         result.reader_backend == MEMORY_READER_VM_READV ? "process_vm_readv" : "signal guard",
+         result.scan_chunk_size, result.simd_kernel == SIMD_KERNEL_VECTOR ? "vector" : "scalar",
+         get_hash_thread_count());
+}
+
+/**
+ * @brief Returns the bytes read per signature-scan chunk
+ * 
+ * @return Chunk size between SCAN_CHUNK_SIZE and SCAN_CHUNK_MAX_SIZE
+ */
+size_t get_scan_chunk_size(void) {
+    return active_calibration.scan_chunk_size;
+}
+
+/**
+ * @brief Returns the kernel of the byte comparison loops
+ * 
+ * @return SIMD_KERNEL_VECTOR or SIMD_KERNEL_SCALAR
+ */
+SimdKernel get_simd_kernel(void) {
+    return active_calibration.simd_kernel;
+}
+
+/**
+ * @brief Returns the threads one tree hash is spread over
+ * 
+ * Never more than the online CPUs, whatever was calibrated or cached.
+ * 
+ * @return Thread count between 1 and CONTENT_HASH_MAX_THREADS
+ */
+int get_hash_thread_count(void) {
+    int thread_limit = get_hash_thread_limit();
+    return active_calibration.hash_thread_count < thread_limit ? active_calibration.hash_thread_count : thread_limit;
+}
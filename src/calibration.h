@@ -0,0 +1,45 @@
+#ifndef DEXDUMPER_CALIBRATION_H
+#define DEXDUMPER_CALIBRATION_H
+
+// Calibration header - declares the startup benchmark that picks the scanner's fastest settings
+
+#include "common.h"
+#include "config.h"
+#include "signal_handler.h"
+
+/**
+ * Startup Calibration:
+ * 
+ * Which memory reader is cheaper (signal-guarded memcpy() or
+ * process_vm_readv()), how large a signature-scan chunk pays off,
+ * whether the NEON/SSE2 kernels beat plain loops and how many threads a
+ * tree hash is worth spreading over differs from device to device. After
+ * the initial delay and before the first pass every combination of
+ * reader backend and chunk size reads a synthetic buffer and a sample of
+ * real high-priority regions (whose pages are given back afterwards),
+ * the vector and scalar kernels count zeros in the synthetic buffer, a
+ * synthetic buffer is tree-hashed on every thread count up to the online
+ * CPUs, and the fastest choices are applied. The result is cached next
+ * to the configuration file together with a fingerprint of the CPU and
+ * kernel, so later starts on the same device skip the benchmark.
+ */
+
+// Loop kernel for byte comparisons (zero counting, XOR candidate screening)
+typedef enum {
+    SIMD_KERNEL_SCALAR = 0, // Plain byte loops
+    SIMD_KERNEL_VECTOR = 1  // NEON or SSE2, where compiled in
+} SimdKernel;
+
+// Loads the cached calibration for this device or benchmarks and caches a new one
+void run_startup_calibration(void);
+
+// Returns the bytes read per signature-scan chunk
+size_t get_scan_chunk_size(void);
+
+// Returns the kernel of the byte comparison loops
+SimdKernel get_simd_kernel(void);
+
+// Returns the threads one tree hash is spread over
+int get_hash_thread_count(void);
+
+#endif
@@ -58,8 +58,29 @@ typedef struct {
     time_t dump_timestamp;  // When the file was dumped
     char file_path[MAX_PATH_LENGTH]; // Where it was saved
     uint8_t sha1_digest[20]; // SHA1 checksum for duplicate detection
+    int has_sha1;            // Set if sha1_digest is valid, large dumps may be known by content_id only
+    uint8_t content_id[CONTENT_ID_SIZE]; // Tree hash content ID of large dumps
+    int has_content_id;      // Set if content_id is valid
 } DumpedFileInfo;
 
+/**
+ * @brief Encoding of a detected payload
+ * 
+ * Plain payloads are dumped as found; compressed payloads are inflated
+ * and obfuscated payloads decrypted first, and the output is fed back
+ * into detection.
+ */
+typedef enum {
+    PAYLOAD_ENCODING_PLAIN = 0,     // Bytes are the payload itself
+    PAYLOAD_ENCODING_ZLIB,          // zlib stream (RFC 1950)
+    PAYLOAD_ENCODING_GZIP,          // gzip member (RFC 1952)
+    PAYLOAD_ENCODING_ZIP_DEFLATE,   // Raw deflate data behind a zip local file header
+    PAYLOAD_ENCODING_LZ4_FRAME,     // LZ4 frame format
+    PAYLOAD_ENCODING_XOR,           // XORed with a repeating key
+    PAYLOAD_ENCODING_ADD,           // Repeating key added byte-wise (subtract to decode)
+    PAYLOAD_ENCODING_ELF_MAPPED     // Loaded ELF image, segments at their virtual addresses
+} PayloadEncoding;
+
 /**
  * @brief Result of DEX file detection
  * 
@@ -69,6 +90,105 @@ typedef struct {
 typedef struct {
     void* dex_address; // Memory address where DEX file starts
     size_t dex_size;   // Size of the DEX file in bytes
+    const char* detector_name; // Detector that recognised the payload
+    PayloadEncoding payload_encoding; // How the payload bytes are encoded
+    uint8_t payload_key[MAX_XOR_KEY_LENGTH]; // Recovered key of XOR/ADD payloads
+    size_t payload_key_length;        // Length of payload_key in bytes, 0 if none
 } DexDetectionResult;
 
+/**
+ * @brief Per-region scanning budget state
+ * 
+ * Tracks how much work has been spent on the current region so that
+ * adversarial content (e.g. thousands of fake DEX headers) cannot make
+ * the scan time grow beyond a small constant factor of the region size.
+ */
+typedef struct {
+    size_t candidates_seen;       // Magic signature hits in this region
+    size_t validations_performed; // Header validations attempted
+    size_t consecutive_failures;  // Failed validations since the last skip or success
+    size_t read_faults;           // Unreadable locations encountered
+    size_t skip_distance;         // Current skip-ahead distance in bytes, 0 until backoff starts
+    size_t skip_end_offset;       // Candidates before this offset are not validated while backing off
+    size_t last_candidate_offset; // Offset of the last candidate seen
+    int budget_exhausted;         // Set once any budget has been exceeded
+    int high_priority;            // Region is high priority (enables costly detectors)
+    size_t inflate_attempts;      // Sniff inflations attempted in this region
+    int file_backed;              // Region maps a file on disk (anonymous-only detectors skip it)
+} RegionScanBudget;
+
+/**
+ * @brief Content class of a region derived from its sampled entropy
+ * 
+ * Decides which stages a region is routed to before any byte scanning.
+ */
+typedef enum {
+    REGION_CONTENT_UNKNOWN = 0,   // Nothing could be sampled, scan as usual
+    REGION_CONTENT_EMPTY,         // Private anonymous, nothing swapped out and every present page zero, skipped
+    REGION_CONTENT_STRUCTURED,    // Low or medium entropy, regular DEX scan
+    REGION_CONTENT_HIGH_ENTROPY   // Compressed or encrypted, decode stages enabled
+} RegionContentClass;
+
+/**
+ * @brief Entropy profile built from a few cache lines per page
+ */
+typedef struct {
+    size_t pages_sampled;         // Pages whose sample could be read
+    size_t pages_unreadable;      // Pages whose sample faulted
+    size_t zero_pages;            // Pages whose sample was all zero
+    size_t bytes_sampled;         // Total sampled bytes
+    size_t zero_bytes;            // Sampled bytes equal to zero
+    unsigned int entropy_millibits; // Shannon entropy of the sample in bits per byte x1000
+    RegionContentClass content_class; // Resulting routing decision
+} RegionEntropyProfile;
+
+/**
+ * @brief Aggregated statistics for a scanning session
+ * 
+ * Counters are updated atomically so they can be read while a scan
+ * is running. Reset at the start of every memory dumping pass.
+ */
+typedef struct {
+    unsigned long regions_scanned;     // Regions handed to DEX detection
+    unsigned long candidates_found;    // Magic signature hits
+    unsigned long headers_validated;   // Header validations performed
+    unsigned long validations_failed;  // Header validations that failed
+    unsigned long read_faults;         // Faults caught while scanning
+    unsigned long bytes_skipped;       // Bytes left unvalidated by skip-ahead or unread after faults
+    unsigned long budgets_exhausted;   // Regions whose scan budget ran out
+    unsigned long regions_quarantined; // Regions quarantined for later passes
+    unsigned long quarantine_skips;    // Scans skipped because region was quarantined
+    unsigned long inflate_attempts;    // Compressed candidates sniff-inflated
+    unsigned long payloads_inflated;   // Compressed payloads fully inflated
+    unsigned long bytes_inflated;      // Total inflated output bytes
+    unsigned long inflate_budget_stops; // Inflations stopped by CPU or byte budgets
+    unsigned long expansion_children;  // Child buffers emitted by container expansion
+    unsigned long expansion_duplicates; // Child buffers dropped as already seen
+    unsigned long expansion_budget_stops; // Expansions cut short by depth, item, byte or time budgets
+    unsigned long xor_candidates_verified; // Screened XOR/ADD candidates fully verified
+    unsigned long xor_keys_recovered;  // Obfuscated DEX whose key was recovered
+    unsigned long xor_budget_stops;    // Key screening stopped by the CPU budget
+    unsigned long entropy_empty_skips; // Regions skipped because every sample was zero
+    unsigned long entropy_decode_enabled; // High-entropy regions given the decode stages
+    unsigned long elf_images_rebuilt;  // Loaded native libraries put back into file layout
+    unsigned long heap_spaces_walked;  // ART heap spaces walked for byte[] arrays
+    unsigned long heap_pages_skipped;  // Heap pages skipped as not resident
+    unsigned long heap_arrays_found;   // byte[] arrays holding a DEX file
+    unsigned long pointer_regions_scanned; // Writable regions searched for (pointer, length) pairs
+    unsigned long pointer_targets_checked; // Pointer targets read for a DEX header
+    unsigned long pointer_dex_found;   // DEX files found through pointers
+    unsigned long protected_regions_read; // Non-readable regions copied through /proc/self/mem
+    unsigned long protected_regions_empty; // Non-readable regions without resident pages
+    unsigned long protected_bytes_read; // Bytes copied through /proc/self/mem
+    unsigned long prefault_calls;      // MADV_POPULATE_READ calls issued
+    unsigned long prefault_unreadable; // Prefaulted ranges reported unreadable
+    unsigned long footprint_pages_released; // Pages pulled in by scans and advised cold/pageout
+    unsigned long io_uring_submissions; // Read and write requests completed through io_uring
+    unsigned long io_uring_bytes;      // Bytes read and written through io_uring
+    unsigned long io_sync_fallbacks;   // File operations finished with synchronous I/O instead
+    unsigned long dump_bytes_uncached; // Dump bytes flushed and dropped from the page cache
+    unsigned long copy_tears_detected; // Payload copies that differed from their source afterwards
+    unsigned long copies_left_torn;    // Copies kept torn after every retry
+} ScanStatistics;
+
 #endif
\ No newline at end of file
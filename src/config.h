@@ -11,6 +11,7 @@
 #define DEX_MAGIC_SIGNATURE "dex\n"  // Magic bytes for DEX files
 #define DEX_HEADER_SIZE 0x70         // Size of standard DEX header
 #define DEX_MAGIC_LEN 8              // Length of magic signature
+#define DEX_CONTAINER_HEADER_SIZE 0x78 // Header size of version 041 (container) DEX
 
 // File system limits
 #define MAX_PATH_LENGTH 512          // Maximum file path length
@@ -21,17 +22,159 @@
 #define DEFAULT_SCAN_LIMIT (2 * 1024 * 1024) // 2MB default scan limit per region
 #define MAX_REGION_SIZE (200 * 1024 * 1024)  // 200MB maximum region size to scan
 
+// Per-region scan budgets (protect against candidate storms)
+#define MAX_CANDIDATES_PER_REGION 256        // Magic hits before region is abandoned
+#define MAX_VALIDATIONS_PER_REGION 64        // Header validations before region is abandoned
+#define MAX_FAULTS_PER_REGION 32             // Read faults before region is abandoned
+#define MAX_PAYLOADS_PER_REGION 16           // Payloads detected before the region scan stops
+#define SKIP_AHEAD_FAILURE_THRESHOLD 4       // Consecutive failed validations before skipping ahead
+#define SKIP_AHEAD_INITIAL_DISTANCE 64       // First skip-ahead distance in bytes (doubles each time)
+#define SKIP_AHEAD_MAX_DISTANCE (64 * 1024)  // Upper bound for skip-ahead distance
+#define SKIP_AHEAD_RESET_DISTANCE 256        // Candidate-free bytes that end skip-ahead backoff
+#define MAX_QUARANTINED_REGIONS 128          // Regions remembered as quarantined
+#define SCAN_CHUNK_SIZE 4096                 // Bytes read per signature-scan chunk (default, uncalibrated)
+#define SCAN_CHUNK_MAX_SIZE (16 * 1024)      // Largest signature-scan chunk calibration may pick
+#define RESIDENCY_WINDOW_PAGES 4096          // Pages queried per mincore() call
+#define PREFAULT_WINDOW_SIZE (256 * 1024)    // Bytes prefaulted ahead of the scan cursor per madvise()
+
+// Detector plugins
+#define MAX_REGISTERED_DETECTORS 32          // Built-in plus plugin detectors
+#define DETECTOR_PLUGIN_DIRECTORY ""         // Directory of detector plugins (empty = disabled)
+
+// Compressed payload inflation (sniff-first, budgeted)
+#define INFLATE_SNIFF_OUTPUT_SIZE 4096               // Output inflated before checking for a magic
+#define INFLATE_SNIFF_INPUT_SIZE (16 * 1024)         // Compressed bytes read for the sniff
+#define INFLATE_INPUT_WINDOW_SIZE (64 * 1024)        // Compressed bytes read per refill
+#define MAX_INFLATE_ATTEMPTS_PER_REGION 16           // Sniff inflations allowed per region
+#define INFLATE_MAX_OUTPUT_SIZE (64 * 1024 * 1024)   // Largest inflated payload
+#define INFLATE_PASS_BYTE_BUDGET (256 * 1024 * 1024) // Inflated bytes allowed per scanning pass
+#define INFLATE_TIME_BUDGET_MS 250                   // CPU time allowed per payload inflation
+#define INFLATE_SNIFF_TIME_BUDGET_MS 5               // CPU time allowed per sniff inflation
+
+// XOR / additive key recovery for obfuscated DEX (high-priority regions only)
+#define MAX_XOR_KEY_LENGTH 32                        // Longest repeating key tried
+#define XOR_SCAN_TIME_BUDGET_MS 40                   // CPU time allowed per region for key screening
+#define XOR_SCAN_PASS_TIME_BUDGET_MS 400             // CPU time allowed per scanning pass for key screening
+#define MAX_XOR_VERIFICATIONS_PER_REGION 16          // Screened candidates fully verified per region
+#define XOR_KEY_FREQUENCY_WINDOW (64 * 1024)         // Bytes sampled to fill key bytes the header leaves open
+
+// Sampled entropy profile used to route regions before scanning
+#define ENTROPY_SAMPLED_PAGES 128                    // Pages sampled within the scan window
+#define ENTROPY_SAMPLE_BYTES 256                     // Bytes (four cache lines) sampled per page
+#define ENTROPY_MIN_SAMPLE_BYTES 4096                // Smaller samples are never called high entropy
+#define ENTROPY_HIGH_THRESHOLD_MILLIBITS 7500        // Bits per byte (x1000) above which data is compressed or encrypted
+#define ENTROPY_EMPTY_VERIFY_PAGES 16                // Most resident pages for a zero-sampled window to be verified and skipped
+
+// Recursive container expansion (zip -> compressed -> dex container -> dex)
+#define EXPANSION_MAX_DEPTH 4                        // Nesting levels below the detected payload
+#define EXPANSION_MAX_ITEMS 64                       // Buffers processed per detected payload
+#define EXPANSION_BYTE_BUDGET (128 * 1024 * 1024)    // Child bytes processed per detected payload
+#define EXPANSION_TIME_BUDGET_MS 2000                // CPU time allowed per detected payload
+#define MAX_PROVENANCE_LENGTH 512                    // Length of a provenance chain string
+#define DUMP_MANIFEST_FILENAME "manifest.jsonl"      // Manifest of dumped files in output directory
+
+// Native library (ELF) recovery from anonymous memory
+#define ELF_MAX_PROGRAM_HEADERS 64                   // Program headers accepted per ELF image
+#define ELF_MAX_IMAGE_SIZE DEX_MAX_FILE_SIZE         // Largest native library recovered (dump size limit)
+
+// ART heap walking (byte[] arrays in dalvik heap spaces)
+#define ART_OBJECT_ALIGNMENT 8                       // Alignment of every object in an ART heap space
+#define ART_ARRAY_LENGTH_OFFSET 8                    // int32 length after the klass and monitor words
+#define ART_BYTE_ARRAY_DATA_OFFSET 12                // First element of a byte[] (header size)
+#define ART_HEAP_MAX_REGION_SIZE (1024 * 1024 * 1024) // Largest heap space walked (bypasses MAX_REGION_SIZE)
+#define ART_HEAP_MAX_PAYLOADS_PER_REGION 32          // DEX byte arrays dumped per heap space
+
+// Pointer-guided discovery ((pointer, length) pairs in writable native memory)
+#define POINTER_SCAN_MAX_REGION_SIZE (64 * 1024 * 1024) // Largest writable region searched for pointers
+#define POINTER_SCAN_BYTE_BUDGET (256 * 1024 * 1024)    // Resident bytes searched per pass
+#define MAX_POINTER_TARGET_CHECKS 4096                  // Pointer targets read per pass
+#define MAX_POINTED_DEX_PER_PASS 64                     // DEX files collected through pointers per pass
+#define POINTER_TARGET_CACHE_SLOTS 1024                 // Rejected targets remembered to skip repeats
+
+// Non-readable (PROT_NONE) regions read through /proc/self/mem
+#define PROTECTED_REGION_MAX_SIZE (64 * 1024 * 1024)    // Largest non-readable region read
+#define PROC_MEM_READ_SIZE (1024 * 1024)                // Bytes per pread() of a resident run
+
 // DEX file size validation
 #define DEX_MIN_FILE_SIZE 1024               // 1KB minimum DEX size
 #define DEX_MAX_FILE_SIZE (50 * 1024 * 1024) // 50MB maximum DEX size
 
 // Registry and tracking
 #define MAX_DUMPED_FILES 512                 // Maximum files to track
-#define MAX_REGIONS_INITIAL_CAPACITY 100     // Initial memory regions array size
+#define MAPS_READ_SIZE (64 * 1024)           // Initial buffer for /proc/self/maps text
+
+// Per-pass arena (bump allocator for scan-lifetime objects)
+#define SCAN_ARENA_CHUNK_SIZE (1024 * 1024)         // Minimum mmap'd chunk of the pass arena
+#define SCAN_ARENA_ALIGNMENT 16                     // Alignment of every arena allocation
+
+// Startup calibration (result cached per device fingerprint next to the config file)
+#define CALIBRATION_BUFFER_SIZE (256 * 1024) // Synthetic buffer read by every candidate
+#define CALIBRATION_SAMPLE_REGIONS 4         // Real high-priority regions sampled
+#define CALIBRATION_SAMPLE_SIZE (256 * 1024) // Bytes read from each sampled region
+#define CALIBRATION_ROUNDS 3                 // Timed repetitions, the fastest one counts
+#define CALIBRATION_HASH_BUFFER_SIZE (4 * 1024 * 1024) // Buffer tree-hashed with every thread count
+
+// Resolved configuration snapshot (binary cache of the config file and its package profiles)
+#define CONFIG_SNAPSHOT_MAGIC 0x50534344     // "DCSP"
+#define CONFIG_SNAPSHOT_VERSION 2            // Bump when the meaning of a RuntimeConfig field changes
+
+// Cross-process dedup table (mmap'd file in the output directory, lock-free slots)
+#define SHARED_DEDUP_FILENAME ".dedup_table"  // Table file in the output directory
+#define SHARED_DEDUP_LOCK_FILENAME ".dedup_table.lock" // Serializes the opening of the table
+#define SHARED_DEDUP_MAGIC 0x32444453        // "SDD2"
+#define SHARED_DEDUP_SLOT_COUNT 4096         // Slots of 64 bytes, power of two
+#define SHARED_DEDUP_SPIN_LIMIT 1000         // Yields spent waiting for a slot another process is filling
+
+// Runtime control channel (abstract UNIX socket "@<prefix>.<pid>", one command per connection)
+#define CONTROL_SOCKET_PREFIX "dexdumper"    // Socket name before the process id
+#define CONTROL_COMMAND_MAX_LENGTH 256       // Longest command line accepted
+#define CONTROL_REPLY_MAX_LENGTH 4096        // Largest reply (statistics)
+
+// Torn copy detection (payload modified by the app while it is copied)
+#define TORN_CHECK_SAMPLE_WINDOWS 32         // Windows of the source compared with the copy afterwards
+#define TORN_CHECK_WINDOW_SIZE 4096          // Bytes per compared window
+#define TORN_COPY_MAX_RETRIES 3              // Copies retried before keeping a torn one
+#define TORN_COPY_BACKOFF_MS 2               // Wait before the first retry, doubled on each further one
+
+// Multi-buffer SHA1 (independent buffers hashed side by side in SIMD lanes)
+#define SHA1_LANE_COUNT 4                    // 32-bit lanes of a NEON/SSE2 vector
+#define SHA1_BATCH_MAX_BUFFERS 8             // Dumps of one expansion queued and hashed together
+
+// Tree hash content ID (BLAKE3 over 1 KB chunks, subtrees spread over threads)
+#define CONTENT_ID_SIZE 32                   // BLAKE3-256
+#define TREE_HASH_MIN_SIZE (1024 * 1024)     // Dumps from this size are identified by the tree hash, SHA1 follows lazily
+#define CONTENT_HASH_LEAF_CHUNKS 16          // Chunks hashed and merged by one leaf of the recursion
+#define CONTENT_HASH_PARALLEL_MIN_SIZE (2 * 1024 * 1024) // Subtrees from this size are split with a worker thread
+#define CONTENT_HASH_MAX_THREADS 4           // Threads sharing one tree hash, the calling one included
+
+// Self-owned memory tracking (keeps the scanner away from its own buffers)
+#define MAX_SELF_OWNED_RANGES 128            // Maximum tracked dumper allocations
+#define SELF_BUFFER_CACHE_SLOTS 4            // Released buffers kept for reuse
+#define FILE_READ_WINDOW_SIZE (256 * 1024)   // Buffer size for hashing files on disk
+
+// io_uring file I/O (synchronous pread()/pwrite() when unavailable)
+#define IO_URING_QUEUE_DEPTH 8               // Submission queue entries
+#define IO_URING_READ_BUFFERS 4              // Registered FILE_READ_WINDOW_SIZE windows read per batch
+#define IO_URING_WRITE_CHUNK_SIZE (1024 * 1024) // Bytes per queued write request
+#define DUMP_WRITEBACK_WINDOW (8 * 1024 * 1024) // Dump bytes written before the previous slice is flushed and dropped
 
 // Feature toggles
 #define ENABLE_REGION_FILTERING 1    // Enable smart region filtering
 #define ENABLE_SECOND_SCAN 0  // Enable/disable second scan
+#define ENABLE_ELF_DUMPING 1         // Dump native libraries found in anonymous memory
+#define REBUILD_ELF_SECTIONS 1       // Rebuild section headers of loaded native libraries
+#define ENABLE_ART_HEAP_WALK 1       // Walk byte[] arrays of dalvik heap spaces
+#define ENABLE_POINTER_DISCOVERY 1   // Follow (pointer, length) pairs in native memory to DEX files
+#define ENABLE_PROTECTED_REGION_READS 1 // Read non-readable anonymous regions through /proc/self/mem
+#define FOOTPRINT_RELEASE_MODE 1     // Pages a scan pulled in: 0=keep, 1=MADV_COLD, 2=MADV_PAGEOUT
+#define ENABLE_IO_URING 1            // Read and write dump files through io_uring when the kernel allows it
+#define ENABLE_DUMP_CACHE_DROP 1     // Preallocate dumps and drop their pages from the page cache once written
+#define ENABLE_STARTUP_CALIBRATION 1 // Benchmark reader backend, scan chunk size and SIMD kernels at startup
+#define ENABLE_CONTROL_CHANNEL 0     // Accept scan/pause/set/stats commands on an abstract UNIX socket
+#define ENABLE_CONFIG_HOT_RELOAD 1   // Reload the configuration file through inotify when it is saved
+#define ENABLE_SHARED_DEDUP_TABLE 1  // Share dumped checksums with the app's other processes through an mmap'd table
+#define ENABLE_TREE_CONTENT_HASH 1   // Identify large dumps by a parallel BLAKE3 tree hash, SHA1 only when needed
+#define ENABLE_TORN_COPY_CHECK 1     // Compare sampled windows of each payload copy with its source, retry torn copies
 
 // Timing Configuration (in seconds)
 #define THREAD_INITIAL_DELAY 8     // Initial delay before first scan
@@ -46,6 +189,7 @@
 }
 
 // SHA1 Exclusion List - Add SHA1 hashes of DEX files to exclude from dumping
+// (dumps of TREE_HASH_MIN_SIZE and more are excluded by content ID in the config file)
 #define EXCLUDED_SHA1_LIST { \
     "da39a3ee5e6b4b0d3255bfef95601890afd80709", /* Empty file SHA1 */ \
     "5ba93c9db0cff93f52b521d7420e43f6eda2784f", /* Null file 1 SHA1 */ \
@@ -9,28 +9,101 @@
 
 #include "config_manager.h"
 #include "file_utils.h"
+#include <sys/inotify.h>
+#include <fnmatch.h>
 
 /**
  * @brief Runtime configuration structure
  * 
  * Holds all configurable parameters that can be modified at runtime
- * through configuration files. This structure is populated when the
- * configuration manager is initialized.
+ * through configuration files. Every load, reload or runtime change
+ * builds a new snapshot; a published snapshot is never modified, so
+ * readers need no lock.
  */
 typedef struct {
+    // Scalar options first: the snapshot cache stores them as one block
     int enable_second_scan;              // Enable/disable second memory scan
     int thread_initial_delay;            // Initial delay before first scan (seconds)
     int second_scan_delay;               // Delay between scans (seconds)
     int enable_region_filtering;         // Enable smart memory region filtering
+    int max_candidates_per_region;       // Magic hits allowed per region before giving up
+    int max_validations_per_region;      // Header validations allowed per region
+    int max_faults_per_region;           // Read faults allowed per region before quarantine
+    int enable_elf_dumping;              // Dump native libraries found in anonymous memory
+    int rebuild_elf_sections;            // Rebuild section headers of loaded native libraries
+    int enable_art_heap_walk;            // Walk byte[] arrays of ART heap spaces
+    int enable_pointer_discovery;        // Follow (pointer, length) pairs to DEX files
+    int enable_protected_region_reads;   // Read non-readable regions through /proc/self/mem
+    int footprint_release_mode;          // Give back pages a scan pulled in (0=off, 1=cold, 2=pageout)
+    int enable_io_uring;                 // Batch file reads and writes through io_uring
+    int drop_dump_page_cache;            // Flush written dumps and drop them from the page cache
+    int enable_calibration;              // Benchmark reader backend, chunk size and kernels at startup
+    int enable_control_channel;          // Accept runtime commands on an abstract UNIX socket
+    int enable_config_hot_reload;        // Reload this file when it changes
+    int enable_shared_dedup_table;       // Share dumped checksums with the app's other processes
+    int enable_tree_content_hash;        // Identify large dumps by a parallel tree hash, SHA1 lazily
+    int enable_torn_copy_check;          // Retry payload copies the app modified while they were taken
+    char* detector_plugin_directory;     // Directory of detector plugins (NULL = default)
     char** excluded_sha1_list;           // List of SHA1 hashes to exclude from dumping
     int excluded_sha1_count;             // Number of excluded SHA1 entries
+    char** excluded_content_id_list;     // List of tree hash content IDs to exclude from dumping
+    int excluded_content_id_count;       // Number of excluded content ID entries
     char** output_directory_templates;   // Template paths for output directories
     int output_directory_count;          // Number of output directory templates
     int config_loaded;                   // Flag indicating if config was successfully loaded
 } RuntimeConfig;
 
-// Global runtime configuration instance
-static RuntimeConfig g_runtime_config;
+// Bytes of the scalar options at the start of RuntimeConfig
+#define RUNTIME_CONFIG_SCALAR_SIZE offsetof(RuntimeConfig, detector_plugin_directory)
+
+// Header of the resolved configuration snapshot cached next to the config file
+typedef struct {
+    uint32_t magic;              // CONFIG_SNAPSHOT_MAGIC
+    uint32_t scalar_block_size;  // RUNTIME_CONFIG_SCALAR_SIZE of the build that wrote it
+    uint64_t source_fingerprint; // Config file, library build and package it was resolved for
+    uint64_t payload_checksum;   // FNV-1a of everything after the header
+} ConfigSnapshotHeader;
+
+/**
+ * Snapshot Publishing:
+ * 
+ * g_runtime_config points to the current snapshot and is swapped
+ * atomically by writers, which are serialized by config_write_mutex.
+ * Getters load the pointer without locking, so a scan sees a new budget
+ * or exclusion list at its next region. Replaced snapshots may still be
+ * in use by the dumping thread (exclusion lists, template arrays), so
+ * they are retired rather than freed and released by
+ * release_retired_config_snapshots() between scanning passes.
+ */
+
+// Current configuration snapshot (NULL before init_config_manager)
+static RuntimeConfig* g_runtime_config = NULL;
+
+// Returned by the getters before the configuration manager is initialized
+static const RuntimeConfig empty_runtime_config;
+
+// Configuration file found or created at initialization (empty if none), fixed afterwards
+static char config_file_path[MAX_PATH_LENGTH];
+
+// Serializes snapshot writers and the retired list
+static pthread_mutex_t config_write_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Replaced snapshots waiting for the end of the scanning pass
+static RuntimeConfig** retired_snapshots = NULL;
+static int retired_snapshot_count = 0;
+
+// Configuration file watcher
+static int config_watch_fd = -1;
+static int config_watch_descriptor = -1;
+static volatile int config_watcher_stopping = 0;
+
+/**
+ * @brief Gets the current configuration snapshot without locking
+ */
+static inline const RuntimeConfig* current_config(void) {
+    const RuntimeConfig* config = __atomic_load_n(&g_runtime_config, __ATOMIC_ACQUIRE);
+    return config ? config : &empty_runtime_config;
+}
 
 /**
  * @brief Extracts base library name from full path
@@ -172,12 +245,132 @@ static void create_default_config(const char* config_path) {
     fprintf(config_file, "# Default: %d (0=disabled, 1=enabled)\n", ENABLE_REGION_FILTERING);
     fprintf(config_file, "enable_region_filtering=%d\n\n", ENABLE_REGION_FILTERING);
     
+    // Scan budget section
+    fprintf(config_file, "# SCAN BUDGETS\n");
+    fprintf(config_file, "# ============\n");
+    fprintf(config_file, "# Limits that keep scan time linear on regions crafted to contain\n");
+    fprintf(config_file, "# many fake DEX signatures. A region that runs out of budget is\n");
+    fprintf(config_file, "# quarantined and skipped by later scans.\n");
+    fprintf(config_file, "\n");
+    fprintf(config_file, "# Maximum DEX signature hits examined per region\n");
+    fprintf(config_file, "# Default: %d\n", MAX_CANDIDATES_PER_REGION);
+    fprintf(config_file, "max_candidates_per_region=%d\n\n", MAX_CANDIDATES_PER_REGION);
+    
+    fprintf(config_file, "# Maximum DEX header validations performed per region\n");
+    fprintf(config_file, "# Default: %d\n", MAX_VALIDATIONS_PER_REGION);
+    fprintf(config_file, "max_validations_per_region=%d\n\n", MAX_VALIDATIONS_PER_REGION);
+    
+    fprintf(config_file, "# Maximum unreadable locations tolerated per region\n");
+    fprintf(config_file, "# Default: %d\n", MAX_FAULTS_PER_REGION);
+    fprintf(config_file, "max_faults_per_region=%d\n\n", MAX_FAULTS_PER_REGION);
+    
+    // Native library section
+    fprintf(config_file, "# NATIVE LIBRARY DUMPING\n");
+    fprintf(config_file, "# ======================\n");
+    fprintf(config_file, "# Dump ELF shared objects found in anonymous memory (e.g. decrypted by a packer)\n");
+    fprintf(config_file, "# Libraries mapped from files on disk are never dumped\n");
+    fprintf(config_file, "# Default: %d (0=disabled, 1=enabled)\n", ENABLE_ELF_DUMPING);
+    fprintf(config_file, "enable_elf_dumping=%d\n\n", ENABLE_ELF_DUMPING);
+    
+    fprintf(config_file, "# Rebuild section headers of libraries recovered from their loaded layout\n");
+    fprintf(config_file, "# Default: %d (0=disabled, 1=enabled)\n", REBUILD_ELF_SECTIONS);
+    fprintf(config_file, "rebuild_elf_sections=%d\n\n", REBUILD_ELF_SECTIONS);
+    
+    // ART heap section
+    fprintf(config_file, "# ART HEAP WALKING\n");
+    fprintf(config_file, "# ================\n");
+    fprintf(config_file, "# Check the byte[] arrays of dalvik heap spaces for DEX files loaded from memory\n");
+    fprintf(config_file, "# Heap spaces are walked in full, past the usual scan and region size limits\n");
+    fprintf(config_file, "# Default: %d (0=disabled, 1=enabled)\n", ENABLE_ART_HEAP_WALK);
+    fprintf(config_file, "enable_art_heap_walk=%d\n\n", ENABLE_ART_HEAP_WALK);
+    
+    // Pointer discovery section
+    fprintf(config_file, "# POINTER DISCOVERY\n");
+    fprintf(config_file, "# =================\n");
+    fprintf(config_file, "# Search writable native memory for (pointer, length) pairs leading to DEX files\n");
+    fprintf(config_file, "# Finds DEX files inside regions too large for the byte scan\n");
+    fprintf(config_file, "# Default: %d (0=disabled, 1=enabled)\n", ENABLE_POINTER_DISCOVERY);
+    fprintf(config_file, "enable_pointer_discovery=%d\n\n", ENABLE_POINTER_DISCOVERY);
+    
+    // Protected region section
+    fprintf(config_file, "# PROTECTED REGIONS\n");
+    fprintf(config_file, "# =================\n");
+    fprintf(config_file, "# Read non-readable (e.g. PROT_NONE) anonymous regions through /proc/self/mem\n");
+    fprintf(config_file, "# Only resident pages of high-priority regions up to %d MB are read\n",
+            PROTECTED_REGION_MAX_SIZE / (1024 * 1024));
+    fprintf(config_file, "# Default: %d (0=disabled, 1=enabled)\n", ENABLE_PROTECTED_REGION_READS);
+    fprintf(config_file, "enable_protected_region_reads=%d\n\n", ENABLE_PROTECTED_REGION_READS);
+    
+    // Memory footprint section
+    fprintf(config_file, "# MEMORY FOOTPRINT\n");
+    fprintf(config_file, "# ================\n");
+    fprintf(config_file, "# Give back file pages a scan pulled into memory (pages resident before are kept)\n");
+    fprintf(config_file, "# 0=keep resident, 1=MADV_COLD (reclaim first), 2=MADV_PAGEOUT (reclaim now)\n");
+    fprintf(config_file, "# Default: %d\n", FOOTPRINT_RELEASE_MODE);
+    fprintf(config_file, "footprint_release_mode=%d\n\n", FOOTPRINT_RELEASE_MODE);
+    
+    // File I/O section
+    fprintf(config_file, "# FILE I/O\n");
+    fprintf(config_file, "# ========\n");
+    fprintf(config_file, "# Read and write dump files through io_uring with registered buffers\n");
+    fprintf(config_file, "# Falls back to plain pread()/pwrite() if io_uring is unsupported or blocked\n");
+    fprintf(config_file, "# Default: %d (0=disabled, 1=enabled)\n", ENABLE_IO_URING);
+    fprintf(config_file, "enable_io_uring=%d\n\n", ENABLE_IO_URING);
+    fprintf(config_file, "# Preallocate dumps, flush them as they are written and drop them from the page cache\n");
+    fprintf(config_file, "# Keeps the app's own pages cached while hundreds of MB are dumped\n");
+    fprintf(config_file, "# Default: %d (0=disabled, 1=enabled)\n", ENABLE_DUMP_CACHE_DROP);
+    fprintf(config_file, "drop_dump_page_cache=%d\n\n", ENABLE_DUMP_CACHE_DROP);
+    
+    fprintf(config_file, "# Benchmark memory reader backend, scan chunk size and SIMD kernels at startup\n");
+    fprintf(config_file, "# The choice is cached per device next to this file and reused on later starts\n");
+    fprintf(config_file, "# Default: %d (0=disabled, 1=enabled)\n", ENABLE_STARTUP_CALIBRATION);
+    fprintf(config_file, "enable_calibration=%d\n\n", ENABLE_STARTUP_CALIBRATION);
+    
+    fprintf(config_file, "# Accept commands on the abstract UNIX socket @%s.<pid> after the startup scans\n", CONTROL_SOCKET_PREFIX);
+    fprintf(config_file, "# Commands: scan [full|incremental|<start>-<end>], pause, resume, set <key> <value>, stats, flush\n");
+    fprintf(config_file, "# Only the app itself, root and the adb shell may connect\n");
+    fprintf(config_file, "# Default: %d (0=disabled, 1=enabled)\n", ENABLE_CONTROL_CHANNEL);
+    fprintf(config_file, "enable_control_channel=%d\n\n", ENABLE_CONTROL_CHANNEL);
+    
+    fprintf(config_file, "# Reload this file as soon as it is saved, without restarting the app\n");
+    fprintf(config_file, "# New budgets, filters and exclusions apply from the next region scanned\n");
+    fprintf(config_file, "# Default: %d (0=disabled, 1=enabled)\n", ENABLE_CONFIG_HOT_RELOAD);
+    fprintf(config_file, "enable_config_hot_reload=%d\n\n", ENABLE_CONFIG_HOT_RELOAD);
+    
+    fprintf(config_file, "# Share checksums of dumped files with the app's other processes (main, :remote, ...)\n");
+    fprintf(config_file, "# through a table mapped from the output directory, instead of rehashing every dump there\n");
+    fprintf(config_file, "# Default: %d (0=disabled, 1=enabled)\n", ENABLE_SHARED_DEDUP_TABLE);
+    fprintf(config_file, "enable_shared_dedup_table=%d\n\n", ENABLE_SHARED_DEDUP_TABLE);
+    
+    fprintf(config_file, "# Identify dumps of %d KB and more by a BLAKE3 tree hash spread over several cores\n", TREE_HASH_MIN_SIZE / 1024);
+    fprintf(config_file, "# Their SHA1 is only computed when the shared dedup table is unavailable\n");
+    fprintf(config_file, "# Default: %d (0=disabled, 1=enabled)\n", ENABLE_TREE_CONTENT_HASH);
+    fprintf(config_file, "enable_tree_content_hash=%d\n\n", ENABLE_TREE_CONTENT_HASH);
+    
+    fprintf(config_file, "# Compare %d sampled windows of every payload copy with its source afterwards\n", TORN_CHECK_SAMPLE_WINDOWS);
+    fprintf(config_file, "# A copy the app modified meanwhile is retried %d times with backoff, then dumped\n", TORN_COPY_MAX_RETRIES);
+    fprintf(config_file, "# with the torn ranges recorded in its manifest provenance\n");
+    fprintf(config_file, "# Default: %d (0=disabled, 1=enabled)\n", ENABLE_TORN_COPY_CHECK);
+    fprintf(config_file, "enable_torn_copy_check=%d\n\n", ENABLE_TORN_COPY_CHECK);
+    
+    // Detector plugin section
+    fprintf(config_file, "# DETECTOR PLUGINS\n");
+    fprintf(config_file, "# ================\n");
+    fprintf(config_file, "# Directory containing detector plugin libraries (*.so)\n");
+    fprintf(config_file, "# Plugins export dexdumper_get_detectors() as defined in dexdumper_plugin.h\n");
+    fprintf(config_file, "# Their signatures are checked in the same single pass as built-in detectors\n");
+    fprintf(config_file, "# Leave empty to disable plugin loading\n");
+    fprintf(config_file, "detector_plugin_directory=%s\n\n", DETECTOR_PLUGIN_DIRECTORY);
+    
     // DEX exclusions section
     fprintf(config_file, "# DEX FILE EXCLUSIONS\n");
     fprintf(config_file, "# ===================\n");
     fprintf(config_file, "# Add SHA1 hashes of DEX files you want to exclude from dumping\n");
     fprintf(config_file, "# Useful for excluding system DEX files or known false positives\n");
+    fprintf(config_file, "# Dumps of %d KB and more are excluded by the content_id of their manifest record\n", TREE_HASH_MIN_SIZE / 1024);
+    fprintf(config_file, "# instead, so they are never run through SHA1 just for this check\n");
     fprintf(config_file, "# Format: excluded_sha1=40_character_sha1_hash\n");
+    fprintf(config_file, "# Format: excluded_content_id=%d_character_content_id\n", CONTENT_ID_SIZE * 2);
     fprintf(config_file, "# Example: excluded_sha1=da39a3ee5e6b4b0d3255bfef95601890afd80709\n");
     fprintf(config_file, "# Default exclusions (system/empty files):\n");
     
@@ -206,6 +399,22 @@ static void create_default_config(const char* config_path) {
         fprintf(config_file, "output_directory_templates=%s\n", default_templates[i]);
     }
     
+    fprintf(config_file, "\n");
+    
+    // Per-package profiles
+    fprintf(config_file, "# PACKAGE PROFILES\n");
+    fprintf(config_file, "# ================\n");
+    fprintf(config_file, "# Settings above are the base for every app. A [pattern, ...] line starts a\n");
+    fprintf(config_file, "# profile whose settings override the base for packages matching a pattern\n");
+    fprintf(config_file, "# (shell wildcards). Later matching profiles override earlier ones. A list\n");
+    fprintf(config_file, "# (excluded_sha1, excluded_content_id, output_directory_templates) set in a\n");
+    fprintf(config_file, "# profile replaces the inherited list. The resolved settings are cached in a\n");
+    fprintf(config_file, "# .snapshot file next to this one and reused until this file or the library\n");
+    fprintf(config_file, "# changes.\n");
+    fprintf(config_file, "# Example:\n");
+    fprintf(config_file, "# [com.example.game, com.example.game.*]\n");
+    fprintf(config_file, "# thread_initial_delay=20\n");
+    fprintf(config_file, "# max_candidates_per_region=1024\n");
     fprintf(config_file, "\n");
     fprintf(config_file, "# END OF CONFIGURATION FILE\n");
     
@@ -266,7 +475,7 @@ static const char* get_writable_config_path(void) {
     const char* package_name = get_current_package_name();
     char* base_name = get_library_basename();
     const char* config_filename = base_name ? base_name : "dexdumper";
-
+    
     // Possible configuration file locations in order of preference
     const char* config_locations[] = {
         "/data/data/%s/files/%s.conf",                    // App's private storage
@@ -274,9 +483,9 @@ static const char* get_writable_config_path(void) {
         "/storage/emulated/0/Android/data/%s/files/%s.conf", // External app storage
         "/sdcard/Android/data/%s/files/%s.conf"           // Legacy external storage
     };
-
+    
     size_t location_count = sizeof(config_locations) / sizeof(config_locations[0]);
-
+    
     // Try each location until we find one that's writable
     for (size_t i = 0; i < location_count; i++) {
         snprintf(config_path, sizeof(config_path), config_locations[i], package_name, config_filename);
@@ -287,7 +496,7 @@ static const char* get_writable_config_path(void) {
             return config_path;
         }
     }
-
+    
     if (base_name) free(base_name);
     return NULL;
 }
@@ -304,10 +513,10 @@ static const char* get_writable_config_path(void) {
 static const char* get_config_file_path(void) {
     static char config_path[MAX_PATH_LENGTH];
     const char* package_name = get_current_package_name();
-
+    
     char* base_name = get_library_basename();
     const char* config_filename = base_name ? base_name : "dexdumper";
-
+    
     // Possible configuration file locations
     const char* config_locations[] = {
         "/data/data/%s/files/%s.conf",
@@ -315,9 +524,9 @@ static const char* get_config_file_path(void) {
         "/storage/emulated/0/Android/data/%s/files/%s.conf",
         "/sdcard/Android/data/%s/files/%s.conf"
     };
-
+    
     size_t location_count = sizeof(config_locations) / sizeof(config_locations[0]);
-
+    
     // First, check if configuration file already exists
     for (size_t i = 0; i < location_count; i++) {
         snprintf(config_path, sizeof(config_path), config_locations[i], package_name, config_filename);
@@ -330,7 +539,7 @@ static const char* get_config_file_path(void) {
             return config_path;
         }
     }
-
+    
     // No existing config found, create a default one
     const char* writable_path = get_writable_config_path();
     if (writable_path) {
@@ -342,54 +551,332 @@ static const char* get_config_file_path(void) {
         if (base_name) free(base_name);
         return config_path;
     }
-
+    
     if (base_name) free(base_name);
     return NULL;
 }
 
 /**
- * @brief Loads runtime configuration from file
+ * @brief Applies one scalar configuration option
  * 
- * This function parses the configuration file line by line, extracting
- * key-value pairs and updating the runtime configuration accordingly.
- * It handles various configuration options and maintains backward
- * compatibility with default values.
+ * Shared by the configuration file loader and runtime changes made
+ * through the control channel. List options (excluded_sha1,
+ * excluded_content_id, output_directory_templates) are collected by the
+ * loader itself.
+ * 
+ * @param config Snapshot being built, not yet published
+ * @param key Option name
+ * @param value Option value as text
+ * @return 1 if the option is known, 0 otherwise
  */
-static void load_runtime_config(void) {
-    const char* config_path = get_config_file_path();
-    if (!config_path) {
-        LOGI("No configuration file found, using default settings");
-        return;
+static int apply_runtime_option(RuntimeConfig* config, const char* key, const char* value) {
+    if (strcmp(key, "enable_second_scan") == 0) {
+        config->enable_second_scan = atoi(value);
+        LOGI("Runtime config: enable_second_scan = %d", config->enable_second_scan);
+    }
+    else if (strcmp(key, "thread_initial_delay") == 0) {
+        config->thread_initial_delay = atoi(value);
+        LOGI("Runtime config: thread_initial_delay = %d", config->thread_initial_delay);
+    }
+    else if (strcmp(key, "second_scan_delay") == 0) {
+        config->second_scan_delay = atoi(value);
+        LOGI("Runtime config: second_scan_delay = %d", config->second_scan_delay);
+    }
+    else if (strcmp(key, "enable_region_filtering") == 0) {
+        config->enable_region_filtering = atoi(value);
+        LOGI("Runtime config: enable_region_filtering = %d", config->enable_region_filtering);
+    }
+    else if (strcmp(key, "max_candidates_per_region") == 0) {
+        config->max_candidates_per_region = atoi(value);
+        LOGI("Runtime config: max_candidates_per_region = %d", config->max_candidates_per_region);
+    }
+    else if (strcmp(key, "max_validations_per_region") == 0) {
+        config->max_validations_per_region = atoi(value);
+        LOGI("Runtime config: max_validations_per_region = %d", config->max_validations_per_region);
+    }
+    else if (strcmp(key, "max_faults_per_region") == 0) {
+        config->max_faults_per_region = atoi(value);
+        LOGI("Runtime config: max_faults_per_region = %d", config->max_faults_per_region);
+    }
+    else if (strcmp(key, "enable_elf_dumping") == 0) {
+        config->enable_elf_dumping = atoi(value);
+        LOGI("Runtime config: enable_elf_dumping = %d", config->enable_elf_dumping);
+    }
+    else if (strcmp(key, "rebuild_elf_sections") == 0) {
+        config->rebuild_elf_sections = atoi(value);
+        LOGI("Runtime config: rebuild_elf_sections = %d", config->rebuild_elf_sections);
+    }
+    else if (strcmp(key, "enable_art_heap_walk") == 0) {
+        config->enable_art_heap_walk = atoi(value);
+        LOGI("Runtime config: enable_art_heap_walk = %d", config->enable_art_heap_walk);
+    }
+    else if (strcmp(key, "enable_pointer_discovery") == 0) {
+        config->enable_pointer_discovery = atoi(value);
+        LOGI("Runtime config: enable_pointer_discovery = %d", config->enable_pointer_discovery);
+    }
+    else if (strcmp(key, "enable_protected_region_reads") == 0) {
+        config->enable_protected_region_reads = atoi(value);
+        LOGI("Runtime config: enable_protected_region_reads = %d", config->enable_protected_region_reads);
+    }
+    else if (strcmp(key, "footprint_release_mode") == 0) {
+        config->footprint_release_mode = atoi(value);
+        LOGI("Runtime config: footprint_release_mode = %d", config->footprint_release_mode);
+    }
+    else if (strcmp(key, "enable_io_uring") == 0) {
+        config->enable_io_uring = atoi(value);
+        LOGI("Runtime config: enable_io_uring = %d", config->enable_io_uring);
+    }
+    else if (strcmp(key, "drop_dump_page_cache") == 0) {
+        config->drop_dump_page_cache = atoi(value);
+        LOGI("Runtime config: drop_dump_page_cache = %d", config->drop_dump_page_cache);
+    }
+    else if (strcmp(key, "enable_calibration") == 0) {
+        config->enable_calibration = atoi(value);
+        LOGI("Runtime config: enable_calibration = %d", config->enable_calibration);
+    }
+    else if (strcmp(key, "enable_control_channel") == 0) {
+        config->enable_control_channel = atoi(value);
+        LOGI("Runtime config: enable_control_channel = %d", config->enable_control_channel);
+    }
+    else if (strcmp(key, "enable_config_hot_reload") == 0) {
+        config->enable_config_hot_reload = atoi(value);
+        LOGI("Runtime config: enable_config_hot_reload = %d", config->enable_config_hot_reload);
+    }
+    else if (strcmp(key, "enable_shared_dedup_table") == 0) {
+        config->enable_shared_dedup_table = atoi(value);
+        LOGI("Runtime config: enable_shared_dedup_table = %d", config->enable_shared_dedup_table);
+    }
+    else if (strcmp(key, "enable_tree_content_hash") == 0) {
+        config->enable_tree_content_hash = atoi(value);
+        LOGI("Runtime config: enable_tree_content_hash = %d", config->enable_tree_content_hash);
+    }
+    else if (strcmp(key, "enable_torn_copy_check") == 0) {
+        config->enable_torn_copy_check = atoi(value);
+        LOGI("Runtime config: enable_torn_copy_check = %d", config->enable_torn_copy_check);
+    }
+    else if (strcmp(key, "detector_plugin_directory") == 0) {
+        free(config->detector_plugin_directory);
+        config->detector_plugin_directory = strdup(value);
+        LOGI("Runtime config: detector_plugin_directory = %s", value);
+    }
+    else {
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief Fills a snapshot with the compile-time defaults of config.h
+ * 
+ * @param config Snapshot to initialize
+ */
+static void set_default_config(RuntimeConfig* config) {
+    memset(config, 0, sizeof(*config));
+    config->enable_second_scan = ENABLE_SECOND_SCAN;
+    config->thread_initial_delay = THREAD_INITIAL_DELAY;
+    config->second_scan_delay = SECOND_SCAN_DELAY;
+    config->enable_region_filtering = ENABLE_REGION_FILTERING;
+    config->max_candidates_per_region = MAX_CANDIDATES_PER_REGION;
+    config->max_validations_per_region = MAX_VALIDATIONS_PER_REGION;
+    config->max_faults_per_region = MAX_FAULTS_PER_REGION;
+    config->enable_elf_dumping = ENABLE_ELF_DUMPING;
+    config->rebuild_elf_sections = REBUILD_ELF_SECTIONS;
+    config->enable_art_heap_walk = ENABLE_ART_HEAP_WALK;
+    config->enable_pointer_discovery = ENABLE_POINTER_DISCOVERY;
+    config->enable_protected_region_reads = ENABLE_PROTECTED_REGION_READS;
+    config->footprint_release_mode = FOOTPRINT_RELEASE_MODE;
+    config->enable_io_uring = ENABLE_IO_URING;
+    config->drop_dump_page_cache = ENABLE_DUMP_CACHE_DROP;
+    config->enable_calibration = ENABLE_STARTUP_CALIBRATION;
+    config->enable_control_channel = ENABLE_CONTROL_CHANNEL;
+    config->enable_config_hot_reload = ENABLE_CONFIG_HOT_RELOAD;
+    config->enable_shared_dedup_table = ENABLE_SHARED_DEDUP_TABLE;
+    config->enable_tree_content_hash = ENABLE_TREE_CONTENT_HASH;
+    config->enable_torn_copy_check = ENABLE_TORN_COPY_CHECK;
+    config->detector_plugin_directory = NULL;
+    config->excluded_sha1_list = NULL;
+    config->excluded_sha1_count = 0;
+    config->excluded_content_id_list = NULL;
+    config->excluded_content_id_count = 0;
+    config->output_directory_templates = NULL;
+    config->output_directory_count = 0;
+    config->config_loaded = 0;
+}
+
+/**
+ * @brief Frees a list of strings and the strings in it
+ */
+static void free_string_list(char** strings, int count) {
+    if (!strings) return;
+    for (int i = 0; i < count; i++) {
+        free(strings[i]);
+    }
+    free(strings);
+}
+
+/**
+ * @brief Frees a snapshot and everything it owns
+ */
+static void free_runtime_config(RuntimeConfig* config) {
+    if (!config) return;
+    free_string_list(config->excluded_sha1_list, config->excluded_sha1_count);
+    free_string_list(config->excluded_content_id_list, config->excluded_content_id_count);
+    free_string_list(config->output_directory_templates, config->output_directory_count);
+    free(config->detector_plugin_directory);
+    free(config);
+}
+
+/**
+ * @brief Appends a copy of a string to a growable list
+ * 
+ * @param strings List to grow (NULL when empty)
+ * @param count Number of strings in the list
+ * @param capacity Entries allocated in the list
+ * @param value String to copy
+ * @return 1 on success, 0 if memory ran out
+ */
+static int append_string_list(char*** strings, int* count, int* capacity, const char* value) {
+    if (*count == *capacity) {
+        int new_capacity = *capacity ? *capacity * 2 : 16;
+        char** grown = realloc(*strings, (size_t)new_capacity * sizeof(char*));
+        if (!grown) return 0;
+        *strings = grown;
+        *capacity = new_capacity;
+    }
+    char* copy = strdup(value);
+    if (!copy) return 0;
+    (*strings)[(*count)++] = copy;
+    return 1;
+}
+
+/**
+ * @brief Makes a private copy of a snapshot that can be changed before publishing
+ * 
+ * @param config Snapshot to copy
+ * @return New snapshot, NULL if memory ran out
+ */
+static RuntimeConfig* copy_runtime_config(const RuntimeConfig* config) {
+    RuntimeConfig* copy = malloc(sizeof(*copy));
+    if (!copy) return NULL;
+    *copy = *config;
+    copy->detector_plugin_directory = NULL;
+    copy->excluded_sha1_list = NULL;
+    copy->excluded_sha1_count = 0;
+    copy->excluded_content_id_list = NULL;
+    copy->excluded_content_id_count = 0;
+    copy->output_directory_templates = NULL;
+    copy->output_directory_count = 0;
+    
+    int excluded_capacity = 0, content_id_capacity = 0, template_capacity = 0;
+    int copied = 1;
+    if (config->detector_plugin_directory) {
+        copy->detector_plugin_directory = strdup(config->detector_plugin_directory);
+        copied = copy->detector_plugin_directory != NULL;
+    }
+    for (int i = 0; copied && i < config->excluded_sha1_count; i++) {
+        copied = append_string_list(&copy->excluded_sha1_list, &copy->excluded_sha1_count,
+                                    &excluded_capacity, config->excluded_sha1_list[i]);
+    }
+    for (int i = 0; copied && i < config->excluded_content_id_count; i++) {
+        copied = append_string_list(&copy->excluded_content_id_list, &copy->excluded_content_id_count,
+                                    &content_id_capacity, config->excluded_content_id_list[i]);
+    }
+    for (int i = 0; copied && i < config->output_directory_count; i++) {
+        copied = append_string_list(&copy->output_directory_templates, &copy->output_directory_count,
+                                    &template_capacity, config->output_directory_templates[i]);
     }
     
+    if (!copied) {
+        free_runtime_config(copy);
+        return NULL;
+    }
+    return copy;
+}
+
+/**
+ * @brief Checks whether a profile header applies to a package
+ * 
+ * @param profile_header Line of the form "[pattern, pattern, ...]"
+ * @param package_name Package of this process
+ * @return 1 if a pattern matches the package, 0 otherwise
+ */
+static int is_profile_for_package(const char* profile_header, const char* package_name) {
+    char patterns[MAX_PATH_LENGTH];
+    snprintf(patterns, sizeof(patterns), "%s", profile_header + 1);
+    char* closing_bracket = strchr(patterns, ']');
+    if (!closing_bracket) return 0;
+    *closing_bracket = '\0';
+    
+    char* parse_state = NULL;
+    for (char* pattern = strtok_r(patterns, ", \t", &parse_state); pattern != NULL;
+         pattern = strtok_r(NULL, ", \t", &parse_state)) {
+        if (fnmatch(pattern, package_name, 0) == 0) return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Loads runtime configuration from file
+ * 
+ * This function parses the configuration file line by line, extracting
+ * key-value pairs into a new snapshot that starts from the compile-time
+ * defaults. Settings before the first profile header are the base;
+ * settings of a profile apply only if it matches this package. Lines
+ * and lists may be of any length.
+ * 
+ * @param config_path Configuration file to parse
+ * @return New snapshot, NULL if the file cannot be read
+ */
+static RuntimeConfig* load_runtime_config(const char* config_path) {
     FILE* config_file = fopen(config_path, "r");
     if (!config_file) {
         LOGW("Failed to open configuration file: %s", config_path);
-        return;
+        return NULL;
     }
     
+    RuntimeConfig* config = malloc(sizeof(*config));
+    if (!config) {
+        fclose(config_file);
+        return NULL;
+    }
+    set_default_config(config);
+    
     LOGI("Loading runtime configuration from: %s", config_path);
     
-    char line[256];
+    const char* package_name = get_current_package_name();
+    char* line = NULL;
+    size_t line_capacity = 0;
     int line_number = 0;
+    int excluded_capacity = 0;
+    int content_id_capacity = 0;
+    int template_capacity = 0;
     
-    // Temporary storage for configuration arrays
-    char* excluded_sha1_temp[100] = {0};
-    int excluded_count = 0;
-    
-    char* output_templates_temp[100] = {0};
-    int output_template_count = 0;
+    // Section being read (0 = base) and the section each list was last set in
+    int profile_index = 0;
+    int profile_applies = 1;
+    int excluded_owner = 0;
+    int content_id_owner = 0;
+    int template_owner = 0;
     
     // Read configuration file line by line
-    while (fgets(line, sizeof(line), config_file)) {
+    while (getline(&line, &line_capacity, config_file) != -1) {
         line_number++;
         
         // Remove newline character
-        line[strcspn(line, "\n")] = 0;
+        line[strcspn(line, "\r\n")] = 0;
         
         // Skip empty lines and comments
         if (line[0] == '\0' || line[0] == '#') continue;
         
+        // A profile header starts the settings of matching packages
+        if (line[0] == '[') {
+            profile_index++;
+            profile_applies = is_profile_for_package(line, package_name);
+            if (profile_applies) LOGI("Runtime config: applying profile %s", line);
+            continue;
+        }
+        if (!profile_applies) continue;
+        
         // Split line into key and value
         char* equals = strchr(line, '=');
         if (!equals) {
@@ -406,71 +893,463 @@ static void load_runtime_config(void) {
         while (*value == ' ') value++;
         
         // Process different configuration keys
-        if (strcmp(key, "enable_second_scan") == 0) {
-            g_runtime_config.enable_second_scan = atoi(value);
-            LOGI("Runtime config: enable_second_scan = %d", g_runtime_config.enable_second_scan);
-        }
-        else if (strcmp(key, "thread_initial_delay") == 0) {
-            g_runtime_config.thread_initial_delay = atoi(value);
-            LOGI("Runtime config: thread_initial_delay = %d", g_runtime_config.thread_initial_delay);
-        }
-        else if (strcmp(key, "second_scan_delay") == 0) {
-            g_runtime_config.second_scan_delay = atoi(value);
-            LOGI("Runtime config: second_scan_delay = %d", g_runtime_config.second_scan_delay);
-        }
-        else if (strcmp(key, "enable_region_filtering") == 0) {
-            g_runtime_config.enable_region_filtering = atoi(value);
-            LOGI("Runtime config: enable_region_filtering = %d", g_runtime_config.enable_region_filtering);
-        }
-        else if (strcmp(key, "excluded_sha1") == 0 && strlen(value) == 40) {
+        if (apply_runtime_option(config, key, value)) continue;
+        
+        if (strcmp(key, "excluded_sha1") == 0 && strlen(value) == 40) {
+            // A profile's list replaces the inherited one instead of extending it
+            if (excluded_owner != profile_index) {
+                free_string_list(config->excluded_sha1_list, config->excluded_sha1_count);
+                config->excluded_sha1_list = NULL;
+                config->excluded_sha1_count = 0;
+                excluded_capacity = 0;
+                excluded_owner = profile_index;
+            }
             // Validate SHA1 length (40 hex characters)
-            if (excluded_count < 100) {
-                excluded_sha1_temp[excluded_count] = strdup(value);
-                if (excluded_sha1_temp[excluded_count]) {
-                    excluded_count++;
-                    LOGI("Runtime config: added excluded SHA1: %s", value);
-                }
+            if (append_string_list(&config->excluded_sha1_list, &config->excluded_sha1_count,
+                                   &excluded_capacity, value)) {
+                LOGI("Runtime config: added excluded SHA1: %s", value);
+            }
+        }
+        else if (strcmp(key, "excluded_content_id") == 0 && strlen(value) == CONTENT_ID_SIZE * 2) {
+            if (content_id_owner != profile_index) {
+                free_string_list(config->excluded_content_id_list, config->excluded_content_id_count);
+                config->excluded_content_id_list = NULL;
+                config->excluded_content_id_count = 0;
+                content_id_capacity = 0;
+                content_id_owner = profile_index;
+            }
+            if (append_string_list(&config->excluded_content_id_list, &config->excluded_content_id_count,
+                                   &content_id_capacity, value)) {
+                LOGI("Runtime config: added excluded content ID: %s", value);
             }
         }
         else if (strcmp(key, "output_directory_templates") == 0) {
-            if (output_template_count < 100) {
-                output_templates_temp[output_template_count] = strdup(value);
-                if (output_templates_temp[output_template_count]) {
-                    output_template_count++;
-                    LOGI("Runtime config: added output template: %s", value);
-                }
+            if (template_owner != profile_index) {
+                free_string_list(config->output_directory_templates, config->output_directory_count);
+                config->output_directory_templates = NULL;
+                config->output_directory_count = 0;
+                template_capacity = 0;
+                template_owner = profile_index;
+            }
+            if (append_string_list(&config->output_directory_templates, &config->output_directory_count,
+                                   &template_capacity, value)) {
+                LOGI("Runtime config: added output template: %s", value);
             }
         }
     }
     
+    free(line);
     fclose(config_file);
     
-    // Store excluded SHA1 list in global configuration
-    if (excluded_count > 0) {
-        g_runtime_config.excluded_sha1_list = malloc(excluded_count * sizeof(char*));
-        if (g_runtime_config.excluded_sha1_list) {
-            for (int i = 0; i < excluded_count; i++) {
-                g_runtime_config.excluded_sha1_list[i] = excluded_sha1_temp[i];
-            }
-            g_runtime_config.excluded_sha1_count = excluded_count;
-            LOGI("Runtime config: loaded %d excluded SHA1 entries", excluded_count);
+    if (config->excluded_sha1_count > 0) {
+        LOGI("Runtime config: loaded %d excluded SHA1 entries", config->excluded_sha1_count);
+    }
+    if (config->excluded_content_id_count > 0) {
+        LOGI("Runtime config: loaded %d excluded content ID entries", config->excluded_content_id_count);
+    }
+    if (config->output_directory_count > 0) {
+        LOGI("Runtime config: loaded %d output directory templates", config->output_directory_count);
+    }
+    
+    config->config_loaded = 1;
+    LOGI("Runtime configuration loaded successfully");
+    return config;
+}
+
+/**
+ * @brief Derives the snapshot cache path from the configuration file path
+ * 
+ * @param snapshot_path Output buffer of MAX_PATH_LENGTH bytes
+ * @return 1 on success, 0 if no configuration file is in use
+ */
+static int get_config_snapshot_path(char* snapshot_path) {
+    if (!config_file_path[0]) return 0;
+    
+    const char* file_name = strrchr(config_file_path, '/');
+    const char* extension = strrchr(file_name ? file_name : config_file_path, '.');
+    size_t stem_length = extension ? (size_t)(extension - config_file_path) : strlen(config_file_path);
+    return snprintf(snapshot_path, MAX_PATH_LENGTH, "%.*s.snapshot", (int)stem_length, config_file_path) < MAX_PATH_LENGTH;
+}
+
+/**
+ * @brief Folds a string into an FNV-1a hash
+ */
+static uint64_t hash_snapshot_text(uint64_t hash, const char* text) {
+    for (; *text; text++) {
+        hash ^= (uint8_t)*text;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/**
+ * @brief Folds a block of bytes into an FNV-1a hash
+ */
+static uint64_t hash_snapshot_bytes(uint64_t hash, const uint8_t* bytes, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/**
+ * @brief Folds a file's identity (inode, size, modification time) into an FNV-1a hash
+ */
+static uint64_t hash_file_identity(uint64_t hash, const char* path) {
+    struct stat file_status;
+    char identity_text[128];
+    if (stat(path, &file_status) == 0) {
+        snprintf(identity_text, sizeof(identity_text), "%llu:%llu:%lld:%ld.%ld;",
+                 (unsigned long long)file_status.st_dev, (unsigned long long)file_status.st_ino,
+                 (long long)file_status.st_size, (long)file_status.st_mtim.tv_sec, (long)file_status.st_mtim.tv_nsec);
+    } else {
+        snprintf(identity_text, sizeof(identity_text), "missing;");
+    }
+    return hash_snapshot_text(hash, identity_text);
+}
+
+/**
+ * @brief Computes the fingerprint a cached snapshot is only valid for
+ * 
+ * Covers the configuration file, the library file (a new build may lay
+ * out RuntimeConfig differently; for a library loaded straight from the
+ * APK the APK counts), the package the profiles were resolved for and
+ * the snapshot format version.
+ */
+static uint64_t compute_config_source_fingerprint(void) {
+    uint64_t hash = hash_file_identity(14695981039346656037ULL, config_file_path);
+    
+    Dl_info info;
+    if (dladdr((void*)compute_config_source_fingerprint, &info) != 0 && info.dli_fname) {
+        char library_path[MAX_PATH_LENGTH];
+        snprintf(library_path, sizeof(library_path), "%s", info.dli_fname);
+        char* apk_separator = strstr(library_path, "!/");
+        if (apk_separator) *apk_separator = '\0';
+        hash = hash_file_identity(hash, library_path);
+    }
+    
+    char build_text[MAX_PACKAGE_NAME_LENGTH + 64];
+    snprintf(build_text, sizeof(build_text), "%s version=%d size=%zu",
+             get_current_package_name(), CONFIG_SNAPSHOT_VERSION, sizeof(RuntimeConfig));
+    return hash_snapshot_text(hash, build_text);
+}
+
+// Snapshot file being written, with the checksum of the payload written so far
+typedef struct {
+    FILE* file;
+    uint64_t payload_checksum;
+} SnapshotWriter;
+
+/**
+ * @brief Appends bytes to the snapshot payload
+ */
+static void write_snapshot_bytes(SnapshotWriter* writer, const void* bytes, size_t size) {
+    fwrite(bytes, 1, size, writer->file);
+    writer->payload_checksum = hash_snapshot_bytes(writer->payload_checksum, bytes, size);
+}
+
+/**
+ * @brief Appends a length-prefixed string to the snapshot payload (NULL is stored as length 0)
+ */
+static void write_snapshot_string(SnapshotWriter* writer, const char* text) {
+    uint32_t stored_length = text ? (uint32_t)strlen(text) + 1 : 0;
+    write_snapshot_bytes(writer, &stored_length, sizeof(stored_length));
+    if (stored_length > 1) write_snapshot_bytes(writer, text, stored_length - 1);
+}
+
+/**
+ * @brief Stores a resolved configuration for later starts
+ * 
+ * Written to a temporary file and renamed, so a start that races with
+ * the write sees either the old snapshot or the new one.
+ * 
+ * @param config Snapshot resolved from the configuration file
+ * @param source_fingerprint Fingerprint of the sources it was resolved from
+ */
+static void save_config_snapshot(const RuntimeConfig* config, uint64_t source_fingerprint) {
+    char snapshot_path[MAX_PATH_LENGTH];
+    char temporary_path[MAX_PATH_LENGTH + 8];
+    if (!get_config_snapshot_path(snapshot_path)) return;
+    snprintf(temporary_path, sizeof(temporary_path), "%s.tmp", snapshot_path);
+    
+    FILE* snapshot_file = fopen(temporary_path, "wb");
+    if (!snapshot_file) {
+        LOGW("Failed to write configuration snapshot %s: %s", temporary_path, strerror(errno));
+        return;
+    }
+    
+    // The header is written again once the payload checksum is known
+    ConfigSnapshotHeader header = {
+        .magic = CONFIG_SNAPSHOT_MAGIC,
+        .scalar_block_size = (uint32_t)RUNTIME_CONFIG_SCALAR_SIZE,
+        .source_fingerprint = source_fingerprint
+    };
+    fwrite(&header, sizeof(header), 1, snapshot_file);
+    
+    SnapshotWriter writer = { snapshot_file, 14695981039346656037ULL };
+    write_snapshot_bytes(&writer, config, RUNTIME_CONFIG_SCALAR_SIZE);
+    write_snapshot_string(&writer, config->detector_plugin_directory);
+    uint32_t list_count = (uint32_t)config->excluded_sha1_count;
+    write_snapshot_bytes(&writer, &list_count, sizeof(list_count));
+    for (int i = 0; i < config->excluded_sha1_count; i++) {
+        write_snapshot_string(&writer, config->excluded_sha1_list[i]);
+    }
+    list_count = (uint32_t)config->excluded_content_id_count;
+    write_snapshot_bytes(&writer, &list_count, sizeof(list_count));
+    for (int i = 0; i < config->excluded_content_id_count; i++) {
+        write_snapshot_string(&writer, config->excluded_content_id_list[i]);
+    }
+    list_count = (uint32_t)config->output_directory_count;
+    write_snapshot_bytes(&writer, &list_count, sizeof(list_count));
+    for (int i = 0; i < config->output_directory_count; i++) {
+        write_snapshot_string(&writer, config->output_directory_templates[i]);
+    }
+    
+    header.payload_checksum = writer.payload_checksum;
+    if (fseek(snapshot_file, 0, SEEK_SET) == 0) {
+        fwrite(&header, sizeof(header), 1, snapshot_file);
+    }
+    
+    int write_failed = ferror(snapshot_file);
+    if (fclose(snapshot_file) != 0 || write_failed || rename(temporary_path, snapshot_path) != 0) {
+        LOGW("Failed to write configuration snapshot %s", snapshot_path);
+        unlink(temporary_path);
+    }
+}
+
+// Read cursor over a snapshot file loaded into memory
+typedef struct {
+    const uint8_t* data;
+    size_t size;
+    size_t offset;
+} SnapshotReader;
+
+/**
+ * @brief Reads a 32-bit value from a snapshot
+ * 
+ * @return 1 on success, 0 if the snapshot is truncated
+ */
+static int read_snapshot_uint32(SnapshotReader* reader, uint32_t* value) {
+    if (reader->size - reader->offset < sizeof(*value)) return 0;
+    memcpy(value, reader->data + reader->offset, sizeof(*value));
+    reader->offset += sizeof(*value);
+    return 1;
+}
+
+/**
+ * @brief Reads a length-prefixed string from a snapshot
+ * 
+ * @param reader Snapshot being read
+ * @param text Output copy (NULL for a stored NULL), to be freed by the caller
+ * @return 1 on success, 0 if the snapshot is truncated or memory ran out
+ */
+static int read_snapshot_string(SnapshotReader* reader, char** text) {
+    uint32_t stored_length = 0;
+    *text = NULL;
+    if (!read_snapshot_uint32(reader, &stored_length)) return 0;
+    if (stored_length == 0) return 1;
+    if (reader->size - reader->offset < stored_length - 1) return 0;
+    
+    *text = malloc(stored_length);
+    if (!*text) return 0;
+    memcpy(*text, reader->data + reader->offset, stored_length - 1);
+    (*text)[stored_length - 1] = '\0';
+    reader->offset += stored_length - 1;
+    return 1;
+}
+
+/**
+ * @brief Reads a list of strings from a snapshot
+ * 
+ * @return 1 on success, 0 if the snapshot is malformed or memory ran out
+ */
+static int read_snapshot_string_list(SnapshotReader* reader, char*** strings, int* count) {
+    uint32_t list_count = 0;
+    if (!read_snapshot_uint32(reader, &list_count)) return 0;
+    // Every entry takes at least its length prefix
+    if (list_count > (reader->size - reader->offset) / sizeof(uint32_t)) return 0;
+    if (list_count == 0) return 1;
+    
+    *strings = calloc(list_count, sizeof(char*));
+    if (!*strings) return 0;
+    for (uint32_t i = 0; i < list_count; i++) {
+        char* text = NULL;
+        if (!read_snapshot_string(reader, &text) || text == NULL) {
+            free(text);
+            return 0;
         }
+        (*strings)[(*count)++] = text;
     }
+    return 1;
+}
+
+/**
+ * @brief Loads the cached snapshot if it was resolved from the current sources
+ * 
+ * @param source_fingerprint Fingerprint of the configuration file, library and package
+ * @return New snapshot, NULL if there is no valid cached snapshot
+ */
+static RuntimeConfig* load_config_snapshot(uint64_t source_fingerprint) {
+    char snapshot_path[MAX_PATH_LENGTH];
+    if (!get_config_snapshot_path(snapshot_path)) return NULL;
     
-    // Store output directory templates in global configuration
-    if (output_template_count > 0) {
-        g_runtime_config.output_directory_templates = malloc(output_template_count * sizeof(char*));
-        if (g_runtime_config.output_directory_templates) {
-            for (int i = 0; i < output_template_count; i++) {
-                g_runtime_config.output_directory_templates[i] = output_templates_temp[i];
-            }
-            g_runtime_config.output_directory_count = output_template_count;
-            LOGI("Runtime config: loaded %d output directory templates", output_template_count);
+    int snapshot_fd = open(snapshot_path, O_RDONLY | O_CLOEXEC);
+    if (snapshot_fd < 0) return NULL;
+    
+    struct stat snapshot_status;
+    uint8_t* snapshot_data = NULL;
+    size_t snapshot_size = 0;
+    if (fstat(snapshot_fd, &snapshot_status) == 0 && snapshot_status.st_size >= (off_t)sizeof(ConfigSnapshotHeader) &&
+        snapshot_status.st_size <= 16 * 1024 * 1024) {
+        snapshot_size = (size_t)snapshot_status.st_size;
+        snapshot_data = malloc(snapshot_size);
+        if (snapshot_data && read(snapshot_fd, snapshot_data, snapshot_size) != (ssize_t)snapshot_size) {
+            free(snapshot_data);
+            snapshot_data = NULL;
         }
     }
+    close(snapshot_fd);
+    if (!snapshot_data) return NULL;
     
-    g_runtime_config.config_loaded = 1;
-    LOGI("Runtime configuration loaded successfully");
+    ConfigSnapshotHeader header;
+    memcpy(&header, snapshot_data, sizeof(header));
+    if (header.magic != CONFIG_SNAPSHOT_MAGIC || header.scalar_block_size != RUNTIME_CONFIG_SCALAR_SIZE ||
+        header.source_fingerprint != source_fingerprint) {
+        LOGI("Configuration snapshot %s is out of date, parsing the configuration file", snapshot_path);
+        free(snapshot_data);
+        return NULL;
+    }
+    if (snapshot_size - sizeof(header) < RUNTIME_CONFIG_SCALAR_SIZE ||
+        hash_snapshot_bytes(14695981039346656037ULL, snapshot_data + sizeof(header),
+                            snapshot_size - sizeof(header)) != header.payload_checksum) {
+        LOGW("Ignoring malformed configuration snapshot %s", snapshot_path);
+        free(snapshot_data);
+        return NULL;
+    }
+    
+    RuntimeConfig* config = malloc(sizeof(*config));
+    if (!config) {
+        free(snapshot_data);
+        return NULL;
+    }
+    set_default_config(config);
+    memcpy(config, snapshot_data + sizeof(header), RUNTIME_CONFIG_SCALAR_SIZE);
+    
+    SnapshotReader reader = { snapshot_data, snapshot_size, sizeof(header) + RUNTIME_CONFIG_SCALAR_SIZE };
+    int loaded = read_snapshot_string(&reader, &config->detector_plugin_directory) &&
+                 read_snapshot_string_list(&reader, &config->excluded_sha1_list, &config->excluded_sha1_count) &&
+                 read_snapshot_string_list(&reader, &config->excluded_content_id_list,
+                                           &config->excluded_content_id_count) &&
+                 read_snapshot_string_list(&reader, &config->output_directory_templates, &config->output_directory_count) &&
+                 reader.offset == reader.size;
+    free(snapshot_data);
+    if (!loaded) {
+        LOGW("Ignoring malformed configuration snapshot %s", snapshot_path);
+        free_runtime_config(config);
+        return NULL;
+    }
+    
+    config->config_loaded = 1;
+    return config;
+}
+
+/**
+ * @brief Resolves the configuration file, from its cached snapshot when it is current
+ * 
+ * @param config_path Configuration file to resolve
+ * @return New snapshot, NULL if the file cannot be read
+ */
+static RuntimeConfig* load_resolved_config(const char* config_path) {
+    uint64_t source_fingerprint = compute_config_source_fingerprint();
+    RuntimeConfig* config = load_config_snapshot(source_fingerprint);
+    if (config) {
+        LOGI("Loaded resolved configuration snapshot of %s", config_path);
+        return config;
+    }
+    
+    config = load_runtime_config(config_path);
+    if (config) save_config_snapshot(config, source_fingerprint);
+    return config;
+}
+
+/**
+ * @brief Makes a snapshot the current configuration
+ * 
+ * The caller must hold config_write_mutex. The replaced snapshot is
+ * retired until release_retired_config_snapshots().
+ * 
+ * @param config Snapshot to publish, owned by the configuration manager afterwards
+ */
+static void publish_runtime_config(RuntimeConfig* config) {
+    RuntimeConfig* previous = __atomic_exchange_n(&g_runtime_config, config, __ATOMIC_ACQ_REL);
+    if (!previous) return;
+    
+    RuntimeConfig** grown = realloc(retired_snapshots, (size_t)(retired_snapshot_count + 1) * sizeof(RuntimeConfig*));
+    if (!grown) {
+        // Leaking is safer than freeing a snapshot a scan may still read
+        LOGW("Cannot retire previous configuration snapshot");
+        return;
+    }
+    retired_snapshots = grown;
+    retired_snapshots[retired_snapshot_count++] = previous;
+}
+
+/**
+ * @brief Rereads the configuration file and publishes it as a new snapshot
+ * 
+ * Options changed through set_runtime_config_option() are replaced by
+ * the file's values. A file that cannot be read keeps the current
+ * configuration.
+ */
+static void reload_runtime_config(void) {
+    pthread_mutex_lock(&config_write_mutex);
+    RuntimeConfig* config = config_file_path[0] ? load_resolved_config(config_file_path) : NULL;
+    if (config) {
+        publish_runtime_config(config);
+        LOGI("Configuration reloaded from %s", config_file_path);
+    }
+    pthread_mutex_unlock(&config_write_mutex);
+}
+
+/**
+ * @brief Reloads the configuration whenever its file is written or replaced
+ * 
+ * @param thread_argument Name of the configuration file in the watched directory (freed on exit)
+ * @return NULL
+ */
+static void* config_watcher_thread(void* thread_argument) {
+    char* config_name = thread_argument;
+    char event_buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    
+    while (!config_watcher_stopping) {
+        ssize_t bytes_read = read(config_watch_fd, event_buffer, sizeof(event_buffer));
+        if (bytes_read < 0 && errno == EINTR) continue;
+        if (bytes_read <= 0) break;
+        
+        // Several events of one save are folded into one reload
+        int config_changed = 0;
+        for (char* cursor = event_buffer; cursor < event_buffer + bytes_read; ) {
+            const struct inotify_event* event = (const struct inotify_event*)cursor;
+            if (event->len > 0 && strcmp(event->name, config_name) == 0) config_changed = 1;
+            cursor += sizeof(struct inotify_event) + event->len;
+        }
+        if (!config_changed || config_watcher_stopping) continue;
+        
+        reload_runtime_config();
+        if (!current_config()->enable_config_hot_reload) {
+            LOGI("Configuration hot reload disabled by the reloaded file");
+            break;
+        }
+    }
+    
+    pthread_mutex_lock(&config_write_mutex);
+    close(config_watch_fd);
+    config_watch_fd = -1;
+    config_watch_descriptor = -1;
+    pthread_mutex_unlock(&config_write_mutex);
+    free(config_name);
+    return NULL;
 }
 
 /**
@@ -479,52 +1358,123 @@ static void load_runtime_config(void) {
  * This function sets up the configuration system by:
  * 1. Setting default values from compile-time configuration
  * 2. Attempting to load runtime configuration from file
- * 3. Setting up the global configuration structure
+ * 3. Publishing the result as the first configuration snapshot
  * 
  * It should be called early in the application lifecycle.
  */
 void init_config_manager(void) {
-    // Initialize with default values from config.h
-    g_runtime_config.enable_second_scan = ENABLE_SECOND_SCAN;
-    g_runtime_config.thread_initial_delay = THREAD_INITIAL_DELAY;
-    g_runtime_config.second_scan_delay = SECOND_SCAN_DELAY;
-    g_runtime_config.enable_region_filtering = ENABLE_REGION_FILTERING;
-    g_runtime_config.excluded_sha1_list = NULL;
-    g_runtime_config.excluded_sha1_count = 0;
-    g_runtime_config.output_directory_templates = NULL;
-    g_runtime_config.output_directory_count = 0;
-    g_runtime_config.config_loaded = 0;
+    pthread_mutex_lock(&config_write_mutex);
     
     // Attempt to load configuration from file
-    load_runtime_config();
+    RuntimeConfig* config = NULL;
+    const char* config_path = get_config_file_path();
+    if (config_path) {
+        snprintf(config_file_path, sizeof(config_file_path), "%s", config_path);
+        config = load_resolved_config(config_path);
+    } else {
+        LOGI("No configuration file found, using default settings");
+    }
+    
+    // Fall back to the default values from config.h
+    if (!config) {
+        config = malloc(sizeof(*config));
+        if (config) set_default_config(config);
+    }
+    if (config) publish_runtime_config(config);
+    
+    pthread_mutex_unlock(&config_write_mutex);
+}
+
+/**
+ * @brief Starts watching the configuration file for changes
+ * 
+ * The directory of the file is watched rather than the file itself,
+ * because editors often save by writing a new file and renaming it over
+ * the old one.
+ * 
+ * @return int 1 if the file is watched, 0 if hot reload is disabled or unavailable
+ */
+int start_config_watcher(void) {
+    if (config_watch_fd >= 0) return 1;
+    if (!current_config()->enable_config_hot_reload || !config_file_path[0]) return 0;
+    
+    char config_directory[MAX_PATH_LENGTH];
+    snprintf(config_directory, sizeof(config_directory), "%s", config_file_path);
+    char* last_slash = strrchr(config_directory, '/');
+    if (!last_slash) return 0;
+    *last_slash = '\0';
+    char* config_name = strdup(last_slash + 1);
+    if (!config_name) return 0;
+    
+    int watch_fd = inotify_init1(IN_CLOEXEC);
+    int watch_descriptor = watch_fd >= 0 ?
+                           inotify_add_watch(watch_fd, config_directory, IN_CLOSE_WRITE | IN_MOVED_TO) : -1;
+    if (watch_descriptor < 0) {
+        LOGW("Cannot watch %s for configuration changes: %s", config_directory, strerror(errno));
+        if (watch_fd >= 0) close(watch_fd);
+        free(config_name);
+        return 0;
+    }
+    config_watch_fd = watch_fd;
+    config_watch_descriptor = watch_descriptor;
+    config_watcher_stopping = 0;
+    
+    pthread_t watcher_thread;
+    pthread_attr_t thread_attributes;
+    pthread_attr_init(&thread_attributes);
+    pthread_attr_setdetachstate(&thread_attributes, PTHREAD_CREATE_DETACHED);
+    if (pthread_create(&watcher_thread, &thread_attributes, config_watcher_thread, config_name) != 0) {
+        LOGW("Failed to create configuration watcher thread");
+        pthread_attr_destroy(&thread_attributes);
+        close(config_watch_fd);
+        config_watch_fd = -1;
+        config_watch_descriptor = -1;
+        free(config_name);
+        return 0;
+    }
+    pthread_attr_destroy(&thread_attributes);
+    
+    LOGI("Watching %s for configuration changes", config_file_path);
+    return 1;
+}
+
+/**
+ * @brief Frees configuration snapshots replaced since the last call
+ * 
+ * Must be called by the dumping thread between scanning passes, when it
+ * holds no string or list obtained from the getters.
+ */
+void release_retired_config_snapshots(void) {
+    pthread_mutex_lock(&config_write_mutex);
+    for (int i = 0; i < retired_snapshot_count; i++) {
+        free_runtime_config(retired_snapshots[i]);
+    }
+    free(retired_snapshots);
+    retired_snapshots = NULL;
+    retired_snapshot_count = 0;
+    pthread_mutex_unlock(&config_write_mutex);
 }
 
 /**
  * @brief Cleans up configuration manager resources
  * 
- * This function frees all dynamically allocated memory used by the
- * configuration system. It should be called when the configuration
- * manager is no longer needed.
+ * This function stops the configuration watcher and frees every
+ * snapshot. It should be called when the configuration manager is no
+ * longer needed.
  */
 void cleanup_config_manager(void) {
-    // Free excluded SHA1 list
-    if (g_runtime_config.excluded_sha1_list) {
-        for (int i = 0; i < g_runtime_config.excluded_sha1_count; i++) {
-            free(g_runtime_config.excluded_sha1_list[i]);
-        }
-        free(g_runtime_config.excluded_sha1_list);
-    }
+    pthread_mutex_lock(&config_write_mutex);
     
-    // Free output directory templates
-    if (g_runtime_config.output_directory_templates) {
-        for (int i = 0; i < g_runtime_config.output_directory_count; i++) {
-            free(g_runtime_config.output_directory_templates[i]);
-        }
-        free(g_runtime_config.output_directory_templates);
+    // Removing the watch queues an IN_IGNORED event that wakes the watcher up
+    if (config_watch_fd >= 0) {
+        config_watcher_stopping = 1;
+        inotify_rm_watch(config_watch_fd, config_watch_descriptor);
     }
     
-    // Reset configuration structure
-    memset(&g_runtime_config, 0, sizeof(g_runtime_config));
+    free_runtime_config(__atomic_exchange_n(&g_runtime_config, NULL, __ATOMIC_ACQ_REL));
+    pthread_mutex_unlock(&config_write_mutex);
+    
+    release_retired_config_snapshots();
     LOGI("Configuration manager cleanup completed");
 }
 
@@ -534,7 +1484,7 @@ void cleanup_config_manager(void) {
  * @return int 1 if second scan is enabled, 0 otherwise
  */
 int should_enable_second_scan(void) {
-    return g_runtime_config.enable_second_scan;
+    return current_config()->enable_second_scan;
 }
 
 /**
@@ -543,7 +1493,7 @@ int should_enable_second_scan(void) {
  * @return int 1 if region filtering is enabled, 0 otherwise
  */
 int should_enable_region_filtering(void) {
-    return g_runtime_config.enable_region_filtering;
+    return current_config()->enable_region_filtering;
 }
 
 /**
@@ -552,7 +1502,7 @@ int should_enable_region_filtering(void) {
  * @return int Delay in seconds
  */
 int get_initial_delay(void) {
-    return g_runtime_config.thread_initial_delay;
+    return current_config()->thread_initial_delay;
 }
 
 /**
@@ -561,7 +1511,201 @@ int get_initial_delay(void) {
  * @return int Delay in seconds
  */
 int get_second_scan_delay(void) {
-    return g_runtime_config.second_scan_delay;
+    return current_config()->second_scan_delay;
+}
+
+/**
+ * @brief Gets the maximum number of DEX signature hits examined per region
+ * 
+ * @return int Candidate budget (always at least 1)
+ */
+int get_max_candidates_per_region(void) {
+    int max_candidates = current_config()->max_candidates_per_region;
+    return max_candidates > 0 ? max_candidates : MAX_CANDIDATES_PER_REGION;
+}
+
+/**
+ * @brief Gets the maximum number of header validations performed per region
+ * 
+ * @return int Validation budget (always at least 1)
+ */
+int get_max_validations_per_region(void) {
+    int max_validations = current_config()->max_validations_per_region;
+    return max_validations > 0 ? max_validations : MAX_VALIDATIONS_PER_REGION;
+}
+
+/**
+ * @brief Gets the number of read faults tolerated per region
+ * 
+ * @return int Fault budget (always at least 1)
+ */
+int get_max_faults_per_region(void) {
+    int max_faults = current_config()->max_faults_per_region;
+    return max_faults > 0 ? max_faults : MAX_FAULTS_PER_REGION;
+}
+
+/**
+ * @brief Checks if native libraries in anonymous memory should be dumped
+ * 
+ * @return int 1 if ELF dumping is enabled, 0 otherwise
+ */
+int should_enable_elf_dumping(void) {
+    return current_config()->enable_elf_dumping;
+}
+
+/**
+ * @brief Checks if section headers of loaded native libraries should be rebuilt
+ * 
+ * @return int 1 if section rebuilding is enabled, 0 otherwise
+ */
+int should_rebuild_elf_sections(void) {
+    return current_config()->rebuild_elf_sections;
+}
+
+/**
+ * @brief Checks if ART heap spaces should be walked for DEX byte arrays
+ * 
+ * @return int 1 if heap walking is enabled, 0 otherwise
+ */
+int should_enable_art_heap_walk(void) {
+    return current_config()->enable_art_heap_walk;
+}
+
+/**
+ * @brief Checks if (pointer, length) pairs should be followed to DEX files
+ * 
+ * @return int 1 if pointer discovery is enabled, 0 otherwise
+ */
+int should_enable_pointer_discovery(void) {
+    return current_config()->enable_pointer_discovery;
+}
+
+/**
+ * @brief Checks if non-readable regions should be read through /proc/self/mem
+ * 
+ * @return int 1 if protected region reads are enabled, 0 otherwise
+ */
+int should_enable_protected_region_reads(void) {
+    return current_config()->enable_protected_region_reads;
+}
+
+/**
+ * @brief Gets how pages pulled in by a scan are given back
+ * 
+ * @return int 0 to keep them, 1 for MADV_COLD, 2 for MADV_PAGEOUT
+ */
+int get_footprint_release_mode(void) {
+    int release_mode = current_config()->footprint_release_mode;
+    return release_mode >= 0 && release_mode <= 2 ? release_mode : FOOTPRINT_RELEASE_MODE;
+}
+
+/**
+ * @brief Checks if dump files are read and written through io_uring
+ * 
+ * @return int 1 if io_uring may be used, 0 for synchronous I/O only
+ */
+int should_enable_io_uring(void) {
+    return current_config()->enable_io_uring;
+}
+
+/**
+ * @brief Checks if written dumps are flushed and dropped from the page cache
+ * 
+ * @return int 1 if dump pages are dropped, 0 to leave them cached
+ */
+int should_drop_dump_page_cache(void) {
+    return current_config()->drop_dump_page_cache;
+}
+
+/**
+ * @brief Checks if the reader backend, chunk size and kernels are benchmarked at startup
+ * 
+ * @return int 1 if startup calibration runs, 0 to keep the built-in defaults
+ */
+int should_enable_calibration(void) {
+    return current_config()->enable_calibration;
+}
+
+/**
+ * @brief Checks if runtime commands are accepted on the control socket
+ * 
+ * @return int 1 if the control channel is started, 0 otherwise
+ */
+int should_enable_control_channel(void) {
+    return current_config()->enable_control_channel;
+}
+
+/**
+ * @brief Checks if dumped checksums are shared with the app's other processes
+ * 
+ * @return int 1 if the shared dedup table is used, 0 otherwise
+ */
+int should_enable_shared_dedup_table(void) {
+    return current_config()->enable_shared_dedup_table;
+}
+
+/**
+ * @brief Checks if large dumps are identified by the tree hash content ID
+ * 
+ * @return int 1 if the tree hash is used from TREE_HASH_MIN_SIZE, 0 for SHA1 only
+ */
+int should_enable_tree_content_hash(void) {
+    return current_config()->enable_tree_content_hash;
+}
+
+/**
+ * @brief Checks if payload copies are compared with their source afterwards
+ * 
+ * @return int 1 if torn copies are detected and retried, 0 otherwise
+ */
+int should_enable_torn_copy_check(void) {
+    return current_config()->enable_torn_copy_check;
+}
+
+/**
+ * @brief Gets the configuration file that was loaded
+ * 
+ * @return const char* Path of the configuration file, NULL if none was loaded
+ */
+const char* get_config_file_location(void) {
+    return config_file_path[0] ? config_file_path : NULL;
+}
+
+/**
+ * @brief Changes a scalar configuration option while the library runs
+ * 
+ * Accepts the same keys and values as the configuration file; the file
+ * itself is not modified, so the next reload of the file replaces the
+ * change.
+ * 
+ * @param key Option name
+ * @param value Option value as text
+ * @return int 1 if the option was applied, 0 if the key is unknown
+ */
+int set_runtime_config_option(const char* key, const char* value) {
+    pthread_mutex_lock(&config_write_mutex);
+    RuntimeConfig* config = copy_runtime_config(current_config());
+    int applied = config != NULL && apply_runtime_option(config, key, value);
+    if (applied) {
+        publish_runtime_config(config);
+    } else {
+        free_runtime_config(config);
+    }
+    pthread_mutex_unlock(&config_write_mutex);
+    return applied;
+}
+
+/**
+ * @brief Gets the directory detector plugins are loaded from
+ * 
+ * @return const char* Directory path, empty string if plugins are disabled
+ */
+const char* get_detector_plugin_directory(void) {
+    const RuntimeConfig* config = current_config();
+    if (config->detector_plugin_directory) {
+        return config->detector_plugin_directory;
+    }
+    return DETECTOR_PLUGIN_DIRECTORY;
 }
 
 /**
@@ -571,9 +1715,10 @@ int get_second_scan_delay(void) {
  * @return const char** Array of directory template strings
  */
 const char** get_output_directory_templates(int* count) {
-    if (g_runtime_config.config_loaded && g_runtime_config.output_directory_count > 0) {
-        *count = g_runtime_config.output_directory_count;
-        return (const char**)g_runtime_config.output_directory_templates;
+    const RuntimeConfig* config = current_config();
+    if (config->config_loaded && config->output_directory_count > 0) {
+        *count = config->output_directory_count;
+        return (const char**)config->output_directory_templates;
     } else {
         // Fall back to compile-time defaults
         static const char* default_templates[] = OUTPUT_DIRECTORY_TEMPLATES;
@@ -589,13 +1734,29 @@ const char** get_output_directory_templates(int* count) {
  * @return const char** Array of SHA1 hash strings
  */
 const char** get_excluded_sha1_list(int* count) {
-    if (g_runtime_config.config_loaded && g_runtime_config.excluded_sha1_count > 0) {
-        *count = g_runtime_config.excluded_sha1_count;
-        return (const char**)g_runtime_config.excluded_sha1_list;
+    const RuntimeConfig* config = current_config();
+    if (config->config_loaded && config->excluded_sha1_count > 0) {
+        *count = config->excluded_sha1_count;
+        return (const char**)config->excluded_sha1_list;
     } else {
         // Fall back to compile-time defaults
         static const char* default_exclusions[] = EXCLUDED_SHA1_LIST;
         *count = sizeof(default_exclusions) / sizeof(default_exclusions[0]);
         return default_exclusions;
     }
+}
+
+/**
+ * @brief Gets the list of excluded tree hash content IDs
+ * 
+ * There are no compile-time defaults: the default exclusions are small
+ * files, which are identified by SHA1.
+ * 
+ * @param count Output parameter that receives the number of excluded content IDs
+ * @return const char** Array of content ID strings, NULL if there are none
+ */
+const char** get_excluded_content_id_list(int* count) {
+    const RuntimeConfig* config = current_config();
+    *count = config->config_loaded ? config->excluded_content_id_count : 0;
+    return *count > 0 ? (const char**)config->excluded_content_id_list : NULL;
 }
\ No newline at end of file
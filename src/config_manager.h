@@ -10,6 +10,12 @@ void init_config_manager(void);
 // Cleanup configuration resources
 void cleanup_config_manager(void);
 
+// Start reloading the configuration when its file changes (if enabled)
+int start_config_watcher(void);
+
+// Free configuration snapshots replaced since the last call (between scanning passes only)
+void release_retired_config_snapshots(void);
+
 // Check if second memory scan is enabled
 int should_enable_second_scan(void);
 
@@ -22,10 +28,70 @@ int get_initial_delay(void);
 // Get delay between scans (seconds)
 int get_second_scan_delay(void);
 
+// Get per-region budget for DEX signature hits
+int get_max_candidates_per_region(void);
+
+// Get per-region budget for header validations
+int get_max_validations_per_region(void);
+
+// Get per-region budget for read faults
+int get_max_faults_per_region(void);
+
+// Check if native libraries in anonymous memory are dumped
+int should_enable_elf_dumping(void);
+
+// Check if section headers of loaded native libraries are rebuilt
+int should_rebuild_elf_sections(void);
+
+// Check if byte[] arrays of ART heap spaces are walked
+int should_enable_art_heap_walk(void);
+
+// Check if (pointer, length) pairs in native memory are followed to DEX files
+int should_enable_pointer_discovery(void);
+
+// Check if non-readable regions are read through /proc/self/mem
+int should_enable_protected_region_reads(void);
+
+// Get how pages pulled in by a scan are given back (0=keep, 1=cold, 2=pageout)
+int get_footprint_release_mode(void);
+
+// Check if dump files are read and written through io_uring
+int should_enable_io_uring(void);
+
+// Check if written dumps are flushed and dropped from the page cache
+int should_drop_dump_page_cache(void);
+
+// Check if the reader backend, chunk size and kernels are benchmarked at startup
+int should_enable_calibration(void);
+
+// Check if runtime commands are accepted on the control socket
+int should_enable_control_channel(void);
+
+// Check if dumped checksums are shared with the app's other processes
+int should_enable_shared_dedup_table(void);
+
+// Check if large dumps are identified by the tree hash content ID
+int should_enable_tree_content_hash(void);
+
+// Check if payload copies are compared with their source afterwards
+int should_enable_torn_copy_check(void);
+
+// Get the configuration file that was loaded (NULL if none)
+const char* get_config_file_location(void);
+
+// Change a scalar configuration option while the library runs
+int set_runtime_config_option(const char* key, const char* value);
+
+// Get directory detector plugins are loaded from (empty = disabled)
+const char* get_detector_plugin_directory(void);
+
 // Get output directory path templates
 const char** get_output_directory_templates(int* count);
 
 // Get list of excluded SHA1 hashes
 const char** get_excluded_sha1_list(int* count);
 
+// Get list of excluded tree hash content IDs
+const char** get_excluded_content_id_list(int* count);
+
 #endif
\ No newline at end of file
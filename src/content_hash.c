@@ -0,0 +1,387 @@
+#include "content_hash.h"
+#include "calibration.h"
+
+// Chunk kernel: NEON on ARM, SSE2 on x86, one chunk at a time elsewhere
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define CONTENT_HASH_LANES_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define CONTENT_HASH_LANES_SSE2 1
+#endif
+
+#define BLAKE3_BLOCK_SIZE 64
+#define BLAKE3_CHUNK_SIZE 1024
+
+// Domain flags of a compression
+#define BLAKE3_CHUNK_START 1
+#define BLAKE3_CHUNK_END   2
+#define BLAKE3_PARENT      4
+#define BLAKE3_ROOT        8
+
+static const uint32_t blake3_iv[8] = {
+    0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A,
+    0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19
+};
+
+// Message word order of each of the seven rounds
+static const uint8_t blake3_schedule[7][16] = {
+    { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+    { 2, 6, 3, 10, 7, 0, 4, 13, 1, 11, 12, 5, 9, 14, 15, 8 },
+    { 3, 4, 10, 12, 13, 2, 7, 14, 6, 5, 9, 0, 11, 15, 8, 1 },
+    { 10, 7, 12, 9, 14, 3, 13, 15, 4, 0, 11, 2, 5, 8, 1, 6 },
+    { 12, 13, 9, 11, 15, 10, 14, 8, 7, 2, 5, 3, 0, 1, 6, 4 },
+    { 9, 14, 11, 5, 8, 12, 15, 1, 13, 3, 0, 10, 2, 6, 4, 7 },
+    { 11, 15, 5, 0, 1, 9, 8, 6, 14, 10, 2, 12, 3, 4, 7, 13 }
+};
+
+/**
+ * @brief Reads a little-endian 32-bit word
+ */
+static inline uint32_t load_le32(const uint8_t* bytes) {
+    return (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) |
+           ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+}
+
+static inline uint32_t rotate_right(uint32_t value, int shift) {
+    return (value >> shift) | (value << (32 - shift));
+}
+
+// Mixing function on four state words
+#define BLAKE3_G(v, a, b, c, d, x, y) do { \
+    v[a] = v[a] + v[b] + (x); \
+    v[d] = rotate_right(v[d] ^ v[a], 16); \
+    v[c] = v[c] + v[d]; \
+    v[b] = rotate_right(v[b] ^ v[c], 12); \
+    v[a] = v[a] + v[b] + (y); \
+    v[d] = rotate_right(v[d] ^ v[a], 8); \
+    v[c] = v[c] + v[d]; \
+    v[b] = rotate_right(v[b] ^ v[c], 7); \
+} while (0)
+
+/**
+ * @brief Compresses one 64-byte block into a chaining value
+ * 
+ * @param cv Chaining value, replaced by the output
+ * @param block Block contents, zero padded
+ * @param counter Chunk index (0 for parents)
+ * @param block_length Bytes of the block that are input
+ * @param flags BLAKE3_* domain flags
+ */
+static void compress_block(uint32_t cv[8], const uint8_t block[BLAKE3_BLOCK_SIZE], uint64_t counter,
+                           uint32_t block_length, uint32_t flags) {
+    uint32_t m[16];
+    for (int i = 0; i < 16; i++) m[i] = load_le32(block + i * 4);
+    
+    uint32_t v[16] = {
+        cv[0], cv[1], cv[2], cv[3], cv[4], cv[5], cv[6], cv[7],
+        blake3_iv[0], blake3_iv[1], blake3_iv[2], blake3_iv[3],
+        (uint32_t)counter, (uint32_t)(counter >> 32), block_length, flags
+    };
+    for (int round = 0; round < 7; round++) {
+        const uint8_t* s = blake3_schedule[round];
+        BLAKE3_G(v, 0, 4, 8, 12, m[s[0]], m[s[1]]);
+        BLAKE3_G(v, 1, 5, 9, 13, m[s[2]], m[s[3]]);
+        BLAKE3_G(v, 2, 6, 10, 14, m[s[4]], m[s[5]]);
+        BLAKE3_G(v, 3, 7, 11, 15, m[s[6]], m[s[7]]);
+        BLAKE3_G(v, 0, 5, 10, 15, m[s[8]], m[s[9]]);
+        BLAKE3_G(v, 1, 6, 11, 12, m[s[10]], m[s[11]]);
+        BLAKE3_G(v, 2, 7, 8, 13, m[s[12]], m[s[13]]);
+        BLAKE3_G(v, 3, 4, 9, 14, m[s[14]], m[s[15]]);
+    }
+    for (int i = 0; i < 8; i++) cv[i] = v[i] ^ v[i + 8];
+}
+
+/**
+ * @brief Hashes one chunk (up to 1 KB) into its chaining value
+ * 
+ * @param root_flag BLAKE3_ROOT if the chunk is the whole input, 0 otherwise
+ */
+static void hash_chunk(const uint8_t* input, size_t size, uint64_t chunk_counter, uint32_t root_flag,
+                       uint32_t cv[8]) {
+    memcpy(cv, blake3_iv, sizeof(blake3_iv));
+    uint32_t flags = BLAKE3_CHUNK_START;
+    size_t offset = 0;
+    do {
+        size_t block_length = size - offset < BLAKE3_BLOCK_SIZE ? size - offset : BLAKE3_BLOCK_SIZE;
+        uint8_t block[BLAKE3_BLOCK_SIZE] = { 0 };
+        memcpy(block, input + offset, block_length);
+        offset += block_length;
+        if (offset == size) flags |= BLAKE3_CHUNK_END | root_flag;
+        compress_block(cv, block, chunk_counter, (uint32_t)block_length, flags);
+        flags = 0;
+    } while (offset < size);
+}
+
+/**
+ * @brief Combines the chaining values of two sibling subtrees
+ */
+static void hash_parent(const uint32_t left_cv[8], const uint32_t right_cv[8], uint32_t root_flag,
+                        uint32_t cv[8]) {
+    uint8_t block[BLAKE3_BLOCK_SIZE];
+    for (int i = 0; i < 8; i++) {
+        for (int byte = 0; byte < 4; byte++) {
+            block[i * 4 + byte] = (uint8_t)(left_cv[i] >> (byte * 8));
+            block[32 + i * 4 + byte] = (uint8_t)(right_cv[i] >> (byte * 8));
+        }
+    }
+    memcpy(cv, blake3_iv, sizeof(blake3_iv));
+    compress_block(cv, block, 0, BLAKE3_BLOCK_SIZE, BLAKE3_PARENT | root_flag);
+}
+
+#if defined(CONTENT_HASH_LANES_NEON) || defined(CONTENT_HASH_LANES_SSE2)
+
+// One 32-bit word per chunk
+#if defined(CONTENT_HASH_LANES_NEON)
+typedef uint32x4_t chunk_lanes;
+#define LANES_SET(value) vdupq_n_u32(value)
+#define LANES_LOAD(words) vld1q_u32(words)
+#define LANES_STORE(words, lanes) vst1q_u32(words, lanes)
+#define LANES_ADD(x, y) vaddq_u32(x, y)
+#define LANES_XOR(x, y) veorq_u32(x, y)
+#define LANES_ROTR(x, shift) vsriq_n_u32(vshlq_n_u32(x, 32 - (shift)), x, shift)
+#else
+typedef __m128i chunk_lanes;
+#define LANES_SET(value) _mm_set1_epi32((int)(value))
+#define LANES_LOAD(words) _mm_loadu_si128((const __m128i*)(words))
+#define LANES_STORE(words, lanes) _mm_storeu_si128((__m128i*)(words), lanes)
+#define LANES_ADD(x, y) _mm_add_epi32(x, y)
+#define LANES_XOR(x, y) _mm_xor_si128(x, y)
+#define LANES_ROTR(x, shift) _mm_or_si128(_mm_srli_epi32(x, shift), _mm_slli_epi32(x, 32 - (shift)))
+#endif
+
+#define CHUNK_LANE_COUNT 4
+
+#define BLAKE3_LANES_G(v, a, b, c, d, x, y) do { \
+    v[a] = LANES_ADD(LANES_ADD(v[a], v[b]), x); \
+    v[d] = LANES_ROTR(LANES_XOR(v[d], v[a]), 16); \
+    v[c] = LANES_ADD(v[c], v[d]); \
+    v[b] = LANES_ROTR(LANES_XOR(v[b], v[c]), 12); \
+    v[a] = LANES_ADD(LANES_ADD(v[a], v[b]), y); \
+    v[d] = LANES_ROTR(LANES_XOR(v[d], v[a]), 8); \
+    v[c] = LANES_ADD(v[c], v[d]); \
+    v[b] = LANES_ROTR(LANES_XOR(v[b], v[c]), 7); \
+} while (0)
+
+/**
+ * @brief Hashes four consecutive full chunks at once, one per lane
+ * 
+ * @param input First of the four chunks
+ * @param chunk_counter Index of the first chunk
+ * @param cvs Output, one chaining value per chunk
+ */
+static void hash_four_chunks(const uint8_t* input, uint64_t chunk_counter, uint32_t cvs[CHUNK_LANE_COUNT][8]) {
+    uint32_t words[CHUNK_LANE_COUNT];
+    chunk_lanes h[8];
+    for (int i = 0; i < 8; i++) h[i] = LANES_SET(blake3_iv[i]);
+    
+    for (int lane = 0; lane < CHUNK_LANE_COUNT; lane++) words[lane] = (uint32_t)(chunk_counter + lane);
+    chunk_lanes counter_low = LANES_LOAD(words);
+    for (int lane = 0; lane < CHUNK_LANE_COUNT; lane++) words[lane] = (uint32_t)((chunk_counter + lane) >> 32);
+    chunk_lanes counter_high = LANES_LOAD(words);
+    
+    for (int block = 0; block < BLAKE3_CHUNK_SIZE / BLAKE3_BLOCK_SIZE; block++) {
+        // Word i of every chunk's block, side by side
+        chunk_lanes m[16];
+        for (int i = 0; i < 16; i++) {
+            for (int lane = 0; lane < CHUNK_LANE_COUNT; lane++) {
+                words[lane] = load_le32(input + lane * BLAKE3_CHUNK_SIZE + block * BLAKE3_BLOCK_SIZE + i * 4);
+            }
+            m[i] = LANES_LOAD(words);
+        }
+        
+        uint32_t flags = (block == 0 ? BLAKE3_CHUNK_START : 0) |
+                         (block == BLAKE3_CHUNK_SIZE / BLAKE3_BLOCK_SIZE - 1 ? BLAKE3_CHUNK_END : 0);
+        chunk_lanes v[16] = {
+            h[0], h[1], h[2], h[3], h[4], h[5], h[6], h[7],
+            LANES_SET(blake3_iv[0]), LANES_SET(blake3_iv[1]), LANES_SET(blake3_iv[2]), LANES_SET(blake3_iv[3]),
+            counter_low, counter_high, LANES_SET(BLAKE3_BLOCK_SIZE), LANES_SET(flags)
+        };
+        for (int round = 0; round < 7; round++) {
+            const uint8_t* s = blake3_schedule[round];
+            BLAKE3_LANES_G(v, 0, 4, 8, 12, m[s[0]], m[s[1]]);
+            BLAKE3_LANES_G(v, 1, 5, 9, 13, m[s[2]], m[s[3]]);
+            BLAKE3_LANES_G(v, 2, 6, 10, 14, m[s[4]], m[s[5]]);
+            BLAKE3_LANES_G(v, 3, 7, 11, 15, m[s[6]], m[s[7]]);
+            BLAKE3_LANES_G(v, 0, 5, 10, 15, m[s[8]], m[s[9]]);
+            BLAKE3_LANES_G(v, 1, 6, 11, 12, m[s[10]], m[s[11]]);
+            BLAKE3_LANES_G(v, 2, 7, 8, 13, m[s[12]], m[s[13]]);
+            BLAKE3_LANES_G(v, 3, 4, 9, 14, m[s[14]], m[s[15]]);
+        }
+        for (int i = 0; i < 8; i++) h[i] = LANES_XOR(v[i], v[i + 8]);
+    }
+    
+    for (int i = 0; i < 8; i++) {
+        LANES_STORE(words, h[i]);
+        for (int lane = 0; lane < CHUNK_LANE_COUNT; lane++) cvs[lane][i] = words[lane];
+    }
+}
+
+#endif
+
+/**
+ * @brief Returns the largest power of two strictly below a count (count >= 2)
+ */
+static size_t largest_power_of_two_below(size_t count) {
+    size_t power = 1;
+    while (power * 2 < count) power *= 2;
+    return power;
+}
+
+/**
+ * @brief Reduces the chaining values of consecutive chunks to their subtree's
+ * 
+ * Splits like the byte-level tree: the left subtree holds the largest
+ * power of two of chunks below the total.
+ */
+static void merge_chunk_cvs(uint32_t (*cvs)[8], size_t count, uint32_t root_flag, uint32_t cv[8]) {
+    if (count == 1) {
+        memcpy(cv, cvs[0], sizeof(cvs[0]));
+        return;
+    }
+    size_t left_count = largest_power_of_two_below(count);
+    uint32_t left_cv[8];
+    uint32_t right_cv[8];
+    merge_chunk_cvs(cvs, left_count, 0, left_cv);
+    merge_chunk_cvs(cvs + left_count, count - left_count, 0, right_cv);
+    hash_parent(left_cv, right_cv, root_flag, cv);
+}
+
+// One subtree of the input, hashed on the calling thread or a worker
+typedef struct {
+    const uint8_t* input;
+    size_t size;            // More than one chunk
+    uint64_t chunk_counter; // Index of the subtree's first chunk
+    uint32_t root_flag;     // BLAKE3_ROOT for the whole input
+    int threads;            // Threads the subtree may use, the calling one included
+    uint32_t cv[8];         // Output chaining value
+} ContentHashTask;
+
+/**
+ * @brief Hashes up to CONTENT_HASH_LEAF_CHUNKS chunks and merges them
+ */
+static void hash_leaf_subtree(ContentHashTask* task) {
+    uint32_t cvs[CONTENT_HASH_LEAF_CHUNKS][8];
+    size_t chunk_count = (task->size + BLAKE3_CHUNK_SIZE - 1) / BLAKE3_CHUNK_SIZE;
+    size_t full_chunks = task->size / BLAKE3_CHUNK_SIZE;
+    size_t chunk = 0;
+
+#if defined(CONTENT_HASH_LANES_NEON) || defined(CONTENT_HASH_LANES_SSE2)
+    for (; chunk + CHUNK_LANE_COUNT <= full_chunks; chunk += CHUNK_LANE_COUNT) {
+        hash_four_chunks(task->input + chunk * BLAKE3_CHUNK_SIZE, task->chunk_counter + chunk, &cvs[chunk]);
+    }
+#endif
+    for (; chunk < chunk_count; chunk++) {
+        size_t offset = chunk * BLAKE3_CHUNK_SIZE;
+        size_t chunk_size = chunk < full_chunks ? BLAKE3_CHUNK_SIZE : task->size - offset;
+        hash_chunk(task->input + offset, chunk_size, task->chunk_counter + chunk, 0, cvs[chunk]);
+    }
+    
+    merge_chunk_cvs(cvs, chunk_count, task->root_flag, task->cv);
+}
+
+static void* hash_subtree_thread(void* argument);
+
+/**
+ * @brief Hashes a subtree, handing its right half to a worker while it is large
+ */
+static void hash_subtree(ContentHashTask* task) {
+    if (task->size <= (size_t)CONTENT_HASH_LEAF_CHUNKS * BLAKE3_CHUNK_SIZE) {
+        hash_leaf_subtree(task);
+        return;
+    }
+    
+    size_t chunk_count = (task->size + BLAKE3_CHUNK_SIZE - 1) / BLAKE3_CHUNK_SIZE;
+    size_t left_size = largest_power_of_two_below(chunk_count) * BLAKE3_CHUNK_SIZE;
+    ContentHashTask left = {
+        .input = task->input, .size = left_size, .chunk_counter = task->chunk_counter,
+        .threads = task->threads - task->threads / 2
+    };
+    ContentHashTask right = {
+        .input = task->input + left_size, .size = task->size - left_size,
+        .chunk_counter = task->chunk_counter + left_size / BLAKE3_CHUNK_SIZE, .threads = task->threads / 2
+    };
+    
+    pthread_t worker;
+    int worker_started = right.threads > 0 && task->size >= CONTENT_HASH_PARALLEL_MIN_SIZE &&
+                         pthread_create(&worker, NULL, hash_subtree_thread, &right) == 0;
+    if (!worker_started) {
+        left.threads = task->threads;
+        right.threads = 1;
+    }
+    hash_subtree(&left);
+    if (worker_started) {
+        pthread_join(worker, NULL);
+    } else {
+        hash_subtree(&right);
+    }
+    
+    hash_parent(left.cv, right.cv, task->root_flag, task->cv);
+}
+
+static void* hash_subtree_thread(void* argument) {
+    hash_subtree(argument);
+    return NULL;
+}
+
+/**
+ * @brief Computes the BLAKE3-256 content ID of a buffer on a given number of threads
+ * 
+ * Inputs of CONTENT_HASH_PARALLEL_MIN_SIZE and more are split into
+ * subtrees hashed on up to thread_count threads; the calling thread
+ * hashes one of them and waits for the others.
+ * 
+ * @param data Buffer to hash
+ * @param data_size Size of the buffer
+ * @param thread_count Threads the hash may use, the calling one included
+ * @param content_id Output, CONTENT_ID_SIZE bytes
+ */
+void compute_content_id_on_threads(const void* data, size_t data_size, int thread_count, uint8_t* content_id) {
+    uint32_t cv[8];
+    if (data_size <= BLAKE3_CHUNK_SIZE) {
+        hash_chunk(data, data_size, 0, BLAKE3_ROOT, cv);
+    } else {
+        ContentHashTask root = {
+            .input = data, .size = data_size, .chunk_counter = 0,
+            .root_flag = BLAKE3_ROOT, .threads = thread_count
+        };
+        hash_subtree(&root);
+        memcpy(cv, root.cv, sizeof(cv));
+    }
+    
+    for (int i = 0; i < 8; i++) {
+        for (int byte = 0; byte < 4; byte++) {
+            content_id[i * 4 + byte] = (uint8_t)(cv[i] >> (byte * 8));
+        }
+    }
+}
+
+/**
+ * @brief Computes the BLAKE3-256 content ID of a buffer
+ * 
+ * Uses the thread count chosen by startup calibration, never more than
+ * the online CPUs.
+ * 
+ * @param data Buffer to hash
+ * @param data_size Size of the buffer
+ * @param content_id Output, CONTENT_ID_SIZE bytes
+ */
+void compute_content_id(const void* data, size_t data_size, uint8_t* content_id) {
+    compute_content_id_on_threads(data, data_size, get_hash_thread_count(), content_id);
+}
+
+/**
+ * @brief Converts a content ID to a hexadecimal string
+ * 
+ * @param content_id CONTENT_ID_SIZE bytes
+ * @param output Output buffer
+ * @param output_size Size of the output buffer, at least CONTENT_ID_SIZE * 2 + 1
+ */
+void content_id_to_hex_string(const uint8_t* content_id, char* output, size_t output_size) {
+    if (output_size < CONTENT_ID_SIZE * 2 + 1) return;
+    
+    for (int i = 0; i < CONTENT_ID_SIZE; i++) {
+        snprintf(output + i * 2, 3, "%02x", content_id[i]);
+    }
+    output[CONTENT_ID_SIZE * 2] = '\0';
+}
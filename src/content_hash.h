@@ -0,0 +1,32 @@
+#ifndef DEXDUMPER_CONTENT_HASH_H
+#define DEXDUMPER_CONTENT_HASH_H
+
+// Content hash header - declares the parallel tree hash identifying large dumps
+
+#include "common.h"
+#include "config.h"
+
+/**
+ * Tree Hash Content ID:
+ * 
+ * SHA-1 processes its input strictly in sequence, so a 50 MB DEX takes
+ * hundreds of milliseconds on one little core however many cores are
+ * idle. The content ID is BLAKE3-256: the input is cut into 1 KB chunks
+ * that are hashed independently and combined pairwise up a binary tree.
+ * Four chunks are compressed at once in the lanes of a NEON or SSE2
+ * vector, and subtrees of large inputs are spread over worker threads,
+ * as many as startup calibration found worthwhile.
+ * The result is the standard BLAKE3 hash of the input whatever the
+ * number of threads or lanes used.
+ */
+
+// Computes the BLAKE3-256 content ID of a buffer
+void compute_content_id(const void* data, size_t data_size, uint8_t* content_id);
+
+// Computes the BLAKE3-256 content ID of a buffer on a given number of threads
+void compute_content_id_on_threads(const void* data, size_t data_size, int thread_count, uint8_t* content_id);
+
+// Converts a content ID to a hexadecimal string (output_size >= CONTENT_ID_SIZE * 2 + 1)
+void content_id_to_hex_string(const uint8_t* content_id, char* output, size_t output_size);
+
+#endif
@@ -0,0 +1,262 @@
+#include "control_channel.h"
+#include "config_manager.h"
+#include "scan_statistics.h"
+#include "dump_manifest.h"
+#include <sys/socket.h>
+#include <sys/un.h>
+
+// Android's adb shell user, allowed to connect besides root and the app itself
+#define SHELL_UID 2000
+
+// State shared by the listener thread and the dumping thread
+static pthread_mutex_t control_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t control_condition = PTHREAD_COND_INITIALIZER;
+static int control_channel_running = 0;
+static int scanning_paused = 0;
+static int scan_request_pending = 0;
+static ScanRequest pending_scan_request;
+static int control_socket_fd = -1;
+static char control_output_directory[MAX_PATH_LENGTH];
+
+/**
+ * @brief Parses the arguments of a scan command
+ * 
+ * @param arguments "full", "incremental", "<start>-<end>" in hex, or empty for full
+ * @param scan_request Output request
+ * @return 1 if the arguments are valid, 0 otherwise
+ */
+static int parse_scan_request(const char* arguments, ScanRequest* scan_request) {
+    memset(scan_request, 0, sizeof(*scan_request));
+    if (arguments == NULL || arguments[0] == '\0' || strcmp(arguments, "full") == 0) {
+        scan_request->scan_mode = SCAN_MODE_FULL;
+        return 1;
+    }
+    if (strcmp(arguments, "incremental") == 0) {
+        scan_request->scan_mode = SCAN_MODE_INCREMENTAL;
+        return 1;
+    }
+    
+    unsigned long long range_start = 0, range_end = 0;
+    int parsed_length = 0;
+    if (sscanf(arguments, "%llx-%llx%n", &range_start, &range_end, &parsed_length) != 2 ||
+        arguments[parsed_length] != '\0' || range_end <= range_start || range_end > UINTPTR_MAX) {
+        return 0;
+    }
+    scan_request->scan_mode = SCAN_MODE_RANGE;
+    scan_request->range_start = (uintptr_t)range_start;
+    scan_request->range_end = (uintptr_t)range_end;
+    return 1;
+}
+
+/**
+ * @brief Runs one command line and writes its reply
+ * 
+ * @param command Command line without the newline (modified while parsing)
+ * @param reply Output reply, starting with "OK" or "ERR"
+ * @param reply_capacity Size of reply
+ */
+static void execute_control_command(char* command, char* reply, size_t reply_capacity) {
+    size_t command_length = strlen(command);
+    while (command_length > 0 && (command[command_length - 1] == ' ' || command[command_length - 1] == '\t')) {
+        command[--command_length] = '\0';
+    }
+    
+    char* parse_state = NULL;
+    char* verb = strtok_r(command, " \t", &parse_state);
+    char* arguments = parse_state ? parse_state + strspn(parse_state, " \t") : NULL;
+    if (verb == NULL) {
+        snprintf(reply, reply_capacity, "ERR empty command\n");
+        return;
+    }
+    
+    if (strcmp(verb, "scan") == 0) {
+        ScanRequest scan_request;
+        if (!parse_scan_request(arguments, &scan_request)) {
+            snprintf(reply, reply_capacity, "ERR usage: scan [full|incremental|<start>-<end>]\n");
+            return;
+        }
+        pthread_mutex_lock(&control_mutex);
+        int queued = !scan_request_pending;
+        if (queued) {
+            pending_scan_request = scan_request;
+            scan_request_pending = 1;
+            pthread_cond_broadcast(&control_condition);
+        }
+        pthread_mutex_unlock(&control_mutex);
+        snprintf(reply, reply_capacity, queued ? "OK scan queued\n" : "ERR a scan is already queued\n");
+    } else if (strcmp(verb, "pause") == 0 || strcmp(verb, "resume") == 0) {
+        pthread_mutex_lock(&control_mutex);
+        scanning_paused = strcmp(verb, "pause") == 0;
+        pthread_cond_broadcast(&control_condition);
+        pthread_mutex_unlock(&control_mutex);
+        snprintf(reply, reply_capacity, "OK %s\n", scanning_paused ? "paused" : "resumed");
+    } else if (strcmp(verb, "set") == 0) {
+        char* key = strtok_r(NULL, " \t", &parse_state);
+        char* value = parse_state ? parse_state + strspn(parse_state, " \t") : NULL;
+        if (key == NULL || value == NULL || value[0] == '\0') {
+            snprintf(reply, reply_capacity, "ERR usage: set <key> <value>\n");
+        } else if (set_runtime_config_option(key, value)) {
+            snprintf(reply, reply_capacity, "OK %s=%s\n", key, value);
+        } else {
+            snprintf(reply, reply_capacity, "ERR unknown option %s\n", key);
+        }
+    } else if (strcmp(verb, "stats") == 0) {
+        size_t text_length = format_scan_statistics(reply + 3, reply_capacity - 3);
+        memcpy(reply, "OK\n", 3);
+        reply[3 + text_length] = '\0';
+    } else if (strcmp(verb, "flush") == 0) {
+        int flushed = flush_dump_manifest(control_output_directory);
+        snprintf(reply, reply_capacity, flushed ? "OK manifest flushed\n" : "ERR manifest flush failed\n");
+    } else {
+        snprintf(reply, reply_capacity, "ERR unknown command %s\n", verb);
+    }
+}
+
+/**
+ * @brief Checks that a client runs as the app, root or the adb shell
+ */
+static int is_control_peer_allowed(int client_fd) {
+    struct ucred peer_credentials;
+    socklen_t credentials_size = sizeof(peer_credentials);
+    if (getsockopt(client_fd, SOL_SOCKET, SO_PEERCRED, &peer_credentials, &credentials_size) != 0) return 0;
+    return peer_credentials.uid == getuid() || peer_credentials.uid == 0 || peer_credentials.uid == SHELL_UID;
+}
+
+/**
+ * @brief Serves one connection: reads a command line, replies and closes
+ */
+static void serve_control_client(int client_fd) {
+    if (!is_control_peer_allowed(client_fd)) {
+        LOGW("Control channel: rejected connection from another user");
+        return;
+    }
+    
+    // A client that never finishes its line must not block the channel
+    struct timeval receive_timeout = { 1, 0 };
+    setsockopt(client_fd, SOL_SOCKET, SO_RCVTIMEO, &receive_timeout, sizeof(receive_timeout));
+    
+    char command[CONTROL_COMMAND_MAX_LENGTH];
+    size_t command_length = 0;
+    while (command_length < sizeof(command) - 1) {
+        ssize_t bytes_read = read(client_fd, command + command_length, sizeof(command) - 1 - command_length);
+        if (bytes_read < 0 && errno == EINTR) continue;
+        if (bytes_read <= 0) break;
+        command_length += (size_t)bytes_read;
+        if (memchr(command, '\n', command_length)) break;
+    }
+    command[command_length] = '\0';
+    command[strcspn(command, "\r\n")] = '\0';
+    
+    char* reply = malloc(CONTROL_REPLY_MAX_LENGTH);
+    if (!reply) return;
+    execute_control_command(command, reply, CONTROL_REPLY_MAX_LENGTH);
+    LOGI("Control channel: %s -> %.*s", command, (int)strcspn(reply, "\n"), reply);
+    
+    size_t reply_length = strlen(reply);
+    for (size_t written = 0; written < reply_length; ) {
+        ssize_t bytes_written = write(client_fd, reply + written, reply_length - written);
+        if (bytes_written < 0 && errno == EINTR) continue;
+        if (bytes_written <= 0) break;
+        written += (size_t)bytes_written;
+    }
+    free(reply);
+}
+
+/**
+ * @brief Accepts and serves connections for the lifetime of the process
+ */
+static void* control_channel_thread(void* thread_argument) {
+    for (;;) {
+        int client_fd = accept4(control_socket_fd, NULL, NULL, SOCK_CLOEXEC);
+        if (client_fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            LOGE("Control channel: accept failed: %s", strerror(errno));
+            break;
+        }
+        serve_control_client(client_fd);
+        close(client_fd);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Starts listening for commands if the control channel is enabled
+ * 
+ * @param output_directory Directory holding the dumps and the manifest
+ * @return 1 if the channel is listening, 0 if it is disabled or failed to start
+ */
+int start_control_channel(const char* output_directory) {
+    if (!should_enable_control_channel() || control_channel_running) return control_channel_running;
+    snprintf(control_output_directory, sizeof(control_output_directory), "%s", output_directory);
+    
+    // Abstract namespace: no file to create or clean up, gone with the process
+    struct sockaddr_un socket_address;
+    memset(&socket_address, 0, sizeof(socket_address));
+    socket_address.sun_family = AF_UNIX;
+    int name_length = snprintf(socket_address.sun_path + 1, sizeof(socket_address.sun_path) - 1,
+                               "%s.%d", CONTROL_SOCKET_PREFIX, (int)getpid());
+    socklen_t address_length = (socklen_t)(offsetof(struct sockaddr_un, sun_path) + 1 + name_length);
+    
+    control_socket_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (control_socket_fd < 0 ||
+        bind(control_socket_fd, (struct sockaddr*)&socket_address, address_length) != 0 ||
+        listen(control_socket_fd, 4) != 0) {
+        LOGE("Control channel: cannot listen on @%s: %s", socket_address.sun_path + 1, strerror(errno));
+        if (control_socket_fd >= 0) close(control_socket_fd);
+        control_socket_fd = -1;
+        return 0;
+    }
+    
+    pthread_t listener_thread;
+    pthread_attr_t thread_attributes;
+    pthread_attr_init(&thread_attributes);
+    pthread_attr_setdetachstate(&thread_attributes, PTHREAD_CREATE_DETACHED);
+    if (pthread_create(&listener_thread, &thread_attributes, control_channel_thread, NULL) != 0) {
+        LOGE("Control channel: failed to create listener thread");
+        pthread_attr_destroy(&thread_attributes);
+        close(control_socket_fd);
+        control_socket_fd = -1;
+        return 0;
+    }
+    pthread_attr_destroy(&thread_attributes);
+    
+    control_channel_running = 1;
+    LOGI("Control channel listening on @%s", socket_address.sun_path + 1);
+    return 1;
+}
+
+/**
+ * @brief Waits for the next queued scan
+ * 
+ * @param scan_request Output request
+ * @return 1 when a scan was dequeued, 0 if the control channel is not running
+ */
+int wait_for_scan_request(ScanRequest* scan_request) {
+    if (!control_channel_running) return 0;
+    
+    pthread_mutex_lock(&control_mutex);
+    while (!scan_request_pending) {
+        pthread_cond_wait(&control_condition, &control_mutex);
+    }
+    *scan_request = pending_scan_request;
+    scan_request_pending = 0;
+    pthread_mutex_unlock(&control_mutex);
+    return 1;
+}
+
+/**
+ * @brief Blocks while a pause command is in effect
+ * 
+ * Called by the dumping thread between regions, so a pause takes effect
+ * once the region being scanned is done.
+ */
+void wait_while_scanning_paused(void) {
+    if (!__atomic_load_n(&scanning_paused, __ATOMIC_RELAXED)) return;
+    
+    pthread_mutex_lock(&control_mutex);
+    if (scanning_paused) LOGI("Scanning paused by control channel");
+    while (scanning_paused) {
+        pthread_cond_wait(&control_condition, &control_mutex);
+    }
+    pthread_mutex_unlock(&control_mutex);
+}
@@ -0,0 +1,53 @@
+#ifndef DEXDUMPER_CONTROL_CHANNEL_H
+#define DEXDUMPER_CONTROL_CHANNEL_H
+
+// Control channel header - declares the runtime command socket and the scan requests it queues
+
+#include "common.h"
+#include "config.h"
+
+/**
+ * Runtime Control:
+ * 
+ * Without a control channel the dumper scans at startup and stops; any
+ * change means editing the configuration and restarting the app, which
+ * repeats the whole startup scan. With enable_control_channel set, a
+ * thread listens on the abstract UNIX socket "@CONTROL_SOCKET_PREFIX.<pid>"
+ * and answers one command line per connection:
+ * 
+ *   scan [full|incremental|<start>-<end>]  queue a pass (incremental skips
+ *                                          regions seen by an earlier pass,
+ *                                          a hex range scans only that range)
+ *   pause / resume                         hold or continue the running pass
+ *   set <key> <value>                      change a configuration option
+ *   stats                                  statistics of the latest pass
+ *   flush                                  sync the dump manifest to storage
+ * 
+ * Queued scans run on the dumping thread, one at a time. Only the app's
+ * own uid, root and the adb shell may connect.
+ */
+
+// What a scanning pass covers
+typedef enum {
+    SCAN_MODE_FULL = 0,    // Every region, as at startup
+    SCAN_MODE_INCREMENTAL, // Regions whose bounds no earlier pass has seen
+    SCAN_MODE_RANGE        // Regions overlapping an address range, clipped to its enclosing pages
+} ScanMode;
+
+// Scanning pass requested through the control channel
+typedef struct {
+    ScanMode scan_mode;    // What the pass covers
+    uintptr_t range_start; // SCAN_MODE_RANGE: first byte
+    uintptr_t range_end;   // SCAN_MODE_RANGE: one past the last byte
+} ScanRequest;
+
+// Starts listening for commands if the control channel is enabled
+int start_control_channel(const char* output_directory);
+
+// Waits for the next queued scan, returns 0 if the control channel is not running
+int wait_for_scan_request(ScanRequest* scan_request);
+
+// Blocks while a pause command is in effect
+void wait_while_scanning_paused(void);
+
+#endif
@@ -1,4 +1,58 @@
 #include "dex_detector.h"
+#include "config_manager.h"
+#include "scan_statistics.h"
+#include "xor_key_recovery.h"
+#include "calibration.h"
+
+// Budget for the region currently being scanned by this thread
+static __thread RegionScanBudget current_region_budget;
+
+/**
+ * @brief Resets the scan budget before a new region is examined
+ * 
+ * All detection strategies run against the same region share one budget,
+ * so the total work per region stays bounded regardless of strategy count.
+ * 
+ * @param high_priority Nonzero for high-priority regions, which also
+ *                      enable the costlier detectors (e.g. compressed payloads)
+ */
+void begin_region_scan_budget(int high_priority) {
+    memset(&current_region_budget, 0, sizeof(current_region_budget));
+    current_region_budget.high_priority = high_priority;
+}
+
+/**
+ * @brief Gives detectors access to the budget of the region being scanned
+ * 
+ * @return Budget of the current thread's region
+ */
+RegionScanBudget* get_current_region_budget(void) {
+    return &current_region_budget;
+}
+
+/**
+ * @brief Reports whether the current region exhausted its scan budget
+ * 
+ * @return 1 if any candidate, validation or fault budget was exceeded
+ */
+int region_scan_budget_exhausted(void) {
+    return current_region_budget.budget_exhausted;
+}
+
+/**
+ * @brief Marks the current region budget as exhausted
+ * 
+ * @param reason Short description of which budget ran out (for logging)
+ */
+static void exhaust_region_budget(const char* reason) {
+    if (!current_region_budget.budget_exhausted) {
+        current_region_budget.budget_exhausted = 1;
+        SCAN_STAT_ADD(budgets_exhausted, 1);
+        LOGW("Region scan budget exhausted (%s): %zu candidates, %zu validations, %zu faults",
+             reason, current_region_budget.candidates_seen,
+             current_region_budget.validations_performed, current_region_budget.read_faults);
+    }
+}
 
 /**
  * @brief Validates the structure of a potential DEX header
@@ -25,28 +79,33 @@ int validate_dex_header_structure(const void* header_start, size_t buffer_size,
 
     // Validate DEX file size constraints
     if (dex_file_size < DEX_MIN_FILE_SIZE || dex_file_size > DEX_MAX_FILE_SIZE) {
-        LOGW("Invalid DEX file size in header: %u (expected %d-%d)", 
-             dex_file_size, DEX_MIN_FILE_SIZE, DEX_MAX_FILE_SIZE);
+        VLOGD("Invalid DEX file size in header: %u (expected %d-%d)", 
+              dex_file_size, DEX_MIN_FILE_SIZE, DEX_MAX_FILE_SIZE);
         return 0;
     }
 
     // Ensure claimed size fits in available buffer
     if (dex_file_size > (buffer_size - header_offset)) {
-        LOGW("DEX file size %u exceeds available buffer space %zu", 
-             dex_file_size, buffer_size - header_offset);
+        VLOGD("DEX file size %u exceeds available buffer space %zu", 
+              dex_file_size, buffer_size - header_offset);
         return 0;
     }
 
-    // Verify header size field (should be 0x70 for standard DEX)
+    // Verify header size field (0x70 for standard DEX, 0x78 for version 041 containers)
     uint32_t header_size_value = 0;
+    unsigned char magic_bytes[DEX_MAGIC_LEN];
     if (!read_memory_safely((const char*)header_start + header_offset + 0x24, 
-                           &header_size_value, sizeof(uint32_t))) {
+                           &header_size_value, sizeof(uint32_t)) ||
+        !read_memory_safely((const char*)header_start + header_offset, 
+                           magic_bytes, DEX_MAGIC_LEN)) {
         return 0;
     }
     
-    if (header_size_value != DEX_HEADER_SIZE) {
-        LOGW("DEX header size mismatch: %u (expected %u)", 
-             header_size_value, DEX_HEADER_SIZE);
+    uint32_t expected_header_size = memcmp(magic_bytes + 4, "041", 3) == 0 ?
+                                    DEX_CONTAINER_HEADER_SIZE : DEX_HEADER_SIZE;
+    if (header_size_value != expected_header_size) {
+        VLOGD("DEX header size mismatch: %u (expected %u)", 
+              header_size_value, expected_header_size);
         return 0;
     }
 
@@ -58,7 +117,7 @@ int validate_dex_header_structure(const void* header_start, size_t buffer_size,
     }
     
     if (endian_tag_value != 0x12345678U) {
-        LOGW("Unexpected DEX endian tag: 0x%08x", endian_tag_value);
+        VLOGD("Unexpected DEX endian tag: 0x%08x", endian_tag_value);
         return 0;
     }
 
@@ -77,16 +136,195 @@ int validate_dex_header_structure(const void* header_start, size_t buffer_size,
 }
 
 /**
- * @brief Scans memory for DEX file signatures
+ * @brief Checks the DEX version digits following the "dex\n" magic
+ * 
+ * @param signature_bytes At least 8 bytes starting at the magic
+ * @return 1 for a supported version (035-041), 0 otherwise
+ */
+static int is_supported_dex_version(const unsigned char* signature_bytes) {
+    if (signature_bytes[4] != '0' || signature_bytes[7] != '\0') return 0;
+    return (signature_bytes[5] == '3' && signature_bytes[6] >= '5' && signature_bytes[6] <= '9') ||
+           (signature_bytes[5] == '4' && (signature_bytes[6] == '0' || signature_bytes[6] == '1'));
+}
+
+/**
+ * @brief Validate callback of the built-in standard DEX detector
+ */
+static int validate_standard_dex_candidate(const DexDumperMemoryView* memory_view, 
+                                           size_t candidate_offset, void* context) {
+    unsigned char signature_bytes[DEX_MAGIC_LEN];
+    if (candidate_offset + DEX_MAGIC_LEN > memory_view->region_size ||
+        !memory_view->read_memory((const char*)memory_view->base_address + candidate_offset,
+                                  signature_bytes, DEX_MAGIC_LEN)) {
+        return 0;
+    }
+    if (!is_supported_dex_version(signature_bytes)) return 0;
+    
+    return validate_dex_header_structure(memory_view->base_address, memory_view->region_size, 
+                                         candidate_offset);
+}
+
+/**
+ * @brief Extent callback of the built-in standard DEX detector
+ * 
+ * For the first header of a version 041 container the whole container is
+ * taken, so the container parser can split it into its member DEX files.
+ * 
+ * @return file_size (or container_size) field of the validated header
+ */
+static size_t standard_dex_extent(const DexDumperMemoryView* memory_view, 
+                                  size_t candidate_offset, void* context) {
+    const char* header_address = (const char*)memory_view->base_address + candidate_offset;
+    uint32_t file_size_value = 0;
+    uint32_t header_size_value = 0;
+    if (!memory_view->read_memory(header_address + 0x20, &file_size_value, sizeof(uint32_t)) ||
+        !memory_view->read_memory(header_address + 0x24, &header_size_value, sizeof(uint32_t))) {
+        return 0;
+    }
+    
+    if (header_size_value == DEX_CONTAINER_HEADER_SIZE) {
+        uint32_t container_fields[2] = {0}; // container_size, header_offset
+        if (memory_view->read_memory(header_address + 0x70, container_fields, sizeof(container_fields)) &&
+            container_fields[1] == 0 && container_fields[0] > file_size_value &&
+            container_fields[0] <= DEX_MAX_FILE_SIZE &&
+            container_fields[0] <= memory_view->region_size - candidate_offset) {
+            return container_fields[0];
+        }
+    }
+    return file_size_value;
+}
+
+// Built-in detector for standard DEX files (magic at 4-byte aligned offsets)
+static const DexDumperDetector standard_dex_detector = {
+    .abi_version = DEXDUMPER_DETECTOR_ABI_VERSION,
+    .detector_name = "standard DEX",
+    .prefilter_pattern = (const uint8_t*)DEX_MAGIC_SIGNATURE,
+    .prefilter_length = 4,
+    .prefilter_alignment = 4,
+    .validate = validate_standard_dex_candidate,
+    .extent = standard_dex_extent,
+    .context = NULL
+};
+
+// Registered detector with the internal attributes plugins cannot set
+typedef struct {
+    const DexDumperDetector* detector; // Detector description
+    unsigned int detector_flags;       // DETECTOR_FLAG_* bits
+    PayloadEncoding payload_encoding;  // Encoding of payloads this detector reports
+} RegisteredDetector;
+
+// Registered detectors and the first-byte dispatch table built from their prefilters
+static RegisteredDetector registered_detectors[MAX_REGISTERED_DETECTORS] = {
+    { &standard_dex_detector, 0, PAYLOAD_ENCODING_PLAIN }
+};
+static int registered_detector_count = 1;
+static uint32_t prefilter_dispatch_table[256];
+static size_t longest_prefilter_length = 0;
+static int dispatch_table_ready = 0;
+static pthread_mutex_t detector_registry_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief Rebuilds the first-byte dispatch table from registered prefilters
+ * 
+ * Each table entry holds a bitmask of detectors whose prefilter starts with
+ * that byte, so the scanner inspects every byte once no matter how many
+ * detectors are registered. Caller must hold detector_registry_mutex.
+ */
+static void rebuild_prefilter_dispatch_table(void) {
+    memset(prefilter_dispatch_table, 0, sizeof(prefilter_dispatch_table));
+    longest_prefilter_length = 0;
+    
+    for (int i = 0; i < registered_detector_count; i++) {
+        const DexDumperDetector* detector = registered_detectors[i].detector;
+        prefilter_dispatch_table[detector->prefilter_pattern[0]] |= (1U << i);
+        if (detector->prefilter_length > longest_prefilter_length) {
+            longest_prefilter_length = detector->prefilter_length;
+        }
+    }
+    dispatch_table_ready = 1;
+}
+
+/**
+ * @brief Registers a built-in detection strategy with internal attributes
  * 
- * This function searches through memory for DEX magic bytes and
- * validates any potential matches. It handles multiple DEX versions.
+ * Detectors must be registered before scanning starts; the scanner reads
+ * the registry without locking. Registering the same detector twice is a
+ * no-op.
+ * 
+ * @param detector Detector description (must outlive all scans)
+ * @param detector_flags DETECTOR_FLAG_* bits
+ * @param payload_encoding Encoding of payloads reported by this detector
+ * @return 1 if registered, 0 if rejected
+ */
+int register_builtin_detector(const DexDumperDetector* detector, unsigned int detector_flags,
+                              PayloadEncoding payload_encoding) {
+    if (detector == NULL || detector->abi_version != DEXDUMPER_DETECTOR_ABI_VERSION) {
+        LOGW("Rejecting detector with incompatible ABI version");
+        return 0;
+    }
+    if (detector->prefilter_pattern == NULL || detector->prefilter_length == 0 ||
+        detector->prefilter_length > DEXDUMPER_MAX_PREFILTER_LENGTH ||
+        detector->validate == NULL || detector->extent == NULL) {
+        LOGW("Rejecting malformed detector: %s", 
+             detector->detector_name ? detector->detector_name : "(unnamed)");
+        return 0;
+    }
+    
+    pthread_mutex_lock(&detector_registry_mutex);
+    for (int i = 0; i < registered_detector_count; i++) {
+        if (registered_detectors[i].detector == detector) {
+            pthread_mutex_unlock(&detector_registry_mutex);
+            return 1;
+        }
+    }
+    if (registered_detector_count >= MAX_REGISTERED_DETECTORS) {
+        pthread_mutex_unlock(&detector_registry_mutex);
+        LOGW("Detector registry full, %s not registered", detector->detector_name);
+        return 0;
+    }
+    registered_detectors[registered_detector_count].detector = detector;
+    registered_detectors[registered_detector_count].detector_flags = detector_flags;
+    registered_detectors[registered_detector_count].payload_encoding = payload_encoding;
+    registered_detector_count++;
+    rebuild_prefilter_dispatch_table();
+    pthread_mutex_unlock(&detector_registry_mutex);
+    
+    LOGI("Registered detector: %s", detector->detector_name ? detector->detector_name : "(unnamed)");
+    return 1;
+}
+
+/**
+ * @brief Registers an additional plain-payload detection strategy
+ * 
+ * Used for plugin detectors, which always report plain payloads and share
+ * the region's candidate and validation budget.
+ * 
+ * @param detector Detector description (must outlive all scans)
+ * @return 1 if registered, 0 if rejected
+ */
+int register_dex_detector(const DexDumperDetector* detector) {
+    return register_builtin_detector(detector, 0, PAYLOAD_ENCODING_PLAIN);
+}
+
+/**
+ * @brief Scans memory for all registered detector signatures in one pass
+ * 
+ * Memory is read one page-bounded chunk at a time (up to the chunk size
+ * chosen by startup calibration) and every byte is looked up once in the
+ * prefilter dispatch table; only prefilter hits reach the detectors'
+ * validate callbacks. Built-in and plugin detectors therefore
+ * share a single pass over the region.
+ * 
+ * Work is bounded by the per-region budget: after repeated failed
+ * validations the scan skips ahead by an exponentially growing distance,
+ * unreadable pages are skipped whole, and the scan stops once the
+ * candidate, validation or fault budget is used up.
  * 
  * @param scan_start Starting address to scan from
  * @param scan_size Size of memory region to scan
  * @param max_scan_limit Maximum bytes to scan (for performance)
  * @param detection_result Output parameter for detection results
- * @return 1 if DEX found, 0 otherwise
+ * @return 1 if a payload was found, 0 otherwise
  */
 int scan_for_dex_signature(const void* scan_start, size_t scan_size, 
                           size_t max_scan_limit, DexDetectionResult* detection_result) {
@@ -97,55 +335,189 @@ int scan_for_dex_signature(const void* scan_start, size_t scan_size,
     size_t actual_scan_limit = (max_scan_limit > scan_size) ? scan_size : max_scan_limit;
     if (actual_scan_limit < 8) return 0; // Need at least 8 bytes for signature
     
-    unsigned char signature_buffer[8]; // Buffer to read potential signatures
+    pthread_mutex_lock(&detector_registry_mutex);
+    if (!dispatch_table_ready) rebuild_prefilter_dispatch_table();
+    pthread_mutex_unlock(&detector_registry_mutex);
+    
+    RegionScanBudget* budget = &current_region_budget;
+    // Backoff offsets are relative to this scan_start
+    budget->consecutive_failures = 0;
+    budget->skip_distance = 0;
+    budget->skip_end_offset = 0;
+    unsigned int excluded_flags = budget->high_priority ? 0 : DETECTOR_FLAG_HIGH_PRIORITY_ONLY;
+    if (budget->file_backed) excluded_flags |= DETECTOR_FLAG_ANONYMOUS_ONLY;
+    size_t max_candidates = (size_t)get_max_candidates_per_region();
+    size_t max_validations = (size_t)get_max_validations_per_region();
+    size_t max_faults = (size_t)get_max_faults_per_region();
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    size_t chunk_size = get_scan_chunk_size();
+    
+    DexDumperMemoryView memory_view = {
+        .base_address = scan_start,
+        .region_size = scan_size,
+        .read_memory = read_memory_safely
+    };
+    
+    // Chunk buffer with room for a prefilter straddling the chunk end
+    unsigned char chunk_buffer[SCAN_CHUNK_MAX_SIZE + DEXDUMPER_MAX_PREFILTER_LENGTH];
     
-    // Scan through memory in 4-byte increments
-    for (size_t current_offset = 0; current_offset <= actual_scan_limit - 8; current_offset += 4) {
-        // Safely read 8 bytes to check for signature
-        if (!read_memory_safely((const char*)scan_start + current_offset, 
-                               signature_buffer, 8)) {
-            continue; // Skip if we can't read this location
+    size_t current_offset = 0;
+    size_t prefaulted_offset = 0;
+    while (current_offset < actual_scan_limit && !budget->budget_exhausted) {
+        // Fault in the window ahead of the cursor with one call; on failure the guarded reads below cope
+        if (current_offset >= prefaulted_offset) {
+            size_t window_length = actual_scan_limit - current_offset < PREFAULT_WINDOW_SIZE ?
+                                   actual_scan_limit - current_offset : PREFAULT_WINDOW_SIZE;
+            prefault_memory_range((const char*)scan_start + current_offset, window_length);
+            prefaulted_offset = current_offset + window_length;
         }
         
-        // Check for DEX signatures with various versions (035-039)
-        if (memcmp(signature_buffer, "dex\n035", 7) == 0 || 
-            memcmp(signature_buffer, "dex\n036", 7) == 0 ||
-            memcmp(signature_buffer, "dex\n037", 7) == 0 ||
-            memcmp(signature_buffer, "dex\n038", 7) == 0 ||
-            memcmp(signature_buffer, "dex\n039", 7) == 0) {
-            
-            VLOGD("Detected DEX signature at offset %zu", current_offset);
+        // Chunks end at page boundaries so one bad page never hides its neighbours
+        uintptr_t chunk_address = (uintptr_t)scan_start + current_offset;
+        size_t first_page_length = page_size - (chunk_address % page_size);
+        size_t chunk_length = first_page_length;
+        if (chunk_size > page_size) chunk_length += (chunk_size / page_size - 1) * page_size;
+        if (chunk_length > chunk_size) chunk_length = chunk_size;
+        if (chunk_length > actual_scan_limit - current_offset) {
+            chunk_length = actual_scan_limit - current_offset;
+        }
+        if (first_page_length > chunk_length) first_page_length = chunk_length;
+        
+        // Read the chunk plus prefilter overlap; drop the overlap if the next page faults
+        size_t read_length = chunk_length + longest_prefilter_length - 1;
+        if (read_length > actual_scan_limit - current_offset) {
+            read_length = actual_scan_limit - current_offset;
+        }
+        if (!read_memory_safely((const void*)chunk_address, chunk_buffer, read_length)) {
+            read_length = chunk_length;
+            if (!read_memory_safely((const void*)chunk_address, chunk_buffer, read_length)) {
+                // Retry the first page alone: a later page of the chunk may be the bad one
+                int single_page = first_page_length == chunk_length;
+                read_length = chunk_length = first_page_length;
+                if (single_page || !read_memory_safely((const void*)chunk_address, chunk_buffer, read_length)) {
+                    // Skip the rest of this page instead of faulting on every word
+                    budget->read_faults++;
+                    SCAN_STAT_ADD(read_faults, 1);
+                    SCAN_STAT_ADD(bytes_skipped, chunk_length);
+                    if (budget->read_faults >= max_faults) {
+                        exhaust_region_budget("read faults");
+                        break;
+                    }
+                    current_offset += chunk_length;
+                    continue;
+                }
+            }
+        }
+        
+        for (size_t position = 0; position < chunk_length; position++) {
+            uint32_t detector_mask = prefilter_dispatch_table[chunk_buffer[position]];
+            if (detector_mask == 0) continue;
             
-            // Validate the header to confirm it's a real DEX file
-            if (validate_dex_header_structure(scan_start, scan_size, current_offset)) {
-                uint32_t file_size_value = 0;
-                // Read the actual file size from validated header
-                if (read_memory_safely((const char*)scan_start + current_offset + 0x20, 
-                                      &file_size_value, sizeof(uint32_t))) {
-                    detection_result->dex_size = file_size_value;
-                    detection_result->dex_address = (void*)((char*)scan_start + current_offset);
-                    LOGI("Valid DEX file detected at %p, size: %u bytes", 
-                         detection_result->dex_address, file_size_value);
-                    return 1; // Successfully found and validated DEX
+            size_t candidate_offset = current_offset + position;
+            for (int d = 0; detector_mask != 0; d++, detector_mask >>= 1) {
+                if (!(detector_mask & 1U)) continue;
+                const RegisteredDetector* registered = &registered_detectors[d];
+                const DexDumperDetector* detector = registered->detector;
+                if (registered->detector_flags & excluded_flags) continue;
+                int self_budgeted = (registered->detector_flags & DETECTOR_FLAG_SELF_BUDGETED) != 0;
+                
+                // Prefilter must fit, match exactly and honour the alignment
+                if (position + detector->prefilter_length > read_length) continue;
+                if (detector->prefilter_alignment > 1 &&
+                    candidate_offset % detector->prefilter_alignment != 0) continue;
+                if (memcmp(chunk_buffer + position, detector->prefilter_pattern, 
+                           detector->prefilter_length) != 0) continue;
+                
+                VLOGD("Detected %s signature at offset %zu", detector->detector_name, candidate_offset);
+                
+                // Self-budgeted detectors enforce their own limits inside validate
+                if (!self_budgeted) {
+                    // Candidates packed into the skip window are passed over unvalidated,
+                    // a candidate-free stretch ends the backoff
+                    if (budget->skip_distance != 0) {
+                        if (candidate_offset >= budget->last_candidate_offset + SKIP_AHEAD_RESET_DISTANCE) {
+                            budget->skip_distance = 0;
+                            budget->consecutive_failures = 0;
+                        } else if (candidate_offset < budget->skip_end_offset) {
+                            budget->last_candidate_offset = candidate_offset;
+                            continue;
+                        }
+                    }
+                    budget->last_candidate_offset = candidate_offset;
+                    SCAN_STAT_ADD(candidates_found, 1);
+                    
+                    // Stop once the region produced more candidates than any real content would
+                    if (++budget->candidates_seen > max_candidates) {
+                        exhaust_region_budget("candidates");
+                        return 0;
+                    }
+                    if (budget->validations_performed >= max_validations) {
+                        exhaust_region_budget("validations");
+                        return 0;
+                    }
+                    budget->validations_performed++;
+                    SCAN_STAT_ADD(headers_validated, 1);
+                }
+                
+                // Validate the candidate to confirm it's genuine
+                if (detector->validate(&memory_view, candidate_offset, detector->context)) {
+                    if (!self_budgeted) {
+                        budget->consecutive_failures = 0;
+                        budget->skip_distance = 0;
+                    }
+                    size_t payload_size = detector->extent(&memory_view, candidate_offset, 
+                                                           detector->context);
+                    if (payload_size > 0 && payload_size <= scan_size - candidate_offset) {
+                        detection_result->dex_size = payload_size;
+                        detection_result->dex_address = (void*)((char*)scan_start + candidate_offset);
+                        detection_result->detector_name = detector->detector_name;
+                        detection_result->payload_encoding = registered->payload_encoding;
+                        LOGI("Valid payload detected by %s at %p, size: %zu bytes", 
+                             detector->detector_name, detection_result->dex_address, payload_size);
+                        return 1; // Successfully found and validated payload
+                    }
+                }
+                
+                VLOGD("%s signature found but validation failed at offset %zu", 
+                      detector->detector_name, candidate_offset);
+                if (self_budgeted) continue;
+                SCAN_STAT_ADD(validations_failed, 1);
+                
+                // Repeated failures: stop validating candidates for an exponentially growing
+                // distance, then keep backing off on every failure until a validation succeeds
+                // or the candidates thin out
+                if (++budget->consecutive_failures >= SKIP_AHEAD_FAILURE_THRESHOLD || budget->skip_distance != 0) {
+                    budget->skip_distance = budget->skip_distance ?
+                                            budget->skip_distance * 2 : SKIP_AHEAD_INITIAL_DISTANCE;
+                    if (budget->skip_distance > SKIP_AHEAD_MAX_DISTANCE) {
+                        budget->skip_distance = SKIP_AHEAD_MAX_DISTANCE;
+                    }
+                    size_t skip_end_offset = actual_scan_limit - candidate_offset > budget->skip_distance ?
+                                             candidate_offset + budget->skip_distance : actual_scan_limit;
+                    if (skip_end_offset > budget->skip_end_offset) {
+                        size_t skip_start_offset = budget->skip_end_offset > candidate_offset ?
+                                                   budget->skip_end_offset : candidate_offset;
+                        SCAN_STAT_ADD(bytes_skipped, skip_end_offset - skip_start_offset);
+                        budget->skip_end_offset = skip_end_offset;
+                    }
+                    budget->consecutive_failures = 0;
                 }
-            } else {
-                LOGW("DEX signature found but header validation failed at offset %zu", 
-                     current_offset);
             }
         }
+        current_offset += chunk_length;
     }
-    return 0; // No valid DEX found
+    return 0; // No valid payload found
 }
 
 /**
- * @brief Scans a memory region for standard DEX files
+ * @brief Scans a memory region with all registered detectors
  * 
  * Wrapper function that applies size checks before scanning.
  * 
  * @param region_start Start of memory region to scan
  * @param region_size Size of memory region
  * @param detection_result Output for detection results
- * @return 1 if DEX found, 0 otherwise
+ * @return 1 if a payload was found, 0 otherwise
  */
 int scan_region_for_dex_files(const void* region_start, size_t region_size, 
                              DexDetectionResult* detection_result) {
@@ -158,37 +530,13 @@ int scan_region_for_dex_files(const void* region_start, size_t region_size,
 }
 
 /**
- * @brief Scans OAT containers for embedded DEX files
- * 
- * OAT files are Android's optimized ART format that often contain
- * embedded DEX files. This function specifically handles OAT containers.
- * 
- * @param region_start Start of memory region
- * @param region_size Size of memory region  
- * @param detection_result Output for detection results
- * @return 1 if DEX found in OAT, 0 otherwise
- */
-int scan_region_for_oat_dex_files(const void* region_start, size_t region_size, 
-                                 DexDetectionResult* detection_result) {
-    // Check for OAT magic signature
-    if (region_size < 8) return 0;
-    
-    unsigned char oat_magic[4];
-    if (!read_memory_safely(region_start, oat_magic, 4)) return 0;
-    
-    // Verify OAT container signature
-    if (memcmp(oat_magic, "oat\n", 4) != 0) return 0;
-    
-    VLOGD("Detected OAT container, scanning for embedded DEX");
-    // Scan first 64KB of OAT for embedded DEX (common location)
-    return scan_for_dex_signature(region_start, region_size, 64 * 1024, detection_result);
-}
-
-/**
- * @brief Performs comprehensive DEX detection using multiple strategies
+ * @brief Performs comprehensive DEX detection on a memory region
  * 
- * This function tries different detection methods to find DEX files
- * in various formats and containers.
+ * All detectors (the built-in DEX detector and any loaded plugins) are
+ * evaluated in a single pass over the region. OAT containers need no
+ * separate pass: their embedded DEX files are found by the same scan.
+ * High-priority regions without a hit are then screened for a DEX
+ * obfuscated with a repeating XOR/ADD key.
  * 
  * @param region_start Start of memory region to scan
  * @param region_size Size of memory region
@@ -197,25 +545,25 @@ int scan_region_for_oat_dex_files(const void* region_start, size_t region_size,
  */
 int perform_comprehensive_dex_detection(const void* region_start, size_t region_size, 
                                        DexDetectionResult* detection_result) {
-    // Array of detection strategies to try
-    const struct {
-        const char* detection_type;  // Name for logging
-        int (*detector_function)(const void*, size_t, DexDetectionResult*); // Function pointer
-    } detection_strategies[] = {
-        {"standard DEX", scan_region_for_dex_files},    // First try standard DEX
-        {"OAT container", scan_region_for_oat_dex_files} // Then try OAT containers
-    };
+    // Note OAT containers for diagnostics
+    unsigned char oat_magic[4];
+    if (region_size >= 8 && read_memory_safely(region_start, oat_magic, 4) &&
+        memcmp(oat_magic, "oat\n", 4) == 0) {
+        VLOGD("Detected OAT container, scanning for embedded DEX");
+    }
     
-    size_t strategy_count = sizeof(detection_strategies) / sizeof(detection_strategies[0]);
+    VLOGD("Attempting single-pass detection with %d detectors", registered_detector_count);
+    if (scan_region_for_dex_files(region_start, region_size, detection_result)) {
+        LOGI("DEX file detected via %s strategy", detection_result->detector_name);
+        return 1;
+    }
     
-    // Try each detection strategy in order
-    for (size_t i = 0; i < strategy_count; i++) {
-        VLOGD("Attempting %s detection", detection_strategies[i].detection_type);
-        if (detection_strategies[i].detector_function(region_start, region_size, detection_result)) {
-            LOGI("DEX file detected via %s strategy", detection_strategies[i].detection_type);
-            return 1; // Success with this strategy
-        }
+    // Key-obfuscated DEX has no magic to prefilter on, screen high-priority regions separately
+    if (current_region_budget.high_priority && !current_region_budget.budget_exhausted &&
+        scan_for_xor_obfuscated_dex(region_start, region_size, detection_result)) {
+        LOGI("DEX file detected via %s strategy", detection_result->detector_name);
+        return 1;
     }
     
-    return 0; // No strategies succeeded
-}
\ No newline at end of file
+    return 0; // No detector succeeded
+}
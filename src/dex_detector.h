@@ -6,6 +6,7 @@
 #include "common.h"
 #include "config.h"
 #include "signal_handler.h"  // For read_memory_safely
+#include "dexdumper_plugin.h" // Detector plugin ABI
 
 /**
  * DEX Detection Functions:
@@ -14,22 +15,39 @@
  * in process memory using signature scanning and header validation.
  */
 
+// Detector attributes only available to built-in detectors
+#define DETECTOR_FLAG_HIGH_PRIORITY_ONLY 0x1 // Only run in high-priority regions
+#define DETECTOR_FLAG_SELF_BUDGETED 0x2      // Enforces its own budget, not the shared one
+#define DETECTOR_FLAG_ANONYMOUS_ONLY 0x4     // Skips regions that map a file on disk
+
+// Resets the per-region scan budget before scanning a new region
+void begin_region_scan_budget(int high_priority);
+
+// Returns the scan budget of the region currently scanned by this thread
+RegionScanBudget* get_current_region_budget(void);
+
+// Reports whether the current region ran out of scan budget
+int region_scan_budget_exhausted(void);
+
+// Registers a built-in detector with internal flags and payload encoding
+int register_builtin_detector(const DexDumperDetector* detector, unsigned int detector_flags,
+                              PayloadEncoding payload_encoding);
+
+// Registers an additional plain-payload detector (e.g. from a plugin) for the single-pass scan
+int register_dex_detector(const DexDumperDetector* detector);
+
 // Validates DEX header structure to confirm genuine DEX files
 int validate_dex_header_structure(const void* header_start, size_t buffer_size, 
                                  size_t header_offset);
 
-// Scans memory region for DEX magic signatures
+// Scans memory region for all registered detector signatures in one pass
 int scan_for_dex_signature(const void* scan_start, size_t scan_size, 
                           size_t max_scan_limit, DexDetectionResult* detection_result);
 
-// Scans a memory region for standard DEX files
+// Scans a memory region with all registered detectors
 int scan_region_for_dex_files(const void* region_start, size_t region_size, 
                              DexDetectionResult* detection_result);
 
-// Specialized scanner for OAT files containing embedded DEX
-int scan_region_for_oat_dex_files(const void* region_start, size_t region_size, 
-                                 DexDetectionResult* detection_result);
-
 // Comprehensive detection using multiple strategies
 int perform_comprehensive_dex_detection(const void* region_start, size_t region_size, 
                                        DexDetectionResult* detection_result);
@@ -0,0 +1,162 @@
+#include "dump_manifest.h"
+#include "io_engine.h"
+#include "content_hash.h"
+
+// Serializes manifest appends from concurrent writers
+static pthread_mutex_t manifest_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief Builds the manifest path for an output directory
+ */
+static void build_manifest_path(char* path_buffer, size_t buffer_size, const char* output_directory) {
+    snprintf(path_buffer, buffer_size, "%s/%s", output_directory, DUMP_MANIFEST_FILENAME);
+}
+
+/**
+ * @brief Returns the worst-case size of a string written as a JSON literal
+ */
+static size_t json_string_capacity(const char* text) {
+    return (text ? strlen(text) : 0) * 6 + 2;
+}
+
+/**
+ * @brief Appends a string as a JSON string literal to a record
+ * 
+ * Region paths and zip entry names come from the target app, so quotes,
+ * backslashes and control characters are escaped. The record must have
+ * json_string_capacity() bytes left.
+ * 
+ * @param record Record being built
+ * @param position Current end of the record
+ * @param text String to write (NULL is written as empty)
+ * @return New end of the record
+ */
+static size_t append_json_string(char* record, size_t position, const char* text) {
+    record[position++] = '"';
+    for (const unsigned char* p = (const unsigned char*)(text ? text : ""); *p; p++) {
+        if (*p == '"' || *p == '\\') {
+            record[position++] = '\\';
+            record[position++] = (char)*p;
+        } else if (*p < 0x20) {
+            position += (size_t)sprintf(record + position, "\\u%04x", *p);
+        } else {
+            record[position++] = (char)*p;
+        }
+    }
+    record[position++] = '"';
+    return position;
+}
+
+/**
+ * @brief Truncates the manifest at the start of a dumping session
+ * 
+ * The output directory is cleaned of old dumps at startup, so the
+ * manifest is reset at the same time to describe this session only.
+ * Neither happens while other processes of the app are dumping.
+ * 
+ * @param output_directory Directory holding the dumped files
+ */
+void init_dump_manifest(const char* output_directory) {
+    char manifest_path[MAX_PATH_LENGTH];
+    build_manifest_path(manifest_path, sizeof(manifest_path), output_directory);
+    
+    pthread_mutex_lock(&manifest_mutex);
+    FILE* manifest_file = fopen(manifest_path, "w");
+    if (manifest_file) {
+        fclose(manifest_file);
+    } else {
+        LOGW("Failed to reset dump manifest %s: %s", manifest_path, strerror(errno));
+    }
+    pthread_mutex_unlock(&manifest_mutex);
+}
+
+/**
+ * @brief Appends one record for a dumped file
+ * 
+ * @param output_directory Directory holding the dumped files
+ * @param dump_file_path Full path of the dumped file
+ * @param sha1_digest SHA1 of the dumped content (20 bytes), NULL if it was never computed
+ * @param content_id Tree hash content ID (CONTENT_ID_SIZE bytes), NULL if the dump has none
+ * @param data_size Size of the dumped content
+ * @param memory_region Region the payload originated from
+ * @param provenance Provenance chain of the payload (may be NULL)
+ */
+void append_dump_manifest_record(const char* output_directory, const char* dump_file_path,
+                                 const uint8_t* sha1_digest, const uint8_t* content_id, size_t data_size,
+                                 const MemoryRegion* memory_region, const char* provenance) {
+    char manifest_path[MAX_PATH_LENGTH];
+    build_manifest_path(manifest_path, sizeof(manifest_path), output_directory);
+    
+    // Record the file name only, the directory is implied by the manifest location
+    const char* file_name = strrchr(dump_file_path, '/');
+    file_name = file_name ? file_name + 1 : dump_file_path;
+    
+    // Build the whole record first so it reaches the manifest in a single write
+    size_t record_capacity = 256 + CONTENT_ID_SIZE * 2 + json_string_capacity(file_name) +
+                             json_string_capacity(memory_region->path_name) +
+                             json_string_capacity(provenance);
+    char* record = malloc(record_capacity);
+    if (!record) return;
+    
+    size_t record_length = (size_t)sprintf(record, "{\"file\":");
+    record_length = append_json_string(record, record_length, file_name);
+    if (sha1_digest) {
+        char sha1_hex[41];
+        for (int i = 0; i < 20; i++) {
+            snprintf(sha1_hex + i * 2, 3, "%02x", sha1_digest[i]);
+        }
+        record_length += (size_t)sprintf(record + record_length, ",\"sha1\":\"%s\"", sha1_hex);
+    }
+    if (content_id) {
+        char content_id_hex[CONTENT_ID_SIZE * 2 + 1];
+        content_id_to_hex_string(content_id, content_id_hex, sizeof(content_id_hex));
+        record_length += (size_t)sprintf(record + record_length, ",\"content_id\":\"%s\"", content_id_hex);
+    }
+    record_length += (size_t)sprintf(record + record_length,
+                                     ",\"size\":%zu,\"region_start\":\"%p\",\"region_end\":\"%p\",\"region_path\":",
+                                     data_size, memory_region->start_address, memory_region->end_address);
+    record_length = append_json_string(record, record_length, memory_region->path_name);
+    record_length += (size_t)sprintf(record + record_length, ",\"provenance\":");
+    record_length = append_json_string(record, record_length, provenance);
+    record_length += (size_t)sprintf(record + record_length, "}\n");
+    
+    pthread_mutex_lock(&manifest_mutex);
+    int manifest_fd = open(manifest_path, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+    if (manifest_fd < 0) {
+        pthread_mutex_unlock(&manifest_mutex);
+        LOGW("Failed to append to dump manifest %s: %s", manifest_path, strerror(errno));
+        free(record);
+        return;
+    }
+    
+    // O_APPEND: the record lands at the end of the manifest whatever the offset
+    if (!io_engine_write_all(manifest_fd, record, record_length, 0)) {
+        LOGW("Failed to append to dump manifest %s: %s", manifest_path, strerror(errno));
+    }
+    
+    close(manifest_fd);
+    pthread_mutex_unlock(&manifest_mutex);
+    free(record);
+}
+
+/**
+ * @brief Forces the manifest written so far to storage
+ * 
+ * Records reach the manifest with a single write each, so a flushed
+ * manifest never ends in a partial record.
+ * 
+ * @param output_directory Directory holding the dumped files
+ * @return 1 on success, 0 if the manifest could not be opened or synced
+ */
+int flush_dump_manifest(const char* output_directory) {
+    char manifest_path[MAX_PATH_LENGTH];
+    build_manifest_path(manifest_path, sizeof(manifest_path), output_directory);
+    
+    pthread_mutex_lock(&manifest_mutex);
+    int manifest_fd = open(manifest_path, O_WRONLY | O_CLOEXEC);
+    int flushed = manifest_fd >= 0 && fdatasync(manifest_fd) == 0;
+    if (!flushed) LOGW("Failed to flush dump manifest %s: %s", manifest_path, strerror(errno));
+    if (manifest_fd >= 0) close(manifest_fd);
+    pthread_mutex_unlock(&manifest_mutex);
+    return flushed;
+}
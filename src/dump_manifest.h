@@ -0,0 +1,29 @@
+#ifndef DEXDUMPER_DUMP_MANIFEST_H
+#define DEXDUMPER_DUMP_MANIFEST_H
+
+// Dump manifest header - declares the JSON-lines record of every dumped file
+
+#include "common.h"
+#include "config.h"
+
+/**
+ * Dump Manifest:
+ * 
+ * Every successful dump appends one JSON object per line to
+ * DUMP_MANIFEST_FILENAME in the output directory. Records carry the
+ * source region and the provenance chain describing how the payload
+ * was reached (e.g. zip entry -> inflated stream -> container member).
+ */
+
+// Truncates the manifest at the start of a dumping session
+void init_dump_manifest(const char* output_directory);
+
+// Appends one record for a dumped file
+void append_dump_manifest_record(const char* output_directory, const char* dump_file_path,
+                                 const uint8_t* sha1_digest, const uint8_t* content_id, size_t data_size,
+                                 const MemoryRegion* memory_region, const char* provenance);
+
+// Forces the manifest written so far to storage
+int flush_dump_manifest(const char* output_directory);
+
+#endif
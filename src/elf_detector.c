@@ -0,0 +1,917 @@
+#include "elf_detector.h"
+#include "dex_detector.h"
+#include "self_exclusion.h"
+#include "config_manager.h"
+#include "scan_statistics.h"
+#include <elf.h>
+
+// Tags and section types missing from older <elf.h> versions
+#ifndef DT_RELRSZ
+#define DT_RELRSZ 35
+#define DT_RELR 36
+#define DT_RELRENT 37
+#endif
+#ifndef SHT_RELR
+#define SHT_RELR 19
+#endif
+#ifndef DT_ANDROID_REL
+#define DT_ANDROID_REL 0x6000000f
+#define DT_ANDROID_RELSZ 0x60000010
+#define DT_ANDROID_RELA 0x60000011
+#define DT_ANDROID_RELASZ 0x60000012
+#endif
+#ifndef SHT_ANDROID_REL
+#define SHT_ANDROID_REL 0x60000001
+#define SHT_ANDROID_RELA 0x60000002
+#endif
+
+// ELF and program headers must lie within the first page
+#define ELF_HEADER_WINDOW 4096
+
+// Dynamic entries checked when deciding which layout an image is in
+#define DYNAMIC_PROBE_ENTRIES 4
+
+// Room reserved after the segments for rebuilt section names and headers
+#define SECTION_REBUILD_RESERVE 4096
+#define MAX_REBUILT_SECTIONS 16
+#define SECTION_NAMES_CAPACITY 256
+
+// Program header normalized from either ELF class
+typedef struct {
+    uint32_t type;
+    uint64_t offset;
+    uint64_t vaddr;
+    uint64_t filesz;
+    uint64_t memsz;
+    uint64_t align;
+} ElfSegment;
+
+// ELF header fields and program headers normalized from either ELF class
+typedef struct {
+    int is_64bit;
+    uint64_t section_header_offset;
+    uint16_t section_header_size;
+    uint16_t section_count;
+    uint16_t section_name_index;
+    ElfSegment segments[ELF_MAX_PROGRAM_HEADERS];
+    int segment_count;
+    int dynamic_index;        // Index of PT_DYNAMIC, -1 if none
+    uint64_t base_vaddr;      // Virtual address of the first load segment (holds the header)
+    uint64_t file_extent;     // End of the last segment in file layout
+    uint64_t mapped_extent;   // End of the last segment's file bytes in memory, from the header
+} ElfImageInfo;
+
+/**
+ * @brief Copies bytes of an image, refusing ranges past readable_size
+ */
+static int read_image_bytes(const uint8_t* image_address, size_t readable_size,
+                            uint64_t offset, void* buffer, size_t size) {
+    if (offset > readable_size || size > readable_size - offset) return 0;
+    return read_memory_safely(image_address + offset, buffer, size);
+}
+
+/**
+ * @brief Parses and sanity-checks the ELF and program headers of an image
+ * 
+ * Only little-endian shared objects and executables for the ABIs Android
+ * runs are accepted. Load segments must be sorted, congruent with their
+ * alignment, and the first one must map the ELF header.
+ * 
+ * @param image_address Address of the ELF header
+ * @param readable_size Bytes that may be read from image_address
+ * @param info Output: normalized headers
+ * @return 1 if the headers describe a plausible image, 0 otherwise
+ */
+static int parse_elf_image(const uint8_t* image_address, size_t readable_size, ElfImageInfo* info) {
+    unsigned char header[sizeof(Elf64_Ehdr)];
+    if (!read_image_bytes(image_address, readable_size, 0, header, sizeof(Elf32_Ehdr))) return 0;
+    if (memcmp(header, ELFMAG, SELFMAG) != 0 || header[EI_DATA] != ELFDATA2LSB ||
+        header[EI_VERSION] != EV_CURRENT) {
+        return 0;
+    }
+    
+    memset(info, 0, sizeof(*info));
+    info->dynamic_index = -1;
+    uint16_t image_type, machine, header_size, segment_header_size, segment_count;
+    uint32_t version;
+    uint64_t segment_header_offset;
+    
+    if (header[EI_CLASS] == ELFCLASS64) {
+        if (!read_image_bytes(image_address, readable_size, 0, header, sizeof(Elf64_Ehdr))) return 0;
+        Elf64_Ehdr elf_header;
+        memcpy(&elf_header, header, sizeof(elf_header));
+        info->is_64bit = 1;
+        image_type = elf_header.e_type;
+        machine = elf_header.e_machine;
+        version = elf_header.e_version;
+        header_size = elf_header.e_ehsize;
+        segment_header_offset = elf_header.e_phoff;
+        segment_header_size = elf_header.e_phentsize;
+        segment_count = elf_header.e_phnum;
+        info->section_header_offset = elf_header.e_shoff;
+        info->section_header_size = elf_header.e_shentsize;
+        info->section_count = elf_header.e_shnum;
+        info->section_name_index = elf_header.e_shstrndx;
+        if (machine != EM_AARCH64 && machine != EM_X86_64 && machine != EM_RISCV) return 0;
+        if (header_size != sizeof(Elf64_Ehdr) || segment_header_size != sizeof(Elf64_Phdr)) return 0;
+    } else if (header[EI_CLASS] == ELFCLASS32) {
+        Elf32_Ehdr elf_header;
+        memcpy(&elf_header, header, sizeof(elf_header));
+        image_type = elf_header.e_type;
+        machine = elf_header.e_machine;
+        version = elf_header.e_version;
+        header_size = elf_header.e_ehsize;
+        segment_header_offset = elf_header.e_phoff;
+        segment_header_size = elf_header.e_phentsize;
+        segment_count = elf_header.e_phnum;
+        info->section_header_offset = elf_header.e_shoff;
+        info->section_header_size = elf_header.e_shentsize;
+        info->section_count = elf_header.e_shnum;
+        info->section_name_index = elf_header.e_shstrndx;
+        if (machine != EM_ARM && machine != EM_386) return 0;
+        if (header_size != sizeof(Elf32_Ehdr) || segment_header_size != sizeof(Elf32_Phdr)) return 0;
+    } else {
+        return 0;
+    }
+    
+    if ((image_type != ET_DYN && image_type != ET_EXEC) || version != EV_CURRENT) return 0;
+    if (segment_count == 0 || segment_count > ELF_MAX_PROGRAM_HEADERS) return 0;
+    size_t segment_table_size = (size_t)segment_count * segment_header_size;
+    if (segment_header_offset < header_size ||
+        segment_header_offset + segment_table_size > ELF_HEADER_WINDOW) {
+        return 0;
+    }
+    
+    unsigned char segment_table[ELF_MAX_PROGRAM_HEADERS * sizeof(Elf64_Phdr)];
+    if (!read_image_bytes(image_address, readable_size, segment_header_offset,
+                          segment_table, segment_table_size)) {
+        return 0;
+    }
+    
+    int load_count = 0;
+    uint64_t previous_load_vaddr = 0;
+    for (int i = 0; i < segment_count; i++) {
+        ElfSegment* segment = &info->segments[i];
+        if (info->is_64bit) {
+            Elf64_Phdr program_header;
+            memcpy(&program_header, segment_table + i * sizeof(Elf64_Phdr), sizeof(program_header));
+            segment->type = program_header.p_type;
+            segment->offset = program_header.p_offset;
+            segment->vaddr = program_header.p_vaddr;
+            segment->filesz = program_header.p_filesz;
+            segment->memsz = program_header.p_memsz;
+            segment->align = program_header.p_align;
+        } else {
+            Elf32_Phdr program_header;
+            memcpy(&program_header, segment_table + i * sizeof(Elf32_Phdr), sizeof(program_header));
+            segment->type = program_header.p_type;
+            segment->offset = program_header.p_offset;
+            segment->vaddr = program_header.p_vaddr;
+            segment->filesz = program_header.p_filesz;
+            segment->memsz = program_header.p_memsz;
+            segment->align = program_header.p_align;
+        }
+        
+        if (segment->filesz > ELF_MAX_IMAGE_SIZE || segment->offset > ELF_MAX_IMAGE_SIZE - segment->filesz) {
+            return 0;
+        }
+        if (segment->type == PT_DYNAMIC) info->dynamic_index = i;
+        if (segment->type != PT_LOAD) continue;
+        
+        // Loaders insist on sorted, alignment-congruent load segments
+        if (segment->filesz > segment->memsz) return 0;
+        if (segment->align > 1 && ((segment->align & (segment->align - 1)) != 0 ||
+                                   (segment->vaddr - segment->offset) % segment->align != 0)) {
+            return 0;
+        }
+        if (load_count == 0) {
+            if (segment->offset != 0) return 0; // First load segment maps the ELF header
+            info->base_vaddr = segment->vaddr;
+        } else if (segment->vaddr < previous_load_vaddr) {
+            return 0;
+        }
+        previous_load_vaddr = segment->vaddr;
+        load_count++;
+        
+        if (segment->vaddr - info->base_vaddr > ELF_MAX_IMAGE_SIZE - segment->filesz) return 0;
+        uint64_t mapped_end = segment->vaddr - info->base_vaddr + segment->filesz;
+        if (mapped_end > info->mapped_extent) info->mapped_extent = mapped_end;
+    }
+    if (load_count == 0) return 0;
+    info->segment_count = segment_count;
+    
+    for (int i = 0; i < segment_count; i++) {
+        uint64_t file_end = info->segments[i].offset + info->segments[i].filesz;
+        if (info->segments[i].filesz > 0 && file_end > info->file_extent) info->file_extent = file_end;
+    }
+    return 1;
+}
+
+/**
+ * @brief Checks whether the section header table is present in file layout
+ * 
+ * @return Offset just past the section header table, 0 if it is missing or invalid
+ */
+static uint64_t intact_section_table_end(const uint8_t* image_address, size_t readable_size,
+                                         const ElfImageInfo* info) {
+    size_t header_size = info->is_64bit ? sizeof(Elf64_Shdr) : sizeof(Elf32_Shdr);
+    if (info->section_header_offset == 0 || info->section_count == 0 ||
+        info->section_header_size != header_size || info->section_name_index >= info->section_count ||
+        info->section_header_offset > ELF_MAX_IMAGE_SIZE) {
+        return 0;
+    }
+    
+    // Section 0 is all zero and the name table must be a string table
+    unsigned char null_section[sizeof(Elf64_Shdr)];
+    unsigned char name_section[sizeof(Elf64_Shdr)];
+    uint64_t name_section_offset = info->section_header_offset +
+                                   (uint64_t)info->section_name_index * header_size;
+    if (!read_image_bytes(image_address, readable_size, info->section_header_offset,
+                          null_section, header_size) ||
+        !read_image_bytes(image_address, readable_size, name_section_offset, name_section, header_size)) {
+        return 0;
+    }
+    for (size_t i = 0; i < header_size; i++) {
+        if (null_section[i] != 0) return 0;
+    }
+    uint32_t name_section_type;
+    memcpy(&name_section_type, name_section + 4, sizeof(name_section_type)); // sh_type in both classes
+    if (name_section_type != SHT_STRTAB) return 0;
+    
+    return info->section_header_offset + (uint64_t)info->section_count * header_size;
+}
+
+/**
+ * @brief Checks whether a dynamic section starts at the given image offset
+ * 
+ * The first entries must carry known tags before any DT_NULL.
+ * 
+ * @param tags Output: the first DYNAMIC_PROBE_ENTRIES tags (zero after DT_NULL)
+ */
+static int is_plausible_dynamic_section(const uint8_t* image_address, size_t readable_size,
+                                        uint64_t offset, int is_64bit, int64_t* tags) {
+    size_t entry_size = is_64bit ? sizeof(Elf64_Dyn) : sizeof(Elf32_Dyn);
+    unsigned char entries[DYNAMIC_PROBE_ENTRIES * sizeof(Elf64_Dyn)];
+    if (!read_image_bytes(image_address, readable_size, offset, entries,
+                          DYNAMIC_PROBE_ENTRIES * entry_size)) {
+        return 0;
+    }
+    
+    memset(tags, 0, DYNAMIC_PROBE_ENTRIES * sizeof(int64_t));
+    for (int i = 0; i < DYNAMIC_PROBE_ENTRIES; i++) {
+        int64_t tag;
+        if (is_64bit) {
+            memcpy(&tag, entries + i * entry_size, sizeof(int64_t));
+        } else {
+            int32_t tag32;
+            memcpy(&tag32, entries + i * entry_size, sizeof(int32_t));
+            tag = tag32;
+        }
+        if (tag == DT_NULL) return i > 0;
+        if (!(tag > 0 && tag <= DT_RELRENT) && !(tag >= 0x60000000 && tag < 0x70000000)) return 0;
+        tags[i] = tag;
+    }
+    return 1;
+}
+
+/**
+ * @brief Determines the layout and size of an ELF image
+ * 
+ * An image whose load segments sit at the same offsets in memory and in
+ * the file needs no rebuild. Otherwise a dynamic section at its virtual
+ * address marks a loaded library and one at its file offset (or an intact
+ * section header table) marks a raw file copy. A loader mapping whole
+ * file pages leaves a stale copy of the dynamic section at its file
+ * offset too; identical tags at both places still mean a loaded library.
+ * A loaded library usually continues past the region it starts in, since
+ * the loader maps every segment with its own protection.
+ * 
+ * @param image_address Address of the ELF header
+ * @param available_size Bytes that may be read from image_address
+ * @param image_size Output: file size (file layout) or mapped span (mapped layout)
+ * @return Layout of the image, ELF_IMAGE_LAYOUT_NONE if not a supported ELF image
+ */
+ElfImageLayout inspect_elf_image(const void* image_address, size_t available_size, size_t* image_size) {
+    const uint8_t* image = image_address;
+    ElfImageInfo info;
+    *image_size = 0;
+    if (!parse_elf_image(image, available_size, &info)) return ELF_IMAGE_LAYOUT_NONE;
+    
+    uint64_t file_size = info.file_extent;
+    uint64_t section_table_end = intact_section_table_end(image, available_size, &info);
+    if (section_table_end > file_size && section_table_end <= ELF_MAX_IMAGE_SIZE) file_size = section_table_end;
+    
+    int layouts_match = 1;
+    for (int i = 0; i < info.segment_count; i++) {
+        const ElfSegment* segment = &info.segments[i];
+        if (segment->type == PT_LOAD && segment->vaddr - info.base_vaddr != segment->offset) {
+            layouts_match = 0;
+            break;
+        }
+    }
+    if (layouts_match) {
+        *image_size = file_size;
+        return ELF_IMAGE_LAYOUT_FILE;
+    }
+    
+    if (info.dynamic_index >= 0) {
+        const ElfSegment* dynamic = &info.segments[info.dynamic_index];
+        int64_t file_tags[DYNAMIC_PROBE_ENTRIES];
+        int64_t mapped_tags[DYNAMIC_PROBE_ENTRIES];
+        int file_layout_plausible = is_plausible_dynamic_section(image, available_size, dynamic->offset,
+                                                                 info.is_64bit, file_tags);
+        int mapped_layout_plausible = dynamic->vaddr >= info.base_vaddr &&
+            is_plausible_dynamic_section(image, available_size, dynamic->vaddr - info.base_vaddr,
+                                         info.is_64bit, mapped_tags);
+        if (mapped_layout_plausible &&
+            (!file_layout_plausible || memcmp(file_tags, mapped_tags, sizeof(file_tags)) == 0)) {
+            *image_size = info.mapped_extent;
+            return ELF_IMAGE_LAYOUT_MAPPED;
+        }
+        if (file_layout_plausible) {
+            *image_size = file_size;
+            return ELF_IMAGE_LAYOUT_FILE;
+        }
+    }
+    if (section_table_end != 0) {
+        *image_size = file_size;
+        return ELF_IMAGE_LAYOUT_FILE;
+    }
+    return ELF_IMAGE_LAYOUT_NONE;
+}
+
+/**
+ * @brief Validate callback shared by the ELF image detectors
+ * 
+ * The detector context holds the layout it accepts. Reads may go past the
+ * region end: the rest of a loaded library lives in the following mappings.
+ */
+static int validate_elf_image_candidate(const DexDumperMemoryView* memory_view,
+                                        size_t candidate_offset, void* context) {
+    const ElfImageLayout* accepted_layout = context;
+    size_t image_size = 0;
+    return inspect_elf_image((const char*)memory_view->base_address + candidate_offset,
+                             ELF_MAX_IMAGE_SIZE, &image_size) == *accepted_layout;
+}
+
+/**
+ * @brief Extent callback shared by the ELF image detectors
+ * 
+ * The extent stops at the region end. A truncated file image is dumped as
+ * far as it goes; the rebuild stage of a loaded library reads the
+ * remaining segments itself.
+ */
+static size_t elf_image_extent(const DexDumperMemoryView* memory_view,
+                               size_t candidate_offset, void* context) {
+    size_t image_size = 0;
+    if (inspect_elf_image((const char*)memory_view->base_address + candidate_offset,
+                          ELF_MAX_IMAGE_SIZE, &image_size) == ELF_IMAGE_LAYOUT_NONE) {
+        return 0;
+    }
+    size_t available_size = memory_view->region_size - candidate_offset;
+    return image_size < available_size ? image_size : available_size;
+}
+
+static ElfImageLayout file_layout_context = ELF_IMAGE_LAYOUT_FILE;
+static ElfImageLayout mapped_layout_context = ELF_IMAGE_LAYOUT_MAPPED;
+
+// Raw .so copies sit in heap buffers, loaded libraries start on a page boundary
+static const DexDumperDetector elf_image_detectors[] = {
+    {
+        .abi_version = DEXDUMPER_DETECTOR_ABI_VERSION,
+        .detector_name = "ELF file image",
+        .prefilter_pattern = (const uint8_t*)ELFMAG,
+        .prefilter_length = SELFMAG,
+        .prefilter_alignment = 8,
+        .validate = validate_elf_image_candidate,
+        .extent = elf_image_extent,
+        .context = &file_layout_context
+    },
+    {
+        .abi_version = DEXDUMPER_DETECTOR_ABI_VERSION,
+        .detector_name = "mapped ELF image",
+        .prefilter_pattern = (const uint8_t*)ELFMAG,
+        .prefilter_length = SELFMAG,
+        .prefilter_alignment = 4096,
+        .validate = validate_elf_image_candidate,
+        .extent = elf_image_extent,
+        .context = &mapped_layout_context
+    }
+};
+
+/**
+ * @brief Registers the ELF image detectors
+ * 
+ * They only run on memory not backed by a file, so libraries the system
+ * linker mapped from disk are left alone.
+ */
+void register_elf_image_detectors(void) {
+    register_builtin_detector(&elf_image_detectors[0], DETECTOR_FLAG_ANONYMOUS_ONLY,
+                              PAYLOAD_ENCODING_PLAIN);
+    register_builtin_detector(&elf_image_detectors[1], DETECTOR_FLAG_ANONYMOUS_ONLY,
+                              PAYLOAD_ENCODING_ELF_MAPPED);
+}
+
+// Section header collected before it is written in the image's class
+typedef struct {
+    uint32_t name_offset;
+    uint32_t type;
+    uint64_t flags;
+    uint64_t address;
+    uint64_t offset;
+    uint64_t size;
+    uint32_t link;
+    uint32_t info;
+    uint64_t alignment;
+    uint64_t entry_size;
+} RebuiltSection;
+
+// Section headers and their name table built from the dynamic segment
+typedef struct {
+    RebuiltSection sections[MAX_REBUILT_SECTIONS];
+    int section_count;
+    char names[SECTION_NAMES_CAPACITY];
+    size_t names_length;
+} SectionTable;
+
+// Dynamic entries used to locate sections
+typedef struct {
+    uint64_t values[DT_RELRENT + 1]; // Indexed by tag for the standard tags
+    uint8_t present[DT_RELRENT + 1];
+    uint64_t gnu_hash;
+    uint64_t versym;
+    uint64_t android_rel;
+    uint64_t android_rel_size;
+    uint64_t android_rela;
+    uint64_t android_rela_size;
+} DynamicInfo;
+
+/**
+ * @brief Appends a section to the rebuilt table
+ * 
+ * @return Index of the new section, 0 if it was not added
+ */
+static int add_rebuilt_section(SectionTable* table, const char* name, uint32_t type, uint64_t flags,
+                               uint64_t address, uint64_t offset, uint64_t size,
+                               uint64_t entry_size, uint64_t alignment) {
+    size_t name_length = strlen(name) + 1;
+    if (table->section_count >= MAX_REBUILT_SECTIONS ||
+        table->names_length + name_length > sizeof(table->names)) {
+        return 0;
+    }
+    
+    RebuiltSection* section = &table->sections[table->section_count];
+    memset(section, 0, sizeof(*section));
+    section->name_offset = table->names_length;
+    section->type = type;
+    section->flags = flags;
+    section->address = address;
+    section->offset = offset;
+    section->size = size;
+    section->entry_size = entry_size;
+    section->alignment = alignment;
+    memcpy(table->names + table->names_length, name, name_length);
+    table->names_length += name_length;
+    return table->section_count++;
+}
+
+/**
+ * @brief Maps a link-time address to its file offset
+ * 
+ * @return 1 if the address falls into the file bytes of a load segment
+ */
+static int translate_link_address(const ElfImageInfo* info, uint64_t address, uint64_t* file_offset) {
+    for (int i = 0; i < info->segment_count; i++) {
+        const ElfSegment* segment = &info->segments[i];
+        if (segment->type == PT_LOAD && address >= segment->vaddr &&
+            address - segment->vaddr < segment->filesz) {
+            *file_offset = segment->offset + (address - segment->vaddr);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Checks whether a dynamic tag holds an address
+ */
+static int is_dynamic_pointer_tag(int64_t tag) {
+    switch (tag) {
+        case DT_PLTGOT: case DT_HASH: case DT_STRTAB: case DT_SYMTAB: case DT_RELA:
+        case DT_INIT: case DT_FINI: case DT_REL: case DT_JMPREL: case DT_INIT_ARRAY:
+        case DT_FINI_ARRAY: case DT_PREINIT_ARRAY: case DT_RELR: case DT_GNU_HASH:
+        case DT_VERSYM: case DT_VERDEF: case DT_VERNEED: case DT_ANDROID_REL: case DT_ANDROID_RELA:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * @brief Turns runtime addresses in the dynamic segment back into link-time ones
+ * 
+ * Bionic leaves dynamic pointers untouched, but some loaders relocate them
+ * in place. A pointer outside every load segment that lands inside one
+ * once the runtime load bias is taken off is restored.
+ */
+static void restore_dynamic_pointers(uint8_t* image, uint64_t image_size, const ElfImageInfo* info,
+                                     uintptr_t load_bias) {
+    if (info->dynamic_index < 0 || load_bias == 0) return;
+    
+    const ElfSegment* dynamic = &info->segments[info->dynamic_index];
+    size_t entry_size = info->is_64bit ? sizeof(Elf64_Dyn) : sizeof(Elf32_Dyn);
+    if (dynamic->offset > image_size || dynamic->filesz > image_size - dynamic->offset) return;
+    
+    uint64_t file_offset;
+    for (uint64_t position = 0; position + entry_size <= dynamic->filesz; position += entry_size) {
+        uint8_t* entry_address = image + dynamic->offset + position;
+        if (info->is_64bit) {
+            Elf64_Dyn entry;
+            memcpy(&entry, entry_address, sizeof(entry));
+            if (entry.d_tag == DT_NULL) break;
+            if (is_dynamic_pointer_tag(entry.d_tag) &&
+                !translate_link_address(info, entry.d_un.d_ptr, &file_offset) &&
+                translate_link_address(info, entry.d_un.d_ptr - load_bias, &file_offset)) {
+                entry.d_un.d_ptr -= load_bias;
+                memcpy(entry_address, &entry, sizeof(entry));
+            }
+        } else {
+            Elf32_Dyn entry;
+            memcpy(&entry, entry_address, sizeof(entry));
+            if (entry.d_tag == DT_NULL) break;
+            if (is_dynamic_pointer_tag(entry.d_tag) &&
+                !translate_link_address(info, entry.d_un.d_ptr, &file_offset) &&
+                translate_link_address(info, (Elf32_Addr)(entry.d_un.d_ptr - load_bias), &file_offset)) {
+                entry.d_un.d_ptr = (Elf32_Addr)(entry.d_un.d_ptr - load_bias);
+                memcpy(entry_address, &entry, sizeof(entry));
+            }
+        }
+    }
+}
+
+/**
+ * @brief Counts dynamic symbols from the GNU hash table
+ * 
+ * The highest bucket start is followed along its chain to the last symbol.
+ * 
+ * @return Symbol count, 0 if the table is unreadable; table_size receives its size
+ */
+static uint64_t count_gnu_hash_symbols(const uint8_t* image, uint64_t image_size, uint64_t offset,
+                                       int is_64bit, uint64_t* table_size) {
+    uint32_t header[4]; // nbuckets, symoffset, bloom_size, bloom_shift
+    if (offset > image_size || image_size - offset < sizeof(header)) return 0;
+    memcpy(header, image + offset, sizeof(header));
+    
+    uint64_t buckets_offset = offset + sizeof(header) + (uint64_t)header[2] * (is_64bit ? 8 : 4);
+    uint64_t chains_offset = buckets_offset + (uint64_t)header[0] * 4;
+    if (header[0] == 0 || chains_offset > image_size) return 0;
+    
+    uint32_t last_symbol = 0;
+    for (uint32_t i = 0; i < header[0]; i++) {
+        uint32_t bucket;
+        memcpy(&bucket, image + buckets_offset + i * 4, sizeof(bucket));
+        if (bucket > last_symbol) last_symbol = bucket;
+    }
+    if (last_symbol < header[1]) {
+        *table_size = chains_offset - offset;
+        return header[1];
+    }
+    
+    // Walk the last chain until the entry with the end marker bit
+    while (1) {
+        uint64_t chain_offset = chains_offset + (uint64_t)(last_symbol - header[1]) * 4;
+        if (chain_offset + 4 > image_size) return 0;
+        uint32_t chain_value;
+        memcpy(&chain_value, image + chain_offset, sizeof(chain_value));
+        if (chain_value & 1) break;
+        last_symbol++;
+    }
+    *table_size = chains_offset + (uint64_t)(last_symbol + 1 - header[1]) * 4 - offset;
+    return (uint64_t)last_symbol + 1;
+}
+
+/**
+ * @brief Reads the dynamic segment of a rebuilt image
+ * 
+ * @return 1 if a dynamic segment was found and parsed
+ */
+static int read_dynamic_info(const uint8_t* image, uint64_t image_size, const ElfImageInfo* info,
+                             DynamicInfo* dynamic_info) {
+    memset(dynamic_info, 0, sizeof(*dynamic_info));
+    if (info->dynamic_index < 0) return 0;
+    
+    const ElfSegment* dynamic = &info->segments[info->dynamic_index];
+    size_t entry_size = info->is_64bit ? sizeof(Elf64_Dyn) : sizeof(Elf32_Dyn);
+    if (dynamic->offset > image_size || dynamic->filesz > image_size - dynamic->offset) return 0;
+    
+    for (uint64_t position = 0; position + entry_size <= dynamic->filesz; position += entry_size) {
+        int64_t tag;
+        uint64_t value;
+        if (info->is_64bit) {
+            Elf64_Dyn entry;
+            memcpy(&entry, image + dynamic->offset + position, sizeof(entry));
+            tag = entry.d_tag;
+            value = entry.d_un.d_val;
+        } else {
+            Elf32_Dyn entry;
+            memcpy(&entry, image + dynamic->offset + position, sizeof(entry));
+            tag = entry.d_tag;
+            value = entry.d_un.d_val;
+        }
+        
+        if (tag == DT_NULL) break;
+        if (tag > 0 && tag <= DT_RELRENT) {
+            dynamic_info->values[tag] = value;
+            dynamic_info->present[tag] = 1;
+        } else if (tag == DT_GNU_HASH) {
+            dynamic_info->gnu_hash = value;
+        } else if (tag == DT_VERSYM) {
+            dynamic_info->versym = value;
+        } else if (tag == DT_ANDROID_REL) {
+            dynamic_info->android_rel = value;
+        } else if (tag == DT_ANDROID_RELSZ) {
+            dynamic_info->android_rel_size = value;
+        } else if (tag == DT_ANDROID_RELA) {
+            dynamic_info->android_rela = value;
+        } else if (tag == DT_ANDROID_RELASZ) {
+            dynamic_info->android_rela_size = value;
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief Adds a section located by a dynamic pointer
+ * 
+ * @return Index of the new section, 0 if the pointer does not resolve
+ */
+static int add_dynamic_section(SectionTable* table, const ElfImageInfo* info, const char* name, uint32_t type, uint64_t flags, uint64_t pointer,
+                               uint64_t size, uint64_t entry_size, uint64_t alignment) {
+    uint64_t file_offset;
+    if (pointer == 0 || size == 0 || !translate_link_address(info, pointer, &file_offset)) return 0;
+    return add_rebuilt_section(table, name, type, flags, pointer, file_offset, size, entry_size, alignment);
+}
+
+/**
+ * @brief Rebuilds section headers from the dynamic segment
+ * 
+ * Enough sections are recreated for tools to find the dynamic symbols,
+ * relocations and initializers: .dynsym, .dynstr, the hash tables,
+ * relocation tables, .init_array, .fini_array and .dynamic. Names and
+ * headers are appended after the last segment and the ELF header is
+ * pointed at them.
+ * 
+ * @param image Rebuilt image in file layout
+ * @param image_size Bytes of segment data in image
+ * @param buffer_size Size of the buffer holding image
+ * @param info Parsed headers of the image
+ * @return New image size, image_size if no sections could be rebuilt
+ */
+static uint64_t rebuild_section_headers(uint8_t* image, uint64_t image_size, size_t buffer_size,
+                                        const ElfImageInfo* info) {
+    DynamicInfo dynamic_info;
+    if (!read_dynamic_info(image, image_size, info, &dynamic_info)) return image_size;
+    
+    int is_64bit = info->is_64bit;
+    uint64_t word_size = is_64bit ? 8 : 4;
+    uint64_t symbol_size = is_64bit ? sizeof(Elf64_Sym) : sizeof(Elf32_Sym);
+    const uint64_t* values = dynamic_info.values;
+    
+    SectionTable* table = calloc(1, sizeof(SectionTable));
+    if (!table) return image_size;
+    add_rebuilt_section(table, "", SHT_NULL, 0, 0, 0, 0, 0, 0);
+    
+    // Symbol count: hash table chain count, GNU hash walk, or the gap up to the string table
+    uint64_t symbol_count = 0;
+    uint64_t hash_offset = 0, gnu_hash_offset = 0, gnu_hash_size = 0;
+    if (dynamic_info.present[DT_HASH] && translate_link_address(info, values[DT_HASH], &hash_offset) &&
+        hash_offset + 8 <= image_size) {
+        uint32_t chain_count;
+        memcpy(&chain_count, image + hash_offset + 4, sizeof(chain_count));
+        symbol_count = chain_count;
+    }
+    if (dynamic_info.gnu_hash != 0 && translate_link_address(info, dynamic_info.gnu_hash, &gnu_hash_offset)) {
+        uint64_t gnu_symbol_count = count_gnu_hash_symbols(image, image_size, gnu_hash_offset,
+                                                           is_64bit, &gnu_hash_size);
+        if (symbol_count == 0) symbol_count = gnu_symbol_count;
+    }
+    if (symbol_count == 0 && values[DT_STRTAB] > values[DT_SYMTAB] && values[DT_SYMTAB] != 0) {
+        symbol_count = (values[DT_STRTAB] - values[DT_SYMTAB]) / symbol_size;
+    }
+    
+    int dynsym_index = add_dynamic_section(table, info, ".dynsym", SHT_DYNSYM, SHF_ALLOC,
+                                           values[DT_SYMTAB], symbol_count * symbol_size,
+                                           symbol_size, word_size);
+    int versym_index = add_dynamic_section(table, info, ".gnu.version", SHT_GNU_versym, SHF_ALLOC,
+                                           dynamic_info.versym, symbol_count * 2, 2, 2);
+    int gnu_hash_index = add_dynamic_section(table, info, ".gnu.hash", SHT_GNU_HASH, SHF_ALLOC,
+                                             dynamic_info.gnu_hash, gnu_hash_size, 0, word_size);
+    int hash_index = 0;
+    if (hash_offset != 0 && hash_offset + 8 <= image_size) {
+        uint32_t hash_counts[2]; // nbucket, nchain
+        memcpy(hash_counts, image + hash_offset, sizeof(hash_counts));
+        hash_index = add_dynamic_section(table, info, ".hash", SHT_HASH, SHF_ALLOC, values[DT_HASH],
+                                         (2 + (uint64_t)hash_counts[0] + hash_counts[1]) * 4, 4, word_size);
+    }
+    int dynstr_index = add_dynamic_section(table, info, ".dynstr", SHT_STRTAB, SHF_ALLOC,
+                                           values[DT_STRTAB], values[DT_STRSZ], 0, 1);
+    
+    int relocation_indices[5];
+    int relocation_count = 0;
+    relocation_indices[relocation_count++] = add_dynamic_section(
+        table, info, is_64bit ? ".rela.dyn" : ".rel.dyn", is_64bit ? SHT_RELA : SHT_REL, SHF_ALLOC,
+        is_64bit ? values[DT_RELA] : values[DT_REL], is_64bit ? values[DT_RELASZ] : values[DT_RELSZ],
+        is_64bit ? values[DT_RELAENT] : values[DT_RELENT], word_size);
+    relocation_indices[relocation_count++] = add_dynamic_section(
+        table, info, is_64bit ? ".rela.dyn" : ".rel.dyn", is_64bit ? SHT_ANDROID_RELA : SHT_ANDROID_REL,
+        SHF_ALLOC, is_64bit ? dynamic_info.android_rela : dynamic_info.android_rel,
+        is_64bit ? dynamic_info.android_rela_size : dynamic_info.android_rel_size, 1, word_size);
+    relocation_indices[relocation_count++] = add_dynamic_section(
+        table, info, ".relr.dyn", SHT_RELR, SHF_ALLOC, values[DT_RELR], values[DT_RELRSZ],
+        word_size, word_size);
+    uint32_t plt_relocation_type = values[DT_PLTREL] == DT_RELA ? SHT_RELA : SHT_REL;
+    relocation_indices[relocation_count++] = add_dynamic_section(
+        table, info, plt_relocation_type == SHT_RELA ? ".rela.plt" : ".rel.plt",
+        plt_relocation_type, SHF_ALLOC, values[DT_JMPREL], values[DT_PLTRELSZ],
+        plt_relocation_type == SHT_RELA ? (is_64bit ? sizeof(Elf64_Rela) : sizeof(Elf32_Rela)) :
+                                          (is_64bit ? sizeof(Elf64_Rel) : sizeof(Elf32_Rel)),
+        word_size);
+    
+    add_dynamic_section(table, info, ".init_array", SHT_INIT_ARRAY, SHF_ALLOC | SHF_WRITE,
+                        values[DT_INIT_ARRAY], values[DT_INIT_ARRAYSZ], word_size, word_size);
+    add_dynamic_section(table, info, ".fini_array", SHT_FINI_ARRAY, SHF_ALLOC | SHF_WRITE,
+                        values[DT_FINI_ARRAY], values[DT_FINI_ARRAYSZ], word_size, word_size);
+    
+    const ElfSegment* dynamic = &info->segments[info->dynamic_index];
+    int dynamic_index = add_rebuilt_section(table, ".dynamic", SHT_DYNAMIC, SHF_ALLOC | SHF_WRITE,
+                                            dynamic->vaddr, dynamic->offset, dynamic->filesz,
+                                            is_64bit ? sizeof(Elf64_Dyn) : sizeof(Elf32_Dyn), word_size);
+    int names_index = add_rebuilt_section(table, ".shstrtab", SHT_STRTAB, 0, 0, 0, 0, 0, 1);
+    
+    // Link symbol-based sections to their string and symbol tables
+    if (dynsym_index) {
+        table->sections[dynsym_index].link = dynstr_index;
+        table->sections[dynsym_index].info = 1; // Only the null symbol is known to be local
+    }
+    if (versym_index) table->sections[versym_index].link = dynsym_index;
+    if (gnu_hash_index) table->sections[gnu_hash_index].link = dynsym_index;
+    if (hash_index) table->sections[hash_index].link = dynsym_index;
+    for (int i = 0; i < relocation_count; i++) {
+        if (relocation_indices[i] && table->sections[relocation_indices[i]].type != SHT_RELR) {
+            table->sections[relocation_indices[i]].link = dynsym_index;
+        }
+    }
+    if (dynamic_index) table->sections[dynamic_index].link = dynstr_index;
+    
+    // Name table right after the segments, headers aligned behind it
+    size_t header_size = is_64bit ? sizeof(Elf64_Shdr) : sizeof(Elf32_Shdr);
+    uint64_t names_offset = image_size;
+    uint64_t headers_offset = (names_offset + table->names_length + 7) & ~(uint64_t)7;
+    uint64_t rebuilt_size = headers_offset + (uint64_t)table->section_count * header_size;
+    if (names_index == 0 || dynsym_index == 0 || rebuilt_size > buffer_size) {
+        free(table);
+        return image_size;
+    }
+    table->sections[names_index].offset = names_offset;
+    table->sections[names_index].size = table->names_length;
+    memcpy(image + names_offset, table->names, table->names_length);
+    
+    for (int i = 0; i < table->section_count; i++) {
+        const RebuiltSection* section = &table->sections[i];
+        uint8_t* destination = image + headers_offset + (uint64_t)i * header_size;
+        if (is_64bit) {
+            Elf64_Shdr section_header = {
+                .sh_name = section->name_offset, .sh_type = section->type, .sh_flags = section->flags,
+                .sh_addr = section->address, .sh_offset = section->offset, .sh_size = section->size,
+                .sh_link = section->link, .sh_info = section->info,
+                .sh_addralign = section->alignment, .sh_entsize = section->entry_size
+            };
+            memcpy(destination, &section_header, sizeof(section_header));
+        } else {
+            Elf32_Shdr section_header = {
+                .sh_name = section->name_offset, .sh_type = section->type, .sh_flags = (Elf32_Word)section->flags,
+                .sh_addr = (Elf32_Addr)section->address, .sh_offset = (Elf32_Off)section->offset,
+                .sh_size = (Elf32_Word)section->size, .sh_link = section->link, .sh_info = section->info,
+                .sh_addralign = (Elf32_Word)section->alignment, .sh_entsize = (Elf32_Word)section->entry_size
+            };
+            memcpy(destination, &section_header, sizeof(section_header));
+        }
+    }
+    
+    // Point the ELF header at the rebuilt table
+    if (is_64bit) {
+        Elf64_Ehdr* elf_header = (Elf64_Ehdr*)image;
+        elf_header->e_shoff = headers_offset;
+        elf_header->e_shentsize = sizeof(Elf64_Shdr);
+        elf_header->e_shnum = table->section_count;
+        elf_header->e_shstrndx = names_index;
+    } else {
+        Elf32_Ehdr* elf_header = (Elf32_Ehdr*)image;
+        elf_header->e_shoff = (Elf32_Off)headers_offset;
+        elf_header->e_shentsize = sizeof(Elf32_Shdr);
+        elf_header->e_shnum = table->section_count;
+        elf_header->e_shstrndx = names_index;
+    }
+    
+    VLOGD("Rebuilt %d section headers for ELF image", table->section_count);
+    free(table);
+    return rebuilt_size;
+}
+
+/**
+ * @brief Rebuilds the file layout of a loaded ELF image
+ * 
+ * The file bytes of every load segment are copied from their virtual
+ * address back to their file offset, one page at a time so that an
+ * unmapped or protected page only leaves a hole of zeros. The original
+ * section header table is never mapped, so the header fields pointing at
+ * it are cleared and, when enabled, replaced by rebuilt section headers.
+ * 
+ * @param image_address Address of the ELF header of the loaded library
+ * @param readable_size Bytes that may be read from image_address
+ * @param output_buffer Output: tracked buffer holding the file image
+ * @param output_size Output: size of the file image
+ * @return 1 if an image was rebuilt, 0 otherwise
+ */
+int rebuild_mapped_elf_image(const void* image_address, size_t readable_size,
+                             void** output_buffer, size_t* output_size) {
+    *output_buffer = NULL;
+    *output_size = 0;
+    
+    const uint8_t* image = image_address;
+    ElfImageInfo info;
+    if (!parse_elf_image(image, readable_size, &info)) return 0;
+    if (info.file_extent < ELF_HEADER_WINDOW || info.file_extent > ELF_MAX_IMAGE_SIZE) return 0;
+    
+    size_t buffer_size = info.file_extent + SECTION_REBUILD_RESERVE;
+    uint8_t* buffer = allocate_tracked_buffer(buffer_size);
+    if (!buffer) return 0;
+    memset(buffer, 0, buffer_size);
+    
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    size_t pages_copied = 0;
+    size_t pages_missing = 0;
+    for (int i = 0; i < info.segment_count; i++) {
+        const ElfSegment* segment = &info.segments[i];
+        if (segment->type != PT_LOAD || segment->filesz == 0) continue;
+        
+        uint64_t memory_offset = segment->vaddr - info.base_vaddr;
+        uint64_t copied = 0;
+        while (copied < segment->filesz) {
+            uintptr_t source_address = (uintptr_t)image + memory_offset + copied;
+            size_t chunk_length = page_size - (source_address % page_size);
+            if (chunk_length > segment->filesz - copied) chunk_length = segment->filesz - copied;
+            
+            if (read_image_bytes(image, readable_size, memory_offset + copied,
+                                 buffer + segment->offset + copied, chunk_length)) {
+                pages_copied++;
+            } else {
+                memset(buffer + segment->offset + copied, 0, chunk_length);
+                pages_missing++;
+            }
+            copied += chunk_length;
+        }
+    }
+    if (pages_copied == 0) {
+        release_tracked_buffer(buffer, buffer_size);
+        return 0;
+    }
+    
+    // The section header table is not part of any segment, drop the stale reference
+    if (info.is_64bit) {
+        Elf64_Ehdr* elf_header = (Elf64_Ehdr*)buffer;
+        elf_header->e_shoff = 0;
+        elf_header->e_shnum = 0;
+        elf_header->e_shstrndx = SHN_UNDEF;
+    } else {
+        Elf32_Ehdr* elf_header = (Elf32_Ehdr*)buffer;
+        elf_header->e_shoff = 0;
+        elf_header->e_shnum = 0;
+        elf_header->e_shstrndx = SHN_UNDEF;
+    }
+    
+    restore_dynamic_pointers(buffer, info.file_extent, &info, (uintptr_t)image - (uintptr_t)info.base_vaddr);
+    
+    uint64_t rebuilt_size = info.file_extent;
+    if (should_rebuild_elf_sections()) {
+        rebuilt_size = rebuild_section_headers(buffer, info.file_extent, buffer_size, &info);
+    }
+    
+    SCAN_STAT_ADD(elf_images_rebuilt, 1);
+    LOGI("Rebuilt ELF image at %p: %llu bytes, %zu of %zu pages unreadable", image_address,
+         (unsigned long long)rebuilt_size, pages_missing, pages_copied + pages_missing);
+    
+    *output_buffer = buffer;
+    *output_size = rebuilt_size;
+    return 1;
+}
+
+/**
+ * @brief Releases a buffer returned by rebuild_mapped_elf_image
+ * 
+ * @param output_buffer Buffer returned by rebuild_mapped_elf_image
+ * @param output_size Size returned by rebuild_mapped_elf_image
+ */
+void release_rebuilt_elf_image(void* output_buffer, size_t output_size) {
+    release_tracked_buffer(output_buffer, output_size);
+}
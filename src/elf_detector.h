@@ -0,0 +1,43 @@
+#ifndef DEXDUMPER_ELF_DETECTOR_H
+#define DEXDUMPER_ELF_DETECTOR_H
+
+// ELF detection header - declares recovery of native libraries from memory
+
+#include "common.h"
+#include "config.h"
+
+/**
+ * Native Library Support:
+ * 
+ * Packers often decrypt their .so files into anonymous memory and load
+ * them with a private linker. ELF headers are one more prefilter in the
+ * single-pass scanner, restricted to memory that is not backed by a file
+ * so libraries mapped from disk are never dumped. A library still in its
+ * file layout is dumped as it is. A loaded library has its segments at
+ * their virtual addresses; it is put back into file layout from its
+ * program headers and, when enabled, given section headers rebuilt from
+ * its dynamic segment. Both go through the same dedup, manifest and
+ * writer stages as DEX files.
+ */
+
+// How an ELF image found in memory is laid out
+typedef enum {
+    ELF_IMAGE_LAYOUT_NONE = 0, // Not a supported ELF image
+    ELF_IMAGE_LAYOUT_FILE,     // Bytes are in file layout (raw .so contents)
+    ELF_IMAGE_LAYOUT_MAPPED    // Segments sit at their virtual addresses (loaded library)
+} ElfImageLayout;
+
+// Registers the ELF image detectors with the single-pass scanner
+void register_elf_image_detectors(void);
+
+// Determines the layout and size of an ELF image
+ElfImageLayout inspect_elf_image(const void* image_address, size_t available_size, size_t* image_size);
+
+// Rebuilds the file layout of a loaded ELF image into a tracked buffer
+int rebuild_mapped_elf_image(const void* image_address, size_t readable_size,
+                             void** output_buffer, size_t* output_size);
+
+// Releases a buffer returned by rebuild_mapped_elf_image
+void release_rebuilt_elf_image(void* output_buffer, size_t output_size);
+
+#endif
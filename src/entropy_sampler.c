@@ -0,0 +1,239 @@
+#include "entropy_sampler.h"
+#include "signal_handler.h"
+
+// Zero counting kernel: NEON on ARM, SSE2 on x86, scalar elsewhere
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define ENTROPY_ZERO_COUNT_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define ENTROPY_ZERO_COUNT_SSE2 1
+#endif
+
+// Independent histograms updated round-robin so consecutive equal bytes do not serialize
+#define HISTOGRAM_WAYS 4
+
+// /proc/self/pagemap entry bits
+#define PAGEMAP_ENTRY_SWAPPED (1ULL << 62)
+#define PAGEMAP_ENTRY_PRESENT (1ULL << 63)
+#define PAGEMAP_ENTRIES_PER_READ 512
+
+/**
+ * @brief Counts zero bytes in a sample
+ * 
+ * @param data Sample bytes
+ * @param size Sample size (a multiple of 16 is fastest)
+ * @param kernel SIMD_KERNEL_VECTOR to use NEON/SSE2 where compiled in
+ * @return Number of zero bytes
+ */
+size_t count_zero_bytes_with_kernel(const uint8_t* data, size_t size, SimdKernel kernel) {
+    size_t zero_count = 0;
+    size_t position = 0;
+    
+#if defined(ENTROPY_ZERO_COUNT_NEON)
+    for (; kernel == SIMD_KERNEL_VECTOR && position + 16 <= size; position += 16) {
+        // Each matching lane is 0xFF; shifting right by 7 turns it into 1
+        uint8x16_t is_zero = vshrq_n_u8(vceqq_u8(vld1q_u8(data + position), vdupq_n_u8(0)), 7);
+        uint64x2_t lane_sums = vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(is_zero)));
+        zero_count += (size_t)(vgetq_lane_u64(lane_sums, 0) + vgetq_lane_u64(lane_sums, 1));
+    }
+#elif defined(ENTROPY_ZERO_COUNT_SSE2)
+    for (; kernel == SIMD_KERNEL_VECTOR && position + 16 <= size; position += 16) {
+        __m128i bytes = _mm_loadu_si128((const __m128i*)(data + position));
+        zero_count += (size_t)__builtin_popcount((unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_setzero_si128())));
+    }
+#endif
+    
+    for (; position < size; position++) {
+        if (data[position] == 0) zero_count++;
+    }
+    return zero_count;
+}
+
+/**
+ * @brief Adds a sample to a split byte histogram
+ * 
+ * Neither NEON nor SSE2 can scatter, so the histogram is split into
+ * HISTOGRAM_WAYS tables instead; runs of equal bytes (the common case in
+ * structured data) then hit different counters and do not stall on the
+ * same memory location.
+ */
+static void accumulate_histogram(const uint8_t* data, size_t size, uint32_t histogram[HISTOGRAM_WAYS][256]) {
+    size_t position = 0;
+    for (; position + HISTOGRAM_WAYS <= size; position += HISTOGRAM_WAYS) {
+        histogram[0][data[position]]++;
+        histogram[1][data[position + 1]]++;
+        histogram[2][data[position + 2]]++;
+        histogram[3][data[position + 3]]++;
+    }
+    for (; position < size; position++) {
+        histogram[0][data[position]]++;
+    }
+}
+
+/**
+ * @brief Computes Shannon entropy of a split histogram
+ * 
+ * @return Bits per byte multiplied by 1000
+ */
+static unsigned int histogram_entropy_millibits(uint32_t histogram[HISTOGRAM_WAYS][256], size_t total_count) {
+    if (total_count == 0) return 0;
+    
+    double entropy = 0.0;
+    for (int value = 0; value < 256; value++) {
+        uint32_t count = histogram[0][value] + histogram[1][value] + histogram[2][value] + histogram[3][value];
+        if (count == 0) continue;
+        double probability = (double)count / (double)total_count;
+        entropy -= probability * log2(probability);
+    }
+    return (unsigned int)(entropy * 1000.0);
+}
+
+/**
+ * @brief Reads a range in full and checks that every byte is zero
+ */
+static int range_is_zero(const uint8_t* range_start, size_t range_size) {
+    uint8_t chunk[4096]; // Pages may be larger, they are read in pieces
+    for (size_t offset = 0; offset < range_size; offset += sizeof(chunk)) {
+        size_t chunk_size = range_size - offset < sizeof(chunk) ? range_size - offset : sizeof(chunk);
+        if (!read_memory_safely(range_start + offset, chunk, chunk_size) ||
+            count_zero_bytes_with_kernel(chunk, chunk_size, get_simd_kernel()) != chunk_size) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief Confirms that a window whose samples were all zero holds nothing
+ * 
+ * The samples cover a few cache lines per page, so a small DEX can slip
+ * between them. Only private anonymous memory qualifies: an evicted file
+ * page holds whatever the file does. pagemap then tells the pages apart
+ * (the swap and present bits are reported to unprivileged readers, only
+ * frame numbers are hidden):
+ * - swapped out (zram on most devices): content unknown, not confirmed
+ * - present, which includes the pages the sampling faulted in: read in full
+ * - neither: never written, reads as zero
+ * Windows with more than ENTROPY_EMPTY_VERIFY_PAGES pages resident before
+ * sampling are not worth the reads and get scanned.
+ * 
+ * @param memory_region Region the window belongs to
+ * @param window_size Size of the sampled window
+ * @param page_size System page size
+ * @param residency mincore() vector of the window taken before sampling
+ * @return 1 if the window is confirmed zero, 0 if it must be scanned
+ */
+static int window_is_confirmed_zero(const MemoryRegion* memory_region, size_t window_size, size_t page_size,
+                                    const unsigned char* residency) {
+    if (memory_region->inode_number != 0 || memory_region->permissions[3] != 'p') return 0;
+    
+    const uint8_t* window_start = memory_region->start_address;
+    size_t page_count = (window_size + page_size - 1) / page_size;
+    size_t resident_pages = 0;
+    for (size_t page = 0; page < page_count; page++) {
+        if (residency[page] & 1) resident_pages++;
+    }
+    if (resident_pages > ENTROPY_EMPTY_VERIFY_PAGES) return 0;
+    
+    int pagemap_fd = open("/proc/self/pagemap", O_RDONLY | O_CLOEXEC);
+    if (pagemap_fd < 0) return 0;
+    
+    uint64_t entries[PAGEMAP_ENTRIES_PER_READ];
+    off_t first_entry = (off_t)((uintptr_t)window_start / page_size) * (off_t)sizeof(uint64_t);
+    int confirmed_zero = 1;
+    for (size_t base = 0; base < page_count && confirmed_zero; base += PAGEMAP_ENTRIES_PER_READ) {
+        size_t entry_count = page_count - base < PAGEMAP_ENTRIES_PER_READ ? page_count - base : PAGEMAP_ENTRIES_PER_READ;
+        ssize_t bytes_read = pread(pagemap_fd, entries, entry_count * sizeof(uint64_t),
+                                   first_entry + (off_t)(base * sizeof(uint64_t)));
+        if (bytes_read != (ssize_t)(entry_count * sizeof(uint64_t))) {
+            confirmed_zero = 0;
+            break;
+        }
+        
+        for (size_t i = 0; i < entry_count && confirmed_zero; i++) {
+            if (entries[i] & PAGEMAP_ENTRY_SWAPPED) {
+                confirmed_zero = 0;
+            } else if (entries[i] & PAGEMAP_ENTRY_PRESENT) {
+                size_t page_offset = (base + i) * page_size;
+                size_t page_length = window_size - page_offset < page_size ? window_size - page_offset : page_size;
+                confirmed_zero = range_is_zero(window_start + page_offset, page_length);
+            }
+        }
+    }
+    close(pagemap_fd);
+    return confirmed_zero;
+}
+
+/**
+ * @brief Samples a region and classifies its content
+ * 
+ * Up to ENTROPY_SAMPLED_PAGES pages of the scan window are sampled, each
+ * at a different cache-line group so repeated page layouts do not bias
+ * the estimate. The window matches the DEX scan limit, so for regions up
+ * to that size every page contributes a sample. A window sampled as all
+ * zero is only called empty once window_is_confirmed_zero() confirms it.
+ * 
+ * @param memory_region Region to sample
+ * @param profile Output profile including the routing decision
+ */
+void build_region_entropy_profile(const MemoryRegion* memory_region, RegionEntropyProfile* profile) {
+    memset(profile, 0, sizeof(*profile));
+    
+    size_t region_size = (char*)memory_region->end_address - (char*)memory_region->start_address;
+    size_t window_size = region_size > DEFAULT_SCAN_LIMIT ? DEFAULT_SCAN_LIMIT : region_size;
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    size_t page_count = (window_size + page_size - 1) / page_size;
+    size_t sampled_pages = page_count < ENTROPY_SAMPLED_PAGES ? page_count : ENTROPY_SAMPLED_PAGES;
+    size_t groups_per_page = page_size / ENTROPY_SAMPLE_BYTES;
+    
+    uint32_t histogram[HISTOGRAM_WAYS][256];
+    memset(histogram, 0, sizeof(histogram));
+    uint8_t sample[ENTROPY_SAMPLE_BYTES];
+    
+    // Residency before sampling: reading a page below makes it resident
+    unsigned char residency[RESIDENCY_WINDOW_PAGES];
+    int has_residency = page_count <= RESIDENCY_WINDOW_PAGES &&
+                        mincore(memory_region->start_address, window_size, residency) == 0;
+    
+    for (size_t i = 0; i < sampled_pages; i++) {
+        size_t page_offset = (i * page_count / sampled_pages) * page_size;
+        size_t sample_offset = page_offset + (groups_per_page ? (i % groups_per_page) * ENTROPY_SAMPLE_BYTES : 0);
+        if (sample_offset >= window_size) sample_offset = page_offset;
+        size_t sample_size = window_size - sample_offset < ENTROPY_SAMPLE_BYTES ?
+                             window_size - sample_offset : ENTROPY_SAMPLE_BYTES;
+        
+        if (!read_memory_safely((const char*)memory_region->start_address + sample_offset, sample, sample_size)) {
+            profile->pages_unreadable++;
+            continue;
+        }
+        
+        size_t zero_count = count_zero_bytes_with_kernel(sample, sample_size, get_simd_kernel());
+        if (zero_count == sample_size) profile->zero_pages++;
+        profile->pages_sampled++;
+        profile->bytes_sampled += sample_size;
+        profile->zero_bytes += zero_count;
+        accumulate_histogram(sample, sample_size, histogram);
+    }
+    
+    profile->entropy_millibits = histogram_entropy_millibits(histogram, profile->bytes_sampled);
+    
+    if (profile->bytes_sampled == 0) {
+        profile->content_class = REGION_CONTENT_UNKNOWN;
+    } else if (profile->zero_bytes == profile->bytes_sampled) {
+        // Unconfirmed zero samples get the regular scan
+        int confirmed_empty = has_residency &&
+                              window_is_confirmed_zero(memory_region, window_size, page_size, residency);
+        profile->content_class = confirmed_empty ? REGION_CONTENT_EMPTY : REGION_CONTENT_UNKNOWN;
+    } else if (profile->bytes_sampled >= ENTROPY_MIN_SAMPLE_BYTES &&
+               profile->entropy_millibits >= ENTROPY_HIGH_THRESHOLD_MILLIBITS) {
+        profile->content_class = REGION_CONTENT_HIGH_ENTROPY;
+    } else {
+        profile->content_class = REGION_CONTENT_STRUCTURED;
+    }
+    
+    VLOGD("Entropy profile %p-%p: pages=%zu unreadable=%zu zero_pages=%zu entropy=%u.%03u class=%d",
+          memory_region->start_address, memory_region->end_address, profile->pages_sampled,
+          profile->pages_unreadable, profile->zero_pages, profile->entropy_millibits / 1000,
+          profile->entropy_millibits % 1000, profile->content_class);
+}
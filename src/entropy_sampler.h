@@ -0,0 +1,30 @@
+#ifndef DEXDUMPER_ENTROPY_SAMPLER_H
+#define DEXDUMPER_ENTROPY_SAMPLER_H
+
+// Entropy sampler header - declares the per-region entropy profile used for routing
+
+#include "common.h"
+#include "config.h"
+#include "calibration.h"
+
+/**
+ * Entropy-Based Routing:
+ * 
+ * Path names say little about anonymous memory. Before a region is
+ * scanned, a few cache lines of each page in the scan window are sampled
+ * to estimate byte entropy and the zero fraction. All-zero regions are
+ * skipped only if they are private anonymous memory with no page swapped
+ * out and every present page confirmed zero in full (pages neither
+ * present nor swapped were never written), high-entropy regions (media,
+ * compressed or encrypted buffers) get the decode stages on top of the
+ * regular DEX scan whatever their priority, and everything else gets the
+ * regular DEX scan.
+ */
+
+// Samples a region and classifies its content
+void build_region_entropy_profile(const MemoryRegion* memory_region, RegionEntropyProfile* profile);
+
+// Counts zero bytes with the scalar or the vector kernel (benchmarked by startup calibration)
+size_t count_zero_bytes_with_kernel(const uint8_t* data, size_t size, SimdKernel kernel);
+
+#endif
@@ -0,0 +1,740 @@
+#include "expansion_engine.h"
+#include "dex_detector.h"
+#include "memory_scanner.h"
+#include "payload_inflater.h"
+#include "xor_key_recovery.h"
+#include "elf_detector.h"
+#include "file_utils.h"
+#include "registry_manager.h"
+#include "scan_statistics.h"
+#include "sha1.h"
+#include "content_hash.h"
+
+// What a queued buffer is known to contain
+typedef enum {
+    EXPANSION_KIND_UNKNOWN,       // Classify by magic, otherwise scan with the detectors
+    EXPANSION_KIND_DETECTED,      // Accepted by a detector; classify by magic, otherwise dump as-is
+    EXPANSION_KIND_DEX,           // Single DEX file, dumped
+    EXPANSION_KIND_DEX_CONTAINER, // Version 041 container, dumped and split into members
+    EXPANSION_KIND_ZIP,           // Zip archive, entries become children
+    EXPANSION_KIND_ELF,           // Native library in file layout, dumped
+    EXPANSION_KIND_ENCODED        // Compressed or key-obfuscated, decoded output becomes a child
+} ExpansionKind;
+
+// One buffer waiting on the expansion queue
+typedef struct {
+    const uint8_t* data;       // Start of the buffer
+    size_t size;               // Size of the buffer in bytes
+    int depth;                 // Nesting level below the detected payload
+    ExpansionKind kind;        // Known content type
+    PayloadEncoding encoding;  // Encoding of EXPANSION_KIND_ENCODED items
+    uint8_t key[MAX_XOR_KEY_LENGTH]; // Key of XOR/ADD encoded items
+    size_t key_length;         // Length of key, 0 if none
+    int backing_index;         // Owned buffer holding the data, -1 for app memory
+    uint8_t content_key[CONTENT_ID_SIZE]; // Content ID if uses_tree_content_id(key_size), SHA1 otherwise
+    size_t key_size;           // Bytes of data content_key covers, 0 if not hashed
+    char provenance[MAX_PROVENANCE_LENGTH]; // Stages that produced this buffer
+} ExpansionItem;
+
+// Private buffer owned by an expansion, released when no queued item uses it
+typedef struct {
+    void* buffer;        // Copy or inflated output, NULL once released
+    size_t buffer_size;  // Size passed to the allocator
+    int from_inflater;   // Allocated by the inflater rather than as a tracked copy (decryption and ELF rebuild)
+    int references;      // Queued items whose data lives in this buffer
+} ExpansionBuffer;
+
+// State of one expansion of a detected payload
+typedef struct {
+    const char* output_directory;
+    MemoryRegion dump_region;   // Region recorded for dumps (inode cleared after first dump)
+    int region_index;
+    ExpansionItem queue[EXPANSION_MAX_ITEMS];
+    int queue_count;
+    int items_emitted;
+    ExpansionBuffer buffers[EXPANSION_MAX_ITEMS];
+    int buffer_count;
+    uint8_t child_keys[EXPANSION_MAX_ITEMS][CONTENT_ID_SIZE]; // Content keys of the emitted children
+    size_t child_key_sizes[EXPANSION_MAX_ITEMS];
+    int child_key_count;
+    size_t child_bytes;
+    uint64_t deadline_ms;       // Thread CPU time at which the expansion stops
+    int budget_reported;        // A budget stop has been logged for this expansion
+    int timed_out;              // Time budget exhausted, remaining items are dropped
+    int dumped_count;
+    ExpansionItem pending_dumps[SHA1_BATCH_MAX_BUFFERS]; // Dumps waiting to be hashed together
+    int pending_dump_count;
+} ExpansionSession;
+
+#define ZIP_LOCAL_HEADER_SIZE 30
+#define ZIP_MAX_ENTRY_NAME 256
+
+/**
+ * @brief Returns the CPU time used by the calling thread in milliseconds
+ */
+static uint64_t thread_cpu_milliseconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return (uint64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+/**
+ * @brief Reads little-endian integers from private buffers
+ */
+static uint16_t read_le16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t read_le32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/**
+ * @brief Short name of a payload encoding for provenance chains
+ */
+static const char* payload_encoding_name(PayloadEncoding payload_encoding) {
+    switch (payload_encoding) {
+        case PAYLOAD_ENCODING_ZLIB: return "zlib";
+        case PAYLOAD_ENCODING_GZIP: return "gzip";
+        case PAYLOAD_ENCODING_ZIP_DEFLATE: return "deflate";
+        case PAYLOAD_ENCODING_LZ4_FRAME: return "lz4";
+        case PAYLOAD_ENCODING_XOR: return "xor";
+        case PAYLOAD_ENCODING_ADD: return "add";
+        case PAYLOAD_ENCODING_ELF_MAPPED: return "elf";
+        default: return "plain";
+    }
+}
+
+/**
+ * @brief Records that an expansion hit one of its budgets
+ * 
+ * Logged and counted once per expansion; the child that hit the budget
+ * is dropped while already queued items are still processed.
+ */
+static void report_expansion_budget(ExpansionSession* session, const char* reason) {
+    if (!session->budget_reported) {
+        session->budget_reported = 1;
+        SCAN_STAT_ADD(expansion_budget_stops, 1);
+        LOGW("Expansion of region %d cut short: %s", session->region_index, reason);
+    }
+}
+
+/**
+ * @brief Takes ownership of a private buffer for the current expansion
+ * 
+ * @return Buffer index, -1 if the buffer table is full (buffer released)
+ */
+static int adopt_buffer(ExpansionSession* session, void* buffer, size_t buffer_size, int from_inflater) {
+    if (session->buffer_count >= EXPANSION_MAX_ITEMS) {
+        if (from_inflater) release_inflated_payload(buffer);
+        else release_memory_copy(buffer, buffer_size);
+        return -1;
+    }
+    
+    ExpansionBuffer* owned = &session->buffers[session->buffer_count];
+    owned->buffer = buffer;
+    owned->buffer_size = buffer_size;
+    owned->from_inflater = from_inflater;
+    owned->references = 0;
+    return session->buffer_count++;
+}
+
+/**
+ * @brief Releases an owned buffer once no queued item refers to it
+ */
+static void release_unreferenced_buffer(ExpansionSession* session, int backing_index) {
+    if (backing_index < 0) return;
+    
+    ExpansionBuffer* owned = &session->buffers[backing_index];
+    if (owned->buffer == NULL || owned->references > 0) return;
+    
+    if (owned->from_inflater) release_inflated_payload(owned->buffer);
+    else release_memory_copy(owned->buffer, owned->buffer_size);
+    owned->buffer = NULL;
+}
+
+/**
+ * @brief Queues a child buffer produced by an expansion stage
+ * 
+ * Enforces the depth, item and byte budgets and drops children whose
+ * content has already been queued in this expansion.
+ * 
+ * @param session Current expansion
+ * @param parent Item the child was produced from
+ * @param backing_index Owned buffer holding the child data
+ * @param data Start of the child
+ * @param size Size of the child
+ * @param kind Known content type of the child
+ * @param encoding Encoding of the child (EXPANSION_KIND_ENCODED only)
+ * @param stage_label Description of the producing stage for the provenance chain
+ * @return Queued child, NULL if dropped
+ */
+static ExpansionItem* emit_child(ExpansionSession* session, const ExpansionItem* parent, int backing_index,
+                      const uint8_t* data, size_t size, ExpansionKind kind,
+                      PayloadEncoding encoding, const char* stage_label) {
+    if (size == 0) return NULL;
+    
+    if (parent->depth + 1 > EXPANSION_MAX_DEPTH) {
+        report_expansion_budget(session, "depth budget exhausted");
+        return NULL;
+    }
+    if (session->items_emitted >= EXPANSION_MAX_ITEMS || session->queue_count >= EXPANSION_MAX_ITEMS) {
+        report_expansion_budget(session, "item budget exhausted");
+        return NULL;
+    }
+    if (size > EXPANSION_BYTE_BUDGET - session->child_bytes) {
+        report_expansion_budget(session, "byte budget exhausted");
+        return NULL;
+    }
+    
+    // Identical children (the same jar in two assets, repeated members) are expanded once;
+    // they are told apart by the key their dump uses, which the dump then reuses
+    uint8_t content_key[CONTENT_ID_SIZE] = { 0 };
+    if (uses_tree_content_id(size)) {
+        compute_content_id(data, size, content_key);
+    } else {
+        compute_sha1_checksum(data, size, content_key);
+    }
+    for (int i = 0; i < session->child_key_count; i++) {
+        if (session->child_key_sizes[i] == size &&
+            memcmp(session->child_keys[i], content_key, CONTENT_ID_SIZE) == 0) {
+            SCAN_STAT_ADD(expansion_duplicates, 1);
+            VLOGD("Dropping duplicate child %s of %s", stage_label, parent->provenance);
+            return NULL;
+        }
+    }
+    memcpy(session->child_keys[session->child_key_count], content_key, CONTENT_ID_SIZE);
+    session->child_key_sizes[session->child_key_count++] = size;
+    
+    ExpansionItem* child = &session->queue[session->queue_count++];
+    memcpy(child->content_key, content_key, CONTENT_ID_SIZE);
+    child->key_size = size;
+    child->data = data;
+    child->size = size;
+    child->depth = parent->depth + 1;
+    child->kind = kind;
+    child->encoding = encoding;
+    child->backing_index = backing_index;
+    child->key_length = 0;
+    // Over-long chains are truncated, the tail of the chain matters least
+    size_t parent_length = strlen(parent->provenance);
+    memcpy(child->provenance, parent->provenance, parent_length + 1);
+    snprintf(child->provenance + parent_length, sizeof(child->provenance) - parent_length,
+             " > %s", stage_label);
+    
+    if (backing_index >= 0) session->buffers[backing_index].references++;
+    session->items_emitted++;
+    session->child_bytes += size;
+    SCAN_STAT_ADD(expansion_children, 1);
+    return child;
+}
+
+/**
+ * @brief Classifies a private buffer by its leading magic
+ * 
+ * DEX and ELF buffers are trimmed to the size their headers declare.
+ * 
+ * @param item Item to classify, kind/encoding/size updated on success
+ * @return 1 if a known format was recognized, 0 otherwise
+ */
+static int classify_by_magic(ExpansionItem* item) {
+    const uint8_t* data = item->data;
+    
+    if (item->size >= DEX_CONTAINER_HEADER_SIZE && memcmp(data, DEX_MAGIC_SIGNATURE, 4) == 0 &&
+        validate_dex_header_structure(data, item->size, 0)) {
+        size_t available_size = item->size;
+        uint32_t file_size = read_le32(data + 0x20);
+        uint32_t header_size = read_le32(data + 0x24);
+        item->kind = EXPANSION_KIND_DEX;
+        item->size = file_size;
+        
+        if (header_size == DEX_CONTAINER_HEADER_SIZE) {
+            uint32_t container_size = read_le32(data + 0x70);
+            uint32_t header_offset = read_le32(data + 0x74);
+            if (header_offset == 0 && container_size > file_size && container_size <= DEX_MAX_FILE_SIZE) {
+                item->kind = EXPANSION_KIND_DEX_CONTAINER;
+                // A truncated container is still dumped as far as it goes
+                item->size = container_size <= available_size ? container_size : available_size;
+            }
+        }
+        return 1;
+    }
+    
+    if (item->size >= 4 && memcmp(data, "\177ELF", 4) == 0) {
+        size_t image_size = 0;
+        ElfImageLayout layout = inspect_elf_image(data, item->size, &image_size);
+        if (layout == ELF_IMAGE_LAYOUT_FILE) {
+            item->kind = EXPANSION_KIND_ELF;
+            if (image_size < item->size) item->size = image_size;
+            return 1;
+        }
+        if (layout == ELF_IMAGE_LAYOUT_MAPPED) {
+            item->kind = EXPANSION_KIND_ENCODED;
+            item->encoding = PAYLOAD_ENCODING_ELF_MAPPED;
+            return 1;
+        }
+    }
+    
+    if (item->size >= ZIP_LOCAL_HEADER_SIZE && memcmp(data, "PK\003\004", 4) == 0) {
+        item->kind = EXPANSION_KIND_ZIP;
+        return 1;
+    }
+    
+    if (item->size >= 4) {
+        if (data[0] == 0x78 && (data[1] == 0x01 || data[1] == 0x5e || data[1] == 0x9c || data[1] == 0xda) &&
+            ((data[0] << 8) | data[1]) % 31 == 0) {
+            item->kind = EXPANSION_KIND_ENCODED;
+            item->encoding = PAYLOAD_ENCODING_ZLIB;
+            return 1;
+        }
+        if (data[0] == 0x1f && data[1] == 0x8b && data[2] == 0x08) {
+            item->kind = EXPANSION_KIND_ENCODED;
+            item->encoding = PAYLOAD_ENCODING_GZIP;
+            return 1;
+        }
+        if (read_le32(data) == 0x184D2204) {
+            item->kind = EXPANSION_KIND_ENCODED;
+            item->encoding = PAYLOAD_ENCODING_LZ4_FRAME;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Dumps the queued items through the shared dump pipeline
+ * 
+ * Children reuse the content key computed when they were emitted. The
+ * items never hashed as a whole (the detected payload itself, members
+ * trimmed to their header size) are hashed together with the
+ * multi-buffer SHA1. Dumps identified by the tree hash are left out:
+ * their SHA1 is only computed if it is needed.
+ */
+static void flush_expansion_dumps(ExpansionSession* session) {
+    int dump_count = session->pending_dump_count;
+    if (dump_count == 0) return;
+    session->pending_dump_count = 0;
+    
+    const void* sha1_data[SHA1_BATCH_MAX_BUFFERS] = { 0 };
+    size_t sha1_sizes[SHA1_BATCH_MAX_BUFFERS] = { 0 };
+    uint8_t sha1_digests[SHA1_BATCH_MAX_BUFFERS][20];
+    const uint8_t* dump_digests[SHA1_BATCH_MAX_BUFFERS];
+    int sha1_count = 0;
+    for (int i = 0; i < dump_count; i++) {
+        const ExpansionItem* item = &session->pending_dumps[i];
+        dump_digests[i] = item->key_size == item->size ? item->content_key : NULL;
+        if (dump_digests[i] != NULL || uses_tree_content_id(item->size)) continue;
+        sha1_data[sha1_count] = item->data;
+        sha1_sizes[sha1_count] = item->size;
+        dump_digests[i] = sha1_digests[sha1_count++];
+    }
+    compute_sha1_checksums(sha1_data, sha1_sizes, sha1_count, sha1_digests);
+    
+    for (int i = 0; i < dump_count; i++) {
+        const ExpansionItem* item = &session->pending_dumps[i];
+        if (dump_memory_to_file(session->output_directory, &session->dump_region, session->region_index,
+                               item->data, item->size, item->provenance, dump_digests[i])) {
+            session->dumped_count++;
+            LOGI("Successfully dumped %s from region %d (%s)", item->kind == EXPANSION_KIND_ELF ? "native library" : "DEX",
+                 session->region_index, item->provenance);
+            
+            // The inode is registered by the first dump, further payloads of the region still go out
+            session->dump_region.inode_number = 0;
+        }
+    }
+    
+    // The dumps no longer need their buffers
+    for (int i = 0; i < dump_count; i++) {
+        int backing_index = session->pending_dumps[i].backing_index;
+        if (backing_index >= 0) {
+            session->buffers[backing_index].references--;
+            release_unreferenced_buffer(session, backing_index);
+        }
+    }
+}
+
+/**
+ * @brief Queues a DEX item for dumping, flushing the queue when it is full
+ */
+static void dump_expansion_item(ExpansionSession* session, const ExpansionItem* item) {
+    if (session->pending_dump_count == SHA1_BATCH_MAX_BUFFERS) {
+        flush_expansion_dumps(session);
+    }
+    
+    // The queued dump keeps its buffer alive until the flush
+    session->pending_dumps[session->pending_dump_count++] = *item;
+    if (item->backing_index >= 0) session->buffers[item->backing_index].references++;
+}
+
+/**
+ * @brief Container stage: emits every member of a version 041 container
+ * 
+ * Each member header records its own offset in the container, which is
+ * checked before the member is accepted, and must pass the same header
+ * validation as a plain DEX file within the container bounds. The walk
+ * stops at the first member that fails, its size cannot be trusted.
+ */
+static void expand_dex_container(ExpansionSession* session, const ExpansionItem* item) {
+    size_t member_offset = 0;
+    int member_index = 0;
+    
+    while (member_offset + DEX_CONTAINER_HEADER_SIZE <= item->size) {
+        const uint8_t* member = item->data + member_offset;
+        if (memcmp(member, DEX_MAGIC_SIGNATURE, 4) != 0 ||
+            read_le32(member + 0x24) != DEX_CONTAINER_HEADER_SIZE ||
+            read_le32(member + 0x74) != member_offset) {
+            break;
+        }
+        
+        if (!validate_dex_header_structure(item->data, item->size, member_offset)) {
+            VLOGD("Container member %d at offset %zu failed validation (%s)", member_index, member_offset,
+                  item->provenance);
+            break;
+        }
+        uint32_t member_size = read_le32(member + 0x20);
+        
+        char stage_label[64];
+        snprintf(stage_label, sizeof(stage_label), "dex041[%d]", member_index);
+        emit_child(session, item, item->backing_index, member, member_size,
+                   EXPANSION_KIND_DEX, PAYLOAD_ENCODING_PLAIN, stage_label);
+        
+        member_offset += member_size;
+        member_index++;
+    }
+}
+
+/**
+ * @brief Checks whether a zip entry may hold code worth expanding
+ */
+static int is_interesting_zip_entry(const char* entry_name) {
+    static const char* code_suffixes[] = { ".dex", ".jar", ".zip", ".apk", ".odex" };
+    
+    if (strncmp(entry_name, "assets/", 7) == 0) return 1;
+    
+    size_t name_length = strlen(entry_name);
+    for (size_t i = 0; i < sizeof(code_suffixes) / sizeof(code_suffixes[0]); i++) {
+        size_t suffix_length = strlen(code_suffixes[i]);
+        if (name_length >= suffix_length &&
+            strcasecmp(entry_name + name_length - suffix_length, code_suffixes[i]) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Zip stage: walks local file headers and emits code-bearing entries
+ * 
+ * Stored entries become views into the archive, deflated entries are
+ * queued for the inflater. Walking stops at the first entry whose length
+ * cannot be determined (data descriptor without sizes).
+ */
+static void expand_zip_archive(ExpansionSession* session, const ExpansionItem* item) {
+    size_t entry_offset = 0;
+    
+    while (entry_offset + ZIP_LOCAL_HEADER_SIZE <= item->size &&
+           memcmp(item->data + entry_offset, "PK\003\004", 4) == 0) {
+        const uint8_t* local_header = item->data + entry_offset;
+        uint16_t general_flags = read_le16(local_header + 6);
+        uint16_t compression_method = read_le16(local_header + 8);
+        uint32_t compressed_size = read_le32(local_header + 18);
+        uint16_t name_length = read_le16(local_header + 26);
+        uint16_t extra_length = read_le16(local_header + 28);
+        
+        size_t data_offset = entry_offset + ZIP_LOCAL_HEADER_SIZE + name_length + extra_length;
+        if (data_offset > item->size) break;
+        
+        // Sizes are zero when a data descriptor follows the data
+        int length_known = !((general_flags & 0x0008) && compressed_size == 0);
+        size_t entry_size = length_known ? compressed_size : item->size - data_offset;
+        if (entry_size > item->size - data_offset) {
+            entry_size = item->size - data_offset; // Truncated archive
+            length_known = 0;
+        }
+        
+        char entry_name[ZIP_MAX_ENTRY_NAME];
+        size_t copied_length = name_length < sizeof(entry_name) - 1 ? name_length : sizeof(entry_name) - 1;
+        memcpy(entry_name, local_header + ZIP_LOCAL_HEADER_SIZE, copied_length);
+        entry_name[copied_length] = '\0';
+        
+        if (!(general_flags & 0x0001) && is_interesting_zip_entry(entry_name)) {
+            char stage_label[ZIP_MAX_ENTRY_NAME + 8];
+            snprintf(stage_label, sizeof(stage_label), "zip:%s", entry_name);
+            
+            if (compression_method == 0 && length_known) {
+                emit_child(session, item, item->backing_index, item->data + data_offset, entry_size,
+                           EXPANSION_KIND_UNKNOWN, PAYLOAD_ENCODING_PLAIN, stage_label);
+            } else if (compression_method == 8) {
+                // The inflater parses the local header itself
+                emit_child(session, item, item->backing_index, local_header,
+                           data_offset - entry_offset + entry_size,
+                           EXPANSION_KIND_ENCODED, PAYLOAD_ENCODING_ZIP_DEFLATE, stage_label);
+            }
+        }
+        
+        if (!length_known) break;
+        entry_offset = data_offset + entry_size;
+        
+        // Skip a data descriptor, with or without its optional signature
+        if (general_flags & 0x0008) {
+            if (entry_offset + 4 <= item->size && read_le32(item->data + entry_offset) == 0x08074b50) {
+                entry_offset += 16;
+            } else {
+                entry_offset += 12;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Rebuild stage: puts a loaded native library back into file layout
+ * 
+ * A library still in app memory continues past the region it was
+ * detected in, its other segments are read from the following mappings.
+ */
+static void expand_mapped_elf_image(ExpansionSession* session, const ExpansionItem* item) {
+    size_t readable_size = item->backing_index < 0 ? ELF_MAX_IMAGE_SIZE : item->size;
+    void* rebuilt_buffer = NULL;
+    size_t rebuilt_size = 0;
+    if (!rebuild_mapped_elf_image(item->data, readable_size, &rebuilt_buffer, &rebuilt_size)) return;
+    
+    int backing_index = adopt_buffer(session, rebuilt_buffer, rebuilt_size, 0);
+    if (backing_index < 0) return;
+    
+    emit_child(session, item, backing_index, rebuilt_buffer, rebuilt_size,
+               EXPANSION_KIND_ELF, PAYLOAD_ENCODING_PLAIN, "rebuild:elf");
+    release_unreferenced_buffer(session, backing_index);
+}
+
+/**
+ * @brief Decoder stage: inflates or decrypts an encoded item into a new owned buffer
+ */
+static void expand_encoded_item(ExpansionSession* session, const ExpansionItem* item) {
+    if (item->encoding == PAYLOAD_ENCODING_ELF_MAPPED) {
+        expand_mapped_elf_image(session, item);
+        return;
+    }
+    
+    DexDetectionResult encoded_detection = {0};
+    encoded_detection.dex_address = (void*)item->data;
+    encoded_detection.dex_size = item->size;
+    encoded_detection.payload_encoding = item->encoding;
+    encoded_detection.detector_name = payload_encoding_name(item->encoding);
+    memcpy(encoded_detection.payload_key, item->key, item->key_length);
+    encoded_detection.payload_key_length = item->key_length;
+    
+    int key_obfuscated = item->encoding == PAYLOAD_ENCODING_XOR || item->encoding == PAYLOAD_ENCODING_ADD;
+    void* decoded_buffer = NULL;
+    size_t decoded_size = 0;
+    int decoded = key_obfuscated ?
+        decrypt_detected_payload(&encoded_detection, &decoded_buffer, &decoded_size) :
+        inflate_detected_payload(&encoded_detection, &decoded_buffer, &decoded_size);
+    if (!decoded) return;
+    
+    int backing_index = adopt_buffer(session, decoded_buffer, decoded_size, !key_obfuscated);
+    if (backing_index < 0) return;
+    
+    char stage_label[32];
+    if (key_obfuscated) {
+        snprintf(stage_label, sizeof(stage_label), "decrypt:%s/%zu",
+                 payload_encoding_name(item->encoding), item->key_length);
+    } else {
+        snprintf(stage_label, sizeof(stage_label), "inflate:%s", payload_encoding_name(item->encoding));
+    }
+    emit_child(session, item, backing_index, decoded_buffer, decoded_size,
+               EXPANSION_KIND_UNKNOWN, PAYLOAD_ENCODING_PLAIN, stage_label);
+    release_unreferenced_buffer(session, backing_index);
+}
+
+/**
+ * @brief Scan stage: runs the registered detectors over an unrecognized buffer
+ * 
+ * Every payload found is emitted, continuing after the end of each one.
+ * Unlike a region scan the whole remaining buffer is searched, not only
+ * its first DEFAULT_SCAN_LIMIT bytes, so the stage ends only once a scan
+ * reaches the end of the buffer without a hit (or its budget runs out).
+ */
+static void expand_by_detection(ExpansionSession* session, const ExpansionItem* item) {
+    size_t scan_offset = 0;
+    
+    while (scan_offset < item->size && !session->timed_out) {
+        const uint8_t* scan_start = item->data + scan_offset;
+        size_t scan_size = item->size - scan_offset;
+        DexDetectionResult detection_result = {0};
+        begin_region_scan_budget(1);
+        if (!scan_for_dex_signature(scan_start, scan_size, scan_size, &detection_result) &&
+            (region_scan_budget_exhausted() ||
+             !scan_for_xor_obfuscated_dex(scan_start, scan_size, &detection_result))) {
+            break;
+        }
+        
+        const uint8_t* payload_start = detection_result.dex_address;
+        size_t payload_offset = payload_start - item->data;
+        size_t payload_size = detection_result.dex_size;
+        if (payload_size > item->size - payload_offset) payload_size = item->size - payload_offset;
+        
+        char stage_label[96];
+        snprintf(stage_label, sizeof(stage_label), "scan:%s@0x%zx",
+                 detection_result.detector_name ? detection_result.detector_name : "dex", payload_offset);
+        
+        if (detection_result.payload_encoding != PAYLOAD_ENCODING_PLAIN) {
+            ExpansionItem* child = emit_child(session, item, item->backing_index, payload_start, payload_size,
+                                              EXPANSION_KIND_ENCODED, detection_result.payload_encoding,
+                                              stage_label);
+            if (child) {
+                memcpy(child->key, detection_result.payload_key, detection_result.payload_key_length);
+                child->key_length = detection_result.payload_key_length;
+            }
+        } else {
+            emit_child(session, item, item->backing_index, payload_start, payload_size,
+                       EXPANSION_KIND_DETECTED, PAYLOAD_ENCODING_PLAIN, stage_label);
+        }
+        
+        // Compressed extents run to the end of the buffer, the inflater finds the real end
+        if (payload_size == 0 || (detection_result.payload_encoding != PAYLOAD_ENCODING_PLAIN &&
+                                  detection_result.payload_encoding != PAYLOAD_ENCODING_ELF_MAPPED &&
+                                  detection_result.payload_key_length == 0)) {
+            break;
+        }
+        scan_offset = payload_offset + payload_size;
+    }
+}
+
+/**
+ * @brief Runs the stage matching an item's kind
+ */
+static void process_expansion_item(ExpansionSession* session, ExpansionItem* item) {
+    if (item->kind == EXPANSION_KIND_UNKNOWN || item->kind == EXPANSION_KIND_DETECTED) {
+        ExpansionKind original_kind = item->kind;
+        if (!classify_by_magic(item)) {
+            if (original_kind == EXPANSION_KIND_DETECTED) {
+                // Plugin payloads of unknown format are dumped as detected
+                dump_expansion_item(session, item);
+            } else {
+                expand_by_detection(session, item);
+            }
+            return;
+        }
+    }
+    
+    switch (item->kind) {
+        case EXPANSION_KIND_DEX:
+            dump_expansion_item(session, item);
+            break;
+        case EXPANSION_KIND_DEX_CONTAINER:
+            // ART loads the container as one file, members are dumped on their own as well
+            dump_expansion_item(session, item);
+            expand_dex_container(session, item);
+            break;
+        case EXPANSION_KIND_ZIP:
+            expand_zip_archive(session, item);
+            break;
+        case EXPANSION_KIND_ELF:
+            dump_expansion_item(session, item);
+            break;
+        case EXPANSION_KIND_ENCODED:
+            expand_encoded_item(session, item);
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Expands a detected payload and dumps every DEX file found inside it
+ * 
+ * Plain payloads are copied out of app memory first, so every stage after
+ * the first one works on private buffers. Encoded payloads are inflated
+ * or decrypted straight from app memory. Items are processed newest first, which keeps
+ * at most one branch of inflated buffers alive at a time.
+ * 
+ * @param output_directory Directory to save dumped files
+ * @param memory_region Region the payload was detected in
+ * @param region_index Index of region for logging and filenames
+ * @param detection_result Detection produced by the region scan
+ * @return 1 if at least one DEX was dumped, 0 otherwise
+ */
+int expand_and_dump_payload(const char* output_directory, const MemoryRegion* memory_region,
+                            int region_index, const DexDetectionResult* detection_result) {
+    // Nothing from an already dumped file is written again
+    if (memory_region->inode_number != 0 && is_file_already_dumped(memory_region->inode_number)) {
+        VLOGD("Skipping already dumped region with inode: %lu", memory_region->inode_number);
+        return 0;
+    }
+    
+    ExpansionSession* session = calloc(1, sizeof(ExpansionSession));
+    if (!session) {
+        LOGE("Memory allocation failed for expansion of region %d", region_index);
+        return 0;
+    }
+    session->output_directory = output_directory;
+    session->dump_region = *memory_region;
+    session->region_index = region_index;
+    session->deadline_ms = thread_cpu_milliseconds() + EXPANSION_TIME_BUDGET_MS;
+    
+    ExpansionItem* root = &session->queue[session->queue_count++];
+    root->depth = 0;
+    root->backing_index = -1;
+    snprintf(root->provenance, sizeof(root->provenance), "region%d@%p:%s", region_index,
+             detection_result->dex_address,
+             detection_result->detector_name ? detection_result->detector_name : "dex");
+    
+    if (detection_result->payload_encoding != PAYLOAD_ENCODING_PLAIN) {
+        root->data = detection_result->dex_address;
+        root->size = detection_result->dex_size;
+        root->kind = EXPANSION_KIND_ENCODED;
+        root->encoding = detection_result->payload_encoding;
+        memcpy(root->key, detection_result->payload_key, detection_result->payload_key_length);
+        root->key_length = detection_result->payload_key_length;
+    } else {
+        // Create safe copy of detected payload, flagging windows the app kept changing
+        char torn_ranges[MAX_PROVENANCE_LENGTH / 2];
+        void* safe_memory_copy = create_verified_memory_copy(detection_result->dex_address,
+                                                            detection_result->dex_size,
+                                                            torn_ranges, sizeof(torn_ranges));
+        int backing_index = safe_memory_copy ?
+            adopt_buffer(session, safe_memory_copy, detection_result->dex_size, 0) : -1;
+        if (backing_index < 0) {
+            LOGW("Failed to create memory copy for region %d", region_index);
+            free(session);
+            return 0;
+        }
+        root->data = safe_memory_copy;
+        root->size = detection_result->dex_size;
+        root->kind = EXPANSION_KIND_DETECTED;
+        root->encoding = PAYLOAD_ENCODING_PLAIN;
+        root->backing_index = backing_index;
+        session->buffers[backing_index].references = 1;
+        
+        // Still torn after the retries: dumped anyway, the manifest tells which bytes to distrust
+        if (torn_ranges[0]) {
+            size_t provenance_length = strlen(root->provenance);
+            snprintf(root->provenance + provenance_length, sizeof(root->provenance) - provenance_length,
+                     " > torn:%s", torn_ranges);
+        }
+    }
+    
+    while (session->queue_count > 0) {
+        ExpansionItem item = session->queue[--session->queue_count];
+        
+        if (!session->timed_out && thread_cpu_milliseconds() > session->deadline_ms) {
+            session->timed_out = 1;
+            report_expansion_budget(session, "time budget exhausted");
+        }
+        if (!session->timed_out) {
+            process_expansion_item(session, &item);
+        }
+        
+        // Drop this item's hold on its buffer, children took their own references
+        if (item.backing_index >= 0) {
+            session->buffers[item.backing_index].references--;
+            release_unreferenced_buffer(session, item.backing_index);
+        }
+    }
+    
+    flush_expansion_dumps(session);
+    
+    int dumped_count = session->dumped_count;
+    free(session);
+    return dumped_count > 0;
+}
@@ -0,0 +1,28 @@
+#ifndef DEXDUMPER_EXPANSION_ENGINE_H
+#define DEXDUMPER_EXPANSION_ENGINE_H
+
+// Expansion engine header - declares recursive expansion of nested payloads
+
+#include "common.h"
+#include "config.h"
+
+/**
+ * Container Expansion:
+ * 
+ * Real payloads nest: a zip inside an asset, a jar holding a compressed
+ * DEX, a version 041 container holding several DEX files. A detected
+ * payload is put on an expansion queue; each stage (zip reader, inflater
+ * or decryptor, container parser, detector scan) turns one buffer into child buffers
+ * that go back on the queue until DEX files (or native libraries) come
+ * out and are dumped.
+ * 
+ * Expansion is bounded by depth, item count, child bytes and time, and
+ * children whose content was already seen are dropped. Every dump is
+ * recorded in the manifest with the chain of stages that produced it.
+ */
+
+// Expands a detected payload and dumps every DEX file found inside it
+int expand_and_dump_payload(const char* output_directory, const MemoryRegion* memory_region,
+                            int region_index, const DexDetectionResult* detection_result);
+
+#endif
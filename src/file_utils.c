@@ -1,6 +1,18 @@
 #include "file_utils.h"
 #include "registry_manager.h"
 #include "config_manager.h"
+#include "dump_manifest.h"
+#include "io_engine.h"
+#include "scan_statistics.h"
+#include "shared_dedup_table.h"
+#include "content_hash.h"
+
+// sync_file_range() flags, missing from older headers
+#ifndef SYNC_FILE_RANGE_WAIT_BEFORE
+#define SYNC_FILE_RANGE_WAIT_BEFORE 1
+#define SYNC_FILE_RANGE_WRITE 2
+#define SYNC_FILE_RANGE_WAIT_AFTER 4
+#endif
 
 /**
  * @brief Gets the current Android application's package name
@@ -124,10 +136,11 @@ char* get_output_directory_path() {
  * @param base_directory Base output directory path
  * @param region_index Index of memory region for naming
  * @param memory_address Memory address where DEX was found (for debugging)
+ * @param file_kind Name prefix and extension: "dex", or "so" for native libraries
  */
 void generate_dump_filename(char* filename_buffer, size_t buffer_size, 
                            const char* base_directory, int region_index, 
-                           void* memory_address) {
+                           void* memory_address, const char* file_kind) {
     time_t current_time = time(NULL);
     struct tm* time_info = localtime(&current_time);
     char timestamp_string[20];
@@ -135,15 +148,15 @@ void generate_dump_filename(char* filename_buffer, size_t buffer_size,
     // Format timestamp as YYYYMMDD_HHMMSS
     strftime(timestamp_string, sizeof(timestamp_string), "%Y%m%d_%H%M%S", time_info);
     
-    // Create filename: dex_{region_index}_{memory_address}_{timestamp}.dex
-    snprintf(filename_buffer, buffer_size, "%s/dex_%d_%p_%s.dex", 
-             base_directory, region_index, memory_address, timestamp_string);
+    // Create filename: {kind}_{region_index}_{memory_address}_{timestamp}.{kind}
+    snprintf(filename_buffer, buffer_size, "%s/%s_%d_%p_%s.%s", 
+             base_directory, file_kind, region_index, memory_address, timestamp_string, file_kind);
 }
 
 /**
  * @brief Checks if filename matches the exact DEX dump pattern
  * 
- * Pattern: dex_%d_%p_%s.dex
+ * Pattern: dex_%d_%p_%s.dex (or so_%d_%p_%s.so for native libraries)
  * Where: 
  *   %d = region index (number)
  *   %p = memory address (pointer format) 
@@ -156,25 +169,33 @@ int matches_dex_dump_pattern(const char* filename) {
     // Pattern breakdown:
     // "dex_" + number + "_" + pointer + "_" + timestamp + ".dex"
     
-    // Check prefix
-    if (strncmp(filename, "dex_", 4) != 0) {
+    // Check prefix, which also names the extension
+    const char* extension;
+    size_t prefix_length;
+    if (strncmp(filename, "dex_", 4) == 0) {
+        extension = ".dex";
+        prefix_length = 4;
+    } else if (strncmp(filename, "so_", 3) == 0) {
+        extension = ".so";
+        prefix_length = 3;
+    } else {
         return 0;
     }
     
-    // Find first underscore after "dex_"
-    char* first_underscore = strchr(filename + 4, '_');
+    // Find first underscore after the prefix
+    char* first_underscore = strchr(filename + prefix_length, '_');
     if (!first_underscore) {
         return 0;
     }
     
-    // Check if part between "dex_" and first underscore is a valid number
+    // Check if part between prefix and first underscore is a valid number
     char number_part[32];
-    size_t num_len = first_underscore - (filename + 4);
+    size_t num_len = first_underscore - (filename + prefix_length);
     if (num_len == 0 || num_len >= sizeof(number_part)) {
         return 0;
     }
     
-    strncpy(number_part, filename + 4, num_len);
+    strncpy(number_part, filename + prefix_length, num_len);
     number_part[num_len] = '\0';
     
     // Verify it's a valid integer
@@ -203,13 +224,13 @@ int matches_dex_dump_pattern(const char* filename) {
         return 0;
     }
     
-    // Check for ".dex" extension
-    char* dot_dex = strstr(second_underscore, ".dex");
-    if (!dot_dex || strlen(dot_dex) != 4) {
+    // Check for the extension matching the prefix
+    char* dot_dex = strstr(second_underscore, extension);
+    if (!dot_dex || strlen(dot_dex) != strlen(extension)) {
         return 0;
     }
     
-    // Verify timestamp part between second_underscore and .dex
+    // Verify timestamp part between second_underscore and the extension
     // Timestamp should be in format YYYYMMDD_HHMMSS (digits and underscore)
     char* timestamp_part = second_underscore + 1;
     size_t timestamp_len = dot_dex - timestamp_part;
@@ -246,7 +267,7 @@ int clean_output_directory(const char* directory_path) {
         LOGE("Failed to open output directory: %s", directory_path);
         return 0;
     }
-
+    
     struct dirent* directory_entry;
     int success_flag = 1;
     int deleted_file_count = 0;
@@ -256,7 +277,7 @@ int clean_output_directory(const char* directory_path) {
         // Skip . and .. entries
         if (strcmp(directory_entry->d_name, ".") == 0 || 
             strcmp(directory_entry->d_name, "..") == 0) continue;
-
+        
         char* filename = directory_entry->d_name;
         
         // Filter files: only delete those matching DEX dump pattern "dex_%d_%p_%s.dex"
@@ -264,7 +285,7 @@ int clean_output_directory(const char* directory_path) {
             VLOGD("Skipping non-DEX-dump file: %s", filename);
             continue; // Skip files that don't match exact pattern
         }
-
+        
         char full_file_path[MAX_PATH_LENGTH];
         snprintf(full_file_path, sizeof(full_file_path), "%s/%s", 
                  directory_path, filename);
@@ -278,27 +299,134 @@ int clean_output_directory(const char* directory_path) {
             success_flag = 0;
         }
     }
-
+    
     closedir(directory_handle);
     LOGI("Cleaned %d DEX dump files from directory: %s", deleted_file_count, directory_path);
     return success_flag;
 }
 
+/**
+ * @brief Writes back a range of a dump file, optionally waiting for it
+ * 
+ * Bionic exports sync_file_range() from API 26 only and 32-bit ARM needs
+ * the argument order of sync_file_range2, so the system call is issued
+ * directly on 64-bit ABIs. 32-bit builds only wait, with fdatasync().
+ * 
+ * @param file_descriptor Dump file
+ * @param range_offset First byte of the range
+ * @param range_size Size of the range
+ * @param wait_for_completion 1 to wait until the range is on disk, 0 to only start writeback
+ */
+static void write_back_dump_range(int file_descriptor, off_t range_offset, size_t range_size,
+                                  int wait_for_completion) {
+#if defined(__LP64__) && defined(__NR_sync_file_range)
+    unsigned int flags = wait_for_completion ?
+                         SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER :
+                         SYNC_FILE_RANGE_WRITE;
+    syscall(__NR_sync_file_range, file_descriptor, (long)range_offset, (long)range_size, flags);
+#else
+    if (wait_for_completion) fdatasync(file_descriptor);
+#endif
+}
+
+/**
+ * @brief Writes a dump without leaving it in the page cache
+ * 
+ * The file is preallocated, then written in DUMP_WRITEBACK_WINDOW slices.
+ * Writeback of each slice starts as soon as it is written; once the
+ * next slice is written the previous one is waited for and dropped with
+ * POSIX_FADV_DONTNEED, so at most two slices of the dump are cached at
+ * any time and the app's own pages are not evicted to hold data that is
+ * never read back on the device.
+ * 
+ * @param file_descriptor Newly created, empty dump file
+ * @param data_buffer Dump contents
+ * @param data_size Size of the dump
+ * @return 1 if the whole dump was written, 0 on failure (errno is set)
+ */
+static int write_dump_file(int file_descriptor, const void* data_buffer, size_t data_size) {
+    if (!should_drop_dump_page_cache()) {
+        return io_engine_write_all(file_descriptor, data_buffer, data_size, 0);
+    }
+    
+    // Reserve the blocks up front: less fragmentation, and a full disk fails before anything is written
+    int allocate_result = fallocate(file_descriptor, 0, 0, (off_t)data_size);
+    if (allocate_result != 0 && errno == ENOSPC) return 0;
+    
+    const char* dump_data = data_buffer;
+    size_t previous_offset = 0;
+    size_t previous_size = 0;
+    for (size_t slice_offset = 0; slice_offset < data_size; slice_offset += DUMP_WRITEBACK_WINDOW) {
+        size_t slice_size = data_size - slice_offset < DUMP_WRITEBACK_WINDOW ?
+                            data_size - slice_offset : DUMP_WRITEBACK_WINDOW;
+        if (!io_engine_write_all(file_descriptor, dump_data + slice_offset, slice_size, (off_t)slice_offset)) {
+            return 0;
+        }
+        write_back_dump_range(file_descriptor, (off_t)slice_offset, slice_size, 0);
+        
+        // The previous slice has had a whole slice worth of time to reach the disk
+        if (previous_size > 0) {
+            write_back_dump_range(file_descriptor, (off_t)previous_offset, previous_size, 1);
+            posix_fadvise(file_descriptor, (off_t)previous_offset, (off_t)previous_size, POSIX_FADV_DONTNEED);
+        }
+        previous_offset = slice_offset;
+        previous_size = slice_size;
+    }
+    
+    write_back_dump_range(file_descriptor, (off_t)previous_offset, previous_size, 1);
+    posix_fadvise(file_descriptor, 0, 0, POSIX_FADV_DONTNEED);
+    SCAN_STAT_ADD(dump_bytes_uncached, data_size);
+    return 1;
+}
+
+/**
+ * @brief Checks if a dump is identified by the tree hash content ID rather than its SHA1
+ * 
+ * Depends on the size only, so the same content always gets the same
+ * kind of key.
+ * 
+ * @param data_size Size of the dump
+ * @return 1 for the tree hash, 0 for SHA1
+ */
+int uses_tree_content_id(size_t data_size) {
+    return should_enable_tree_content_hash() && data_size >= TREE_HASH_MIN_SIZE;
+}
+
+/**
+ * @brief Computes the SHA1 of a dump unless it is known already
+ */
+static void ensure_dump_sha1(const void* data_buffer, size_t data_size, uint8_t* sha1_digest, int* has_sha1) {
+    if (*has_sha1) return;
+    compute_sha1_checksum(data_buffer, data_size, sha1_digest);
+    *has_sha1 = 1;
+}
+
 /**
  * @brief Dumps memory content to a file with duplicate or exclude detection
  * 
  * This is the core function that writes detected DEX files to disk
  * after performing validation and duplicate or exclude checking.
  * 
+ * Dumps of TREE_HASH_MIN_SIZE and more are identified by their tree
+ * hash content ID, which spreads over several cores. They are matched
+ * against the content ID exclusion list and recorded in the registry
+ * and manifest by content ID; their SHA1 is computed only if the
+ * directory check finds a file of the same size, so a large dump is
+ * normally never run through SHA1 at all.
+ * 
  * @param output_directory Directory to write the file to
  * @param memory_region Memory region information for tracking
  * @param region_index Index of the region for filename
  * @param data_buffer Pointer to DEX file data in memory
  * @param data_size Size of DEX file data
+ * @param provenance Provenance chain recorded in the manifest (may be NULL)
+ * @param precomputed_key Content key of data_buffer already computed by the caller (the content ID
+ *                        if uses_tree_content_id(data_size), the SHA1 otherwise), NULL to compute it here
  * @return 1 if successfully dumped, 0 on failure
  */
 int dump_memory_to_file(const char* output_directory, const MemoryRegion* memory_region, 
-                       int region_index, const void* data_buffer, size_t data_size) {
+                       int region_index, const void* data_buffer, size_t data_size,
+                       const char* provenance, const uint8_t* precomputed_key) {
     // Check if we've already dumped this file (by inode)
     if (memory_region->inode_number != 0 && 
         is_file_already_dumped(memory_region->inode_number)) {
@@ -312,63 +440,108 @@ int dump_memory_to_file(const char* output_directory, const MemoryRegion* memory
         return 0;
     }
     
-    // Compute SHA1 checksum for duplicate detection
+    // Compute the content key for duplicate detection: tree hash for large dumps, SHA1 otherwise
     uint8_t sha1_digest[20];
-    compute_sha1_checksum(data_buffer, data_size, sha1_digest);
+    int has_sha1 = 0;
+    uint8_t content_id[CONTENT_ID_SIZE];
+    int has_content_id = uses_tree_content_id(data_size);
+    if (has_content_id && precomputed_key) {
+        memcpy(content_id, precomputed_key, sizeof(content_id));
+    } else if (has_content_id) {
+        compute_content_id(data_buffer, data_size, content_id);
+    } else if (precomputed_key) {
+        memcpy(sha1_digest, precomputed_key, sizeof(sha1_digest));
+        has_sha1 = 1;
+    } else {
+        ensure_dump_sha1(data_buffer, data_size, sha1_digest, &has_sha1);
+    }
     
-    // Check if the dumped file is listed in the exclude list
-    if (is_sha1_excluded(sha1_digest)) {
-        VLOGD("Skipping excluded DEX file based on SHA1 checksum");
+    // Check if we've already dumped a file with this content (it passed the exclude list then)
+    if (has_content_id ? is_content_id_already_dumped(content_id) : is_checksum_already_dumped(sha1_digest)) {
+        VLOGD("Skipping duplicate DEX file based on %s", has_content_id ? "content ID" : "SHA1 checksum");
         return 0;
     }
     
-    // Check if we've already dumped a file with this checksum
-    if (is_checksum_already_dumped(sha1_digest)) {
-        VLOGD("Skipping duplicate DEX file based on SHA1 checksum");
+    // Check if the dumped file is listed in the exclude list, by the key it already has
+    if (has_content_id ? is_content_id_excluded(content_id) : is_sha1_excluded(sha1_digest)) {
+        VLOGD("Skipping excluded DEX file based on %s", has_content_id ? "content ID" : "SHA1 checksum");
         return 0;
     }
     
-    // Check if SHA1 already exists in any file in output directory (persistent duplicate detection)
-    if (is_sha1_duplicate_in_directory(output_directory, sha1_digest)) {
-        VLOGD("Skipping duplicate DEX file based on directory SHA1 check");
+    // Claim the content in the table shared by the app's processes; the
+    // directory was cleaned when the table entries were retired, so the slow rehash
+    // of every dump on disk is only needed without the table
+    const uint8_t* shared_key = has_content_id ? content_id : sha1_digest;
+    SharedDedupResult shared_claim = claim_shared_dump_checksum(shared_key, data_size);
+    if (shared_claim == SHARED_DEDUP_DUPLICATE) {
+        VLOGD("Skipping duplicate DEX file based on shared dedup table");
         return 0;
     }
     
-    // Generate unique output filename
+    // Check if SHA1 already exists in any file in output directory (persistent duplicate detection)
+    if (shared_claim == SHARED_DEDUP_UNAVAILABLE) {
+        if (is_sha1_duplicate_in_directory(output_directory, data_buffer, data_size, sha1_digest, &has_sha1)) {
+            VLOGD("Skipping duplicate DEX file based on directory SHA1 check");
+            return 0;
+        }
+    }
+    
+    // Generate unique output filename, native libraries are told apart by their ELF magic
+    const char* file_kind = (data_size >= 4 && memcmp(data_buffer, "\177ELF", 4) == 0) ? "so" : "dex";
     char output_file_path[MAX_PATH_LENGTH];
     generate_dump_filename(output_file_path, sizeof(output_file_path), 
-                          output_directory, region_index, memory_region->start_address);
+                          output_directory, region_index, memory_region->start_address, file_kind);
+    
+    // Several payloads of one region can be dumped within the same second,
+    // never overwrite an earlier dump: add a numeric suffix instead
+    int output_fd = open(output_file_path, O_WRONLY | O_CREAT | O_EXCL, 0644);
+    size_t base_path_length = strlen(output_file_path) - strlen(file_kind) - 1; // Without extension
+    for (int suffix = 1; output_fd < 0 && errno == EEXIST && suffix < 100; suffix++) {
+        snprintf(output_file_path + base_path_length, sizeof(output_file_path) - base_path_length,
+                 "_%d.%s", suffix, file_kind);
+        output_fd = open(output_file_path, O_WRONLY | O_CREAT | O_EXCL, 0644);
+    }
     
-    // Write data to file
-    FILE* output_file = fopen(output_file_path, "wb");
-    if (!output_file) {
+    if (output_fd < 0) {
         LOGE("Failed to create output file %s: %s", output_file_path, strerror(errno));
+        release_shared_dump_checksum(shared_key);
         return 0;
     }
     
-    size_t bytes_written = fwrite(data_buffer, 1, data_size, output_file);
-    fclose(output_file);
+    // Write data to file straight from memory, keeping it out of the page cache
+    int write_complete = write_dump_file(output_fd, data_buffer, data_size);
+    int write_error = errno;
+    close(output_fd);
     
     // Verify complete write
-    if (bytes_written != data_size) {
-        LOGE("Incomplete write to file %s", output_file_path);
+    if (!write_complete) {
+        LOGE("Incomplete write to file %s: %s", output_file_path, strerror(write_error));
         remove(output_file_path); // Clean up partial file
+        release_shared_dump_checksum(shared_key);
         return 0;
     }
+    publish_shared_dump_checksum(shared_key, output_file_path);
     
-    // Register the dumped file to prevent future duplicates
+    // Register the dumped file to prevent future duplicates, the SHA1 only if it was computed
+    const uint8_t* registered_sha1 = has_sha1 ? sha1_digest : NULL;
+    const uint8_t* registered_content_id = has_content_id ? content_id : NULL;
     if (memory_region->inode_number != 0) {
-        register_dumped_file_with_checksum(memory_region->inode_number, output_file_path, sha1_digest);
+        register_dumped_file_with_checksum(memory_region->inode_number, output_file_path, registered_sha1,
+                                           registered_content_id);
     } else {
-        register_dumped_file_with_checksum(0, output_file_path, sha1_digest);
+        register_dumped_file_with_checksum(0, output_file_path, registered_sha1, registered_content_id);
     }
     
-    // Log success with partial SHA1 for identification
-    char sha1_partial[9];
-    snprintf(sha1_partial, sizeof(sha1_partial), "%02x%02x%02x%02x", 
-             sha1_digest[0], sha1_digest[1], sha1_digest[2], sha1_digest[3]);
+    // Log success with the partial content key for identification
+    const uint8_t* key_digest = has_content_id ? content_id : sha1_digest;
+    char key_partial[9];
+    snprintf(key_partial, sizeof(key_partial), "%02x%02x%02x%02x", 
+             key_digest[0], key_digest[1], key_digest[2], key_digest[3]);
+    
+    LOGI("Successfully dumped %zu bytes to %s (%s: %s...)", 
+         data_size, output_file_path, has_content_id ? "content ID" : "SHA1", key_partial);
     
-    LOGI("Successfully dumped %zu bytes to %s (SHA1: %s...)", 
-         data_size, output_file_path, sha1_partial);
+    append_dump_manifest_record(output_directory, output_file_path, registered_sha1, registered_content_id,
+                                data_size, memory_region, provenance);
     return 1;
 }
\ No newline at end of file
@@ -30,13 +30,17 @@ int matches_dex_dump_pattern(const char* filename);
 // Cleans output directory by removing existing files
 int clean_output_directory(const char* directory_path);
 
-// Generates unique filename for dumped DEX files
+// Generates unique filename for dumped DEX files and native libraries
 void generate_dump_filename(char* filename_buffer, size_t buffer_size, 
                            const char* base_directory, int region_index, 
-                           void* memory_address);
+                           void* memory_address, const char* file_kind);
+
+// Checks if a dump of this size is identified by the tree hash content ID rather than its SHA1
+int uses_tree_content_id(size_t data_size);
 
 // Core function to dump memory content to file with validation
 int dump_memory_to_file(const char* output_directory, const MemoryRegion* memory_region, 
-                       int region_index, const void* data_buffer, size_t data_size);
+                       int region_index, const void* data_buffer, size_t data_size,
+                       const char* provenance, const uint8_t* precomputed_key);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,95 @@
+#include "footprint_tracker.h"
+#include "memory_scanner.h"
+#include "config_manager.h"
+#include "scan_statistics.h"
+#include "scan_arena.h"
+
+// Linux 5.4 advice values, missing from older headers
+#ifndef MADV_COLD
+#define MADV_COLD 20
+#endif
+#ifndef MADV_PAGEOUT
+#define MADV_PAGEOUT 21
+#endif
+
+/**
+ * @brief Records which pages of a file-backed region are resident before scanning it
+ * 
+ * Leaves the snapshot empty (nothing to release) when footprint release
+ * is disabled, the region is anonymous or mincore() fails.
+ * 
+ * @param memory_region Region about to be scanned
+ * @param snapshot Output snapshot, always initialised
+ */
+void capture_residency_snapshot(const MemoryRegion* memory_region, ResidencySnapshot* snapshot) {
+    memset(snapshot, 0, sizeof(*snapshot));
+    if (get_footprint_release_mode() == FOOTPRINT_RELEASE_OFF) return;
+    if (!is_file_backed_region(memory_region)) return;
+    
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    size_t region_size = (char*)memory_region->end_address - (char*)memory_region->start_address;
+    size_t tracked_size = region_size < MAX_REGION_SIZE ? region_size : MAX_REGION_SIZE;
+    size_t page_count = tracked_size / page_size;
+    if (page_count == 0) return;
+    
+    // Both residency vectors are handed back to the scan arena on release
+    ScanArenaMark arena_mark = scan_arena_mark();
+    unsigned char* resident_before = scan_arena_alloc(page_count);
+    if (resident_before == NULL) return;
+    if (mincore(memory_region->start_address, page_count * page_size, resident_before) != 0) {
+        scan_arena_release_to(arena_mark);
+        return;
+    }
+    
+    snapshot->region_start = (const char*)memory_region->start_address;
+    snapshot->tracked_size = page_count * page_size;
+    snapshot->resident_before = resident_before;
+    snapshot->arena_mark = arena_mark;
+}
+
+/**
+ * @brief Gives back the pages that became resident since the snapshot and frees it
+ * 
+ * Residency is queried again and each run of pages resident now but not
+ * before is advised with a single madvise() call. Advice is only a hint:
+ * kernels without MADV_COLD/MADV_PAGEOUT reject it and nothing changes.
+ * 
+ * @param snapshot Snapshot taken by capture_residency_snapshot()
+ */
+void release_scan_footprint(ResidencySnapshot* snapshot) {
+    if (snapshot->resident_before == NULL) return;
+    
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    size_t page_count = snapshot->tracked_size / page_size;
+    int advice = get_footprint_release_mode() == FOOTPRINT_RELEASE_PAGEOUT ? MADV_PAGEOUT : MADV_COLD;
+    
+    unsigned char* resident_after = scan_arena_alloc(page_count);
+    if (resident_after != NULL &&
+        mincore((void*)snapshot->region_start, snapshot->tracked_size, resident_after) == 0) {
+        size_t released_pages = 0;
+        for (size_t page = 0; page < page_count; ) {
+            if (!(resident_after[page] & 1) || (snapshot->resident_before[page] & 1)) {
+                page++;
+                continue;
+            }
+            size_t run_end = page;
+            while (run_end < page_count && (resident_after[run_end] & 1) &&
+                   !(snapshot->resident_before[run_end] & 1)) {
+                run_end++;
+            }
+            
+            if (madvise((void*)(snapshot->region_start + page * page_size),
+                        (run_end - page) * page_size, advice) != 0) {
+                VLOGD("Footprint release advice rejected for %p: %s",
+                      snapshot->region_start + page * page_size, strerror(errno));
+                break;
+            }
+            released_pages += run_end - page;
+            page = run_end;
+        }
+        SCAN_STAT_ADD(footprint_pages_released, released_pages);
+    }
+    
+    scan_arena_release_to(snapshot->arena_mark);
+    snapshot->resident_before = NULL;
+}
@@ -0,0 +1,44 @@
+#ifndef DEXDUMPER_FOOTPRINT_TRACKER_H
+#define DEXDUMPER_FOOTPRINT_TRACKER_H
+
+// Footprint tracker header - declares release of the page cache a scan pulled in
+
+#include "common.h"
+#include "config.h"
+#include "scan_arena.h"
+
+/**
+ * Memory Footprint Restoration:
+ * 
+ * Scanning a file-backed region faults its pages into the page cache, and
+ * they stay resident afterwards, adding to the app's PSS and its risk of
+ * being killed by the low memory killer. Before a file-backed region is
+ * scanned its residency is recorded with mincore(); afterwards every run
+ * of pages that became resident during the scan is advised MADV_COLD (or
+ * MADV_PAGEOUT). Pages the app already had resident are never touched.
+ * Anonymous regions are left alone: reading them maps the shared zero
+ * page or pages the app owns.
+ */
+
+// How pages pulled in by a scan are given back
+typedef enum {
+    FOOTPRINT_RELEASE_OFF = 0,   // Leave pages resident
+    FOOTPRINT_RELEASE_COLD,      // MADV_COLD: reclaim first under memory pressure
+    FOOTPRINT_RELEASE_PAGEOUT    // MADV_PAGEOUT: reclaim right away
+} FootprintReleaseMode;
+
+// Residency of a region recorded before it is scanned
+typedef struct {
+    const char* region_start;       // First byte of the tracked range
+    size_t tracked_size;            // Size of the tracked range
+    unsigned char* resident_before; // mincore() vector from before the scan, NULL if not tracked
+    ScanArenaMark arena_mark;       // Scan arena position before resident_before was allocated
+} ResidencySnapshot;
+
+// Records which pages of a file-backed region are resident before scanning it
+void capture_residency_snapshot(const MemoryRegion* memory_region, ResidencySnapshot* snapshot);
+
+// Gives back the pages that became resident since the snapshot and frees it
+void release_scan_footprint(ResidencySnapshot* snapshot);
+
+#endif
@@ -0,0 +1,461 @@
+#include "io_engine.h"
+#include "self_exclusion.h"
+#include "config_manager.h"
+#include "scan_statistics.h"
+#include <linux/io_uring.h>
+#include <sys/uio.h>
+
+// io_uring system calls share one number on every architecture, older headers lack them
+#ifndef __NR_io_uring_setup
+#define __NR_io_uring_setup 425
+#endif
+#ifndef __NR_io_uring_enter
+#define __NR_io_uring_enter 426
+#endif
+#ifndef __NR_io_uring_register
+#define __NR_io_uring_register 427
+#endif
+
+// State of the shared ring
+typedef enum {
+    IO_ENGINE_UNPROBED = 0,  // Ring not set up yet
+    IO_ENGINE_READY,         // Ring set up, requests go through io_uring
+    IO_ENGINE_UNAVAILABLE    // Disabled, unsupported or failed: synchronous I/O only
+} IoEngineState;
+
+// Mapped submission and completion rings
+typedef struct {
+    int ring_fd;
+    void* sq_ring;
+    size_t sq_ring_size;
+    void* cq_ring;
+    size_t cq_ring_size;
+    struct io_uring_sqe* sqes;
+    size_t sqes_size;
+    unsigned* sq_head;
+    unsigned* sq_tail;
+    unsigned* sq_mask;
+    unsigned* sq_array;
+    unsigned* cq_head;
+    unsigned* cq_tail;
+    unsigned* cq_mask;
+    struct io_uring_cqe* cqes;
+    uint8_t* read_buffers;   // IO_URING_READ_BUFFERS windows of FILE_READ_WINDOW_SIZE bytes
+    int buffers_registered;  // Read windows registered as fixed buffers
+} IoUring;
+
+static IoUring io_ring = { .ring_fd = -1 };
+static IoEngineState io_engine_state = IO_ENGINE_UNPROBED;
+static pthread_mutex_t io_engine_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Recovery point while probing io_uring under a seccomp policy that traps it
+static sigjmp_buf seccomp_probe_recovery;
+
+/**
+ * @brief Leaves the io_uring probe when seccomp traps one of its system calls
+ */
+static void seccomp_probe_signal_handler(int signal_number) {
+    siglongjmp(seccomp_probe_recovery, 1);
+}
+
+/**
+ * @brief Unmaps the rings, closes the ring and releases the read windows
+ */
+static void destroy_io_ring(void) {
+    if (io_ring.sqes) munmap(io_ring.sqes, io_ring.sqes_size);
+    if (io_ring.cq_ring) munmap(io_ring.cq_ring, io_ring.cq_ring_size);
+    if (io_ring.sq_ring) munmap(io_ring.sq_ring, io_ring.sq_ring_size);
+    if (io_ring.ring_fd >= 0) close(io_ring.ring_fd);
+    if (io_ring.read_buffers) {
+        release_tracked_buffer(io_ring.read_buffers, (size_t)IO_URING_READ_BUFFERS * FILE_READ_WINDOW_SIZE);
+    }
+    memset(&io_ring, 0, sizeof(io_ring));
+    io_ring.ring_fd = -1;
+}
+
+/**
+ * @brief Creates the ring, maps it and registers the read windows
+ * 
+ * Registration failure (RLIMIT_MEMLOCK on kernels before 5.12) keeps the
+ * ring: reads then use READV requests on the same windows.
+ * 
+ * @return 1 if the ring is usable, 0 otherwise
+ */
+static int create_io_ring(void) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    io_ring.ring_fd = (int)syscall(__NR_io_uring_setup, IO_URING_QUEUE_DEPTH, &params);
+    if (io_ring.ring_fd < 0) {
+        LOGI("io_uring unavailable (%s), using synchronous I/O", strerror(errno));
+        return 0;
+    }
+    
+    io_ring.sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    io_ring.cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    io_ring.sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    
+    io_ring.sq_ring = mmap(NULL, io_ring.sq_ring_size, PROT_READ | PROT_WRITE,
+                           MAP_SHARED | MAP_POPULATE, io_ring.ring_fd, IORING_OFF_SQ_RING);
+    io_ring.cq_ring = mmap(NULL, io_ring.cq_ring_size, PROT_READ | PROT_WRITE,
+                           MAP_SHARED | MAP_POPULATE, io_ring.ring_fd, IORING_OFF_CQ_RING);
+    io_ring.sqes = mmap(NULL, io_ring.sqes_size, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, io_ring.ring_fd, IORING_OFF_SQES);
+    if (io_ring.sq_ring == MAP_FAILED) io_ring.sq_ring = NULL;
+    if (io_ring.cq_ring == MAP_FAILED) io_ring.cq_ring = NULL;
+    if (io_ring.sqes == MAP_FAILED) io_ring.sqes = NULL;
+    if (!io_ring.sq_ring || !io_ring.cq_ring || !io_ring.sqes) {
+        LOGW("Failed to map io_uring rings: %s", strerror(errno));
+        return 0;
+    }
+    
+    char* sq_base = io_ring.sq_ring;
+    char* cq_base = io_ring.cq_ring;
+    io_ring.sq_head = (unsigned*)(sq_base + params.sq_off.head);
+    io_ring.sq_tail = (unsigned*)(sq_base + params.sq_off.tail);
+    io_ring.sq_mask = (unsigned*)(sq_base + params.sq_off.ring_mask);
+    io_ring.sq_array = (unsigned*)(sq_base + params.sq_off.array);
+    io_ring.cq_head = (unsigned*)(cq_base + params.cq_off.head);
+    io_ring.cq_tail = (unsigned*)(cq_base + params.cq_off.tail);
+    io_ring.cq_mask = (unsigned*)(cq_base + params.cq_off.ring_mask);
+    io_ring.cqes = (struct io_uring_cqe*)(cq_base + params.cq_off.cqes);
+    
+    // Read windows are tracked so file contents never look like process memory to the scanner
+    io_ring.read_buffers = allocate_tracked_buffer((size_t)IO_URING_READ_BUFFERS * FILE_READ_WINDOW_SIZE);
+    if (!io_ring.read_buffers) return 0;
+    
+    struct iovec buffer_vectors[IO_URING_READ_BUFFERS];
+    for (int i = 0; i < IO_URING_READ_BUFFERS; i++) {
+        buffer_vectors[i].iov_base = io_ring.read_buffers + (size_t)i * FILE_READ_WINDOW_SIZE;
+        buffer_vectors[i].iov_len = FILE_READ_WINDOW_SIZE;
+    }
+    io_ring.buffers_registered = syscall(__NR_io_uring_register, io_ring.ring_fd, IORING_REGISTER_BUFFERS,
+                                         buffer_vectors, IO_URING_READ_BUFFERS) == 0;
+    if (!io_ring.buffers_registered) {
+        VLOGD("io_uring buffer registration failed (%s), using unregistered reads", strerror(errno));
+    }
+    
+    LOGI("io_uring engine ready: %u entries, %d %s read windows of %d bytes",
+         params.sq_entries, IO_URING_READ_BUFFERS,
+         io_ring.buffers_registered ? "registered" : "unregistered", FILE_READ_WINDOW_SIZE);
+    return 1;
+}
+
+/**
+ * @brief Sets up the ring on first use, guarding against seccomp traps
+ * 
+ * Android app sandboxes may answer io_uring system calls with SIGSYS
+ * instead of an error. SIGSYS is caught only for the duration of the
+ * probe and the previous disposition is restored afterwards.
+ * 
+ * Must be called with io_engine_mutex held.
+ */
+static void probe_io_engine(void) {
+    if (!should_enable_io_uring()) {
+        __atomic_store_n(&io_engine_state, IO_ENGINE_UNAVAILABLE, __ATOMIC_RELEASE);
+        return;
+    }
+    
+    struct sigaction probe_action, previous_action;
+    memset(&probe_action, 0, sizeof(probe_action));
+    probe_action.sa_handler = seccomp_probe_signal_handler;
+    sigemptyset(&probe_action.sa_mask);
+    sigaction(SIGSYS, &probe_action, &previous_action);
+    
+    volatile int ring_ready = 0;
+    if (sigsetjmp(seccomp_probe_recovery, 1) == 0) {
+        ring_ready = create_io_ring();
+    } else {
+        LOGI("io_uring blocked by seccomp, using synchronous I/O");
+    }
+    sigaction(SIGSYS, &previous_action, NULL);
+    
+    if (!ring_ready) destroy_io_ring();
+    __atomic_store_n(&io_engine_state, ring_ready ? IO_ENGINE_READY : IO_ENGINE_UNAVAILABLE, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Takes the ring for one operation
+ * 
+ * A ring already in use by another thread is not waited for, the caller
+ * takes the synchronous path instead.
+ * 
+ * @return 1 with io_engine_mutex held if the ring can be used, 0 otherwise
+ */
+static int acquire_io_ring(void) {
+    if (__atomic_load_n(&io_engine_state, __ATOMIC_ACQUIRE) == IO_ENGINE_UNAVAILABLE) return 0;
+    if (pthread_mutex_trylock(&io_engine_mutex) != 0) {
+        SCAN_STAT_ADD(io_sync_fallbacks, 1);
+        return 0;
+    }
+    
+    if (io_engine_state == IO_ENGINE_UNPROBED) probe_io_engine();
+    if (io_engine_state != IO_ENGINE_READY) {
+        pthread_mutex_unlock(&io_engine_mutex);
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief Gives up on io_uring after the ring itself failed
+ * 
+ * Must be called with io_engine_mutex held.
+ */
+static void disable_io_engine(int error_number) {
+    LOGW("io_uring request failed (%s), switching to synchronous I/O", strerror(error_number));
+    destroy_io_ring();
+    __atomic_store_n(&io_engine_state, IO_ENGINE_UNAVAILABLE, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Returns the next free submission queue entry, cleared
+ */
+static struct io_uring_sqe* get_submission_entry(unsigned queued_entries) {
+    unsigned tail = *io_ring.sq_tail + queued_entries;
+    unsigned index = tail & *io_ring.sq_mask;
+    struct io_uring_sqe* sqe = &io_ring.sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    io_ring.sq_array[index] = index;
+    return sqe;
+}
+
+/**
+ * @brief Submits queued entries and collects all their completions
+ * 
+ * Results are stored by the user_data index of each request.
+ * 
+ * @param entry_count Number of entries queued with get_submission_entry()
+ * @param results Output: result of request i at results[i]
+ * @return 1 if every request completed, 0 if the ring failed
+ */
+static int submit_and_wait(unsigned entry_count, int* results) {
+    __atomic_store_n(io_ring.sq_tail, *io_ring.sq_tail + entry_count, __ATOMIC_RELEASE);
+    
+    unsigned submitted = 0;
+    unsigned completed = 0;
+    while (completed < entry_count) {
+        unsigned to_submit = entry_count - submitted;
+        long result = syscall(__NR_io_uring_enter, io_ring.ring_fd, to_submit, 1,
+                              IORING_ENTER_GETEVENTS, NULL, 0);
+        if (result < 0) {
+            if (errno == EINTR) continue;
+            disable_io_engine(errno);
+            return 0;
+        }
+        submitted += (unsigned)result;
+        
+        unsigned head = *io_ring.cq_head;
+        unsigned tail = __atomic_load_n(io_ring.cq_tail, __ATOMIC_ACQUIRE);
+        for (; head != tail; head++) {
+            struct io_uring_cqe* cqe = &io_ring.cqes[head & *io_ring.cq_mask];
+            if (cqe->user_data < entry_count) results[cqe->user_data] = cqe->res;
+            completed++;
+        }
+        __atomic_store_n(io_ring.cq_head, head, __ATOMIC_RELEASE);
+    }
+    
+    SCAN_STAT_ADD(io_uring_submissions, entry_count);
+    return 1;
+}
+
+/**
+ * @brief Reads a file window by window with pread(), the synchronous path
+ */
+static long long stream_file_synchronously(int file_descriptor, off_t file_offset, uint8_t* window,
+                                           size_t window_size, IoChunkHandler chunk_handler,
+                                           void* handler_context) {
+    long long bytes_streamed = 0;
+    for (;;) {
+        ssize_t bytes_read = pread(file_descriptor, window, window_size, file_offset);
+        if (bytes_read < 0 && errno == EINTR) continue;
+        if (bytes_read <= 0) break;
+        
+        bytes_streamed += bytes_read;
+        file_offset += bytes_read;
+        if (!chunk_handler(window, (size_t)bytes_read, handler_context)) break;
+    }
+    return bytes_streamed;
+}
+
+/**
+ * @brief Streams a whole file through a handler, batching reads on io_uring when available
+ * 
+ * On io_uring, IO_URING_READ_BUFFERS consecutive windows are requested
+ * per submission and handed to the handler in file order; a short read
+ * marks the end of the file. A failed request continues the stream from
+ * its offset on the synchronous path, which reads into fallback_window.
+ * 
+ * @param file_descriptor File open for reading, read from offset 0
+ * @param fallback_window Caller buffer for synchronous reads
+ * @param window_size Size of fallback_window
+ * @param chunk_handler Receives each chunk, returns 0 to stop
+ * @param handler_context Passed to chunk_handler
+ * @return Number of bytes handed to the handler
+ */
+long long io_engine_stream_file(int file_descriptor, uint8_t* fallback_window, size_t window_size,
+                                IoChunkHandler chunk_handler, void* handler_context) {
+    if (!acquire_io_ring()) {
+        return stream_file_synchronously(file_descriptor, 0, fallback_window, window_size,
+                                         chunk_handler, handler_context);
+    }
+    
+    long long bytes_streamed = 0;
+    off_t file_offset = 0;
+    int stream_active = 1;
+    int request_failed = 0;
+    struct iovec read_vectors[IO_URING_READ_BUFFERS];
+    int results[IO_URING_READ_BUFFERS];
+    
+    while (stream_active && !request_failed) {
+        for (unsigned i = 0; i < IO_URING_READ_BUFFERS; i++) {
+            struct io_uring_sqe* sqe = get_submission_entry(i);
+            uint8_t* window = io_ring.read_buffers + (size_t)i * FILE_READ_WINDOW_SIZE;
+            sqe->fd = file_descriptor;
+            sqe->off = (uint64_t)file_offset + (uint64_t)i * FILE_READ_WINDOW_SIZE;
+            sqe->user_data = i;
+            if (io_ring.buffers_registered) {
+                sqe->opcode = IORING_OP_READ_FIXED;
+                sqe->addr = (uint64_t)(uintptr_t)window;
+                sqe->len = FILE_READ_WINDOW_SIZE;
+                sqe->buf_index = (uint16_t)i;
+            } else {
+                read_vectors[i].iov_base = window;
+                read_vectors[i].iov_len = FILE_READ_WINDOW_SIZE;
+                sqe->opcode = IORING_OP_READV;
+                sqe->addr = (uint64_t)(uintptr_t)&read_vectors[i];
+                sqe->len = 1;
+            }
+        }
+        if (!submit_and_wait(IO_URING_READ_BUFFERS, results)) {
+            request_failed = 1;
+            break;
+        }
+        
+        // Hand the windows over in file order until the end of the file
+        for (unsigned i = 0; i < IO_URING_READ_BUFFERS && stream_active; i++) {
+            if (results[i] < 0) {
+                request_failed = 1;
+                break;
+            }
+            const uint8_t* window = io_ring.read_buffers + (size_t)i * FILE_READ_WINDOW_SIZE;
+            if (results[i] > 0) {
+                bytes_streamed += results[i];
+                file_offset += results[i];
+                SCAN_STAT_ADD(io_uring_bytes, (unsigned long)results[i]);
+                if (!chunk_handler(window, (size_t)results[i], handler_context)) stream_active = 0;
+            }
+            if (results[i] < FILE_READ_WINDOW_SIZE) stream_active = 0;
+        }
+    }
+    pthread_mutex_unlock(&io_engine_mutex);
+    
+    if (request_failed) {
+        SCAN_STAT_ADD(io_sync_fallbacks, 1);
+        bytes_streamed += stream_file_synchronously(file_descriptor, file_offset, fallback_window,
+                                                    window_size, chunk_handler, handler_context);
+    }
+    return bytes_streamed;
+}
+
+/**
+ * @brief Writes a byte range completely, the synchronous path
+ * 
+ * Descriptors opened with O_APPEND are written with write(), in order and
+ * at the end of the file; others with pwrite() at the given offset.
+ */
+static int write_synchronously(int file_descriptor, const char* data, size_t data_size, off_t file_offset,
+                               int append) {
+    size_t bytes_written = 0;
+    while (bytes_written < data_size) {
+        ssize_t result = append ?
+                         write(file_descriptor, data + bytes_written, data_size - bytes_written) :
+                         pwrite(file_descriptor, data + bytes_written, data_size - bytes_written,
+                                file_offset + (off_t)bytes_written);
+        if (result < 0 && errno == EINTR) continue;
+        if (result <= 0) return 0;
+        bytes_written += (size_t)result;
+    }
+    return 1;
+}
+
+/**
+ * @brief Writes a buffer completely at an offset, queuing chunks on io_uring when available
+ * 
+ * Up to IO_URING_QUEUE_DEPTH chunks of IO_URING_WRITE_CHUNK_SIZE bytes are
+ * queued per submission straight from the caller's buffer. A chunk the
+ * kernel wrote only partly, or that failed, is finished with pwrite().
+ * Queued chunks complete in any order, so a descriptor opened with
+ * O_APPEND never goes through the ring: its data is appended with
+ * write() in sequence and the offset is ignored.
+ * 
+ * @param file_descriptor File open for writing
+ * @param data Bytes to write
+ * @param data_size Number of bytes to write
+ * @param file_offset Offset of the first byte in the file
+ * @return 1 if every byte was written, 0 on failure (errno is set)
+ */
+int io_engine_write_all(int file_descriptor, const void* data, size_t data_size, off_t file_offset) {
+    const char* source = data;
+    if (data_size == 0) return 1;
+    int status_flags = fcntl(file_descriptor, F_GETFL);
+    int append = status_flags >= 0 && (status_flags & O_APPEND);
+    if (append || !acquire_io_ring()) {
+        return write_synchronously(file_descriptor, source, data_size, file_offset, append);
+    }
+    
+    struct iovec write_vectors[IO_URING_QUEUE_DEPTH];
+    int results[IO_URING_QUEUE_DEPTH];
+    size_t queued_offset = 0;
+    int write_ok = 1;
+    int ring_failed = 0;
+    
+    while (queued_offset < data_size && write_ok) {
+        unsigned chunk_count = 0;
+        size_t batch_start = queued_offset;
+        while (chunk_count < IO_URING_QUEUE_DEPTH && queued_offset < data_size) {
+            size_t chunk_size = data_size - queued_offset < IO_URING_WRITE_CHUNK_SIZE ?
+                                data_size - queued_offset : IO_URING_WRITE_CHUNK_SIZE;
+            write_vectors[chunk_count].iov_base = (void*)(source + queued_offset);
+            write_vectors[chunk_count].iov_len = chunk_size;
+            
+            struct io_uring_sqe* sqe = get_submission_entry(chunk_count);
+            sqe->opcode = IORING_OP_WRITEV;
+            sqe->fd = file_descriptor;
+            sqe->off = (uint64_t)file_offset + queued_offset;
+            sqe->addr = (uint64_t)(uintptr_t)&write_vectors[chunk_count];
+            sqe->len = 1;
+            sqe->user_data = chunk_count;
+            
+            queued_offset += chunk_size;
+            chunk_count++;
+        }
+        if (!submit_and_wait(chunk_count, results)) {
+            // The ring is gone, redo this batch synchronously
+            ring_failed = 1;
+            queued_offset = batch_start;
+            break;
+        }
+        
+        // Finish short or failed chunks in place
+        for (unsigned i = 0; i < chunk_count && write_ok; i++) {
+            size_t chunk_size = write_vectors[i].iov_len;
+            size_t chunk_done = results[i] > 0 ? (size_t)results[i] : 0;
+            if (results[i] > 0) SCAN_STAT_ADD(io_uring_bytes, (unsigned long)results[i]);
+            if (chunk_done < chunk_size) {
+                SCAN_STAT_ADD(io_sync_fallbacks, 1);
+                size_t chunk_offset = (size_t)((const char*)write_vectors[i].iov_base - source);
+                write_ok = write_synchronously(file_descriptor, source + chunk_offset + chunk_done,
+                                               chunk_size - chunk_done,
+                                               file_offset + (off_t)(chunk_offset + chunk_done), 0);
+            }
+        }
+    }
+    pthread_mutex_unlock(&io_engine_mutex);
+    
+    if (ring_failed) {
+        SCAN_STAT_ADD(io_sync_fallbacks, 1);
+        write_ok = write_synchronously(file_descriptor, source + queued_offset, data_size - queued_offset,
+                                       file_offset + (off_t)queued_offset, 0);
+    }
+    return write_ok;
+}
@@ -0,0 +1,36 @@
+#ifndef DEXDUMPER_IO_ENGINE_H
+#define DEXDUMPER_IO_ENGINE_H
+
+// I/O engine header - declares io_uring backed file reads and writes with a synchronous fallback
+
+#include "common.h"
+#include "config.h"
+
+/**
+ * Asynchronous I/O Support:
+ * 
+ * Hashing earlier dumps for duplicate detection and writing new dumps
+ * move tens of megabytes through one read() or write() per window. When
+ * the kernel offers io_uring, a single ring is set up on first use with
+ * IO_URING_READ_BUFFERS read windows registered as fixed buffers: a file
+ * is read with a batch of READ_FIXED requests per io_uring_enter() call
+ * and each window is handed to the caller in file order. Writes of dumps
+ * are queued as a batch of chunk-sized requests; appends (manifest
+ * records) are written in sequence without the ring.
+ * Kernels without io_uring, devices that disable it and app sandboxes
+ * whose seccomp policy traps it (SIGSYS, caught while probing) keep the
+ * plain pread()/pwrite() path, which is also taken whenever the ring is
+ * busy or a request fails.
+ */
+
+// Receives file contents in order, returns 0 to stop streaming
+typedef int (*IoChunkHandler)(const uint8_t* chunk, size_t chunk_size, void* handler_context);
+
+// Streams a whole file through a handler, batching reads on io_uring when available
+long long io_engine_stream_file(int file_descriptor, uint8_t* fallback_window, size_t window_size,
+                                IoChunkHandler chunk_handler, void* handler_context);
+
+// Writes a buffer completely at an offset, queuing chunks on io_uring when available
+int io_engine_write_all(int file_descriptor, const void* data, size_t data_size, off_t file_offset);
+
+#endif
@@ -7,32 +7,76 @@
 #include "dex_detector.h"
 #include "stealth.h"
 #include "config_manager.h"
+#include "scan_statistics.h"
+#include "self_exclusion.h"
+#include "plugin_loader.h"
+#include "payload_inflater.h"
+#include "expansion_engine.h"
+#include "dump_manifest.h"
+#include "entropy_sampler.h"
+#include "elf_detector.h"
+#include "art_heap_walker.h"
+#include "pointer_discovery.h"
+#include "protected_region_reader.h"
+#include "footprint_tracker.h"
+#include "region_table.h"
+#include "scan_arena.h"
+#include "calibration.h"
+#include "control_channel.h"
+#include "shared_dedup_table.h"
+#include "xor_key_recovery.h"
 
 // Global verbosity control - set to 1 for verbose debugging output
 int verbose_logging = 0;
 
 /**
- * @brief Scans a single memory region and dumps any found DEX files
+ * @brief Walks an ART heap space and dumps every DEX byte[] array in it
  * 
- * This function handles the complete process for one memory region:
- * - Checks if region should be scanned
- * - Performs DEX detection
- * - Creates safe memory copy
- * - Dumps to file if DEX found
+ * @param output_directory Directory to save dumped files
+ * @param memory_region Heap space region
+ * @param data_region Where the region's bytes are read (memory_region itself, or a copy of it)
+ * @param region_index Index of region for logging and filenames
+ * @param space_kind Kind of heap space the region maps
+ * @return 1 if at least one DEX was dumped, 0 otherwise
+ */
+static int walk_and_dump_heap_region(const char* output_directory,
+                                     const MemoryRegion* memory_region, const MemoryRegion* data_region,
+                                     int region_index, ArtHeapSpaceKind space_kind) {
+    DexDetectionResult heap_arrays[ART_HEAP_MAX_PAYLOADS_PER_REGION];
+    int array_count = walk_art_heap_region(data_region, space_kind, heap_arrays,
+                                           ART_HEAP_MAX_PAYLOADS_PER_REGION);
+    
+    int dump_successful = 0;
+    for (int i = 0; i < array_count; i++) {
+        if (expand_and_dump_payload(output_directory, memory_region, region_index, &heap_arrays[i])) {
+            dump_successful = 1;
+        }
+    }
+    return dump_successful;
+}
+
+/**
+ * @brief Scans the contents of an approved region and dumps any found DEX files
+ * 
+ * - Walks the byte[] arrays of ART heap spaces
+ * - Routes the region by sampled entropy (skip, decode stages, full scan)
+ * - Performs DEX detection, resuming after each payload found
+ * - Expands every payload (copy, inflate, unpack containers)
+ * - Dumps every DEX and native library found
+ * 
+ * The region's identity (path, quarantine, dump names) always comes
+ * from memory_region; its bytes are read from data_region, which is a
+ * private copy for regions that cannot be read in place.
  * 
  * @param output_directory Directory to save dumped files
  * @param memory_region Memory region to scan
+ * @param data_region Where the region's bytes are read (memory_region itself, or a copy of it)
  * @param region_index Index of region for logging and filenames
  * @return 1 if DEX was dumped, 0 otherwise
  */
-static int scan_and_dump_region(const char* output_directory, 
-                               const MemoryRegion* memory_region, 
-                               int region_index) {
-    // Apply region filtering rules
-    if (!should_scan_memory_region(memory_region)) {
-        return 0;
-    }
-    
+static int scan_region_contents(const char* output_directory, 
+                                const MemoryRegion* memory_region, const MemoryRegion* data_region,
+                                int region_index) {
     size_t region_size = (char*)memory_region->end_address - (char*)memory_region->start_address;
     
     // Check if this is a high-priority region for scanning
@@ -49,92 +93,381 @@ static int scan_and_dump_region(const char* output_directory,
              region_size, memory_region->path_name);
     }
     
+    // ART heap spaces: only byte[] arrays can hold a DEX, walk those first
+    ArtHeapSpaceKind heap_space_kind = should_enable_art_heap_walk() ?
+                                       classify_art_heap_region(memory_region) : ART_HEAP_SPACE_NONE;
+    if (heap_space_kind != ART_HEAP_SPACE_NONE) {
+        if (walk_and_dump_heap_region(output_directory, memory_region, data_region, region_index,
+                                      heap_space_kind)) {
+            return 1;
+        }
+        // Spaces too large for the regular scan are done after the walk
+        if (region_size > MAX_REGION_SIZE) {
+            return 0;
+        }
+    }
+    
     int dump_successful = 0;
     
-    // Perform DEX detection on this region
-    DexDetectionResult detection_result = {0};
-    if (perform_comprehensive_dex_detection(memory_region->start_address, region_size, 
-                                           &detection_result)) {
-        // Create safe copy of detected DEX file
-        void* safe_memory_copy = create_memory_copy(detection_result.dex_address, 
-                                                   detection_result.dex_size);
-        if (safe_memory_copy) {
-            // Dump the copied memory to file
-            if (dump_memory_to_file(output_directory, memory_region, region_index, 
-                                   safe_memory_copy, detection_result.dex_size)) {
-                dump_successful = 1;
-                LOGI("Successfully dumped DEX from region %d", region_index);
-            }
-            free(safe_memory_copy); // Always free the copy
-        } else {
-            LOGW("Failed to create memory copy for region %d", region_index);
+    // Sample the region first: zero-filled memory holds nothing to dump
+    RegionEntropyProfile entropy_profile;
+    build_region_entropy_profile(data_region, &entropy_profile);
+    if (entropy_profile.content_class == REGION_CONTENT_EMPTY) {
+        SCAN_STAT_ADD(entropy_empty_skips, 1);
+        VLOGD("Skipping all-zero region %d", region_index);
+        return 0;
+    }
+    
+    // Perform DEX detection on this region under a fresh scan budget
+    SCAN_STAT_ADD(regions_scanned, 1);
+    if (entropy_profile.content_class == REGION_CONTENT_HIGH_ENTROPY) {
+        // Compressed or encrypted data: enable the decode stages, plain payloads beside it are still found
+        SCAN_STAT_ADD(entropy_decode_enabled, 1);
+        begin_region_scan_budget(1);
+    } else {
+        begin_region_scan_budget(is_high_priority);
+    }
+    get_current_region_budget()->file_backed = is_file_backed_region(memory_region);
+    
+    // The scan resumes after each payload so a DEX does not hide a native library behind it or the reverse
+    MemoryRegion dump_region = *memory_region;
+    size_t scan_window = region_size > DEFAULT_SCAN_LIMIT ? DEFAULT_SCAN_LIMIT : region_size;
+    size_t scan_offset = 0;
+    for (int payload_count = 0; scan_offset < scan_window && payload_count < MAX_PAYLOADS_PER_REGION;
+         payload_count++) {
+        DexDetectionResult detection_result = {0};
+        if (!perform_comprehensive_dex_detection((char*)data_region->start_address + scan_offset,
+                                                 region_size - scan_offset, &detection_result)) {
+            break;
         }
+        
+        // Copy or inflate the payload and dump every DEX nested inside it; expansion scans
+        // under budgets of its own, the region's is restored for the rest of the region
+        RegionScanBudget region_budget = *get_current_region_budget();
+        if (expand_and_dump_payload(output_directory, &dump_region, region_index, &detection_result)) {
+            dump_successful = 1;
+            // The inode is registered by the first dump, further payloads of the region still go out
+            dump_region.inode_number = 0;
+        }
+        *get_current_region_budget() = region_budget;
+        
+        // Compressed extents run to the end of the region, the inflater finds the real end
+        if (detection_result.dex_size == 0 ||
+            (detection_result.payload_encoding != PAYLOAD_ENCODING_PLAIN &&
+             detection_result.payload_encoding != PAYLOAD_ENCODING_ELF_MAPPED &&
+             detection_result.payload_key_length == 0)) {
+            break;
+        }
+        scan_offset = (size_t)((char*)detection_result.dex_address - (char*)data_region->start_address) +
+                      detection_result.dex_size;
+    }
+    
+    // Regions that blew their budget are not worth rescanning
+    if (region_scan_budget_exhausted()) {
+        quarantine_memory_region(memory_region);
+    }
+    
+    return dump_successful;
+}
+
+/**
+ * @brief Scans a region that is not quarantined, giving back the pages the scan pulled in
+ * 
+ * @param output_directory Directory to save dumped files
+ * @param memory_region Memory region to scan
+ * @param data_region Where the region's bytes are read (memory_region itself, or a copy of it)
+ * @param region_index Index of region for logging and filenames
+ * @return 1 if DEX was dumped, 0 otherwise
+ */
+static int scan_tracked_region(const char* output_directory, const MemoryRegion* memory_region,
+                               const MemoryRegion* data_region, int region_index) {
+    // Skip regions that exhausted their budget in an earlier pass
+    if (is_region_quarantined(memory_region)) {
+        SCAN_STAT_ADD(quarantine_skips, 1);
+        VLOGD("Skipping quarantined region %d: %p-%p", region_index, 
+              memory_region->start_address, memory_region->end_address);
+        return 0;
     }
     
+    ResidencySnapshot residency_snapshot;
+    capture_residency_snapshot(memory_region, &residency_snapshot);
+    int dump_successful = scan_region_contents(output_directory, memory_region, data_region, region_index);
+    release_scan_footprint(&residency_snapshot);
+    
     return dump_successful;
 }
 
+/**
+ * @brief Scans a single memory region and dumps any found DEX files
+ * 
+ * This function handles the complete process for one memory region:
+ * - Checks if region can be read
+ * - Records its page residency
+ * - Scans its contents and dumps what is found
+ * - Gives back the file pages the scan pulled in
+ * 
+ * @param output_directory Directory to save dumped files
+ * @param memory_region Memory region to scan
+ * @param region_index Index of region for logging and filenames
+ * @return 1 if DEX was dumped, 0 otherwise
+ */
+static int scan_and_dump_region(const char* output_directory, 
+                               const MemoryRegion* memory_region, 
+                               int region_index) {
+    // Filtering rules were applied by select_table_regions(), only access is left to test
+    if (!test_region_read_access(memory_region)) {
+        VLOGD("Skipping unreadable memory region: %p-%p %s", 
+              memory_region->start_address, memory_region->end_address, 
+              memory_region->path_name);
+        return 0;
+    }
+    
+    return scan_tracked_region(output_directory, memory_region, memory_region, region_index);
+}
+
+/**
+ * @brief Copies a non-readable region through /proc/self/mem and scans the copy
+ * 
+ * The copy keeps the region's offsets and is only the data source of the
+ * regular pipeline: quarantine, the footprint snapshot and dump names
+ * still refer to the region itself.
+ * 
+ * @param output_directory Directory to save dumped files
+ * @param memory_region Non-readable region
+ * @param region_index Index of region for logging and filenames
+ * @return 1 if DEX was dumped, 0 otherwise
+ */
+static int scan_and_dump_protected_region(const char* output_directory,
+                                          const MemoryRegion* memory_region, int region_index) {
+    void* region_copy = NULL;
+    size_t copy_size = 0;
+    if (!copy_protected_region(memory_region, &region_copy, &copy_size)) {
+        return 0;
+    }
+    
+    MemoryRegion copy_region = *memory_region;
+    copy_region.start_address = region_copy;
+    copy_region.end_address = (char*)region_copy + copy_size;
+    copy_region.permissions[0] = 'r';
+    int dump_successful = scan_tracked_region(output_directory, memory_region, &copy_region, region_index);
+    
+    release_protected_region_copy(region_copy, copy_size);
+    return dump_successful;
+}
+
+/**
+ * @brief Follows (pointer, length) pairs in native memory and dumps the DEX files found
+ * 
+ * @param output_directory Directory to save dumped files
+ * @param region_table Regions of the current pass
+ * @return Number of DEX files dumped
+ */
+static int dump_pointed_dex_files(const char* output_directory, const RegionTable* region_table) {
+    PointedDexFile pointed_files[MAX_POINTED_DEX_PER_PASS];
+    int found_count = discover_pointed_dex_files(region_table, pointed_files, MAX_POINTED_DEX_PER_PASS);
+    
+    int dumped_count = 0;
+    for (int i = 0; i < found_count; i++) {
+        int region_index = pointed_files[i].region_index;
+        MemoryRegion memory_region;
+        get_table_region(region_table, region_index, &memory_region);
+        if (expand_and_dump_payload(output_directory, &memory_region, region_index,
+                                    &pointed_files[i].detection)) {
+            dumped_count++;
+        }
+    }
+    return dumped_count;
+}
+
+// Bounds of the regions the previous pass saw, ascending, for incremental scans
+static uintptr_t* previous_region_starts = NULL;
+static uintptr_t* previous_region_ends = NULL;
+static int previous_region_count = 0;
+
+// Pass run at startup and for a plain "scan" command
+static const ScanRequest full_scan_request = { SCAN_MODE_FULL, 0, 0 };
+
+/**
+ * @brief Checks whether the previous pass saw a region with exactly these bounds
+ */
+static int was_region_seen_before(uintptr_t region_start, uintptr_t region_end) {
+    int low = 0, high = previous_region_count - 1;
+    while (low <= high) {
+        int middle = low + (high - low) / 2;
+        if (previous_region_starts[middle] == region_start) return previous_region_ends[middle] == region_end;
+        if (previous_region_starts[middle] < region_start) low = middle + 1;
+        else high = middle - 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Keeps the bounds of this pass's regions for the next incremental scan
+ * 
+ * Called after full and incremental passes only, which cover every region.
+ */
+static void remember_region_bounds(const RegionTable* region_table) {
+    size_t array_size = (size_t)(region_table->region_count + 1) * sizeof(uintptr_t);
+    uintptr_t* region_starts = realloc(previous_region_starts, array_size);
+    if (region_starts) previous_region_starts = region_starts;
+    uintptr_t* region_ends = realloc(previous_region_ends, array_size);
+    if (region_ends) previous_region_ends = region_ends;
+    if (!region_starts || !region_ends) {
+        previous_region_count = 0;
+        return;
+    }
+    
+    memcpy(previous_region_starts, region_table->start_addresses, array_size - sizeof(uintptr_t));
+    memcpy(previous_region_ends, region_table->end_addresses, array_size - sizeof(uintptr_t));
+    previous_region_count = region_table->region_count;
+}
+
+/**
+ * @brief Builds the MemoryRegion of a selected region if the scan request covers it
+ * 
+ * Waits first while the control channel has scanning paused.
+ * 
+ * @param region_table Regions of the current pass
+ * @param region_index Region to check
+ * @param scan_request What the pass covers
+ * @param memory_region Output region, clipped to the page-aligned range of a range scan
+ * @return 1 if the region is to be scanned, 0 otherwise
+ */
+static int prepare_requested_region(const RegionTable* region_table, int region_index,
+                                    const ScanRequest* scan_request, MemoryRegion* memory_region) {
+    wait_while_scanning_paused();
+    
+    uintptr_t region_start = region_table->start_addresses[region_index];
+    uintptr_t region_end = region_table->end_addresses[region_index];
+    if (scan_request->scan_mode == SCAN_MODE_INCREMENTAL && was_region_seen_before(region_start, region_end)) {
+        return 0;
+    }
+    
+    // Requested addresses need not be aligned, the scan works on whole pages
+    uintptr_t page_mask = (uintptr_t)sysconf(_SC_PAGESIZE) - 1;
+    uintptr_t range_start = scan_request->range_start & ~page_mask;
+    uintptr_t range_end = scan_request->range_end > UINTPTR_MAX - page_mask ?
+                          UINTPTR_MAX & ~page_mask : (scan_request->range_end + page_mask) & ~page_mask;
+    if (scan_request->scan_mode == SCAN_MODE_RANGE && (region_end <= range_start || region_start >= range_end)) {
+        return 0;
+    }
+    
+    get_table_region(region_table, region_index, memory_region);
+    if (scan_request->scan_mode == SCAN_MODE_RANGE) {
+        if (region_start < range_start) memory_region->start_address = (void*)range_start;
+        if (region_end > range_end) memory_region->end_address = (void*)range_end;
+    }
+    return 1;
+}
+
 /**
  * @brief Executes the complete memory dumping process
  * 
  * This is the main dumping logic that:
  * - Parses all memory regions
- * - Scans high-priority regions first
+ * - Scans high-priority regions first (non-readable ones through /proc/self/mem)
+ * - Follows (pointer, length) pairs to DEX files
  * - Falls back to all regions if no DEX found
  * - Manages the overall scanning strategy
  * 
+ * Scans requested through the control channel may cover only regions
+ * new since the previous pass or a single address range; the pointer
+ * pass is skipped for range scans.
+ * 
  * @param output_directory Directory where dumped files will be saved
+ * @param scan_request What the pass covers
  */
-static void execute_memory_dumping(const char* output_directory) {
-    MemoryRegion* memory_regions = NULL;
+static void execute_memory_dumping(const char* output_directory, const ScanRequest* scan_request) {
+    RegionTable region_table;
+    
+    // Everything the pass allocates for itself comes from the pass arena
+    begin_scan_arena();
     
     // Parse process memory map to get all regions
-    int region_count = parse_memory_regions(&memory_regions);
+    int region_count = build_region_table(&region_table);
     
     if (region_count == 0) {
         LOGE("No memory regions found for scanning");
+        end_scan_arena();
         return;
     }
     
+    // Never scan buffers the dumper allocated itself
+    region_count = subtract_self_owned_ranges(&region_table);
+    
     LOGI("Initiating memory dump for %d regions (Filtering: %d)", 
          region_count, ENABLE_REGION_FILTERING);
     
     int total_dumps_successful = 0;
     int processed_region_count = 0;
+    reset_scan_statistics();
+    reset_inflate_budget();
+    reset_key_screening_budget();
+    
+    int* selected_regions = scan_arena_alloc((size_t)region_count * sizeof(int));
+    if (!selected_regions) {
+        LOGE("Memory allocation failed for region selection");
+        end_scan_arena();
+        return;
+    }
+    MemoryRegion memory_region;
     
     // First pass: Scan only high-priority regions
-    for (int i = 0; i < region_count; i++) {
-        if (is_potential_dex_region(&memory_regions[i]) && 
-            should_scan_memory_region(&memory_regions[i])) {
-            if (scan_and_dump_region(output_directory, &memory_regions[i], i)) {
-                total_dumps_successful++;
-            }
-            processed_region_count++;
+    int selected_count = select_table_regions(&region_table, REGION_SELECT_PRIORITY, selected_regions);
+    for (int i = 0; i < selected_count; i++) {
+        if (!prepare_requested_region(&region_table, selected_regions[i], scan_request, &memory_region)) continue;
+        if (scan_and_dump_region(output_directory, &memory_region, selected_regions[i])) {
+            total_dumps_successful++;
         }
+        processed_region_count++;
+    }
+    
+    // Non-readable high-priority regions: read through /proc/self/mem instead
+    selected_count = select_table_regions(&region_table, REGION_SELECT_PROTECTED, selected_regions);
+    for (int i = 0; i < selected_count; i++) {
+        if (!prepare_requested_region(&region_table, selected_regions[i], scan_request, &memory_region)) continue;
+        if (scan_and_dump_protected_region(output_directory, &memory_region, selected_regions[i])) {
+            total_dumps_successful++;
+        }
+        processed_region_count++;
+    }
+    
+    // Pointer pass: DEX files referenced from native memory, wherever they lie
+    if (should_enable_pointer_discovery() && scan_request->scan_mode != SCAN_MODE_RANGE) {
+        total_dumps_successful += dump_pointed_dex_files(output_directory, &region_table);
     }
     
     // Second pass: If no DEX found in priority regions, scan everything
     if (total_dumps_successful == 0) {
         LOGI("No DEX files found in priority regions, scanning all regions");
-        for (int i = 0; i < region_count; i++) {
-            if (!is_potential_dex_region(&memory_regions[i]) && 
-                should_scan_memory_region(&memory_regions[i])) {
-                if (scan_and_dump_region(output_directory, &memory_regions[i], i)) {
-                    total_dumps_successful++;
-                }
-                processed_region_count++;
+        selected_count = select_table_regions(&region_table, REGION_SELECT_REMAINING, selected_regions);
+        for (int i = 0; i < selected_count; i++) {
+            if (!prepare_requested_region(&region_table, selected_regions[i], scan_request, &memory_region)) continue;
+            if (scan_and_dump_region(output_directory, &memory_region, selected_regions[i])) {
+                total_dumps_successful++;
             }
+            processed_region_count++;
         }
     }
     
     // Log final statistics
     LOGI("Dumping process completed: Processed %d regions, dumped %d DEX files", 
          processed_region_count, total_dumps_successful);
+    log_scan_statistics();
     
-    // Clean up memory regions array
-    if (memory_regions) {
-        free(memory_regions);
+    // A range scan covered only part of the regions, the next incremental scan still needs the others
+    if (scan_request->scan_mode != SCAN_MODE_RANGE) {
+        remember_region_bounds(&region_table);
     }
+    
+    // Release the region table and everything else allocated for the pass
+    end_scan_arena();
+    
+    // Drop buffers cached for reuse during this pass
+    release_cached_tracked_buffers();
+    
+    // Configuration snapshots replaced during the pass are no longer read
+    release_retired_config_snapshots();
 }
 
 /**
@@ -150,9 +483,23 @@ static void* dumping_thread_function(void* thread_argument) {
     // Initialize configuration system (loads runtime config if available)
     init_config_manager();
     
+    // Pick up edits of the configuration file without a restart, if enabled
+    start_config_watcher();
+    
     // Initialize random seed for stealth techniques
     srand((unsigned)(time(NULL) ^ getpid() ^ (uintptr_t)pthread_self()));
     
+    // Register built-in compressed payload detectors
+    register_compressed_payload_detectors();
+    
+    // Register native library detectors (anonymous memory only)
+    if (should_enable_elf_dumping()) {
+        register_elf_image_detectors();
+    }
+    
+    // Load detector plugins before any scan so their prefilters join the single pass
+    load_detector_plugins(get_detector_plugin_directory());
+    
     // Apply anti-detection techniques
     apply_stealth_techniques();
     
@@ -161,19 +508,36 @@ static void* dumping_thread_function(void* thread_argument) {
     LOGI("Initial delay: %d seconds", initial_delay);
     sleep(initial_delay);
     
+    // Pick the fastest memory reader, scan chunk size, kernels and hash threads for this device;
+    // benchmarking reads real regions, so it waits for the initial delay like the scans do
+    run_startup_calibration();
+    
     // Determine where to save dumped files
     char* output_directory = get_output_directory_path();
     
-    // Clean previous dumps to avoid accumulation
-    LOGI("Cleaning output directory before dump");
-    clean_output_directory(output_directory);
-    
     // Ensure output directory exists
     mkdir(output_directory, 0755);
     
+    // Share dumped checksums with the app's other processes
+    init_shared_dedup_table(output_directory);
+    
+    // Clean previous dumps to avoid accumulation, unless they belong to
+    // another process of the app that is still running
+    if (shared_dedup_table_has_peers()) {
+        LOGI("Other processes are dumping, keeping output directory and manifest");
+    } else {
+        LOGI("Cleaning output directory before dump");
+        clean_output_directory(output_directory);
+        init_dump_manifest(output_directory);
+    }
+    finish_shared_dedup_table_init();
+    
+    // Accept runtime commands (pause, stats, ...) from here on, if enabled
+    start_control_channel(output_directory);
+    
     // First scan
     LOGI("=== STARTING FIRST DEX DUMP OPERATION ===");
-    execute_memory_dumping(output_directory); // Execute main dumping process
+    execute_memory_dumping(output_directory, &full_scan_request); // Execute main dumping process
     
     // Configurable conditional second scan
     if (should_enable_second_scan()) {
@@ -183,11 +547,18 @@ static void* dumping_thread_function(void* thread_argument) {
         
         LOGI("=== STARTING SECOND DEX DUMP OPERATION ===");
         apply_stealth_techniques();  // Re-apply stealth for second scan
-        execute_memory_dumping(output_directory); // Re-apply dumping process
+        execute_memory_dumping(output_directory, &full_scan_request); // Re-apply dumping process
     } else {
         LOGI("Second scan disabled in configuration");
     }
     
+    // Serve scans requested through the control channel for the rest of the process
+    ScanRequest scan_request;
+    while (wait_for_scan_request(&scan_request)) {
+        LOGI("=== STARTING REQUESTED DEX DUMP OPERATION ===");
+        execute_memory_dumping(output_directory, &scan_request);
+    }
+    
     // Clean up global registry to free memory
     pthread_mutex_lock(&dump_registry_mutex);
     if (dumped_files_registry) {
@@ -1,6 +1,85 @@
 #include "memory_scanner.h"
 #include "file_utils.h"
 #include "config_manager.h"
+#include "scan_statistics.h"
+#include "self_exclusion.h"
+#include "art_heap_walker.h"
+
+// Regions that exhausted their scan budget and are skipped by later passes
+static struct {
+    void* start_address;
+    void* end_address;
+    ino_t inode_number;
+} quarantined_regions[MAX_QUARANTINED_REGIONS];
+static int quarantined_region_count = 0;
+static pthread_mutex_t quarantine_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief Quarantines a region so later scanning passes skip it
+ * 
+ * Regions are identified by address range and inode, so a mapping that
+ * is unmapped and replaced by different content is not affected.
+ * 
+ * @param memory_region Region that exceeded its fault or candidate budget
+ */
+void quarantine_memory_region(const MemoryRegion* memory_region) {
+    pthread_mutex_lock(&quarantine_mutex);
+    
+    if (quarantined_region_count < MAX_QUARANTINED_REGIONS) {
+        quarantined_regions[quarantined_region_count].start_address = memory_region->start_address;
+        quarantined_regions[quarantined_region_count].end_address = memory_region->end_address;
+        quarantined_regions[quarantined_region_count].inode_number = memory_region->inode_number;
+        quarantined_region_count++;
+        SCAN_STAT_ADD(regions_quarantined, 1);
+        LOGW("Quarantined region %p-%p %s", memory_region->start_address, 
+             memory_region->end_address, memory_region->path_name);
+    } else {
+        LOGW("Quarantine list full, region %p-%p not recorded", 
+             memory_region->start_address, memory_region->end_address);
+    }
+    
+    pthread_mutex_unlock(&quarantine_mutex);
+}
+
+/**
+ * @brief Checks whether a region was quarantined by an earlier pass
+ * 
+ * @param memory_region Region to look up
+ * @return 1 if quarantined, 0 otherwise
+ */
+int is_region_quarantined(const MemoryRegion* memory_region) {
+    int quarantined = 0;
+    pthread_mutex_lock(&quarantine_mutex);
+    
+    for (int i = 0; i < quarantined_region_count; i++) {
+        if (quarantined_regions[i].start_address == memory_region->start_address &&
+            quarantined_regions[i].end_address == memory_region->end_address &&
+            quarantined_regions[i].inode_number == memory_region->inode_number) {
+            quarantined = 1;
+            break;
+        }
+    }
+    
+    pthread_mutex_unlock(&quarantine_mutex);
+    return quarantined;
+}
+
+/**
+ * @brief Gets the largest size a region may have to be scanned
+ * 
+ * ART heap spaces are walked object by object rather than byte scanned,
+ * so they are accepted well beyond MAX_REGION_SIZE.
+ * 
+ * @param memory_region Region to check
+ * @return Size limit in bytes
+ */
+static size_t get_region_size_limit(const MemoryRegion* memory_region) {
+    if (should_enable_art_heap_walk() &&
+        classify_art_heap_region(memory_region) != ART_HEAP_SPACE_NONE) {
+        return ART_HEAP_MAX_REGION_SIZE;
+    }
+    return MAX_REGION_SIZE;
+}
 
 /**
  * @brief Tests if a memory region can be safely read
@@ -21,87 +100,67 @@ int test_region_read_access(const MemoryRegion* memory_region) {
     
     // Check region size constraints
     size_t region_size = (char*)memory_region->end_address - (char*)memory_region->start_address;
-    if (region_size < 16 || region_size > MAX_REGION_SIZE) {
+    if (region_size < 16 || region_size > get_region_size_limit(memory_region)) {
         return 0;
     }
     
+    // Prefault the first page: an unreadable region is reported through errno, not a signal
+    PrefaultResult prefault_result = prefault_memory_range(memory_region->start_address, 1);
+    if (prefault_result != PREFAULT_UNSUPPORTED) {
+        return prefault_result == PREFAULT_READABLE;
+    }
+    
     // Test read access by attempting to read first byte
     unsigned char test_byte;
     return read_memory_safely(memory_region->start_address, &test_byte, 1);
 }
 
 /**
- * @brief Parses /proc/self/maps to get memory region information
+ * @brief Checks a region against the system region exclusion patterns
  * 
- * Reads the process memory map to identify all memory regions with their
- * permissions, backing files, and other metadata.
+ * System libraries, framework files, hardware buffers and special
+ * regions are excluded unless their name points at DEX content or
+ * the current package.
  * 
- * @param regions_array Output parameter for allocated array of regions
- * @return Number of memory regions found, 0 on error
+ * @param memory_region Region to check
+ * @return 1 if the region is excluded, 0 otherwise
  */
-int parse_memory_regions(MemoryRegion** regions_array) {
-    // Open process memory maps file
-    FILE* maps_file = fopen("/proc/self/maps", "r");
-    if (!maps_file) {
-        LOGE("Failed to open process memory maps: %s", strerror(errno));
-        return 0;
-    }
-    
-    char map_line[1024];
-    int region_count = 0;
-    int regions_capacity = MAX_REGIONS_INITIAL_CAPACITY;
-    
-    // Allocate initial regions array
-    *regions_array = malloc(regions_capacity * sizeof(MemoryRegion));
-    if (!*regions_array) {
-        LOGE("Memory allocation failed for regions array");
-        fclose(maps_file);
-        return 0;
-    }
-
-    // Read each line from /proc/self/maps
-    while (fgets(map_line, sizeof(map_line), maps_file)) {
-        // Resize array if needed
-        if (region_count >= regions_capacity) {
-            regions_capacity *= 2;
-            MemoryRegion* temporary_array = realloc(*regions_array, 
-                                                   regions_capacity * sizeof(MemoryRegion));
-            if (!temporary_array) {
-                LOGE("Memory reallocation failed for regions, current count: %d", region_count);
-                break;
-            }
-            *regions_array = temporary_array;
-        }
+int is_excluded_system_region(const MemoryRegion* memory_region) {
+    // Apply smart filtering to exclude system regions
+    if (strlen(memory_region->path_name) > 0) {
+        // Patterns for regions to exclude
+        const char* excluded_path_patterns[] = {
+            "/system/", "/apex/", "/vendor/", "/framework/",  // System directories
+            "core-oj", "core-libart", "android.", "java.",    // System libraries
+            "com.android.", "com.google.", "/dev/", "/proc/", // More system paths
+            "/ashmem/", "/dmabuf", "kgsl-3d0", "graphics",    // Hardware buffers
+            "[heap]", "[stack]", "[anon:",                    // Special regions
+            "hwui"                                            // UI framework
+        };
         
-        // Parse current line into MemoryRegion structure
-        MemoryRegion* current_region = &(*regions_array)[region_count];
-        memset(current_region, 0, sizeof(MemoryRegion));
+        const char* package_name = get_current_package_name();
         
-        // Format: start-end permissions offset dev:dev inode pathname
-        int field_count = sscanf(map_line, "%p-%p %4s %lx %x:%x %lu %255s",
-                           &current_region->start_address, 
-                           &current_region->end_address, 
-                           current_region->permissions,
-                           &current_region->file_offset, 
-                           &current_region->device_major, 
-                           &current_region->device_minor,
-                           &current_region->inode_number, 
-                           current_region->path_name);
-
-        // Handle case where pathname is missing
-        if (field_count == 7) {
-            current_region->path_name[0] = '\0';
-        }
-        
-        // Valid line must have at least 7 fields
-        if (field_count >= 7) {
-            region_count++;
+        // Check against exclusion patterns
+        for (size_t i = 0; i < sizeof(excluded_path_patterns)/sizeof(excluded_path_patterns[0]); i++) {
+            if (strstr(memory_region->path_name, excluded_path_patterns[i])) {
+                // Override exclusion for certain DEX-related patterns
+                if (strstr(memory_region->path_name, ".dex") ||
+                    strstr(memory_region->path_name, ".vdex") ||
+                    strstr(memory_region->path_name, ".apk") ||
+                    strstr(memory_region->path_name, "dalvik") ||
+                    strstr(memory_region->path_name, "jit") ||
+                    (package_name && strlen(package_name) > 0 && 
+                     strstr(memory_region->path_name, package_name))) {
+                    VLOGD("Exclusion overridden for region: %s", memory_region->path_name);
+                    return 0;
+                }
+                VLOGD("Excluding system region: %s", memory_region->path_name);
+                return 1;
+            }
         }
     }
     
-    fclose(maps_file);
-    LOGI("Successfully parsed %d memory regions", region_count);
-    return region_count;
+    return 0;
 }
 
 /**
@@ -121,7 +180,7 @@ int should_scan_memory_region(const MemoryRegion* memory_region) {
     
     // Check size constraints
     size_t region_size = (char*)memory_region->end_address - (char*)memory_region->start_address;
-    if (region_size < DEX_MIN_FILE_SIZE || region_size > MAX_REGION_SIZE) {
+    if (region_size < DEX_MIN_FILE_SIZE || region_size > get_region_size_limit(memory_region)) {
         return 0;
     }
     
@@ -139,42 +198,10 @@ int should_scan_memory_region(const MemoryRegion* memory_region) {
               memory_region->path_name);
         return 0;
     }
-
-    // Configurable region filtering
-    if (should_enable_region_filtering()) {
-        // Apply smart filtering to exclude system regions
-        if (strlen(memory_region->path_name) > 0) {
-            // Patterns for regions to exclude
-            const char* excluded_path_patterns[] = {
-                "/system/", "/apex/", "/vendor/", "/framework/",  // System directories
-                "core-oj", "core-libart", "android.", "java.",    // System libraries
-                "com.android.", "com.google.", "/dev/", "/proc/", // More system paths
-                "/ashmem/", "/dmabuf", "kgsl-3d0", "graphics",    // Hardware buffers
-                "[heap]", "[stack]", "[anon:",                    // Special regions
-                "hwui"                                            // UI framework
-            };
-    
-            const char* package_name = get_current_package_name();
     
-            // Check against exclusion patterns
-            for (size_t i = 0; i < sizeof(excluded_path_patterns)/sizeof(excluded_path_patterns[0]); i++) {
-                if (strstr(memory_region->path_name, excluded_path_patterns[i])) {
-                    // Override exclusion for certain DEX-related patterns
-                    if (strstr(memory_region->path_name, ".dex") ||
-                        strstr(memory_region->path_name, ".vdex") ||
-                        strstr(memory_region->path_name, ".apk") ||
-                        strstr(memory_region->path_name, "dalvik") ||
-                        strstr(memory_region->path_name, "jit") ||
-                        (package_name && strlen(package_name) > 0 && 
-                         strstr(memory_region->path_name, package_name))) {
-                        VLOGD("Exclusion overridden for region: %s", memory_region->path_name);
-                        break;
-                    }
-                    VLOGD("Excluding system region: %s", memory_region->path_name);
-                    return 0;
-                }
-            }
-        }
+    // Configurable region filtering
+    if (should_enable_region_filtering() && is_excluded_system_region(memory_region)) {
+        return 0;
     }
     
     VLOGD("Region approved for scanning: %p-%p %s", 
@@ -269,6 +296,76 @@ int is_potential_dex_region(const MemoryRegion* memory_region) {
     return 0;
 }
 
+/**
+ * @brief Checks whether a region maps a file that still exists on disk
+ * 
+ * memfd and deleted files have an inode but nothing to copy from disk,
+ * so they count as anonymous memory.
+ * 
+ * @param memory_region Region to evaluate
+ * @return 1 if the region is backed by a regular file, 0 otherwise
+ */
+int is_file_backed_region(const MemoryRegion* memory_region) {
+    if (memory_region->inode_number == 0) return 0;
+    
+    const char* region_path = memory_region->path_name;
+    if (strncmp(region_path, "/memfd:", 7) == 0 || strstr(region_path, " (deleted)") != NULL) {
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief Compares sampled windows of a copy with its source
+ * 
+ * The windows are spread evenly over the range, the first and last
+ * always included. A window whose source changed after it was copied
+ * no longer matches; the source is read fault-safe, like the copy.
+ * 
+ * @param source_address Address the copy was taken from
+ * @param memory_copy Copy to check
+ * @param copy_size Size of the range
+ * @param torn_ranges Output list of differing windows as "offset+size", NULL if not needed
+ * @param torn_ranges_size Size of torn_ranges
+ * @return Number of windows that differ
+ */
+static int count_torn_windows(const void* source_address, const uint8_t* memory_copy, size_t copy_size,
+                              char* torn_ranges, size_t torn_ranges_size) {
+    uint8_t source_window[TORN_CHECK_WINDOW_SIZE];
+    size_t window_size = copy_size < TORN_CHECK_WINDOW_SIZE ? copy_size : TORN_CHECK_WINDOW_SIZE;
+    int window_count = copy_size <= window_size ? 1 : TORN_CHECK_SAMPLE_WINDOWS;
+    int torn_count = 0;
+    size_t ranges_length = 0;
+    size_t previous_offset = SIZE_MAX;
+    
+    for (int i = 0; i < window_count; i++) {
+        size_t offset = window_count == 1 ? 0 : (copy_size - window_size) / (size_t)(window_count - 1) * (size_t)i;
+        if (i == window_count - 1) offset = copy_size - window_size;
+        if (offset == previous_offset) continue;
+        previous_offset = offset;
+        
+        // An unreadable source has changed too: it was readable for the copy
+        if (read_memory_safely((const uint8_t*)source_address + offset, source_window, window_size) &&
+            memcmp(source_window, memory_copy + offset, window_size) == 0) {
+            continue;
+        }
+        
+        torn_count++;
+        if (torn_ranges && ranges_length < torn_ranges_size) {
+            int written = snprintf(torn_ranges + ranges_length, torn_ranges_size - ranges_length, "%s0x%zx+0x%zx",
+                                   ranges_length ? "," : "", offset, window_size);
+            if (written > 0 && (size_t)written < torn_ranges_size - ranges_length) {
+                ranges_length += (size_t)written;
+            } else {
+                // List full: keep whole entries only
+                torn_ranges[ranges_length] = '\0';
+                ranges_length = torn_ranges_size;
+            }
+        }
+    }
+    return torn_count;
+}
+
 /**
  * @brief Creates a safe copy of memory region for processing
  * 
@@ -281,20 +378,77 @@ int is_potential_dex_region(const MemoryRegion* memory_region) {
  * @return Pointer to allocated copy, NULL on failure
  */
 void* create_memory_copy(const void* source_address, size_t copy_size) {
+    return create_verified_memory_copy(source_address, copy_size, NULL, 0);
+}
+
+/**
+ * @brief Creates a copy checked against modification while it was taken
+ * 
+ * The app may be decrypting or patching a DEX while it is copied, which
+ * leaves a copy mixing old and new bytes. After copying, sampled windows
+ * are compared with the source; on a mismatch the copy is taken again
+ * after a backoff that doubles each time, giving the app time to finish
+ * its writes. If the source is still changing after TORN_COPY_MAX_RETRIES
+ * retries the last copy is kept and the windows that differed are
+ * reported, so the dump can be flagged instead of lost.
+ * 
+ * @param source_address Address to copy from
+ * @param copy_size Number of bytes to copy
+ * @param torn_ranges Output, windows still torn in the returned copy ("" if none), NULL if not needed
+ * @param torn_ranges_size Size of torn_ranges
+ * @return Pointer to allocated copy, NULL on failure
+ */
+void* create_verified_memory_copy(const void* source_address, size_t copy_size,
+                                  char* torn_ranges, size_t torn_ranges_size) {
+    if (torn_ranges && torn_ranges_size > 0) torn_ranges[0] = '\0';
+    
     // Validate inputs
     if (source_address == NULL || copy_size == 0 || copy_size > DEX_MAX_FILE_SIZE) {
         return NULL;
     }
     
-    // Allocate buffer for copy
-    void* memory_copy = malloc(copy_size);
+    // Allocate tracked buffer so later scans never find this copy
+    void* memory_copy = allocate_tracked_buffer(copy_size);
     if (!memory_copy) return NULL;
     
-    // Safely copy memory using signal-protected read
-    if (!read_memory_safely(source_address, memory_copy, copy_size)) {
-        free(memory_copy);
-        return NULL;
+    int check_tears = should_enable_torn_copy_check();
+    for (int attempt = 0; ; attempt++) {
+        // Safely copy memory using signal-protected read
+        if (!read_memory_safely(source_address, memory_copy, copy_size)) {
+            release_tracked_buffer(memory_copy, copy_size);
+            return NULL;
+        }
+        if (!check_tears) break;
+        
+        int last_attempt = attempt == TORN_COPY_MAX_RETRIES;
+        int torn_count = count_torn_windows(source_address, memory_copy, copy_size,
+                                            last_attempt ? torn_ranges : NULL, torn_ranges_size);
+        if (torn_count == 0) break;
+        
+        SCAN_STAT_ADD(copy_tears_detected, 1);
+        if (last_attempt) {
+            SCAN_STAT_ADD(copies_left_torn, 1);
+            LOGW("Source at %p still changing after %d copies, %d sampled windows differ",
+                 source_address, attempt + 1, torn_count);
+            break;
+        }
+        
+        VLOGD("Copy of %p torn in %d sampled windows, retrying", source_address, torn_count);
+        usleep((useconds_t)(TORN_COPY_BACKOFF_MS << attempt) * 1000);
     }
     
     return memory_copy;
+}
+
+/**
+ * @brief Releases a copy created by create_memory_copy
+ * 
+ * The copy's pages are discarded rather than returned to malloc, so the
+ * DEX bytes do not linger in anonymous memory for the next scan to find.
+ * 
+ * @param memory_copy Copy returned by create_memory_copy
+ * @param copy_size Size passed to create_memory_copy
+ */
+void release_memory_copy(void* memory_copy, size_t copy_size) {
+    release_tracked_buffer(memory_copy, copy_size);
 }
\ No newline at end of file
@@ -10,23 +10,40 @@
 /**
  * Memory Scanning Functions:
  * 
- * These functions handle parsing process memory maps, filtering relevant regions,
- * and creating safe copies of memory for analysis.
+ * These functions handle filtering relevant regions and creating safe copies
+ * of memory for analysis. /proc/self/maps is parsed into a RegionTable
+ * (region_table.h), whose path classification reuses the checks below.
  */
 
-// Parses /proc/self/maps to get memory region information
-int parse_memory_regions(MemoryRegion** regions_array);
-
 // Determines if a memory region should be scanned for DEX files
 int should_scan_memory_region(const MemoryRegion* memory_region);
 
+// Checks a region against the system region exclusion patterns
+int is_excluded_system_region(const MemoryRegion* memory_region);
+
 // Tests if a memory region can be safely read
 int test_region_read_access(const MemoryRegion* memory_region);
 
 // Identifies high-potential regions likely to contain DEX files
 int is_potential_dex_region(const MemoryRegion* memory_region);
 
+// Checks whether a region maps a file that still exists on disk
+int is_file_backed_region(const MemoryRegion* memory_region);
+
+// Quarantines a region that exceeded its scan budget
+void quarantine_memory_region(const MemoryRegion* memory_region);
+
+// Checks whether a region was quarantined by an earlier pass
+int is_region_quarantined(const MemoryRegion* memory_region);
+
 // Creates safe copy of memory for processing and dumping
 void* create_memory_copy(const void* source_address, size_t copy_size);
 
+// Creates a copy checked against concurrent modification, reporting windows still torn after the retries
+void* create_verified_memory_copy(const void* source_address, size_t copy_size,
+                                  char* torn_ranges, size_t torn_ranges_size);
+
+// Releases a memory copy and discards its contents
+void release_memory_copy(void* memory_copy, size_t copy_size);
+
 #endif
\ No newline at end of file
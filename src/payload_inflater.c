@@ -0,0 +1,641 @@
+#include "payload_inflater.h"
+#include "dex_detector.h"
+#include "self_exclusion.h"
+#include "scan_statistics.h"
+#include <zlib.h>
+
+// Outcome of an inflation run
+typedef enum {
+    INFLATE_COMPLETE = 0,   // Stream ended normally
+    INFLATE_TRUNCATED,      // Input ran out (or faulted) before the stream ended
+    INFLATE_OUTPUT_LIMIT,   // Output limit reached
+    INFLATE_TIME_LIMIT,     // CPU time budget exhausted
+    INFLATE_ERROR           // Corrupt or unsupported stream
+} InflateStatus;
+
+// Compressed input read safely from scanned memory through a window buffer
+typedef struct {
+    const uint8_t* source;   // Start of compressed data in scanned memory
+    size_t source_size;      // Compressed bytes available
+    size_t consumed;         // Bytes already read from source
+    uint8_t* window;         // Buffer receiving copied input
+    size_t window_capacity;  // Size of window
+} CompressedInput;
+
+// Size of a zip local file header without name and extra field
+#define ZIP_LOCAL_HEADER_SIZE 30
+
+// Largest LZ4 frame block (block maximum size id 7)
+#define LZ4_MAX_BLOCK_SIZE (4 * 1024 * 1024)
+
+// Inflated bytes produced during the current pass
+static size_t inflated_bytes_this_pass = 0;
+static pthread_mutex_t inflate_budget_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief Gets the CPU time used by the calling thread in milliseconds
+ * 
+ * Time spent waiting on page faults or preempted does not count against
+ * inflation budgets.
+ */
+static uint64_t thread_cpu_milliseconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return (uint64_t)now.tv_sec * 1000 + (uint64_t)now.tv_nsec / 1000000;
+}
+
+/**
+ * @brief Resets the per-pass inflated byte budget
+ */
+void reset_inflate_budget(void) {
+    pthread_mutex_lock(&inflate_budget_mutex);
+    inflated_bytes_this_pass = 0;
+    pthread_mutex_unlock(&inflate_budget_mutex);
+}
+
+/**
+ * @brief Gets the number of bytes that may still be inflated in this pass
+ */
+static size_t remaining_inflate_budget(void) {
+    pthread_mutex_lock(&inflate_budget_mutex);
+    size_t remaining = inflated_bytes_this_pass < INFLATE_PASS_BYTE_BUDGET ?
+                       INFLATE_PASS_BYTE_BUDGET - inflated_bytes_this_pass : 0;
+    pthread_mutex_unlock(&inflate_budget_mutex);
+    return remaining;
+}
+
+/**
+ * @brief Charges inflated bytes against the per-pass budget
+ */
+static void charge_inflate_budget(size_t inflated_bytes) {
+    pthread_mutex_lock(&inflate_budget_mutex);
+    inflated_bytes_this_pass += inflated_bytes;
+    pthread_mutex_unlock(&inflate_budget_mutex);
+}
+
+/**
+ * @brief Copies exactly byte_count bytes of compressed input into a buffer
+ * 
+ * @return 1 on success, 0 if input is exhausted or unreadable
+ */
+static int read_input_bytes(CompressedInput* input, void* destination, size_t byte_count) {
+    if (byte_count == 0) return 1;
+    if (byte_count > input->source_size - input->consumed) return 0;
+    if (!read_memory_safely(input->source + input->consumed, destination, byte_count)) return 0;
+    input->consumed += byte_count;
+    return 1;
+}
+
+/**
+ * @brief Refills the input window with the next chunk of compressed data
+ * 
+ * A chunk that faults is retried up to the next page boundary so that a
+ * stream ending just before an unreadable page is still usable.
+ * 
+ * @return Number of bytes now in the window, 0 if no more input
+ */
+static size_t refill_input_window(CompressedInput* input) {
+    size_t chunk_size = input->source_size - input->consumed;
+    if (chunk_size > input->window_capacity) chunk_size = input->window_capacity;
+    if (chunk_size == 0) return 0;
+    
+    if (read_input_bytes(input, input->window, chunk_size)) return chunk_size;
+    
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    uintptr_t chunk_address = (uintptr_t)(input->source + input->consumed);
+    size_t page_remainder = page_size - (chunk_address % page_size);
+    if (page_remainder < chunk_size && read_input_bytes(input, input->window, page_remainder)) {
+        return page_remainder;
+    }
+    return 0;
+}
+
+/**
+ * @brief Inflates a zlib, gzip or raw deflate stream
+ * 
+ * @param window_bits zlib window bits selecting the container format
+ * @param input Compressed input
+ * @param output Output buffer
+ * @param output_limit Maximum bytes to produce
+ * @param produced Output: bytes produced
+ * @param deadline_ms Thread CPU time deadline, 0 for none
+ * @return Inflation status
+ */
+static InflateStatus inflate_deflate_stream(int window_bits, CompressedInput* input,
+                                            uint8_t* output, size_t output_limit,
+                                            size_t* produced, uint64_t deadline_ms) {
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    *produced = 0;
+    if (inflateInit2(&stream, window_bits) != Z_OK) return INFLATE_ERROR;
+    
+    if (output_limit > UINT32_MAX) output_limit = UINT32_MAX;
+    stream.next_out = output;
+    stream.avail_out = (uInt)output_limit;
+    
+    InflateStatus status;
+    for (;;) {
+        if (stream.avail_in == 0) {
+            size_t available = refill_input_window(input);
+            if (available == 0) {
+                status = INFLATE_TRUNCATED;
+                break;
+            }
+            stream.next_in = input->window;
+            stream.avail_in = (uInt)available;
+        }
+        
+        int inflate_result = inflate(&stream, Z_NO_FLUSH);
+        if (inflate_result == Z_STREAM_END) {
+            status = INFLATE_COMPLETE;
+            break;
+        }
+        if (inflate_result != Z_OK && inflate_result != Z_BUF_ERROR) {
+            status = INFLATE_ERROR;
+            break;
+        }
+        if (stream.avail_out == 0) {
+            status = INFLATE_OUTPUT_LIMIT;
+            break;
+        }
+        if (inflate_result == Z_BUF_ERROR && stream.avail_in != 0) {
+            status = INFLATE_ERROR; // No progress possible
+            break;
+        }
+        if (deadline_ms && thread_cpu_milliseconds() > deadline_ms) {
+            status = INFLATE_TIME_LIMIT;
+            break;
+        }
+    }
+    
+    *produced = stream.total_out;
+    inflateEnd(&stream);
+    return status;
+}
+
+/**
+ * @brief Decodes one LZ4 block into the output buffer
+ * 
+ * Matches may reference output of earlier blocks, which is why the whole
+ * frame is decoded into one contiguous buffer.
+ * 
+ * @param block Compressed block bytes (may be truncated when sniffing)
+ * @param block_size Number of bytes available in block
+ * @param output Output buffer (frame start)
+ * @param output_position In/out: current output position
+ * @param output_limit Maximum output position
+ * @return INFLATE_COMPLETE, INFLATE_TRUNCATED, INFLATE_OUTPUT_LIMIT or INFLATE_ERROR
+ */
+static InflateStatus decode_lz4_block(const uint8_t* block, size_t block_size, uint8_t* output,
+                                      size_t* output_position, size_t output_limit) {
+    const uint8_t* input_pointer = block;
+    const uint8_t* input_end = block + block_size;
+    size_t position = *output_position;
+    InflateStatus status = INFLATE_COMPLETE;
+    
+    while (input_pointer < input_end) {
+        uint8_t token = *input_pointer++;
+        
+        // Literal run
+        size_t literal_length = token >> 4;
+        if (literal_length == 15) {
+            uint8_t extra;
+            do {
+                if (input_pointer >= input_end) { status = INFLATE_TRUNCATED; goto done; }
+                extra = *input_pointer++;
+                literal_length += extra;
+            } while (extra == 255);
+        }
+        size_t literal_available = (size_t)(input_end - input_pointer);
+        size_t literal_copy = literal_length < literal_available ? literal_length : literal_available;
+        if (literal_copy > output_limit - position) {
+            memcpy(output + position, input_pointer, output_limit - position);
+            position = output_limit;
+            status = INFLATE_OUTPUT_LIMIT;
+            goto done;
+        }
+        memcpy(output + position, input_pointer, literal_copy);
+        position += literal_copy;
+        input_pointer += literal_copy;
+        if (literal_copy < literal_length) { status = INFLATE_TRUNCATED; goto done; }
+        
+        // Last sequence carries literals only
+        if (input_pointer >= input_end) break;
+        
+        // Match copy (may overlap its own output)
+        if (input_end - input_pointer < 2) { status = INFLATE_TRUNCATED; goto done; }
+        size_t match_offset = (size_t)input_pointer[0] | ((size_t)input_pointer[1] << 8);
+        input_pointer += 2;
+        if (match_offset == 0 || match_offset > position) { status = INFLATE_ERROR; goto done; }
+        
+        size_t match_length = token & 0x0F;
+        if (match_length == 15) {
+            uint8_t extra;
+            do {
+                if (input_pointer >= input_end) { status = INFLATE_TRUNCATED; goto done; }
+                extra = *input_pointer++;
+                match_length += extra;
+            } while (extra == 255);
+        }
+        match_length += 4;
+        
+        if (match_length > output_limit - position) {
+            match_length = output_limit - position;
+            status = INFLATE_OUTPUT_LIMIT;
+        }
+        for (size_t i = 0; i < match_length; i++, position++) {
+            output[position] = output[position - match_offset];
+        }
+        if (status == INFLATE_OUTPUT_LIMIT) goto done;
+    }
+
+done:
+    *output_position = position;
+    return status;
+}
+
+/**
+ * @brief Decodes an LZ4 frame
+ * 
+ * Supports independent and linked blocks, optional content size and
+ * block/content checksums (checksums are skipped, not verified).
+ * Frames with a dictionary ID are rejected.
+ * 
+ * @param input Compressed input starting at the frame magic
+ * @param output Output buffer
+ * @param output_limit Maximum bytes to produce
+ * @param produced Output: bytes produced
+ * @param deadline_ms Thread CPU time deadline, 0 for none
+ * @return Inflation status
+ */
+static InflateStatus inflate_lz4_frame(CompressedInput* input, uint8_t* output, size_t output_limit,
+                                       size_t* produced, uint64_t deadline_ms) {
+    uint8_t frame_header[9];
+    *produced = 0;
+    
+    // Magic, FLG and BD
+    if (!read_input_bytes(input, frame_header, 6)) return INFLATE_TRUNCATED;
+    uint8_t frame_flags = frame_header[4];
+    uint8_t block_descriptor = frame_header[5];
+    if ((frame_flags >> 6) != 1 || (frame_flags & 0x02) || (frame_flags & 0x01)) {
+        return INFLATE_ERROR; // Bad version, reserved bit or dictionary ID
+    }
+    int block_size_id = (block_descriptor >> 4) & 0x07;
+    if (block_size_id < 4 || (block_descriptor & 0x8F)) return INFLATE_ERROR;
+    
+    int has_block_checksum = (frame_flags & 0x10) != 0;
+    size_t header_remaining = ((frame_flags & 0x08) ? 8 : 0) + 1; // Content size + HC
+    if (!read_input_bytes(input, frame_header, header_remaining)) return INFLATE_TRUNCATED;
+    
+    size_t position = 0;
+    for (;;) {
+        uint32_t block_header;
+        if (!read_input_bytes(input, &block_header, sizeof(block_header))) {
+            *produced = position;
+            return INFLATE_TRUNCATED;
+        }
+        if (block_header == 0) break; // EndMark
+        
+        size_t block_size = block_header & 0x7FFFFFFFU;
+        int block_uncompressed = (block_header & 0x80000000U) != 0;
+        if (block_size > LZ4_MAX_BLOCK_SIZE) {
+            *produced = position;
+            return INFLATE_ERROR;
+        }
+        
+        // A window smaller than the block is only used for sniffing; decode the prefix
+        size_t read_size = block_size < input->window_capacity ? block_size : input->window_capacity;
+        if (!read_input_bytes(input, input->window, read_size)) {
+            *produced = position;
+            return INFLATE_TRUNCATED;
+        }
+        
+        InflateStatus block_status;
+        if (block_uncompressed) {
+            size_t copy_size = read_size < output_limit - position ? read_size : output_limit - position;
+            memcpy(output + position, input->window, copy_size);
+            position += copy_size;
+            block_status = copy_size < read_size ? INFLATE_OUTPUT_LIMIT : INFLATE_COMPLETE;
+        } else {
+            block_status = decode_lz4_block(input->window, read_size, output, &position, output_limit);
+        }
+        
+        if (block_status != INFLATE_COMPLETE) {
+            *produced = position;
+            return block_status;
+        }
+        if (read_size < block_size) {
+            *produced = position;
+            return INFLATE_TRUNCATED;
+        }
+        
+        // Block checksum, read through the bounds check and ignored
+        uint32_t block_checksum;
+        if (has_block_checksum && !read_input_bytes(input, &block_checksum, sizeof(block_checksum))) {
+            *produced = position;
+            return INFLATE_TRUNCATED;
+        }
+        if (deadline_ms && thread_cpu_milliseconds() > deadline_ms) {
+            *produced = position;
+            return INFLATE_TIME_LIMIT;
+        }
+    }
+    
+    *produced = position;
+    return INFLATE_COMPLETE;
+}
+
+/**
+ * @brief Locates the compressed stream behind a detected header
+ * 
+ * For zip entries the local file header is parsed to find the deflate data;
+ * all other encodings start at the detected address.
+ * 
+ * @param payload_address Address where the detector matched
+ * @param available_size Bytes available from payload_address
+ * @param payload_encoding Encoding reported by the detector
+ * @param stream_start Output: start of the compressed stream
+ * @param stream_size Output: bytes of compressed input to use
+ * @return 1 on success, 0 if the header is not usable
+ */
+static int locate_compressed_stream(const uint8_t* payload_address, size_t available_size,
+                                    PayloadEncoding payload_encoding,
+                                    const uint8_t** stream_start, size_t* stream_size) {
+    if (payload_encoding != PAYLOAD_ENCODING_ZIP_DEFLATE) {
+        *stream_start = payload_address;
+        *stream_size = available_size;
+        return 1;
+    }
+    
+    uint8_t local_header[ZIP_LOCAL_HEADER_SIZE];
+    if (available_size < ZIP_LOCAL_HEADER_SIZE ||
+        !read_memory_safely(payload_address, local_header, ZIP_LOCAL_HEADER_SIZE)) {
+        return 0;
+    }
+    
+    uint16_t general_flags = local_header[6] | (local_header[7] << 8);
+    uint16_t compression_method = local_header[8] | (local_header[9] << 8);
+    uint32_t compressed_size = local_header[18] | (local_header[19] << 8) |
+                               (local_header[20] << 16) | ((uint32_t)local_header[21] << 24);
+    uint16_t name_length = local_header[26] | (local_header[27] << 8);
+    uint16_t extra_length = local_header[28] | (local_header[29] << 8);
+    
+    // Deflate only, not encrypted, plausible name
+    if (compression_method != 8 || (general_flags & 0x0001) ||
+        name_length == 0 || name_length > MAX_PATH_LENGTH) {
+        return 0;
+    }
+    
+    size_t data_offset = ZIP_LOCAL_HEADER_SIZE + name_length + extra_length;
+    if (data_offset >= available_size) return 0;
+    
+    *stream_start = payload_address + data_offset;
+    *stream_size = available_size - data_offset;
+    
+    // Sizes are zero when a data descriptor follows the data
+    if (compressed_size != 0 && compressed_size < *stream_size) {
+        *stream_size = compressed_size;
+    }
+    return 1;
+}
+
+/**
+ * @brief Runs the inflater matching a payload encoding
+ */
+static InflateStatus inflate_payload_stream(PayloadEncoding payload_encoding, CompressedInput* input,
+                                            uint8_t* output, size_t output_limit,
+                                            size_t* produced, uint64_t deadline_ms) {
+    switch (payload_encoding) {
+        case PAYLOAD_ENCODING_ZLIB:
+            return inflate_deflate_stream(MAX_WBITS, input, output, output_limit, produced, deadline_ms);
+        case PAYLOAD_ENCODING_GZIP:
+            return inflate_deflate_stream(MAX_WBITS + 16, input, output, output_limit, produced, deadline_ms);
+        case PAYLOAD_ENCODING_ZIP_DEFLATE:
+            return inflate_deflate_stream(-MAX_WBITS, input, output, output_limit, produced, deadline_ms);
+        case PAYLOAD_ENCODING_LZ4_FRAME:
+            return inflate_lz4_frame(input, output, output_limit, produced, deadline_ms);
+        default:
+            *produced = 0;
+            return INFLATE_ERROR;
+    }
+}
+
+/**
+ * @brief Sniffs a compressed candidate by inflating its first few KB
+ * 
+ * Only candidates whose output starts with a DEX or zip magic are accepted,
+ * so random bytes that happen to look like a compression header cost at
+ * most one small inflation, bounded in output and in CPU time. The number
+ * of sniffs per region is limited as well.
+ * 
+ * @return 1 if the candidate inflates to a DEX or zip prefix, 0 otherwise
+ */
+static int sniff_compressed_candidate(const DexDumperMemoryView* memory_view, size_t candidate_offset,
+                                      PayloadEncoding payload_encoding) {
+    RegionScanBudget* budget = get_current_region_budget();
+    if (budget->inflate_attempts >= MAX_INFLATE_ATTEMPTS_PER_REGION) return 0;
+    if (remaining_inflate_budget() < INFLATE_SNIFF_OUTPUT_SIZE) return 0;
+    budget->inflate_attempts++;
+    SCAN_STAT_ADD(inflate_attempts, 1);
+    
+    const uint8_t* stream_start;
+    size_t stream_size;
+    const uint8_t* candidate_address = (const uint8_t*)memory_view->base_address + candidate_offset;
+    if (!locate_compressed_stream(candidate_address, memory_view->region_size - candidate_offset,
+                                  payload_encoding, &stream_start, &stream_size)) {
+        return 0;
+    }
+    
+    uint8_t sniff_input[INFLATE_SNIFF_INPUT_SIZE];
+    uint8_t sniff_output[INFLATE_SNIFF_OUTPUT_SIZE];
+    CompressedInput input = {
+        .source = stream_start,
+        .source_size = stream_size,
+        .consumed = 0,
+        .window = sniff_input,
+        .window_capacity = sizeof(sniff_input)
+    };
+    
+    size_t produced = 0;
+    uint64_t deadline_ms = thread_cpu_milliseconds() + INFLATE_SNIFF_TIME_BUDGET_MS;
+    inflate_payload_stream(payload_encoding, &input, sniff_output, sizeof(sniff_output), &produced, deadline_ms);
+    
+    if (produced >= DEX_MAGIC_LEN &&
+        (memcmp(sniff_output, DEX_MAGIC_SIGNATURE, 4) == 0 || memcmp(sniff_output, "PK\003\004", 4) == 0)) {
+        VLOGD("Compressed candidate at offset %zu inflates to a known magic", candidate_offset);
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Validate callbacks for each compressed format
+ */
+static int validate_zlib_candidate(const DexDumperMemoryView* memory_view, size_t candidate_offset, void* context) {
+    uint8_t stream_header[2];
+    if (!memory_view->read_memory((const char*)memory_view->base_address + candidate_offset,
+                                  stream_header, 2)) {
+        return 0;
+    }
+    // FCHECK must make the header a multiple of 31, preset dictionaries are unsupported
+    if (((stream_header[0] << 8) | stream_header[1]) % 31 != 0 || (stream_header[1] & 0x20)) {
+        return 0;
+    }
+    return sniff_compressed_candidate(memory_view, candidate_offset, PAYLOAD_ENCODING_ZLIB);
+}
+
+static int validate_gzip_candidate(const DexDumperMemoryView* memory_view, size_t candidate_offset, void* context) {
+    uint8_t member_header[4];
+    if (!memory_view->read_memory((const char*)memory_view->base_address + candidate_offset,
+                                  member_header, 4)) {
+        return 0;
+    }
+    if (member_header[3] & 0xE0) return 0; // Reserved flag bits must be zero
+    return sniff_compressed_candidate(memory_view, candidate_offset, PAYLOAD_ENCODING_GZIP);
+}
+
+static int validate_zip_entry_candidate(const DexDumperMemoryView* memory_view, size_t candidate_offset, void* context) {
+    return sniff_compressed_candidate(memory_view, candidate_offset, PAYLOAD_ENCODING_ZIP_DEFLATE);
+}
+
+static int validate_lz4_candidate(const DexDumperMemoryView* memory_view, size_t candidate_offset, void* context) {
+    return sniff_compressed_candidate(memory_view, candidate_offset, PAYLOAD_ENCODING_LZ4_FRAME);
+}
+
+/**
+ * @brief Extent callback shared by compressed detectors
+ * 
+ * The compressed size is generally unknown, so the extent is everything
+ * from the header to the end of the region; the inflater stops at the
+ * end of the stream.
+ */
+static size_t compressed_payload_extent(const DexDumperMemoryView* memory_view,
+                                        size_t candidate_offset, void* context) {
+    return memory_view->region_size - candidate_offset;
+}
+
+// Built-in compressed-header detectors (zlib has one per common FLEVEL byte)
+#define COMPRESSED_DETECTOR(name, pattern, length, validator) { \
+    .abi_version = DEXDUMPER_DETECTOR_ABI_VERSION, .detector_name = name, \
+    .prefilter_pattern = (const uint8_t*)pattern, .prefilter_length = length, \
+    .prefilter_alignment = 1, .validate = validator, \
+    .extent = compressed_payload_extent, .context = NULL }
+
+static const DexDumperDetector compressed_detectors[] = {
+    COMPRESSED_DETECTOR("zlib stream", "\x78\x01", 2, validate_zlib_candidate),
+    COMPRESSED_DETECTOR("zlib stream", "\x78\x5e", 2, validate_zlib_candidate),
+    COMPRESSED_DETECTOR("zlib stream", "\x78\x9c", 2, validate_zlib_candidate),
+    COMPRESSED_DETECTOR("zlib stream", "\x78\xda", 2, validate_zlib_candidate),
+    COMPRESSED_DETECTOR("gzip member", "\x1f\x8b\x08", 3, validate_gzip_candidate),
+    COMPRESSED_DETECTOR("zip deflate entry", "PK\x03\x04", 4, validate_zip_entry_candidate),
+    COMPRESSED_DETECTOR("LZ4 frame", "\x04\x22\x4d\x18", 4, validate_lz4_candidate)
+};
+
+static const PayloadEncoding compressed_detector_encodings[] = {
+    PAYLOAD_ENCODING_ZLIB, PAYLOAD_ENCODING_ZLIB, PAYLOAD_ENCODING_ZLIB, PAYLOAD_ENCODING_ZLIB,
+    PAYLOAD_ENCODING_GZIP, PAYLOAD_ENCODING_ZIP_DEFLATE, PAYLOAD_ENCODING_LZ4_FRAME
+};
+
+/**
+ * @brief Registers the compressed-header detectors
+ * 
+ * They run only in high-priority regions and enforce their own sniff
+ * budget instead of consuming the shared DEX validation budget.
+ */
+void register_compressed_payload_detectors(void) {
+    size_t detector_count = sizeof(compressed_detectors) / sizeof(compressed_detectors[0]);
+    for (size_t i = 0; i < detector_count; i++) {
+        register_builtin_detector(&compressed_detectors[i],
+                                  DETECTOR_FLAG_HIGH_PRIORITY_ONLY | DETECTOR_FLAG_SELF_BUDGETED,
+                                  compressed_detector_encodings[i]);
+    }
+}
+
+/**
+ * @brief Inflates a detected compressed payload
+ * 
+ * Output goes into a tracked buffer so it is never rescanned as app
+ * memory. Inflation stops at the end of the stream, at the per-payload
+ * output limit, when the per-pass byte budget is used up, or when the
+ * CPU time budget expires; partial output is still returned so that
+ * detection can decide whether it is usable.
+ * 
+ * @param detection_result Detection with a non-plain payload encoding
+ * @param output_buffer Output: tracked buffer holding inflated bytes
+ * @param output_size Output: number of inflated bytes
+ * @return 1 if any output was produced, 0 otherwise
+ */
+int inflate_detected_payload(const DexDetectionResult* detection_result,
+                            void** output_buffer, size_t* output_size) {
+    *output_buffer = NULL;
+    *output_size = 0;
+    
+    const uint8_t* stream_start;
+    size_t stream_size;
+    if (!locate_compressed_stream(detection_result->dex_address, detection_result->dex_size,
+                                  detection_result->payload_encoding, &stream_start, &stream_size)) {
+        return 0;
+    }
+    
+    size_t output_limit = remaining_inflate_budget();
+    if (output_limit > INFLATE_MAX_OUTPUT_SIZE) output_limit = INFLATE_MAX_OUTPUT_SIZE;
+    if (output_limit < INFLATE_SNIFF_OUTPUT_SIZE) {
+        SCAN_STAT_ADD(inflate_budget_stops, 1);
+        LOGW("Inflate byte budget exhausted, skipping compressed payload at %p",
+             detection_result->dex_address);
+        return 0;
+    }
+    
+    // LZ4 blocks are read whole, deflate streams through a small window
+    size_t window_size = detection_result->payload_encoding == PAYLOAD_ENCODING_LZ4_FRAME ?
+                         LZ4_MAX_BLOCK_SIZE : INFLATE_INPUT_WINDOW_SIZE;
+    uint8_t* window = allocate_tracked_buffer(window_size);
+    uint8_t* output = allocate_tracked_buffer(INFLATE_MAX_OUTPUT_SIZE);
+    if (!window || !output) {
+        release_tracked_buffer(window, window_size);
+        release_tracked_buffer(output, INFLATE_MAX_OUTPUT_SIZE);
+        return 0;
+    }
+    
+    CompressedInput input = {
+        .source = stream_start,
+        .source_size = stream_size,
+        .consumed = 0,
+        .window = window,
+        .window_capacity = window_size
+    };
+    
+    size_t produced = 0;
+    uint64_t deadline_ms = thread_cpu_milliseconds() + INFLATE_TIME_BUDGET_MS;
+    InflateStatus status = inflate_payload_stream(detection_result->payload_encoding, &input,
+                                                  output, output_limit, &produced, deadline_ms);
+    release_tracked_buffer(window, window_size);
+    charge_inflate_budget(produced);
+    
+    if (status == INFLATE_TIME_LIMIT || (status == INFLATE_OUTPUT_LIMIT && output_limit < INFLATE_MAX_OUTPUT_SIZE)) {
+        SCAN_STAT_ADD(inflate_budget_stops, 1);
+        LOGW("Inflation of %s at %p stopped by budget after %zu bytes",
+             detection_result->detector_name, detection_result->dex_address, produced);
+    }
+    
+    if (produced == 0) {
+        release_tracked_buffer(output, INFLATE_MAX_OUTPUT_SIZE);
+        return 0;
+    }
+    
+    SCAN_STAT_ADD(payloads_inflated, 1);
+    SCAN_STAT_ADD(bytes_inflated, produced);
+    LOGI("Inflated %s at %p: %zu bytes (status %d)", detection_result->detector_name,
+         detection_result->dex_address, produced, (int)status);
+    
+    *output_buffer = output;
+    *output_size = produced;
+    return 1;
+}
+
+/**
+ * @brief Releases a buffer returned by inflate_detected_payload
+ */
+void release_inflated_payload(void* output_buffer) {
+    release_tracked_buffer(output_buffer, INFLATE_MAX_OUTPUT_SIZE);
+}
@@ -0,0 +1,33 @@
+#ifndef DEXDUMPER_PAYLOAD_INFLATER_H
+#define DEXDUMPER_PAYLOAD_INFLATER_H
+
+// Payload inflater header - declares compressed payload detection and inflation
+
+#include "common.h"
+#include "config.h"
+
+/**
+ * Compressed Payload Support:
+ * 
+ * Packers often keep the real DEX zlib, gzip, deflate (zip entry) or LZ4
+ * compressed in memory. These functions register detectors for those
+ * headers (high-priority regions only), sniff each candidate by inflating
+ * a few KB and checking for a DEX or zip magic, and inflate confirmed
+ * payloads under CPU and byte budgets so the output can be fed back into
+ * detection.
+ */
+
+// Registers the compressed-header detectors with the single-pass scanner
+void register_compressed_payload_detectors(void);
+
+// Resets the per-pass inflated byte budget
+void reset_inflate_budget(void);
+
+// Inflates a detected compressed payload into a tracked buffer
+int inflate_detected_payload(const DexDetectionResult* detection_result, 
+                            void** output_buffer, size_t* output_size);
+
+// Releases a buffer returned by inflate_detected_payload
+void release_inflated_payload(void* output_buffer);
+
+#endif
@@ -0,0 +1,93 @@
+#include "plugin_loader.h"
+#include "dex_detector.h"
+
+/**
+ * @brief Loads a single plugin library and registers its detectors
+ * 
+ * A library none of whose detectors could be registered (invalid, or the
+ * registry is full) is unloaded again.
+ * 
+ * @param plugin_path Full path to the shared library
+ * @return Number of detectors registered from this plugin
+ */
+static int load_single_plugin(const char* plugin_path) {
+    void* plugin_handle = dlopen(plugin_path, RTLD_NOW | RTLD_LOCAL);
+    if (!plugin_handle) {
+        LOGW("Failed to load detector plugin %s: %s", plugin_path, dlerror());
+        return 0;
+    }
+    
+    DexDumperGetDetectorsFunction get_detectors = 
+        (DexDumperGetDetectorsFunction)dlsym(plugin_handle, DEXDUMPER_PLUGIN_ENTRY_SYMBOL);
+    if (!get_detectors) {
+        LOGW("Plugin %s does not export %s", plugin_path, DEXDUMPER_PLUGIN_ENTRY_SYMBOL);
+        dlclose(plugin_handle);
+        return 0;
+    }
+    
+    size_t detector_count = 0;
+    const DexDumperDetector* detectors = get_detectors(&detector_count);
+    if (!detectors || detector_count == 0) {
+        LOGW("Plugin %s provided no detectors", plugin_path);
+        dlclose(plugin_handle);
+        return 0;
+    }
+    
+    // Register each detector; the registry validates ABI version and fields
+    int registered_count = 0;
+    for (size_t i = 0; i < detector_count; i++) {
+        registered_count += register_dex_detector(&detectors[i]);
+    }
+    
+    if (registered_count == 0) {
+        dlclose(plugin_handle);
+        return 0;
+    }
+    
+    // The handle is never closed: registered detectors point into the library
+    LOGI("Loaded plugin %s with %d detectors", plugin_path, registered_count);
+    return registered_count;
+}
+
+/**
+ * @brief Loads all detector plugins found in a directory
+ * 
+ * Every file ending in ".so" is treated as a plugin. Plugins are loaded
+ * once, before scanning begins, so their prefilters become part of the
+ * single-pass scanner's dispatch table.
+ * 
+ * @param plugin_directory Directory containing plugin libraries
+ * @return Total number of detectors registered
+ */
+int load_detector_plugins(const char* plugin_directory) {
+    if (plugin_directory == NULL || plugin_directory[0] == '\0') {
+        return 0;
+    }
+    
+    DIR* directory_handle = opendir(plugin_directory);
+    if (!directory_handle) {
+        VLOGD("Detector plugin directory not available: %s", plugin_directory);
+        return 0;
+    }
+    
+    struct dirent* directory_entry;
+    int total_registered = 0;
+    
+    while ((directory_entry = readdir(directory_handle)) != NULL) {
+        const char* filename = directory_entry->d_name;
+        size_t name_length = strlen(filename);
+        
+        // Only shared libraries are considered
+        if (name_length <= 3 || strcmp(filename + name_length - 3, ".so") != 0) {
+            continue;
+        }
+        
+        char plugin_path[MAX_PATH_LENGTH];
+        snprintf(plugin_path, sizeof(plugin_path), "%s/%s", plugin_directory, filename);
+        total_registered += load_single_plugin(plugin_path);
+    }
+    
+    closedir(directory_handle);
+    LOGI("Loaded %d plugin detectors from %s", total_registered, plugin_directory);
+    return total_registered;
+}
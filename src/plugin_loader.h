@@ -0,0 +1,20 @@
+#ifndef DEXDUMPER_PLUGIN_LOADER_H
+#define DEXDUMPER_PLUGIN_LOADER_H
+
+// Plugin loader header - declares loading of external detector libraries
+
+#include "common.h"
+#include "config.h"
+
+/**
+ * Detector Plugin Loading:
+ * 
+ * Shared libraries in the configured plugin directory are opened with
+ * dlopen and their detectors are merged into the single-pass scanner.
+ * Libraries stay loaded for the life of the process.
+ */
+
+// Loads all detector plugins from a directory, returns number of detectors registered
+int load_detector_plugins(const char* plugin_directory);
+
+#endif
@@ -0,0 +1,314 @@
+#include "pointer_discovery.h"
+#include "dex_detector.h"
+#include "memory_scanner.h"
+#include "config_manager.h"
+#include "scan_statistics.h"
+#include "scan_arena.h"
+
+// Writable regions that never hold native pointers to loaded DEX files
+static const char* const skipped_source_names[] = {
+    "[stack", "[vvar", "[vsyscall", "/dev/kgsl", "/dmabuf",
+    "dalvik-" // Managed heap and its side tables use 32-bit references
+};
+
+/**
+ * @brief Readable region a pointer may lead to
+ */
+typedef struct {
+    uintptr_t start_address; // First byte of the region
+    uintptr_t end_address;   // One past the last byte
+    int region_index;        // Index in the region table
+} PointerTargetRange;
+
+/**
+ * @brief State of one discovery pass
+ */
+typedef struct {
+    PointerTargetRange* ranges;   // Target regions sorted by address
+    int range_count;              // Number of target regions
+    uintptr_t lowest_address;     // Start of the first target region
+    uintptr_t highest_address;    // End of the last target region
+    PointedDexFile* found_files;  // Output array
+    int max_found;                // Capacity of found_files
+    int found_count;              // DEX files found so far
+    size_t target_checks_left;    // Target reads still allowed
+    uintptr_t rejected_targets[POINTER_TARGET_CACHE_SLOTS]; // Direct-mapped cache of rejected targets
+} PointerDiscoveryState;
+
+/**
+ * @brief Orders target ranges by start address for qsort
+ */
+static int compare_target_ranges(const void* left, const void* right) {
+    const PointerTargetRange* a = (const PointerTargetRange*)left;
+    const PointerTargetRange* b = (const PointerTargetRange*)right;
+    return (a->start_address > b->start_address) - (a->start_address < b->start_address);
+}
+
+/**
+ * @brief Marks the interned paths whose regions are never searched for pointers
+ * 
+ * @param table Region table
+ * @return Arena array with one entry per path id (1 = skipped), NULL if out of memory
+ */
+static unsigned char* mark_skipped_source_paths(const RegionTable* table) {
+    unsigned char* skipped_paths = scan_arena_alloc((size_t)table->paths.path_count + 1);
+    if (skipped_paths == NULL) return NULL;
+    
+    for (int path_id = 0; path_id < table->paths.path_count; path_id++) {
+        const char* path = table->paths.strings + table->paths.string_offsets[path_id];
+        for (size_t i = 0; i < sizeof(skipped_source_names) / sizeof(skipped_source_names[0]); i++) {
+            if (strstr(path, skipped_source_names[i])) {
+                skipped_paths[path_id] = 1;
+                break;
+            }
+        }
+    }
+    return skipped_paths;
+}
+
+/**
+ * @brief Checks whether a region's words are searched for pointers
+ */
+static int is_pointer_source_region(const RegionTable* table, int region_index,
+                                    const unsigned char* skipped_paths) {
+    uint16_t region_flags = table->flags[region_index];
+    if ((region_flags & (REGION_FLAG_READ | REGION_FLAG_WRITE)) != (REGION_FLAG_READ | REGION_FLAG_WRITE)) {
+        return 0;
+    }
+    
+    size_t region_size = table->end_addresses[region_index] - table->start_addresses[region_index];
+    if (region_size == 0 || region_size > POINTER_SCAN_MAX_REGION_SIZE) return 0;
+    return !skipped_paths[table->path_ids[region_index]];
+}
+
+/**
+ * @brief Checks whether a DEX found in a region may be dumped
+ * 
+ * Files mapped from system locations (boot class path, framework jars)
+ * have DexFile objects like any other DEX and are filtered here the same
+ * way the byte scan filters their regions. Anonymous memory is always
+ * accepted: that is where DEX files loaded from memory end up.
+ */
+static int is_pointer_target_region(const RegionTable* table, int region_index) {
+    uint16_t region_flags = table->flags[region_index];
+    if (!(region_flags & REGION_FLAG_READ)) return 0;
+    if (table->end_addresses[region_index] <= table->start_addresses[region_index]) return 0;
+    if (!should_enable_region_filtering() || !(region_flags & REGION_FLAG_FILE_BACKED)) return 1;
+    return !(region_flags & REGION_FLAG_EXCLUDED);
+}
+
+/**
+ * @brief Finds the target range containing an address
+ * 
+ * @return Matching range, NULL if the address is in no target region
+ */
+static const PointerTargetRange* find_target_range(const PointerDiscoveryState* state, uintptr_t address) {
+    int low = 0, high = state->range_count - 1;
+    while (low <= high) {
+        int middle = low + (high - low) / 2;
+        const PointerTargetRange* range = &state->ranges[middle];
+        if (address < range->start_address) {
+            high = middle - 1;
+        } else if (address >= range->end_address) {
+            low = middle + 1;
+        } else {
+            return range;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Checks whether a word holds a plausible DEX size
+ * 
+ * Only the low 32 bits are used: a 32-bit length next to a 64-bit
+ * pointer leaves padding (or the neighbouring field) in the upper half.
+ */
+static int is_plausible_dex_length(uint32_t length) {
+    return length >= DEX_MIN_FILE_SIZE && length <= DEX_MAX_FILE_SIZE;
+}
+
+/**
+ * @brief Follows a pointer word whose neighbours may hold the DEX length
+ * 
+ * @param state Discovery state
+ * @param pointer Word value treated as a pointer
+ * @param previous_length Low 32 bits of the word before it
+ * @param next_length Low 32 bits of the word after it
+ */
+static void check_pointer_candidate(PointerDiscoveryState* state, uintptr_t pointer,
+                                    uint32_t previous_length, uint32_t next_length) {
+    // Cheap rejections first: most words are no pointers, most pointers have no length beside them
+    if (pointer < state->lowest_address || pointer >= state->highest_address || (pointer & 3) != 0) return;
+    int previous_plausible = is_plausible_dex_length(previous_length);
+    int next_plausible = is_plausible_dex_length(next_length);
+    if (!previous_plausible && !next_plausible) return;
+    
+    const PointerTargetRange* range = find_target_range(state, pointer);
+    if (range == NULL) return;
+    size_t available = range->end_address - pointer;
+    if (available < DEX_HEADER_SIZE) return;
+    
+    size_t cache_slot = (pointer >> 2) % POINTER_TARGET_CACHE_SLOTS;
+    if (state->rejected_targets[cache_slot] == pointer) return;
+    for (int i = 0; i < state->found_count; i++) {
+        if ((uintptr_t)state->found_files[i].detection.dex_address == pointer) return;
+    }
+    
+    if (state->target_checks_left == 0) return;
+    state->target_checks_left--;
+    SCAN_STAT_ADD(pointer_targets_checked, 1);
+    
+    // The pointed-to header must carry the length found next to the pointer
+    unsigned char header_start[0x24];
+    uint32_t dex_file_size = 0;
+    if (!read_memory_safely((const void*)pointer, header_start, sizeof(header_start))) {
+        state->rejected_targets[cache_slot] = pointer;
+        return;
+    }
+    memcpy(&dex_file_size, header_start + 0x20, sizeof(dex_file_size));
+    if (memcmp(header_start, DEX_MAGIC_SIGNATURE, 4) != 0 ||
+        !((previous_plausible && previous_length == dex_file_size) ||
+          (next_plausible && next_length == dex_file_size)) ||
+        dex_file_size > available ||
+        !validate_dex_header_structure((const void*)pointer, available, 0)) {
+        state->rejected_targets[cache_slot] = pointer;
+        return;
+    }
+    
+    PointedDexFile* found_file = &state->found_files[state->found_count++];
+    memset(found_file, 0, sizeof(*found_file));
+    found_file->detection.dex_address = (void*)pointer;
+    found_file->detection.dex_size = dex_file_size;
+    found_file->detection.detector_name = "pointer";
+    found_file->detection.payload_encoding = PAYLOAD_ENCODING_PLAIN;
+    found_file->region_index = range->region_index;
+    SCAN_STAT_ADD(pointer_dex_found, 1);
+    
+    LOGI("Found DEX through pointer at %p (%u bytes)", (void*)pointer, dex_file_size);
+}
+
+/**
+ * @brief Searches the resident pages of one writable region for pointers
+ * 
+ * Each word is judged once its successor is known, so lengths stored on
+ * either side of a pointer are seen even across chunk boundaries.
+ * 
+ * @param state Discovery state
+ * @param region_start First byte of the region to search
+ * @param region_size Size of the region to search
+ * @param byte_budget In/out remaining resident bytes to search this pass
+ */
+static void scan_region_for_pointers(PointerDiscoveryState* state, const char* region_start,
+                                     size_t region_size, size_t* byte_budget) {
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    unsigned char residency[RESIDENCY_WINDOW_PAGES];
+    uintptr_t chunk_words[SCAN_CHUNK_SIZE / sizeof(uintptr_t)];
+    size_t window_size = RESIDENCY_WINDOW_PAGES * page_size;
+    
+    // Sliding window of three consecutive words; zero words never pass the checks
+    uintptr_t previous_word = 0, current_word = 0;
+    SCAN_STAT_ADD(pointer_regions_scanned, 1);
+    
+    for (size_t window_offset = 0; window_offset < region_size; window_offset += window_size) {
+        size_t window_length = region_size - window_offset < window_size ?
+                               region_size - window_offset : window_size;
+        size_t window_pages = (window_length + page_size - 1) / page_size;
+        if (mincore((void*)(region_start + window_offset), window_length, residency) != 0) {
+            memset(residency, 1, window_pages);
+        }
+        
+        for (size_t page = 0; page < window_pages; page++) {
+            if (!(residency[page] & 1)) {
+                // Pairs never span a page nobody wrote to
+                check_pointer_candidate(state, current_word, (uint32_t)previous_word, 0);
+                previous_word = current_word = 0;
+                continue;
+            }
+            
+            size_t page_offset = window_offset + page * page_size;
+            for (size_t chunk_offset = 0; chunk_offset < page_size; chunk_offset += sizeof(chunk_words)) {
+                if (*byte_budget < sizeof(chunk_words) || state->found_count >= state->max_found) return;
+                *byte_budget -= sizeof(chunk_words);
+                
+                if (!read_memory_safely(region_start + page_offset + chunk_offset,
+                                        chunk_words, sizeof(chunk_words))) {
+                    SCAN_STAT_ADD(read_faults, 1);
+                    previous_word = current_word = 0;
+                    break;
+                }
+                
+                for (size_t i = 0; i < sizeof(chunk_words) / sizeof(chunk_words[0]); i++) {
+                    check_pointer_candidate(state, current_word, (uint32_t)previous_word, (uint32_t)chunk_words[i]);
+                    if (state->found_count >= state->max_found) return;
+                    previous_word = current_word;
+                    current_word = chunk_words[i];
+                }
+            }
+        }
+    }
+    
+    check_pointer_candidate(state, current_word, (uint32_t)previous_word, 0);
+}
+
+/**
+ * @brief Scans writable regions for (pointer, length) pairs leading to DEX files
+ * 
+ * Target regions are sorted once so every candidate pointer costs a
+ * range check and a binary search; only pointers with a plausible length
+ * beside them have their target read.
+ * 
+ * @param region_table Regions of the current pass (self-owned ranges removed)
+ * @param found_files Output array for DEX files found
+ * @param max_found Capacity of found_files
+ * @return Number of DEX files found
+ */
+int discover_pointed_dex_files(const RegionTable* region_table, PointedDexFile* found_files, int max_found) {
+    int region_count = region_table->region_count;
+    if (region_count <= 0 || max_found <= 0) return 0;
+    
+    // Discovery state is only needed here: hand it back to the arena on return
+    ScanArenaMark arena_mark = scan_arena_mark();
+    PointerDiscoveryState* state = scan_arena_alloc(sizeof(PointerDiscoveryState));
+    if (state == NULL) return 0;
+    state->ranges = scan_arena_alloc((size_t)region_count * sizeof(PointerTargetRange));
+    unsigned char* skipped_paths = mark_skipped_source_paths(region_table);
+    if (state->ranges == NULL || skipped_paths == NULL) {
+        scan_arena_release_to(arena_mark);
+        return 0;
+    }
+    
+    for (int i = 0; i < region_count; i++) {
+        if (!is_pointer_target_region(region_table, i)) continue;
+        PointerTargetRange* range = &state->ranges[state->range_count++];
+        range->start_address = region_table->start_addresses[i];
+        range->end_address = region_table->end_addresses[i];
+        range->region_index = i;
+    }
+    if (state->range_count == 0) {
+        scan_arena_release_to(arena_mark);
+        return 0;
+    }
+    
+    qsort(state->ranges, (size_t)state->range_count, sizeof(PointerTargetRange), compare_target_ranges);
+    state->lowest_address = state->ranges[0].start_address;
+    state->highest_address = state->ranges[state->range_count - 1].end_address;
+    state->found_files = found_files;
+    state->max_found = max_found;
+    state->target_checks_left = MAX_POINTER_TARGET_CHECKS;
+    
+    size_t byte_budget = POINTER_SCAN_BYTE_BUDGET;
+    for (int i = 0; i < region_count && state->found_count < max_found && byte_budget > 0; i++) {
+        if (is_pointer_source_region(region_table, i, skipped_paths)) {
+            scan_region_for_pointers(state, (const char*)region_table->start_addresses[i],
+                                     region_table->end_addresses[i] - region_table->start_addresses[i],
+                                     &byte_budget);
+        }
+    }
+    
+    int found_count = state->found_count;
+    LOGI("Pointer discovery: %d DEX files, %zu target checks left, %zu bytes of budget left",
+         found_count, state->target_checks_left, byte_budget);
+    scan_arena_release_to(arena_mark);
+    return found_count;
+}
@@ -0,0 +1,32 @@
+#ifndef DEXDUMPER_POINTER_DISCOVERY_H
+#define DEXDUMPER_POINTER_DISCOVERY_H
+
+// Pointer discovery header - declares DEX discovery from (pointer, length) pairs
+
+#include "common.h"
+#include "config.h"
+#include "region_table.h"
+
+/**
+ * Pointer-Guided Discovery:
+ * 
+ * ART's native DexFile objects and most custom loaders keep the start and
+ * size of every DEX they load next to each other. Writable native memory
+ * holds far fewer words than the DEX files it points to span, so its
+ * pointer-aligned words are checked instead: a word that points into a
+ * readable mapping with a plausible DEX size in an adjacent word has its
+ * target read, and a DEX magic whose file_size matches that length is a
+ * hit. DEX files deep inside regions too large for the byte scan are
+ * found without scanning those regions.
+ */
+
+// A DEX found through a pointer and the region it lies in
+typedef struct {
+    DexDetectionResult detection; // Location and size of the DEX
+    int region_index;             // Index of the region holding the DEX in the region table
+} PointedDexFile;
+
+// Scans writable regions for (pointer, length) pairs leading to DEX files
+int discover_pointed_dex_files(const RegionTable* region_table, PointedDexFile* found_files, int max_found);
+
+#endif
@@ -0,0 +1,170 @@
+#include "protected_region_reader.h"
+#include "memory_scanner.h"
+#include "self_exclusion.h"
+#include "config_manager.h"
+#include "scan_statistics.h"
+#include "scan_arena.h"
+
+// Descriptor of /proc/self/mem, opened on first use
+static int process_memory_fd = -1;
+static pthread_mutex_t process_memory_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief Returns a descriptor of /proc/self/mem, opening it once
+ * 
+ * @return File descriptor, -1 if /proc/self/mem cannot be opened
+ */
+static int get_process_memory_fd(void) {
+    pthread_mutex_lock(&process_memory_mutex);
+    if (process_memory_fd < 0) {
+        process_memory_fd = open("/proc/self/mem", O_RDONLY | O_CLOEXEC);
+        if (process_memory_fd < 0) {
+            LOGW("Cannot open /proc/self/mem: %s", strerror(errno));
+        }
+    }
+    int memory_fd = process_memory_fd;
+    pthread_mutex_unlock(&process_memory_mutex);
+    return memory_fd;
+}
+
+/**
+ * @brief Checks whether a non-readable region is worth reading through /proc/self/mem
+ * 
+ * Readable regions go through the regular scan. File-backed mappings
+ * are skipped: their PROT_NONE parts are the gaps the linker leaves
+ * between library segments.
+ * 
+ * @param memory_region Region to check
+ * @return 1 if the region should be read, 0 otherwise
+ */
+int is_protected_region_candidate(const MemoryRegion* memory_region) {
+    if (!should_enable_protected_region_reads()) return 0;
+    if (strchr(memory_region->permissions, 'r') != NULL) return 0;
+    
+    size_t region_size = (char*)memory_region->end_address - (char*)memory_region->start_address;
+    if (memory_region->start_address >= memory_region->end_address ||
+        region_size < DEX_MIN_FILE_SIZE || region_size > PROTECTED_REGION_MAX_SIZE) {
+        return 0;
+    }
+    
+    return !is_file_backed_region(memory_region) && is_potential_dex_region(memory_region);
+}
+
+/**
+ * @brief Reads a run of resident pages with large aligned pread() calls
+ * 
+ * @param memory_fd Descriptor of /proc/self/mem
+ * @param source_address First byte of the run (page aligned)
+ * @param destination Copy destination
+ * @param run_size Size of the run in bytes
+ * @return Number of bytes read (a short count stops at the first failure)
+ */
+static size_t read_resident_run(int memory_fd, const char* source_address, char* destination, size_t run_size) {
+    size_t bytes_read = 0;
+    while (bytes_read < run_size) {
+        size_t request_size = run_size - bytes_read < PROC_MEM_READ_SIZE ?
+                              run_size - bytes_read : PROC_MEM_READ_SIZE;
+        // pread64: addresses above 2GB do not fit a 32-bit off_t
+        ssize_t result = pread64(memory_fd, destination + bytes_read, request_size,
+                                 (off64_t)(uintptr_t)(source_address + bytes_read));
+        if (result < 0 && errno == EINTR) continue;
+        if (result <= 0) break;
+        bytes_read += (size_t)result;
+    }
+    return bytes_read;
+}
+
+/**
+ * @brief Copies the resident pages of a non-readable region into a tracked buffer
+ * 
+ * Pages that are not resident were never written (or were reclaimed) and
+ * stay zero in the copy, so offsets in the copy match the region. The copy
+ * is only made if at least one page is resident.
+ * 
+ * @param memory_region Non-readable region
+ * @param output_buffer Output: tracked buffer holding the copy
+ * @param output_size Output: size of the copy (the region size)
+ * @return 1 if a copy was made, 0 otherwise
+ */
+int copy_protected_region(const MemoryRegion* memory_region, void** output_buffer, size_t* output_size) {
+    const char* region_start = (const char*)memory_region->start_address;
+    size_t region_size = (size_t)((const char*)memory_region->end_address - region_start);
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    size_t page_count = region_size / page_size;
+    
+    int memory_fd = get_process_memory_fd();
+    if (memory_fd < 0 || page_count == 0) return 0;
+    
+    ScanArenaMark arena_mark = scan_arena_mark();
+    unsigned char* residency = scan_arena_alloc(page_count);
+    if (residency == NULL) return 0;
+    if (mincore((void*)region_start, page_count * page_size, residency) != 0) {
+        VLOGD("mincore failed for protected region %p: %s", region_start, strerror(errno));
+        scan_arena_release_to(arena_mark);
+        return 0;
+    }
+    
+    size_t resident_pages = 0;
+    for (size_t page = 0; page < page_count; page++) {
+        if (residency[page] & 1) resident_pages++;
+    }
+    if (resident_pages == 0) {
+        SCAN_STAT_ADD(protected_regions_empty, 1);
+        scan_arena_release_to(arena_mark);
+        return 0;
+    }
+    
+    char* region_copy = allocate_tracked_buffer(region_size);
+    if (region_copy == NULL) {
+        scan_arena_release_to(arena_mark);
+        return 0;
+    }
+    
+    // Read each run of consecutive resident pages as one large request
+    size_t bytes_copied = 0;
+    for (size_t page = 0; page < page_count; ) {
+        if (!(residency[page] & 1)) {
+            page++;
+            continue;
+        }
+        size_t run_end = page;
+        while (run_end < page_count && (residency[run_end] & 1)) run_end++;
+        
+        size_t run_offset = page * page_size;
+        size_t run_size = (run_end - page) * page_size;
+        size_t run_read = read_resident_run(memory_fd, region_start + run_offset,
+                                            region_copy + run_offset, run_size);
+        bytes_copied += run_read;
+        if (run_read < run_size) {
+            VLOGD("Short read of protected region %p at offset %zu (%zu of %zu bytes)",
+                  region_start, run_offset, run_read, run_size);
+        }
+        page = run_end;
+    }
+    scan_arena_release_to(arena_mark);
+    
+    if (bytes_copied == 0) {
+        release_tracked_buffer(region_copy, region_size);
+        return 0;
+    }
+    
+    SCAN_STAT_ADD(protected_regions_read, 1);
+    SCAN_STAT_ADD(protected_bytes_read, bytes_copied);
+    LOGI("Read protected region %p-%p (%s) through /proc/self/mem: %zu resident bytes",
+         memory_region->start_address, memory_region->end_address,
+         memory_region->permissions, bytes_copied);
+    
+    *output_buffer = region_copy;
+    *output_size = region_size;
+    return 1;
+}
+
+/**
+ * @brief Releases a buffer returned by copy_protected_region
+ * 
+ * @param output_buffer Buffer to release
+ * @param output_size Size returned with the buffer
+ */
+void release_protected_region_copy(void* output_buffer, size_t output_size) {
+    release_tracked_buffer(output_buffer, output_size);
+}
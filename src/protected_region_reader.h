@@ -0,0 +1,32 @@
+#ifndef DEXDUMPER_PROTECTED_REGION_READER_H
+#define DEXDUMPER_PROTECTED_REGION_READER_H
+
+// Protected region reader header - declares /proc/self/mem access to non-readable mappings
+
+#include "common.h"
+#include "config.h"
+
+/**
+ * Protected Region Support:
+ * 
+ * Some protectors mprotect a decrypted DEX to PROT_NONE between uses so
+ * in-process scanners fault on it. The kernel still lets a process read
+ * its own non-readable mappings through /proc/self/mem without changing
+ * their protection or raising a signal. Candidate regions are limited to
+ * anonymous, high-priority mappings below PROTECTED_REGION_MAX_SIZE, and
+ * only pages mincore() reports as resident are read, so reserved address
+ * space (guard pages, heap reservations) costs a single mincore() call.
+ * The resident pages are copied into a tracked buffer with large aligned
+ * pread() calls and that copy goes through regular detection.
+ */
+
+// Checks whether a non-readable region is worth reading through /proc/self/mem
+int is_protected_region_candidate(const MemoryRegion* memory_region);
+
+// Copies the resident pages of a non-readable region into a tracked buffer
+int copy_protected_region(const MemoryRegion* memory_region, void** output_buffer, size_t* output_size);
+
+// Releases a buffer returned by copy_protected_region
+void release_protected_region_copy(void* output_buffer, size_t output_size);
+
+#endif
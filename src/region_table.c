@@ -0,0 +1,398 @@
+#include "region_table.h"
+#include "memory_scanner.h"
+#include "art_heap_walker.h"
+#include "config_manager.h"
+#include "scan_arena.h"
+
+/**
+ * @brief Hashes a path for the pool index (FNV-1a)
+ */
+static uint32_t hash_region_path(const char* path) {
+    uint32_t hash = 2166136261u;
+    for (const unsigned char* p = (const unsigned char*)path; *p; p++) {
+        hash = (hash ^ *p) * 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * @brief Classifies a path once, with the same rules the per-region checks apply
+ * 
+ * @param path Region path
+ * @return REGION_PATH_FLAGS bits of the path
+ */
+static uint16_t classify_region_path(const char* path) {
+    MemoryRegion path_region;
+    memset(&path_region, 0, sizeof(path_region));
+    snprintf(path_region.path_name, sizeof(path_region.path_name), "%s", path);
+    // Any inode: is_file_backed_region() then judges the path alone
+    path_region.inode_number = 1;
+    
+    uint16_t path_flags = 0;
+    if (path[0] == '\0') path_flags |= REGION_FLAG_UNNAMED;
+    if (is_excluded_system_region(&path_region)) path_flags |= REGION_FLAG_EXCLUDED;
+    if (is_potential_dex_region(&path_region)) path_flags |= REGION_FLAG_POTENTIAL_DEX;
+    if (!is_file_backed_region(&path_region)) path_flags |= REGION_FLAG_NOT_ON_DISK;
+    
+    ArtHeapSpaceKind space_kind = classify_art_heap_region(&path_region);
+    if (space_kind == ART_HEAP_SPACE_OBJECTS) path_flags |= REGION_FLAG_HEAP_OBJECTS;
+    if (space_kind == ART_HEAP_SPACE_LARGE_OBJECTS) path_flags |= REGION_FLAG_HEAP_LARGE;
+    return path_flags;
+}
+
+/**
+ * @brief Sizes the path pool for a known upper bound of paths and path bytes
+ * 
+ * Nothing in the pool grows afterwards, so every array is allocated once.
+ * 
+ * @return 1 on success, 0 if the arena ran out of memory
+ */
+static int init_path_pool(RegionPathPool* pool, int max_paths, size_t max_string_bytes) {
+    int slot_count = 256;
+    while (slot_count < max_paths * 2) slot_count *= 2;
+    
+    pool->strings = scan_arena_alloc(max_string_bytes);
+    pool->string_offsets = scan_arena_alloc((size_t)max_paths * sizeof(uint32_t));
+    pool->path_flags = scan_arena_alloc((size_t)max_paths * sizeof(uint16_t));
+    pool->hash_slots = scan_arena_alloc((size_t)slot_count * sizeof(int32_t));
+    if (!pool->strings || !pool->string_offsets || !pool->path_flags || !pool->hash_slots) return 0;
+    
+    memset(pool->hash_slots, 0xff, (size_t)slot_count * sizeof(int32_t));
+    pool->strings_capacity = max_string_bytes;
+    pool->path_capacity = max_paths;
+    pool->hash_slot_count = slot_count;
+    return 1;
+}
+
+/**
+ * @brief Returns the id of a path, adding and classifying it if it is new
+ * 
+ * @param pool Path pool sized by init_path_pool()
+ * @param path Path to intern (already cut to MAX_REGION_NAME - 1 bytes)
+ * @return Path id, -1 if the pool is full
+ */
+static int intern_region_path(RegionPathPool* pool, const char* path) {
+    uint32_t slot_mask = (uint32_t)(pool->hash_slot_count - 1);
+    uint32_t slot = hash_region_path(path) & slot_mask;
+    for (; pool->hash_slots[slot] >= 0; slot = (slot + 1) & slot_mask) {
+        int path_id = pool->hash_slots[slot];
+        if (strcmp(pool->strings + pool->string_offsets[path_id], path) == 0) return path_id;
+    }
+    
+    size_t path_length = strlen(path) + 1;
+    if (pool->path_count == pool->path_capacity ||
+        pool->strings_size + path_length > pool->strings_capacity) {
+        return -1;
+    }
+    
+    int path_id = pool->path_count++;
+    memcpy(pool->strings + pool->strings_size, path, path_length);
+    pool->string_offsets[path_id] = (uint32_t)pool->strings_size;
+    pool->strings_size += path_length;
+    pool->path_flags[path_id] = classify_region_path(path);
+    pool->hash_slots[slot] = path_id;
+    return path_id;
+}
+
+/**
+ * @brief Allocates every per-region array for a fixed number of regions
+ * 
+ * @return 1 on success, 0 if the arena ran out of memory
+ */
+static int allocate_region_entries(RegionTable* table, int region_capacity) {
+    size_t count = region_capacity > 0 ? (size_t)region_capacity : 1;
+    table->start_addresses = scan_arena_alloc(count * sizeof(*table->start_addresses));
+    table->end_addresses = scan_arena_alloc(count * sizeof(*table->end_addresses));
+    table->flags = scan_arena_alloc(count * sizeof(*table->flags));
+    table->path_ids = scan_arena_alloc(count * sizeof(*table->path_ids));
+    table->inode_numbers = scan_arena_alloc(count * sizeof(*table->inode_numbers));
+    table->file_offsets = scan_arena_alloc(count * sizeof(*table->file_offsets));
+    table->device_numbers = scan_arena_alloc(count * sizeof(*table->device_numbers));
+    table->region_capacity = region_capacity;
+    return table->start_addresses && table->end_addresses && table->flags && table->path_ids &&
+           table->inode_numbers && table->file_offsets && table->device_numbers;
+}
+
+/**
+ * @brief Converts a permission string of /proc/self/maps to region flags
+ */
+static uint16_t parse_permission_flags(const char* permissions) {
+    uint16_t permission_flags = 0;
+    if (permissions[0] == 'r') permission_flags |= REGION_FLAG_READ;
+    if (permissions[1] == 'w') permission_flags |= REGION_FLAG_WRITE;
+    if (permissions[2] == 'x') permission_flags |= REGION_FLAG_EXECUTE;
+    if (permissions[3] == 's') permission_flags |= REGION_FLAG_SHARED;
+    return permission_flags;
+}
+
+/**
+ * @brief Reads all of /proc/self/maps into one NUL-terminated arena buffer
+ * 
+ * Nothing else is allocated while reading, so the buffer grows in place.
+ * 
+ * @param text_size Output: length of the text
+ * @return Maps text, NULL on failure
+ */
+static char* read_process_maps(size_t* text_size) {
+    int maps_fd = open("/proc/self/maps", O_RDONLY | O_CLOEXEC);
+    if (maps_fd < 0) {
+        LOGE("Failed to open process memory maps: %s", strerror(errno));
+        return NULL;
+    }
+    
+    size_t capacity = MAPS_READ_SIZE;
+    size_t size = 0;
+    char* text = scan_arena_alloc(capacity);
+    while (text) {
+        if (capacity - size < MAPS_READ_SIZE / 2) {
+            text = scan_arena_grow(text, capacity, capacity * 2);
+            capacity *= 2;
+            if (!text) break;
+        }
+        ssize_t bytes_read = read(maps_fd, text + size, capacity - size - 1);
+        if (bytes_read < 0 && errno == EINTR) continue;
+        if (bytes_read <= 0) break;
+        size += (size_t)bytes_read;
+    }
+    close(maps_fd);
+    
+    if (!text) {
+        LOGE("Memory allocation failed for process memory maps");
+        return NULL;
+    }
+    text[size] = '\0';
+    *text_size = size;
+    return text;
+}
+
+/**
+ * @brief Parses /proc/self/maps into a region table
+ * 
+ * The maps text is read whole, so its line count bounds the number of
+ * regions and distinct paths and its size bounds the path bytes: every
+ * array is allocated once, from the scan arena, at its final size. The
+ * table is valid until end_scan_arena().
+ * 
+ * The whole path is kept, including a " (deleted)" suffix, cut to
+ * MAX_REGION_NAME - 1 bytes like MemoryRegion.path_name.
+ * 
+ * @param table Table to fill
+ * @return Number of memory regions found, 0 on error
+ */
+int build_region_table(RegionTable* table) {
+    memset(table, 0, sizeof(*table));
+    
+    size_t text_size = 0;
+    char* maps_text = read_process_maps(&text_size);
+    if (!maps_text) return 0;
+    
+    int line_count = 1;
+    for (const char* p = maps_text; (p = strchr(p, '\n')) != NULL; p++) line_count++;
+    
+    if (!allocate_region_entries(table, line_count) ||
+        !init_path_pool(&table->paths, line_count, text_size + 1)) {
+        LOGE("Memory allocation failed for region table");
+        memset(table, 0, sizeof(*table));
+        return 0;
+    }
+    
+    char* next_line = maps_text;
+    while (next_line && *next_line && table->region_count < table->region_capacity) {
+        char* map_line = next_line;
+        next_line = strchr(map_line, '\n');
+        if (next_line) *next_line++ = '\0';
+        
+        // Format: start-end permissions offset dev:dev inode pathname
+        void* start_address = NULL;
+        void* end_address = NULL;
+        char permissions[5] = {0};
+        unsigned long file_offset = 0;
+        unsigned int device_major = 0, device_minor = 0;
+        unsigned long inode_number = 0;
+        int path_position = 0;
+        int field_count = sscanf(map_line, "%p-%p %4s %lx %x:%x %lu %n",
+                                 &start_address, &end_address, permissions, &file_offset,
+                                 &device_major, &device_minor, &inode_number, &path_position);
+        if (field_count < 7) continue;
+        
+        char* path = map_line + path_position;
+        if (strlen(path) >= MAX_REGION_NAME) path[MAX_REGION_NAME - 1] = '\0';
+        
+        int path_id = intern_region_path(&table->paths, path);
+        if (path_id < 0) break;
+        
+        int region_index = table->region_count++;
+        uint16_t region_flags = parse_permission_flags(permissions) | table->paths.path_flags[path_id];
+        if (inode_number != 0 && !(region_flags & REGION_FLAG_NOT_ON_DISK)) {
+            region_flags |= REGION_FLAG_FILE_BACKED;
+        }
+        table->start_addresses[region_index] = (uintptr_t)start_address;
+        table->end_addresses[region_index] = (uintptr_t)end_address;
+        table->flags[region_index] = region_flags;
+        table->path_ids[region_index] = (uint32_t)path_id;
+        table->inode_numbers[region_index] = (ino_t)inode_number;
+        table->file_offsets[region_index] = (off_t)file_offset;
+        table->device_numbers[region_index] = (device_major << 20) | (device_minor & 0xfffff);
+    }
+    
+    LOGI("Successfully parsed %d memory regions (%d distinct paths, %zu path bytes)",
+         table->region_count, table->paths.path_count, table->paths.strings_size);
+    return table->region_count;
+}
+
+/**
+ * @brief Removes sorted, non-overlapping address ranges from every region of the table
+ * 
+ * A region overlapping a range is cut around it: the parts before and
+ * after survive as separate regions with adjusted file offsets, so a
+ * range can split one region in two. The clipped arrays are new arena
+ * allocations; the path pool is kept.
+ * 
+ * @param table Table to clip in place
+ * @param range_starts Range starts, ascending
+ * @param range_ends Range ends (exclusive)
+ * @param range_count Number of ranges
+ * @return Number of regions that lost at least one byte
+ */
+int clip_region_table(RegionTable* table, const uintptr_t* range_starts, const uintptr_t* range_ends,
+                      int range_count) {
+    if (range_count == 0 || table->region_count == 0) return 0;
+    
+    // Each range can split at most one region into two
+    RegionTable clipped;
+    memset(&clipped, 0, sizeof(clipped));
+    if (!allocate_region_entries(&clipped, table->region_count + range_count)) {
+        LOGE("Memory allocation failed while clipping the region table");
+        return 0;
+    }
+
+#define APPEND_CLIPPED_REGION(piece_start, piece_end) do { \
+        int piece = clipped.region_count++; \
+        clipped.start_addresses[piece] = (piece_start); \
+        clipped.end_addresses[piece] = (piece_end); \
+        clipped.flags[piece] = table->flags[i]; \
+        clipped.path_ids[piece] = table->path_ids[i]; \
+        clipped.inode_numbers[piece] = table->inode_numbers[i]; \
+        clipped.file_offsets[piece] = table->file_offsets[i] + (off_t)((piece_start) - region_start); \
+        clipped.device_numbers[piece] = table->device_numbers[i]; \
+    } while (0)
+    
+    int clipped_regions = 0;
+    for (int i = 0; i < table->region_count; i++) {
+        uintptr_t region_start = table->start_addresses[i];
+        uintptr_t region_end = table->end_addresses[i];
+        uintptr_t cursor = region_start;
+        int clipped_region = 0;
+        
+        for (int j = 0; j < range_count && cursor < region_end; j++) {
+            if (range_ends[j] <= cursor || range_starts[j] >= region_end) continue;
+            
+            clipped_region = 1;
+            if (range_starts[j] > cursor && clipped.region_count < clipped.region_capacity) {
+                APPEND_CLIPPED_REGION(cursor, range_starts[j]);
+            }
+            cursor = range_ends[j];
+        }
+        
+        if (cursor < region_end && clipped.region_count < clipped.region_capacity) {
+            APPEND_CLIPPED_REGION(cursor, region_end);
+        }
+        clipped_regions += clipped_region;
+    }
+#undef APPEND_CLIPPED_REGION
+    
+    clipped.paths = table->paths;
+    *table = clipped;
+    return clipped_regions;
+}
+
+/**
+ * @brief Collects the indices of the regions a scanning pass should look at
+ * 
+ * Applies the permission, size and path rules of should_scan_memory_region()
+ * (or is_protected_region_candidate() for REGION_SELECT_PROTECTED) to the
+ * packed flags. Reading the region to test access is left to the caller.
+ * 
+ * @param table Region table
+ * @param selection Which regions to collect
+ * @param selected_indices Output, room for table->region_count indices
+ * @return Number of regions selected
+ */
+int select_table_regions(const RegionTable* table, RegionSelection selection, int* selected_indices) {
+    uint16_t required_mask, required_flags;
+    size_t size_limit = MAX_REGION_SIZE;
+    size_t extended_limit = ART_HEAP_MAX_REGION_SIZE;
+    uint16_t extended_flags = should_enable_art_heap_walk() ? (REGION_FLAG_HEAP_OBJECTS | REGION_FLAG_HEAP_LARGE) : 0;
+    uint16_t excluded_flags = should_enable_region_filtering() ? REGION_FLAG_EXCLUDED : 0;
+    
+    switch (selection) {
+    case REGION_SELECT_PRIORITY:
+        required_mask = REGION_FLAG_READ | REGION_FLAG_POTENTIAL_DEX | excluded_flags;
+        required_flags = REGION_FLAG_READ | REGION_FLAG_POTENTIAL_DEX;
+        break;
+    case REGION_SELECT_REMAINING:
+        required_mask = REGION_FLAG_READ | REGION_FLAG_POTENTIAL_DEX | excluded_flags;
+        required_flags = REGION_FLAG_READ;
+        break;
+    case REGION_SELECT_PROTECTED:
+    default:
+        if (!should_enable_protected_region_reads()) return 0;
+        required_mask = REGION_FLAG_READ | REGION_FLAG_POTENTIAL_DEX | REGION_FLAG_FILE_BACKED;
+        required_flags = REGION_FLAG_POTENTIAL_DEX;
+        size_limit = PROTECTED_REGION_MAX_SIZE;
+        extended_flags = 0;
+        break;
+    }
+    
+    // Branch-free: every index is written, only the selected ones are kept
+    const uint16_t* flags = table->flags;
+    const uintptr_t* start_addresses = table->start_addresses;
+    const uintptr_t* end_addresses = table->end_addresses;
+    int selected_count = 0;
+    for (int i = 0; i < table->region_count; i++) {
+        uint16_t region_flags = flags[i];
+        size_t region_size = end_addresses[i] - start_addresses[i];
+        size_t region_limit = (region_flags & extended_flags) ? extended_limit : size_limit;
+        int selected = (region_flags & required_mask) == required_flags &&
+                       end_addresses[i] > start_addresses[i] &&
+                       region_size >= DEX_MIN_FILE_SIZE && region_size <= region_limit;
+        selected_indices[selected_count] = i;
+        selected_count += selected;
+    }
+    return selected_count;
+}
+
+/**
+ * @brief Returns the interned path of a region
+ * 
+ * @param table Region table
+ * @param region_index Region to look up
+ * @return Path, empty string for unnamed regions
+ */
+const char* get_table_region_path(const RegionTable* table, int region_index) {
+    return table->paths.strings + table->paths.string_offsets[table->path_ids[region_index]];
+}
+
+/**
+ * @brief Builds the full MemoryRegion of one table entry
+ * 
+ * @param table Region table
+ * @param region_index Region to expand
+ * @param memory_region Output region
+ */
+void get_table_region(const RegionTable* table, int region_index, MemoryRegion* memory_region) {
+    uint16_t region_flags = table->flags[region_index];
+    memory_region->start_address = (void*)table->start_addresses[region_index];
+    memory_region->end_address = (void*)table->end_addresses[region_index];
+    memory_region->permissions[0] = (region_flags & REGION_FLAG_READ) ? 'r' : '-';
+    memory_region->permissions[1] = (region_flags & REGION_FLAG_WRITE) ? 'w' : '-';
+    memory_region->permissions[2] = (region_flags & REGION_FLAG_EXECUTE) ? 'x' : '-';
+    memory_region->permissions[3] = (region_flags & REGION_FLAG_SHARED) ? 's' : 'p';
+    memory_region->permissions[4] = '\0';
+    memory_region->file_offset = table->file_offsets[region_index];
+    memory_region->device_major = table->device_numbers[region_index] >> 20;
+    memory_region->device_minor = table->device_numbers[region_index] & 0xfffff;
+    memory_region->inode_number = table->inode_numbers[region_index];
+    snprintf(memory_region->path_name, sizeof(memory_region->path_name), "%s",
+             get_table_region_path(table, region_index));
+}
@@ -0,0 +1,96 @@
+#ifndef DEXDUMPER_REGION_TABLE_H
+#define DEXDUMPER_REGION_TABLE_H
+
+// Region table header - declares the compact table of memory regions and its path pool
+
+#include "common.h"
+#include "config.h"
+
+/**
+ * Region Table:
+ * 
+ * A process can have tens of thousands of mappings, and a MemoryRegion
+ * array spends most of its 300 bytes per entry on an inline, mostly
+ * empty path. The region table keeps the fields the filter passes read
+ * (addresses and flags) in parallel arrays and stores every distinct
+ * path once in a pool. Each path is classified once when interned (system
+ * exclusion, DEX potential, heap space kind, on disk or not) and those
+ * bits are folded into the region's flags together with its permissions,
+ * so selecting the regions of a pass reads a few bytes per region and no
+ * strings. A full MemoryRegion is only built for regions that are
+ * actually scanned. All arrays live in the scan arena (scan_arena.h)
+ * and are released with it at the end of the pass.
+ */
+
+// Region flags: permissions
+#define REGION_FLAG_READ           0x0001  // Mapped readable
+#define REGION_FLAG_WRITE          0x0002  // Mapped writable
+#define REGION_FLAG_EXECUTE        0x0004  // Mapped executable
+#define REGION_FLAG_SHARED         0x0008  // Shared rather than private mapping
+
+// Region flags: classification of the path (computed once per distinct path)
+#define REGION_FLAG_UNNAMED        0x0010  // No path at all
+#define REGION_FLAG_EXCLUDED       0x0020  // Matches the system region exclusion patterns
+#define REGION_FLAG_POTENTIAL_DEX  0x0040  // High-priority region for the first pass
+#define REGION_FLAG_NOT_ON_DISK    0x0080  // memfd or deleted file
+#define REGION_FLAG_HEAP_OBJECTS   0x0100  // ART heap space of regular objects
+#define REGION_FLAG_HEAP_LARGE     0x0200  // ART large object space
+
+// Region flags: per region
+#define REGION_FLAG_FILE_BACKED    0x0400  // Maps a file that still exists on disk
+
+// Flags that come from the path rather than the mapping
+#define REGION_PATH_FLAGS (REGION_FLAG_UNNAMED | REGION_FLAG_EXCLUDED | REGION_FLAG_POTENTIAL_DEX | \
+                           REGION_FLAG_NOT_ON_DISK | REGION_FLAG_HEAP_OBJECTS | REGION_FLAG_HEAP_LARGE)
+
+// Interned region paths, each stored once with its classification
+typedef struct {
+    char* strings;            // NUL-terminated paths, back to back
+    size_t strings_size;      // Bytes used in strings
+    size_t strings_capacity;  // Bytes allocated for strings
+    uint32_t* string_offsets; // Offset of path i in strings
+    uint16_t* path_flags;     // REGION_PATH_FLAGS of path i
+    int path_count;           // Number of distinct paths
+    int path_capacity;        // Entries allocated in the per-path arrays
+    int32_t* hash_slots;      // Open-addressing index of path ids, -1 if empty
+    int hash_slot_count;      // Power of two, at least twice path_count
+} RegionPathPool;
+
+// Memory regions of the process, one array per field
+typedef struct {
+    int region_count;          // Number of regions
+    int region_capacity;       // Entries allocated in every array
+    uintptr_t* start_addresses; // First byte of region i
+    uintptr_t* end_addresses;  // One past the last byte of region i
+    uint16_t* flags;           // REGION_FLAG_* of region i
+    uint32_t* path_ids;        // Interned path of region i
+    ino_t* inode_numbers;      // Inode of the backing file of region i
+    off_t* file_offsets;       // Offset in the backing file of region i
+    uint32_t* device_numbers;  // Major (high 12 bits) and minor (low 20 bits) device of region i
+    RegionPathPool paths;      // Paths shared by all regions
+} RegionTable;
+
+// Regions picked by select_table_regions
+typedef enum {
+    REGION_SELECT_PRIORITY = 0, // Scannable high-priority regions (first pass)
+    REGION_SELECT_REMAINING,    // Scannable regions of no particular priority (second pass)
+    REGION_SELECT_PROTECTED     // Non-readable regions read through /proc/self/mem
+} RegionSelection;
+
+// Parses /proc/self/maps into a region table
+int build_region_table(RegionTable* table);
+
+// Removes sorted, non-overlapping address ranges from every region of the table
+int clip_region_table(RegionTable* table, const uintptr_t* range_starts, const uintptr_t* range_ends,
+                      int range_count);
+
+// Collects the indices of the regions a scanning pass should look at
+int select_table_regions(const RegionTable* table, RegionSelection selection, int* selected_indices);
+
+// Builds the full MemoryRegion of one table entry
+void get_table_region(const RegionTable* table, int region_index, MemoryRegion* memory_region);
+
+// Returns the interned path of a region
+const char* get_table_region_path(const RegionTable* table, int region_index);
+
+#endif
@@ -1,5 +1,8 @@
 #include "registry_manager.h"
 #include "config_manager.h"
+#include "self_exclusion.h"
+#include "io_engine.h"
+#include "content_hash.h"
 
 // Global registry state - tracks all dumped files to prevent duplicates
 DumpedFileInfo* dumped_files_registry = NULL;
@@ -45,7 +48,8 @@ int is_checksum_already_dumped(const uint8_t *sha1_digest) {
     
     // Search for matching SHA1 digest
     for (int i = 0; i < dumped_files_count; i++) {
-        if (compare_sha1_digests(dumped_files_registry[i].sha1_digest, sha1_digest)) {
+        if (dumped_files_registry[i].has_sha1 &&
+            compare_sha1_digests(dumped_files_registry[i].sha1_digest, sha1_digest)) {
             pthread_mutex_unlock(&dump_registry_mutex);
             VLOGD("Duplicate DEX file detected by SHA1 checksum");
             return 1; // Duplicate content found
@@ -56,6 +60,30 @@ int is_checksum_already_dumped(const uint8_t *sha1_digest) {
     return 0; // New content
 }
 
+/**
+ * @brief Checks if content has been dumped based on its tree hash content ID
+ * 
+ * Only entries of dumps identified by the tree hash carry a content ID.
+ * 
+ * @param content_id CONTENT_ID_SIZE-byte content ID to check
+ * @return 1 if duplicate content found, 0 if new content
+ */
+int is_content_id_already_dumped(const uint8_t *content_id) {
+    pthread_mutex_lock(&dump_registry_mutex);
+    
+    for (int i = 0; i < dumped_files_count; i++) {
+        if (dumped_files_registry[i].has_content_id &&
+            memcmp(dumped_files_registry[i].content_id, content_id, CONTENT_ID_SIZE) == 0) {
+            pthread_mutex_unlock(&dump_registry_mutex);
+            VLOGD("Duplicate DEX file detected by content ID");
+            return 1;
+        }
+    }
+    
+    pthread_mutex_unlock(&dump_registry_mutex);
+    return 0;
+}
+
 /**
  * @brief Registers a dumped file in the global registry
  * 
@@ -64,10 +92,11 @@ int is_checksum_already_dumped(const uint8_t *sha1_digest) {
  * 
  * @param file_inode Inode number of dumped file (0 if unknown)
  * @param file_path File path where content was saved
- * @param sha1_digest 20-byte SHA1 hash of file content
+ * @param sha1_digest 20-byte SHA1 hash of file content, NULL if it was never computed
+ * @param content_id Tree hash content ID of the content, NULL if it is identified by SHA1
  */
 void register_dumped_file_with_checksum(ino_t file_inode, const char* file_path, 
-                                      const uint8_t *sha1_digest) {
+                                      const uint8_t *sha1_digest, const uint8_t *content_id) {
     pthread_mutex_lock(&dump_registry_mutex);
     
     // Handle registry capacity limits
@@ -103,15 +132,26 @@ void register_dumped_file_with_checksum(ino_t file_inode, const char* file_path,
             sizeof(dumped_files_registry[0].file_path) - 1);
     dumped_files_registry[dumped_files_count].file_path[sizeof(dumped_files_registry[0].file_path) - 1] = '\0';
     
-    // Copy SHA1 digest
-    memcpy(dumped_files_registry[dumped_files_count].sha1_digest, sha1_digest, 20);
+    // Copy SHA1 digest, if it was computed
+    dumped_files_registry[dumped_files_count].has_sha1 = sha1_digest != NULL;
+    if (sha1_digest) {
+        memcpy(dumped_files_registry[dumped_files_count].sha1_digest, sha1_digest, 20);
+    }
+    dumped_files_registry[dumped_files_count].has_content_id = content_id != NULL;
+    if (content_id) {
+        memcpy(dumped_files_registry[dumped_files_count].content_id, content_id, CONTENT_ID_SIZE);
+    }
     dumped_files_count++;
     
     // Log registration for debugging
-    char sha1_hex[41];
-    sha1_to_hex_string(sha1_digest, sha1_hex, sizeof(sha1_hex));
-    VLOGD("Registered dumped file: inode %lu, SHA1: %s, total count: %d", 
-          file_inode, sha1_hex, dumped_files_count);
+    char key_hex[CONTENT_ID_SIZE * 2 + 1];
+    if (content_id) {
+        content_id_to_hex_string(content_id, key_hex, sizeof(key_hex));
+    } else {
+        sha1_to_hex_string(sha1_digest, key_hex, sizeof(key_hex));
+    }
+    VLOGD("Registered dumped file: inode %lu, %s: %s, total count: %d", 
+          file_inode, content_id ? "content ID" : "SHA1", key_hex, dumped_files_count);
     
     pthread_mutex_unlock(&dump_registry_mutex);
 }
@@ -148,17 +188,75 @@ int is_sha1_excluded(const uint8_t* sha1_digest) {
     return 0; // Not found in exclusion list
 }
 
+/**
+ * @brief Checks if a tree hash content ID is in the exclusion list
+ * 
+ * Dumps identified by the tree hash are matched here rather than by
+ * SHA1, which they would otherwise need just for this check.
+ * 
+ * @param content_id CONTENT_ID_SIZE-byte content ID to check
+ * @return 1 if excluded, 0 if not found in exclusion list
+ */
+int is_content_id_excluded(const uint8_t* content_id) {
+    int excluded_count = 0;
+    const char** excluded_content_id_hex = get_excluded_content_id_list(&excluded_count);
+    if (excluded_count == 0) return 0;
+    
+    char input_content_id_hex[CONTENT_ID_SIZE * 2 + 1];
+    content_id_to_hex_string(content_id, input_content_id_hex, sizeof(input_content_id_hex));
+    for (int i = 0; i < excluded_count; i++) {
+        if (strcasecmp(input_content_id_hex, excluded_content_id_hex[i]) == 0) {
+            LOGI("Skipping excluded DEX (content ID: %.8s...)", input_content_id_hex);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Hashing state of one dump file streamed from disk
+typedef struct {
+    sha1_context sha1_ctx;  // Running SHA1 of the file
+    int header_checked;     // First chunk seen
+    int header_valid;       // First chunk starts with a DEX (or ELF) magic
+} DumpHashStream;
+
+/**
+ * @brief Hashes one chunk of a dump file, checking its magic on the first chunk
+ * 
+ * @return 1 to keep streaming, 0 once the file turned out not to be a dump
+ */
+static int hash_dump_file_chunk(const uint8_t* chunk, size_t chunk_size, void* handler_context) {
+    DumpHashStream* hash_stream = handler_context;
+    if (!hash_stream->header_checked) {
+        hash_stream->header_checked = 1;
+        // A file too small for a header, or without the DEX (or ELF) magic, is not hashed
+        if (chunk_size < DEX_HEADER_SIZE ||
+            (memcmp(chunk, "dex\n", 4) != 0 && memcmp(chunk, "\177ELF", 4) != 0)) {
+            return 0;
+        }
+        hash_stream->header_valid = 1;
+    }
+    sha1_update(&hash_stream->sha1_ctx, chunk, chunk_size);
+    return 1;
+}
+
 /**
  * @brief Checks if a DEX file with the same SHA1 already exists in the output directory
  * 
  * This function scans through all files in the output directory to find duplicate DEX files.
- * This prevents unnecessary SHA1 computation for non-DEX files and large files.
+ * Only files of the dump's exact size are hashed, and the dump's own
+ * SHA1 is computed on the first such file, so a dump with no file of
+ * its size in the directory is never run through SHA1 here.
  * 
  * @param output_directory Path to the directory where DEX files are stored
- * @param sha1_digest The 20-byte SHA1 hash of the DEX file we want to check
+ * @param data_buffer Content of the dump we want to check
+ * @param data_size Size of the dump
+ * @param sha1_digest The 20-byte SHA1 hash of the dump, filled in if *has_sha1 is 0 and it is needed
+ * @param has_sha1 Set if sha1_digest is valid, set by this function once it computes it
  * @return 1 if a duplicate file is found, 0 if the file is unique
  */
-int is_sha1_duplicate_in_directory(const char* output_directory, const uint8_t* sha1_digest) {
+int is_sha1_duplicate_in_directory(const char* output_directory, const void* data_buffer, size_t data_size,
+                                   uint8_t* sha1_digest, int* has_sha1) {
     // Try to open the output directory
     DIR* directory_handle = opendir(output_directory);
     if (!directory_handle) {
@@ -167,103 +265,90 @@ int is_sha1_duplicate_in_directory(const char* output_directory, const uint8_t*
         LOGE("Failed to open directory for duplicate check: %s", output_directory);
         return 0;
     }
-
+    
     struct dirent* directory_entry;
     int duplicate_found = 0;
     
-    // Convert the binary SHA1 to readable hex string for logging
-    char input_sha1_hex[41];
-    sha1_to_hex_string(sha1_digest, input_sha1_hex, sizeof(input_sha1_hex));
-    
-    // Buffer to read and check DEX file header
-    uint8_t dex_header[DEX_HEADER_SIZE];
+    // Tracked read window - file contents must not land in untracked heap memory
+    uint8_t* read_window = allocate_tracked_buffer(FILE_READ_WINDOW_SIZE);
+    if (!read_window) {
+        closedir(directory_handle);
+        return 0;
+    }
     
     // Loop through each file in the directory
     while ((directory_entry = readdir(directory_handle)) != NULL && !duplicate_found) {
         // Skip the special directory entries "." and ".."
         if (strcmp(directory_entry->d_name, ".") == 0 || 
             strcmp(directory_entry->d_name, "..") == 0) continue;
-
+        
         char* filename = directory_entry->d_name;
         
-        // QUICK FILTER: Only process files with ".dex" extension
-        // Check if filename ends with exactly ".dex" (4 characters)
-        char* dot_dex = strstr(filename, ".dex");
-        if (!dot_dex || strlen(dot_dex) != 4) {
+        // QUICK FILTER: Only process dumps (".dex" files, or ".so" native libraries)
+        // Check if filename ends with exactly ".dex" (4 characters) or ".so" (3 characters)
+        char* dot_dex = strrchr(filename, '.');
+        if (!dot_dex || (strcmp(dot_dex, ".dex") != 0 && strcmp(dot_dex, ".so") != 0)) {
             continue; // Skip non-DEX files
         }
-
+        
         // Build the full path to the file
         char full_file_path[MAX_PATH_LENGTH];
         snprintf(full_file_path, sizeof(full_file_path), "%s/%s", 
                  output_directory, filename);
-
+        
         // Get file information to check if it's a regular file (not directory)
         struct stat file_stat;
         if (stat(full_file_path, &file_stat) != 0 || !S_ISREG(file_stat.st_mode)) {
             continue; // Skip if we can't get file info or it's not a regular file
         }
-
-        // SIZE CHECK: Skip files that are too small or too large to be DEX files
-        if (file_stat.st_size > DEX_MAX_FILE_SIZE || file_stat.st_size < DEX_MIN_FILE_SIZE) {
+        
+        // SIZE CHECK: A file of another size cannot hold the same content
+        if ((size_t)file_stat.st_size != data_size) {
             continue;
         }
-
-        // Open the file for reading
-        FILE* file = fopen(full_file_path, "rb");
-        if (!file) {
+        if (!*has_sha1) {
+            compute_sha1_checksum(data_buffer, data_size, sha1_digest);
+            *has_sha1 = 1;
+        }
+        
+        // Open the file for reading (unbuffered, stdio would copy into malloc'd memory)
+        int file_descriptor = open(full_file_path, O_RDONLY | O_CLOEXEC);
+        if (file_descriptor < 0) {
             VLOGD("Cannot open file for reading: %s", full_file_path);
             continue;
         }
-
-        // STEP 1: QUICK DEX HEADER VALIDATION
-        // Read the first few bytes to check DEX magic signature
-        if (fread(dex_header, 1, DEX_HEADER_SIZE, file) != DEX_HEADER_SIZE) {
-            fclose(file);
-            continue; // File is too small or can't be read
-        }
-
-        // Check if the file has the correct DEX magic bytes at the beginning
-        if (memcmp(dex_header, "dex\n", 4) != 0) {
-            fclose(file);
-            continue; // Not a valid DEX file, skip SHA1 computation
-        }
-
-        // STEP 2: MEMORY-EFFICIENT SHA1 COMPUTATION
-        // Reset file pointer to beginning for SHA1 computation
-        fseek(file, 0, SEEK_SET);
-        
-        // Initialize SHA1 context for computing hash
-        sha1_context sha1_ctx;
-        sha1_init(&sha1_ctx);
-        
-        // Use a buffer to read file in chunks (memory efficient)
-        uint8_t buffer[8192]; // 8KB buffer - balances memory usage and I/O efficiency
-        size_t bytes_read;
         
-        // Read file in chunks and update SHA1 computation
-        while ((bytes_read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
-            sha1_update(&sha1_ctx, buffer, bytes_read);
+        // STEP 1 + 2: DEX HEADER VALIDATION AND MEMORY-EFFICIENT SHA1 COMPUTATION
+        // The first window is checked for the DEX magic before anything is hashed,
+        // the rest of the file is streamed window by window (batched on io_uring)
+        DumpHashStream hash_stream;
+        memset(&hash_stream, 0, sizeof(hash_stream));
+        sha1_init(&hash_stream.sha1_ctx);
+        io_engine_stream_file(file_descriptor, read_window, FILE_READ_WINDOW_SIZE,
+                              hash_dump_file_chunk, &hash_stream);
+        close(file_descriptor);
+        if (!hash_stream.header_valid) {
+            continue; // Not a valid DEX file, or it can't be read
         }
-        fclose(file);
         
         // Finalize SHA1 computation to get the hash
         uint8_t file_sha1[20];
-        sha1_final(&sha1_ctx, file_sha1);
+        sha1_final(&hash_stream.sha1_ctx, file_sha1);
         
         // STEP 3: DUPLICATE CHECK
         // Compare the computed SHA1 with the input SHA1
         if (compare_sha1_digests(sha1_digest, file_sha1)) {
             // Found a duplicate! Log it and stop searching
-            char partial_sha1[9];
-            snprintf(partial_sha1, sizeof(partial_sha1), "%.8s", input_sha1_hex);
-            LOGI("Duplicate DEX file found! SHA1: %s... already saved as: %s", 
-                 partial_sha1, filename);
+            char input_sha1_hex[41];
+            sha1_to_hex_string(sha1_digest, input_sha1_hex, sizeof(input_sha1_hex));
+            LOGI("Duplicate DEX file found! SHA1: %.8s... already saved as: %s", 
+                 input_sha1_hex, filename);
             duplicate_found = 1;
         }
     }
-
-    // Clean up - close the directory
+    
+    // Clean up - discard read window and close the directory
+    release_tracked_buffer(read_window, FILE_READ_WINDOW_SIZE);
     closedir(directory_handle);
     return duplicate_found;
 }
\ No newline at end of file
@@ -20,15 +20,22 @@ int is_file_already_dumped(ino_t file_inode);
 // Checks if content has been dumped by SHA1 checksum  
 int is_checksum_already_dumped(const uint8_t *sha1_digest);
 
+// Checks if content has been dumped by tree hash content ID
+int is_content_id_already_dumped(const uint8_t *content_id);
+
 // Registers newly dumped file in the global registry
 void register_dumped_file_with_checksum(ino_t file_inode, const char* file_path, 
-                                      const uint8_t *sha1_digest);
+                                      const uint8_t *sha1_digest, const uint8_t *content_id);
 
 // Checks if a SHA1 digest is in the exclusion list
 int is_sha1_excluded(const uint8_t* sha1_digest);
 
-// Enhanced duplicate detection by checking existing files in directory
-int is_sha1_duplicate_in_directory(const char* output_directory, const uint8_t* sha1_digest);
+// Checks if a tree hash content ID is in the exclusion list
+int is_content_id_excluded(const uint8_t* content_id);
+
+// Enhanced duplicate detection by checking existing files of the same size in directory
+int is_sha1_duplicate_in_directory(const char* output_directory, const void* data_buffer, size_t data_size,
+                                   uint8_t* sha1_digest, int* has_sha1);
 
 // Global registry variables (defined in registry_manager.c)
 extern DumpedFileInfo* dumped_files_registry;  // Array of dumped file info
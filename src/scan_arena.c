@@ -0,0 +1,231 @@
+#include "scan_arena.h"
+#include "self_exclusion.h"
+
+// Header in front of the memory of every chunk
+typedef struct ScanArenaChunk {
+    struct ScanArenaChunk* previous; // Chunk filled before this one
+    size_t chunk_size;               // Usable bytes after the header
+    size_t used;                     // Bytes handed out
+    size_t dirty;                    // Bytes ever handed out: memory past it is still zero
+    size_t mapped_size;              // Size of the mapping
+} ScanArenaChunk;
+
+// Chunk list of one arena
+typedef struct {
+    ScanArenaChunk* current; // Chunk allocations come from
+    void* last_allocation;   // Most recent allocation, grown in place if possible
+} ScanArena;
+
+#define SCAN_ARENA_HEADER_SIZE \
+    ((sizeof(ScanArenaChunk) + SCAN_ARENA_ALIGNMENT - 1) & ~(size_t)(SCAN_ARENA_ALIGNMENT - 1))
+
+// Arena of the current pass, shared by every thread
+static ScanArena pass_arena;
+static pthread_mutex_t pass_arena_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief Rounds a size up to the arena alignment
+ */
+static size_t align_arena_size(size_t size) {
+    return (size + SCAN_ARENA_ALIGNMENT - 1) & ~(size_t)(SCAN_ARENA_ALIGNMENT - 1);
+}
+
+/**
+ * @brief Returns the first usable byte of a chunk
+ */
+static char* chunk_data(ScanArenaChunk* chunk) {
+    return (char*)chunk + SCAN_ARENA_HEADER_SIZE;
+}
+
+/**
+ * @brief Maps a chunk with room for at least one allocation of a given size
+ * 
+ * Chunks are registered as dumper-owned so scans skip them.
+ * 
+ * @param arena Arena to extend (caller holds pass_arena_mutex)
+ * @param minimum_size Aligned size of the allocation that did not fit
+ * @return New current chunk, NULL if memory ran out
+ */
+static ScanArenaChunk* add_arena_chunk(ScanArena* arena, size_t minimum_size) {
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    size_t mapped_size = SCAN_ARENA_HEADER_SIZE + minimum_size;
+    if (mapped_size < SCAN_ARENA_CHUNK_SIZE) mapped_size = SCAN_ARENA_CHUNK_SIZE;
+    mapped_size = (mapped_size + page_size - 1) & ~(page_size - 1);
+    
+    ScanArenaChunk* chunk = mmap(NULL, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (chunk == MAP_FAILED) {
+        LOGE("Scan arena mapping of %zu bytes failed: %s", mapped_size, strerror(errno));
+        return NULL;
+    }
+    register_self_owned_range(chunk, mapped_size);
+    chunk->chunk_size = mapped_size - SCAN_ARENA_HEADER_SIZE;
+    chunk->mapped_size = mapped_size;
+    
+    chunk->previous = arena->current;
+    arena->current = chunk;
+    return chunk;
+}
+
+/**
+ * @brief Bumps an allocation out of an arena
+ * 
+ * @param arena Arena to allocate from (caller holds pass_arena_mutex)
+ * @param size Requested size
+ * @return Zeroed memory, NULL if memory ran out
+ */
+static void* allocate_from_arena(ScanArena* arena, size_t size) {
+    size_t aligned_size = align_arena_size(size ? size : 1);
+    ScanArenaChunk* chunk = arena->current;
+    if (!chunk || chunk->chunk_size - chunk->used < aligned_size) {
+        chunk = add_arena_chunk(arena, aligned_size);
+        if (!chunk) return NULL;
+    }
+    
+    char* allocation = chunk_data(chunk) + chunk->used;
+    // Memory handed out before a release is reused and must be cleared again
+    if (chunk->used < chunk->dirty) {
+        size_t dirty_end = chunk->dirty < chunk->used + aligned_size ? chunk->dirty : chunk->used + aligned_size;
+        memset(allocation, 0, dirty_end - chunk->used);
+    }
+    chunk->used += aligned_size;
+    if (chunk->used > chunk->dirty) chunk->dirty = chunk->used;
+    arena->last_allocation = allocation;
+    return allocation;
+}
+
+/**
+ * @brief Unmaps every mapped chunk of the pass arena newer than a given one
+ * 
+ * Caller holds pass_arena_mutex.
+ */
+static void unmap_pass_chunks_until(ScanArenaChunk* oldest_kept) {
+    while (pass_arena.current && pass_arena.current != oldest_kept) {
+        ScanArenaChunk* chunk = pass_arena.current;
+        pass_arena.current = chunk->previous;
+        unregister_self_owned_range(chunk);
+        munmap(chunk, chunk->mapped_size);
+    }
+}
+
+/**
+ * @brief Starts the arena of a dumping pass
+ * 
+ * Chunks are mapped on first allocation. A pass that was not ended is
+ * ended first.
+ */
+void begin_scan_arena(void) {
+    pthread_mutex_lock(&pass_arena_mutex);
+    if (pass_arena.current) {
+        LOGW("Previous scan arena was not released, releasing it now");
+        unmap_pass_chunks_until(NULL);
+    }
+    memset(&pass_arena, 0, sizeof(pass_arena));
+    pthread_mutex_unlock(&pass_arena_mutex);
+}
+
+/**
+ * @brief Unmaps every chunk of the pass arena
+ * 
+ * Everything allocated during the pass becomes invalid.
+ */
+void end_scan_arena(void) {
+    pthread_mutex_lock(&pass_arena_mutex);
+    size_t released_bytes = 0;
+    int released_chunks = 0;
+    for (ScanArenaChunk* chunk = pass_arena.current; chunk; chunk = chunk->previous) {
+        released_bytes += chunk->mapped_size;
+        released_chunks++;
+    }
+    unmap_pass_chunks_until(NULL);
+    memset(&pass_arena, 0, sizeof(pass_arena));
+    pthread_mutex_unlock(&pass_arena_mutex);
+    
+    if (released_chunks > 0) {
+        VLOGD("Scan arena released: %zu bytes in %d chunks", released_bytes, released_chunks);
+    }
+}
+
+/**
+ * @brief Allocates zeroed, SCAN_ARENA_ALIGNMENT-aligned memory living until the end of the pass
+ * 
+ * @param size Number of bytes
+ * @return Zeroed memory, NULL if memory ran out
+ */
+void* scan_arena_alloc(size_t size) {
+    pthread_mutex_lock(&pass_arena_mutex);
+    void* allocation = allocate_from_arena(&pass_arena, size);
+    pthread_mutex_unlock(&pass_arena_mutex);
+    return allocation;
+}
+
+/**
+ * @brief Grows an allocation, in place when it is the most recent one
+ * 
+ * Buffers filled incrementally (such as /proc/self/maps being read) grow
+ * without copying as long as nothing else is allocated in between.
+ * 
+ * @param allocation Allocation to grow (NULL allocates)
+ * @param old_size Size the allocation was made with
+ * @param new_size New size, the added bytes are zeroed
+ * @return Grown allocation (possibly moved), NULL if memory ran out
+ */
+void* scan_arena_grow(void* allocation, size_t old_size, size_t new_size) {
+    if (allocation == NULL) return scan_arena_alloc(new_size);
+    if (new_size <= old_size) return allocation;
+    
+    pthread_mutex_lock(&pass_arena_mutex);
+    ScanArena* arena = &pass_arena;
+    ScanArenaChunk* chunk = arena->current;
+    size_t old_aligned = align_arena_size(old_size);
+    size_t new_aligned = align_arena_size(new_size);
+    void* grown = NULL;
+    
+    if (chunk && allocation == arena->last_allocation &&
+        (char*)allocation + old_aligned == chunk_data(chunk) + chunk->used &&
+        chunk->used - old_aligned + new_aligned <= chunk->chunk_size) {
+        // Most recent allocation with room behind it: extend in place
+        size_t growth = new_aligned - old_aligned;
+        if (chunk->used < chunk->dirty) {
+            size_t dirty_end = chunk->dirty < chunk->used + growth ? chunk->dirty : chunk->used + growth;
+            memset(chunk_data(chunk) + chunk->used, 0, dirty_end - chunk->used);
+        }
+        chunk->used += growth;
+        if (chunk->used > chunk->dirty) chunk->dirty = chunk->used;
+        grown = allocation;
+    } else {
+        grown = allocate_from_arena(arena, new_size);
+        if (grown) memcpy(grown, allocation, old_size);
+    }
+    
+    pthread_mutex_unlock(&pass_arena_mutex);
+    return grown;
+}
+
+/**
+ * @brief Records the arena position
+ * 
+ * @return Mark to pass to scan_arena_release_to()
+ */
+ScanArenaMark scan_arena_mark(void) {
+    pthread_mutex_lock(&pass_arena_mutex);
+    ScanArenaMark mark = { pass_arena.current, pass_arena.current ? pass_arena.current->used : 0 };
+    pthread_mutex_unlock(&pass_arena_mutex);
+    return mark;
+}
+
+/**
+ * @brief Releases everything allocated since a mark
+ * 
+ * Marks must be released in reverse order.
+ * 
+ * @param mark Mark taken by scan_arena_mark()
+ */
+void scan_arena_release_to(ScanArenaMark mark) {
+    pthread_mutex_lock(&pass_arena_mutex);
+    unmap_pass_chunks_until(mark.chunk);
+    if (pass_arena.current && pass_arena.current == (ScanArenaChunk*)mark.chunk) {
+        pass_arena.current->used = mark.used;
+    }
+    pass_arena.last_allocation = NULL;
+    pthread_mutex_unlock(&pass_arena_mutex);
+}
@@ -0,0 +1,48 @@
+#ifndef DEXDUMPER_SCAN_ARENA_H
+#define DEXDUMPER_SCAN_ARENA_H
+
+// Scan arena header - declares the bump allocator for objects living as long as one pass
+
+#include "common.h"
+#include "config.h"
+
+/**
+ * Per-Pass Arena:
+ * 
+ * Everything a dumping pass allocates for itself (the region table and
+ * its path pool, selection lists, discovery state, residency vectors)
+ * dies with the pass, so it is bump-allocated from mmap'd chunks instead
+ * of the host app's malloc heap and unmapped wholesale when the pass ends.
+ * No allocator lock is shared with the app and the app's heap is not
+ * fragmented by the dumper. Chunks are registered as dumper-owned memory
+ * so scans never look at them.
+ * 
+ * Short-lived temporaries are returned in LIFO order with
+ * scan_arena_mark()/scan_arena_release_to().
+ */
+
+// Position in the arena to roll back to
+typedef struct {
+    void* chunk;  // Current chunk when the mark was taken
+    size_t used;  // Bytes used in that chunk
+} ScanArenaMark;
+
+// Starts the arena of a dumping pass and binds it to the calling thread
+void begin_scan_arena(void);
+
+// Unmaps every chunk of the pass arena
+void end_scan_arena(void);
+
+// Allocates zeroed, SCAN_ARENA_ALIGNMENT-aligned memory living until the end of the pass
+void* scan_arena_alloc(size_t size);
+
+// Grows an allocation, in place when it is the most recent one
+void* scan_arena_grow(void* allocation, size_t old_size, size_t new_size);
+
+// Records the arena position
+ScanArenaMark scan_arena_mark(void);
+
+// Releases everything allocated since a mark
+void scan_arena_release_to(ScanArenaMark mark);
+
+#endif
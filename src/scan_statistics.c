@@ -0,0 +1,124 @@
+#include "scan_statistics.h"
+
+// Global statistics for the current scanning pass
+ScanStatistics scan_statistics = {0};
+
+/**
+ * @brief Resets all scan statistics counters
+ * 
+ * Called at the start of every memory dumping pass so the reported
+ * numbers describe a single pass only.
+ */
+void reset_scan_statistics(void) {
+    memset(&scan_statistics, 0, sizeof(scan_statistics));
+}
+
+/**
+ * @brief Copies the current counters into a caller-provided structure
+ * 
+ * Each counter is loaded atomically; the snapshot as a whole is not
+ * taken under a lock, which is sufficient for reporting purposes.
+ * 
+ * @param snapshot Output structure receiving the counters
+ */
+void snapshot_scan_statistics(ScanStatistics* snapshot) {
+    if (snapshot == NULL) return;
+    
+    snapshot->regions_scanned = __atomic_load_n(&scan_statistics.regions_scanned, __ATOMIC_RELAXED);
+    snapshot->candidates_found = __atomic_load_n(&scan_statistics.candidates_found, __ATOMIC_RELAXED);
+    snapshot->headers_validated = __atomic_load_n(&scan_statistics.headers_validated, __ATOMIC_RELAXED);
+    snapshot->validations_failed = __atomic_load_n(&scan_statistics.validations_failed, __ATOMIC_RELAXED);
+    snapshot->read_faults = __atomic_load_n(&scan_statistics.read_faults, __ATOMIC_RELAXED);
+    snapshot->bytes_skipped = __atomic_load_n(&scan_statistics.bytes_skipped, __ATOMIC_RELAXED);
+    snapshot->budgets_exhausted = __atomic_load_n(&scan_statistics.budgets_exhausted, __ATOMIC_RELAXED);
+    snapshot->regions_quarantined = __atomic_load_n(&scan_statistics.regions_quarantined, __ATOMIC_RELAXED);
+    snapshot->quarantine_skips = __atomic_load_n(&scan_statistics.quarantine_skips, __ATOMIC_RELAXED);
+    snapshot->inflate_attempts = __atomic_load_n(&scan_statistics.inflate_attempts, __ATOMIC_RELAXED);
+    snapshot->payloads_inflated = __atomic_load_n(&scan_statistics.payloads_inflated, __ATOMIC_RELAXED);
+    snapshot->bytes_inflated = __atomic_load_n(&scan_statistics.bytes_inflated, __ATOMIC_RELAXED);
+    snapshot->inflate_budget_stops = __atomic_load_n(&scan_statistics.inflate_budget_stops, __ATOMIC_RELAXED);
+    snapshot->expansion_children = __atomic_load_n(&scan_statistics.expansion_children, __ATOMIC_RELAXED);
+    snapshot->expansion_duplicates = __atomic_load_n(&scan_statistics.expansion_duplicates, __ATOMIC_RELAXED);
+    snapshot->expansion_budget_stops = __atomic_load_n(&scan_statistics.expansion_budget_stops, __ATOMIC_RELAXED);
+    snapshot->xor_candidates_verified = __atomic_load_n(&scan_statistics.xor_candidates_verified, __ATOMIC_RELAXED);
+    snapshot->xor_keys_recovered = __atomic_load_n(&scan_statistics.xor_keys_recovered, __ATOMIC_RELAXED);
+    snapshot->xor_budget_stops = __atomic_load_n(&scan_statistics.xor_budget_stops, __ATOMIC_RELAXED);
+    snapshot->entropy_empty_skips = __atomic_load_n(&scan_statistics.entropy_empty_skips, __ATOMIC_RELAXED);
+    snapshot->entropy_decode_enabled = __atomic_load_n(&scan_statistics.entropy_decode_enabled, __ATOMIC_RELAXED);
+    snapshot->elf_images_rebuilt = __atomic_load_n(&scan_statistics.elf_images_rebuilt, __ATOMIC_RELAXED);
+    snapshot->heap_spaces_walked = __atomic_load_n(&scan_statistics.heap_spaces_walked, __ATOMIC_RELAXED);
+    snapshot->heap_pages_skipped = __atomic_load_n(&scan_statistics.heap_pages_skipped, __ATOMIC_RELAXED);
+    snapshot->heap_arrays_found = __atomic_load_n(&scan_statistics.heap_arrays_found, __ATOMIC_RELAXED);
+    snapshot->pointer_regions_scanned = __atomic_load_n(&scan_statistics.pointer_regions_scanned, __ATOMIC_RELAXED);
+    snapshot->pointer_targets_checked = __atomic_load_n(&scan_statistics.pointer_targets_checked, __ATOMIC_RELAXED);
+    snapshot->pointer_dex_found = __atomic_load_n(&scan_statistics.pointer_dex_found, __ATOMIC_RELAXED);
+    snapshot->protected_regions_read = __atomic_load_n(&scan_statistics.protected_regions_read, __ATOMIC_RELAXED);
+    snapshot->protected_regions_empty = __atomic_load_n(&scan_statistics.protected_regions_empty, __ATOMIC_RELAXED);
+    snapshot->protected_bytes_read = __atomic_load_n(&scan_statistics.protected_bytes_read, __ATOMIC_RELAXED);
+    snapshot->prefault_calls = __atomic_load_n(&scan_statistics.prefault_calls, __ATOMIC_RELAXED);
+    snapshot->prefault_unreadable = __atomic_load_n(&scan_statistics.prefault_unreadable, __ATOMIC_RELAXED);
+    snapshot->footprint_pages_released = __atomic_load_n(&scan_statistics.footprint_pages_released, __ATOMIC_RELAXED);
+    snapshot->io_uring_submissions = __atomic_load_n(&scan_statistics.io_uring_submissions, __ATOMIC_RELAXED);
+    snapshot->io_uring_bytes = __atomic_load_n(&scan_statistics.io_uring_bytes, __ATOMIC_RELAXED);
+    snapshot->io_sync_fallbacks = __atomic_load_n(&scan_statistics.io_sync_fallbacks, __ATOMIC_RELAXED);
+    snapshot->dump_bytes_uncached = __atomic_load_n(&scan_statistics.dump_bytes_uncached, __ATOMIC_RELAXED);
+    snapshot->copy_tears_detected = __atomic_load_n(&scan_statistics.copy_tears_detected, __ATOMIC_RELAXED);
+    snapshot->copies_left_torn = __atomic_load_n(&scan_statistics.copies_left_torn, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Formats the statistics gathered during the current pass
+ * 
+ * @param text Output buffer, one "Scan statistics: ..." line per group
+ * @param capacity Size of the buffer
+ * @return Length of the text (truncated to fit the buffer)
+ */
+size_t format_scan_statistics(char* text, size_t capacity) {
+    ScanStatistics snapshot;
+    snapshot_scan_statistics(&snapshot);
+    
+    int text_length = snprintf(text, capacity,
+        "Scan statistics: regions=%lu candidates=%lu validated=%lu failed=%lu\n"
+        "Scan statistics: faults=%lu skipped_bytes=%lu budgets_exhausted=%lu quarantined=%lu quarantine_skips=%lu\n"
+        "Scan statistics: inflate_attempts=%lu inflated=%lu inflated_bytes=%lu inflate_budget_stops=%lu\n"
+        "Scan statistics: expansion_children=%lu expansion_duplicates=%lu expansion_budget_stops=%lu\n"
+        "Scan statistics: xor_verified=%lu xor_keys=%lu xor_budget_stops=%lu\n"
+        "Scan statistics: entropy_empty_skips=%lu entropy_decode_enabled=%lu elf_rebuilt=%lu\n"
+        "Scan statistics: heap_spaces=%lu heap_pages_skipped=%lu heap_arrays=%lu\n"
+        "Scan statistics: pointer_regions=%lu pointer_targets=%lu pointer_dex=%lu\n"
+        "Scan statistics: protected_read=%lu protected_empty=%lu protected_bytes=%lu\n"
+        "Scan statistics: prefault_calls=%lu prefault_unreadable=%lu footprint_released_pages=%lu\n"
+        "Scan statistics: io_uring_requests=%lu io_uring_bytes=%lu io_sync_fallbacks=%lu dump_uncached_bytes=%lu\n"
+        "Scan statistics: copy_tears=%lu copies_left_torn=%lu\n",
+        snapshot.regions_scanned, snapshot.candidates_found,
+        snapshot.headers_validated, snapshot.validations_failed,
+        snapshot.read_faults, snapshot.bytes_skipped, snapshot.budgets_exhausted,
+        snapshot.regions_quarantined, snapshot.quarantine_skips,
+        snapshot.inflate_attempts, snapshot.payloads_inflated,
+        snapshot.bytes_inflated, snapshot.inflate_budget_stops,
+        snapshot.expansion_children, snapshot.expansion_duplicates, snapshot.expansion_budget_stops,
+        snapshot.xor_candidates_verified, snapshot.xor_keys_recovered, snapshot.xor_budget_stops,
+        snapshot.entropy_empty_skips, snapshot.entropy_decode_enabled, snapshot.elf_images_rebuilt,
+        snapshot.heap_spaces_walked, snapshot.heap_pages_skipped, snapshot.heap_arrays_found,
+        snapshot.pointer_regions_scanned, snapshot.pointer_targets_checked, snapshot.pointer_dex_found,
+        snapshot.protected_regions_read, snapshot.protected_regions_empty, snapshot.protected_bytes_read,
+        snapshot.prefault_calls, snapshot.prefault_unreadable, snapshot.footprint_pages_released,
+        snapshot.io_uring_submissions, snapshot.io_uring_bytes, snapshot.io_sync_fallbacks,
+        snapshot.dump_bytes_uncached,
+        snapshot.copy_tears_detected, snapshot.copies_left_torn);
+    if (text_length < 0) return 0;
+    return (size_t)text_length < capacity ? (size_t)text_length : capacity - 1;
+}
+
+/**
+ * @brief Logs the statistics gathered during the current pass
+ */
+void log_scan_statistics(void) {
+    char text[2048];
+    format_scan_statistics(text, sizeof(text));
+    
+    char* line_state = NULL;
+    for (char* line = strtok_r(text, "\n", &line_state); line != NULL; line = strtok_r(NULL, "\n", &line_state)) {
+        LOGI("%s", line);
+    }
+}
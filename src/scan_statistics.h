@@ -0,0 +1,35 @@
+#ifndef DEXDUMPER_SCAN_STATISTICS_H
+#define DEXDUMPER_SCAN_STATISTICS_H
+
+// Scan statistics header - declares counters reported after each scanning pass
+
+#include "common.h"
+#include "config.h"
+
+/**
+ * Scan Statistics:
+ * 
+ * Lightweight counters describing how much work each scanning pass did
+ * and how often budgets and quarantine kicked in.
+ */
+
+// Global statistics for the current scanning pass (defined in scan_statistics.c)
+extern ScanStatistics scan_statistics;
+
+// Atomically adds a value to one statistics counter
+#define SCAN_STAT_ADD(field, amount) \
+    __atomic_fetch_add(&scan_statistics.field, (unsigned long)(amount), __ATOMIC_RELAXED)
+
+// Resets all counters before a new scanning pass
+void reset_scan_statistics(void);
+
+// Takes a consistent-enough copy of the counters for reporting
+void snapshot_scan_statistics(ScanStatistics* snapshot);
+
+// Formats the current counters as text, one line per group
+size_t format_scan_statistics(char* text, size_t capacity);
+
+// Logs the current counters
+void log_scan_statistics(void);
+
+#endif
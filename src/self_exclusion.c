@@ -0,0 +1,238 @@
+#include "self_exclusion.h"
+
+// Address range owned by the dumper
+typedef struct {
+    uintptr_t range_start; // First byte of the range
+    uintptr_t range_end;   // One past the last byte of the range
+} SelfOwnedRange;
+
+// Registry of dumper-owned ranges
+static SelfOwnedRange self_owned_ranges[MAX_SELF_OWNED_RANGES];
+static int self_owned_range_count = 0;
+static pthread_mutex_t self_owned_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Released buffers kept mapped (with contents discarded) for reuse
+static struct {
+    void* buffer;       // Cached mapping, NULL if slot is empty
+    size_t buffer_size; // Mapping size in bytes
+} buffer_cache[SELF_BUFFER_CACHE_SLOTS];
+
+/**
+ * @brief Rounds a size up to a whole number of pages
+ * 
+ * @param size Size in bytes
+ * @return Page-aligned size
+ */
+static size_t round_up_to_page(size_t size) {
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    return (size + page_size - 1) & ~(page_size - 1);
+}
+
+/**
+ * @brief Registers a memory range as owned by the dumper
+ * 
+ * @param range_start Start of the range
+ * @param range_size Size of the range in bytes
+ */
+void register_self_owned_range(const void* range_start, size_t range_size) {
+    if (range_start == NULL || range_size == 0) return;
+    
+    pthread_mutex_lock(&self_owned_mutex);
+    if (self_owned_range_count < MAX_SELF_OWNED_RANGES) {
+        self_owned_ranges[self_owned_range_count].range_start = (uintptr_t)range_start;
+        self_owned_ranges[self_owned_range_count].range_end = (uintptr_t)range_start + range_size;
+        self_owned_range_count++;
+    } else {
+        LOGW("Self-owned range registry full, %p not tracked", range_start);
+    }
+    pthread_mutex_unlock(&self_owned_mutex);
+}
+
+/**
+ * @brief Removes a range from the self-owned registry
+ * 
+ * @param range_start Start address the range was registered with
+ */
+void unregister_self_owned_range(const void* range_start) {
+    pthread_mutex_lock(&self_owned_mutex);
+    for (int i = 0; i < self_owned_range_count; i++) {
+        if (self_owned_ranges[i].range_start == (uintptr_t)range_start) {
+            // Order does not matter, move last entry into the gap
+            self_owned_ranges[i] = self_owned_ranges[self_owned_range_count - 1];
+            self_owned_range_count--;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&self_owned_mutex);
+}
+
+/**
+ * @brief Checks whether an address lies inside dumper-owned memory
+ * 
+ * @param address Address to check
+ * @return 1 if owned by the dumper, 0 otherwise
+ */
+int is_self_owned_address(const void* address) {
+    int owned = 0;
+    pthread_mutex_lock(&self_owned_mutex);
+    for (int i = 0; i < self_owned_range_count; i++) {
+        if ((uintptr_t)address >= self_owned_ranges[i].range_start &&
+            (uintptr_t)address < self_owned_ranges[i].range_end) {
+            owned = 1;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&self_owned_mutex);
+    return owned;
+}
+
+/**
+ * @brief Allocates an anonymous buffer tracked as dumper-owned
+ * 
+ * Buffers come from private mmap rather than malloc so that they can be
+ * cut out of the scan plan exactly and their contents can be discarded
+ * on release. A small cache of released buffers avoids an mmap per copy.
+ * 
+ * @param buffer_size Requested size in bytes
+ * @return Pointer to zero-filled or discarded memory, NULL on failure
+ */
+void* allocate_tracked_buffer(size_t buffer_size) {
+    if (buffer_size == 0) return NULL;
+    size_t mapping_size = round_up_to_page(buffer_size);
+    
+    // Reuse a cached mapping if one is large enough
+    pthread_mutex_lock(&self_owned_mutex);
+    for (int i = 0; i < SELF_BUFFER_CACHE_SLOTS; i++) {
+        if (buffer_cache[i].buffer && buffer_cache[i].buffer_size >= mapping_size) {
+            void* cached_buffer = buffer_cache[i].buffer;
+            buffer_cache[i].buffer = NULL;
+            buffer_cache[i].buffer_size = 0;
+            pthread_mutex_unlock(&self_owned_mutex);
+            return cached_buffer;
+        }
+    }
+    pthread_mutex_unlock(&self_owned_mutex);
+    
+    void* buffer = mmap(NULL, mapping_size, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (buffer == MAP_FAILED) {
+        LOGE("Failed to map tracked buffer of %zu bytes: %s", mapping_size, strerror(errno));
+        return NULL;
+    }
+    
+    register_self_owned_range(buffer, mapping_size);
+    return buffer;
+}
+
+/**
+ * @brief Releases a tracked buffer and discards its contents
+ * 
+ * The pages are dropped with MADV_DONTNEED so no copy of a DEX survives in
+ * anonymous memory. The mapping is then either cached for reuse (it stays
+ * registered) or unmapped.
+ * 
+ * @param buffer Buffer returned by allocate_tracked_buffer
+ * @param buffer_size Size passed to allocate_tracked_buffer
+ */
+void release_tracked_buffer(void* buffer, size_t buffer_size) {
+    if (buffer == NULL) return;
+    
+    // Find the real mapping size (cached buffers may be larger than requested)
+    size_t mapping_size = round_up_to_page(buffer_size);
+    pthread_mutex_lock(&self_owned_mutex);
+    for (int i = 0; i < self_owned_range_count; i++) {
+        if (self_owned_ranges[i].range_start == (uintptr_t)buffer) {
+            mapping_size = self_owned_ranges[i].range_end - self_owned_ranges[i].range_start;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&self_owned_mutex);
+    
+    // Discard contents; subsequent reads see zero pages
+    madvise(buffer, mapping_size, MADV_DONTNEED);
+    
+    pthread_mutex_lock(&self_owned_mutex);
+    for (int i = 0; i < SELF_BUFFER_CACHE_SLOTS; i++) {
+        if (buffer_cache[i].buffer == NULL) {
+            buffer_cache[i].buffer = buffer;
+            buffer_cache[i].buffer_size = mapping_size;
+            pthread_mutex_unlock(&self_owned_mutex);
+            return;
+        }
+    }
+    pthread_mutex_unlock(&self_owned_mutex);
+    
+    unregister_self_owned_range(buffer);
+    munmap(buffer, mapping_size);
+}
+
+/**
+ * @brief Unmaps all cached buffers
+ * 
+ * Called when scanning is finished so the dumper leaves no idle mappings.
+ */
+void release_cached_tracked_buffers(void) {
+    for (int i = 0; i < SELF_BUFFER_CACHE_SLOTS; i++) {
+        pthread_mutex_lock(&self_owned_mutex);
+        void* buffer = buffer_cache[i].buffer;
+        size_t buffer_size = buffer_cache[i].buffer_size;
+        buffer_cache[i].buffer = NULL;
+        buffer_cache[i].buffer_size = 0;
+        pthread_mutex_unlock(&self_owned_mutex);
+        
+        if (buffer) {
+            unregister_self_owned_range(buffer);
+            munmap(buffer, buffer_size);
+        }
+    }
+}
+
+/**
+ * @brief Comparison function for sorting owned ranges by start address
+ */
+static int compare_owned_ranges(const void* first, const void* second) {
+    const SelfOwnedRange* a = first;
+    const SelfOwnedRange* b = second;
+    if (a->range_start < b->range_start) return -1;
+    return a->range_start > b->range_start;
+}
+
+/**
+ * @brief Removes dumper-owned ranges from the region table
+ * 
+ * The kernel merges adjacent anonymous mappings, so an owned buffer is
+ * often only part of a region. Overlapping regions are therefore clipped
+ * and split rather than dropped, keeping the app's own memory in the plan.
+ * 
+ * @param region_table Table to clip in place
+ * @return New number of regions
+ */
+int subtract_self_owned_ranges(RegionTable* region_table) {
+    if (region_table == NULL || region_table->region_count == 0) {
+        return region_table ? region_table->region_count : 0;
+    }
+    
+    // Snapshot and sort owned ranges
+    SelfOwnedRange owned[MAX_SELF_OWNED_RANGES];
+    pthread_mutex_lock(&self_owned_mutex);
+    int owned_count = self_owned_range_count;
+    memcpy(owned, self_owned_ranges, owned_count * sizeof(SelfOwnedRange));
+    pthread_mutex_unlock(&self_owned_mutex);
+    
+    if (owned_count == 0) return region_table->region_count;
+    qsort(owned, owned_count, sizeof(SelfOwnedRange), compare_owned_ranges);
+    
+    uintptr_t range_starts[MAX_SELF_OWNED_RANGES];
+    uintptr_t range_ends[MAX_SELF_OWNED_RANGES];
+    for (int i = 0; i < owned_count; i++) {
+        range_starts[i] = owned[i].range_start;
+        range_ends[i] = owned[i].range_end;
+    }
+    
+    int removed_count = clip_region_table(region_table, range_starts, range_ends, owned_count);
+    if (removed_count > 0) {
+        LOGI("Excluded dumper-owned memory from %d regions (%d regions remain)",
+             removed_count, region_table->region_count);
+    }
+    return region_table->region_count;
+}
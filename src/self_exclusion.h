@@ -0,0 +1,41 @@
+#ifndef DEXDUMPER_SELF_EXCLUSION_H
+#define DEXDUMPER_SELF_EXCLUSION_H
+
+// Self-exclusion header - declares tracking of memory owned by the dumper itself
+
+#include "common.h"
+#include "config.h"
+#include "region_table.h"
+
+/**
+ * Self-Owned Memory Tracking:
+ * 
+ * Every buffer that may hold DEX bytes (memory copies, file read windows)
+ * is allocated through these functions. The ranges are recorded so the
+ * region planner can cut them out of /proc/self/maps before scanning,
+ * and released buffers are dropped with MADV_DONTNEED so stale copies
+ * never show up in anonymous memory.
+ */
+
+// Allocates a page-aligned anonymous buffer and records its range
+void* allocate_tracked_buffer(size_t buffer_size);
+
+// Releases a tracked buffer, discarding its contents
+void release_tracked_buffer(void* buffer, size_t buffer_size);
+
+// Registers an externally created mapping as dumper-owned
+void register_self_owned_range(const void* range_start, size_t range_size);
+
+// Removes a previously registered range
+void unregister_self_owned_range(const void* range_start);
+
+// Checks whether an address belongs to dumper-owned memory
+int is_self_owned_address(const void* address);
+
+// Removes dumper-owned ranges from the region table, splitting regions as needed
+int subtract_self_owned_ranges(RegionTable* region_table);
+
+// Unmaps cached buffers kept for reuse
+void release_cached_tracked_buffers(void);
+
+#endif
@@ -1,5 +1,14 @@
 #include "sha1.h"
 
+// Multi-buffer kernel: NEON on ARM, SSE2 on x86, one buffer at a time elsewhere
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SHA1_LANES_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define SHA1_LANES_SSE2 1
+#endif
+
 /**
  * @brief Initializes SHA1 context with initial hash values
  * 
@@ -194,6 +203,265 @@ void compute_sha1_checksum(const void *data, size_t data_size, uint8_t *digest)
     sha1_final(&ctx, digest);
 }
 
+#if defined(SHA1_LANES_NEON) || defined(SHA1_LANES_SSE2)
+
+// One 32-bit word per lane
+#if defined(SHA1_LANES_NEON)
+typedef uint32x4_t sha1_lanes;
+#define LANES_SET(value) vdupq_n_u32(value)
+#define LANES_LOAD(words) vld1q_u32(words)
+#define LANES_STORE(words, lanes) vst1q_u32(words, lanes)
+#define LANES_ADD(x, y) vaddq_u32(x, y)
+#define LANES_XOR(x, y) veorq_u32(x, y)
+#define LANES_AND(x, y) vandq_u32(x, y)
+#define LANES_OR(x, y) vorrq_u32(x, y)
+#define LANES_ROTL(x, shift) vsliq_n_u32(vshrq_n_u32(x, 32 - (shift)), x, shift)
+#else
+typedef __m128i sha1_lanes;
+#define LANES_SET(value) _mm_set1_epi32((int)(value))
+#define LANES_LOAD(words) _mm_loadu_si128((const __m128i*)(words))
+#define LANES_STORE(words, lanes) _mm_storeu_si128((__m128i*)(words), lanes)
+#define LANES_ADD(x, y) _mm_add_epi32(x, y)
+#define LANES_XOR(x, y) _mm_xor_si128(x, y)
+#define LANES_AND(x, y) _mm_and_si128(x, y)
+#define LANES_OR(x, y) _mm_or_si128(x, y)
+#define LANES_ROTL(x, shift) _mm_or_si128(_mm_slli_epi32(x, shift), _mm_srli_epi32(x, 32 - (shift)))
+#endif
+
+_Static_assert(SHA1_LANE_COUNT == 4, "SHA1 lanes are the four 32-bit words of a 128-bit vector");
+
+// One SHA1 round on all lanes; the message word is extended in place from round 16 on
+#define SHA1_LANE_ROUND(round, f, k) do { \
+    if ((round) >= 16) { \
+        w[(round) & 15] = LANES_ROTL(LANES_XOR(LANES_XOR(w[((round) - 3) & 15], w[((round) - 8) & 15]), \
+                                               LANES_XOR(w[((round) - 14) & 15], w[(round) & 15])), 1); \
+    } \
+    sha1_lanes temp = LANES_ADD(LANES_ADD(LANES_ROTL(a, 5), f), \
+                                LANES_ADD(LANES_ADD(e, LANES_SET(k)), w[(round) & 15])); \
+    e = d; \
+    d = c; \
+    c = LANES_ROTL(b, 30); \
+    b = a; \
+    a = temp; \
+} while (0)
+
+/**
+ * @brief Runs the SHA1 compression function on one block in every lane
+ * 
+ * @param state Hash state, state[i][lane] is word h<i> of that lane
+ * @param blocks 64-byte block of every lane
+ */
+static void sha1_process_lane_blocks(uint32_t state[5][SHA1_LANE_COUNT],
+                                     const uint8_t* const blocks[SHA1_LANE_COUNT]) {
+    sha1_lanes w[16];
+    uint32_t words[SHA1_LANE_COUNT];
+    
+    // Word i of every lane's block, big-endian, side by side
+    for (int i = 0; i < 16; i++) {
+        for (int lane = 0; lane < SHA1_LANE_COUNT; lane++) {
+            const uint8_t* word = blocks[lane] + i * 4;
+            words[lane] = ((uint32_t)word[0] << 24) | ((uint32_t)word[1] << 16) |
+                          ((uint32_t)word[2] << 8) | (uint32_t)word[3];
+        }
+        w[i] = LANES_LOAD(words);
+    }
+    
+    sha1_lanes a = LANES_LOAD(state[0]);
+    sha1_lanes b = LANES_LOAD(state[1]);
+    sha1_lanes c = LANES_LOAD(state[2]);
+    sha1_lanes d = LANES_LOAD(state[3]);
+    sha1_lanes e = LANES_LOAD(state[4]);
+    
+    for (int i = 0; i < 20; i++) {
+        SHA1_LANE_ROUND(i, LANES_XOR(d, LANES_AND(b, LANES_XOR(c, d))), 0x5A827999);
+    }
+    for (int i = 20; i < 40; i++) {
+        SHA1_LANE_ROUND(i, LANES_XOR(LANES_XOR(b, c), d), 0x6ED9EBA1);
+    }
+    for (int i = 40; i < 60; i++) {
+        SHA1_LANE_ROUND(i, LANES_OR(LANES_AND(b, c), LANES_AND(d, LANES_OR(b, c))), 0x8F1BBCDC);
+    }
+    for (int i = 60; i < 80; i++) {
+        SHA1_LANE_ROUND(i, LANES_XOR(LANES_XOR(b, c), d), 0xCA62C1D6);
+    }
+    
+    LANES_STORE(state[0], LANES_ADD(LANES_LOAD(state[0]), a));
+    LANES_STORE(state[1], LANES_ADD(LANES_LOAD(state[1]), b));
+    LANES_STORE(state[2], LANES_ADD(LANES_LOAD(state[2]), c));
+    LANES_STORE(state[3], LANES_ADD(LANES_LOAD(state[3]), d));
+    LANES_STORE(state[4], LANES_ADD(LANES_LOAD(state[4]), e));
+}
+
+// Buffer being hashed in one lane
+typedef struct {
+    int buffer_index;     // Index in the batch, -1 while the lane is idle
+    const uint8_t* data;  // Buffer contents
+    size_t size;          // Buffer size
+    size_t offset;        // Bytes consumed as whole blocks
+    uint8_t tail[128];    // Last partial block, padding and bit length
+    int tail_blocks;      // Blocks in tail (1 or 2), 0 until the whole blocks are used up
+    int tail_position;    // Tail blocks handed out
+} Sha1Lane;
+
+/**
+ * @brief Starts hashing a buffer in a lane
+ */
+static void start_sha1_lane(Sha1Lane* lane, uint32_t state[5][SHA1_LANE_COUNT], int lane_index,
+                            int buffer_index, const void* data, size_t size) {
+    lane->buffer_index = buffer_index;
+    lane->data = data;
+    lane->size = size;
+    lane->offset = 0;
+    lane->tail_blocks = 0;
+    lane->tail_position = 0;
+    state[0][lane_index] = 0x67452301;
+    state[1][lane_index] = 0xEFCDAB89;
+    state[2][lane_index] = 0x98BADCFE;
+    state[3][lane_index] = 0x10325476;
+    state[4][lane_index] = 0xC3D2E1F0;
+}
+
+/**
+ * @brief Hands out the next block of a lane's buffer, padding included
+ */
+static const uint8_t* next_sha1_lane_block(Sha1Lane* lane) {
+    if (lane->tail_blocks == 0 && lane->size - lane->offset >= 64) {
+        const uint8_t* block = lane->data + lane->offset;
+        lane->offset += 64;
+        return block;
+    }
+    
+    if (lane->tail_blocks == 0) {
+        size_t remaining = lane->size - lane->offset;
+        lane->tail_blocks = remaining < 56 ? 1 : 2;
+        memset(lane->tail, 0, sizeof(lane->tail));
+        memcpy(lane->tail, lane->data + lane->offset, remaining);
+        lane->tail[remaining] = 0x80;
+        
+        uint64_t bit_length = (uint64_t)lane->size * 8;
+        uint8_t* length_field = lane->tail + lane->tail_blocks * 64 - 8;
+        for (int i = 0; i < 8; i++) {
+            length_field[i] = (uint8_t)(bit_length >> (56 - i * 8));
+        }
+    }
+    return lane->tail + 64 * lane->tail_position++;
+}
+
+/**
+ * @brief Writes a lane's hash state as a big-endian digest
+ */
+static void store_sha1_lane_digest(uint32_t state[5][SHA1_LANE_COUNT], int lane_index, uint8_t* digest) {
+    for (int word = 0; word < 5; word++) {
+        for (int i = 0; i < 4; i++) {
+            digest[word * 4 + i] = (uint8_t)(state[word][lane_index] >> (24 - i * 8));
+        }
+    }
+}
+
+#endif
+
+/**
+ * @brief Computes SHA1 checksums for several independent buffers
+ * 
+ * Up to SHA1_LANE_COUNT buffers are hashed side by side, one block per
+ * lane per step. Buffers enter the lanes longest first and a lane that
+ * finishes takes the next waiting buffer, so short buffers fill the gaps
+ * left by long ones. Once a single buffer is left it is finished with
+ * the scalar code, which is faster for one stream. Without NEON or SSE2
+ * the buffers are hashed one after another.
+ * 
+ * @param data Start of every buffer
+ * @param data_sizes Size of every buffer
+ * @param buffer_count Number of buffers
+ * @param digests Output, one 20-byte digest per buffer
+ */
+void compute_sha1_checksums(const void *const *data, const size_t *data_sizes, int buffer_count,
+                            uint8_t (*digests)[20]) {
+#if defined(SHA1_LANES_NEON) || defined(SHA1_LANES_SSE2)
+    int* order = buffer_count > 1 ? malloc((size_t)buffer_count * sizeof(int)) : NULL;
+#else
+    int* order = NULL;
+#endif
+    if (order == NULL) {
+        for (int i = 0; i < buffer_count; i++) {
+            compute_sha1_checksum(data[i], data_sizes[i], digests[i]);
+        }
+        return;
+    }
+
+#if defined(SHA1_LANES_NEON) || defined(SHA1_LANES_SSE2)
+    // Longest first (insertion sort, batches are small)
+    for (int i = 0; i < buffer_count; i++) {
+        int position = i;
+        while (position > 0 && data_sizes[order[position - 1]] < data_sizes[i]) {
+            order[position] = order[position - 1];
+            position--;
+        }
+        order[position] = i;
+    }
+    
+    static const uint8_t idle_block[64];
+    uint32_t state[5][SHA1_LANE_COUNT];
+    Sha1Lane lanes[SHA1_LANE_COUNT];
+    int next_buffer = 0;
+    int active_lanes = 0;
+    
+    for (int lane = 0; lane < SHA1_LANE_COUNT; lane++) {
+        lanes[lane].buffer_index = -1;
+        if (next_buffer < buffer_count) {
+            int buffer_index = order[next_buffer++];
+            start_sha1_lane(&lanes[lane], state, lane, buffer_index, data[buffer_index], data_sizes[buffer_index]);
+            active_lanes++;
+        }
+    }
+    
+    while (active_lanes > 0) {
+        // The last buffer gains nothing from the lanes, finish it with the scalar code
+        if (active_lanes == 1 && next_buffer == buffer_count) {
+            int lane = 0;
+            while (lanes[lane].buffer_index < 0) lane++;
+            if (lanes[lane].tail_blocks == 0) {
+                sha1_context ctx;
+                ctx.h0 = state[0][lane];
+                ctx.h1 = state[1][lane];
+                ctx.h2 = state[2][lane];
+                ctx.h3 = state[3][lane];
+                ctx.h4 = state[4][lane];
+                ctx.buffer_len = 0;
+                ctx.total_len = lanes[lane].offset;
+                sha1_update(&ctx, lanes[lane].data + lanes[lane].offset, lanes[lane].size - lanes[lane].offset);
+                sha1_final(&ctx, digests[lanes[lane].buffer_index]);
+                break;
+            }
+        }
+        
+        const uint8_t* blocks[SHA1_LANE_COUNT];
+        for (int lane = 0; lane < SHA1_LANE_COUNT; lane++) {
+            blocks[lane] = lanes[lane].buffer_index >= 0 ? next_sha1_lane_block(&lanes[lane]) : idle_block;
+        }
+        sha1_process_lane_blocks(state, blocks);
+        
+        // Finished lanes hand in their digest and take the next buffer
+        for (int lane = 0; lane < SHA1_LANE_COUNT; lane++) {
+            Sha1Lane* finished = &lanes[lane];
+            if (finished->buffer_index < 0 || finished->tail_blocks == 0 ||
+                finished->tail_position < finished->tail_blocks) continue;
+            
+            store_sha1_lane_digest(state, lane, digests[finished->buffer_index]);
+            finished->buffer_index = -1;
+            active_lanes--;
+            if (next_buffer < buffer_count) {
+                int buffer_index = order[next_buffer++];
+                start_sha1_lane(finished, state, lane, buffer_index, data[buffer_index], data_sizes[buffer_index]);
+                active_lanes++;
+            }
+        }
+    }
+    
+    free(order);
+#endif
+}
+
 /**
  * @brief Compares two SHA1 digests for equality
  * 
@@ -38,6 +38,10 @@ void sha1_final(sha1_context *ctx, uint8_t *digest);
 // Convenience function to compute SHA1 for single data buffer
 void compute_sha1_checksum(const void *data, size_t data_size, uint8_t *digest);
 
+// Computes SHA1 for several independent buffers, hashing up to SHA1_LANE_COUNT at once in SIMD lanes
+void compute_sha1_checksums(const void *const *data, const size_t *data_sizes, int buffer_count,
+                            uint8_t (*digests)[20]);
+
 // Compares two SHA1 digests for equality
 int compare_sha1_digests(const uint8_t *digest1, const uint8_t *digest2);
 
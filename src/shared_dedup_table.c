@@ -0,0 +1,344 @@
+#include "shared_dedup_table.h"
+#include "config_manager.h"
+#include "self_exclusion.h"
+#include "sha1.h"
+#include <sys/file.h>
+#include <sched.h>
+
+// Slot states, changed only with atomic operations; the state word also
+// carries the table generation the slot was written in
+#define SLOT_EMPTY     0  // Never used
+#define SLOT_WRITING   1  // Claimed, digest being written
+#define SLOT_PENDING   2  // Digest valid, owner still writing the dump file
+#define SLOT_PUBLISHED 3  // Digest valid, dump file complete
+#define SLOT_RELEASED  4  // Claim given up, skipped by lookups and never reused
+#define SLOT_STATE_BITS 3
+#define SLOT_STATE_MASK ((1u << SLOT_STATE_BITS) - 1)
+#define SLOT_GENERATION_MASK (UINT32_MAX >> SLOT_STATE_BITS)
+
+// One content key, 64 bytes so every slot fills exactly one cache line
+typedef struct {
+    uint32_t state;          // Generation << SLOT_STATE_BITS | SLOT_*
+    uint32_t data_size;      // Size of the dumped content
+    uint8_t content_key[20]; // SHA-1, or the leading bytes of the tree hash content ID
+    uint32_t owner_pid;      // Process that dumps it
+    uint32_t path_id;        // FNV-1a of the dump's file name, 0 until the file is written
+    uint32_t reserved[7];    // Pads the slot to 64 bytes
+} SharedDedupSlot;
+
+// Start of the table file, followed by the slots
+typedef struct {
+    uint32_t magic;          // SHARED_DEDUP_MAGIC
+    uint32_t slot_size;      // sizeof(SharedDedupSlot) of the build that created the file
+    uint32_t slot_count;     // Power of two
+    uint32_t generation;     // Bumped by every process that opens the table alone, never 0
+    uint32_t reserved[12];   // Pads the header to 64 bytes
+} SharedDedupHeader;
+
+// Mapping of the table, NULL while unavailable
+static SharedDedupHeader* shared_table = NULL;
+static SharedDedupSlot* shared_slots = NULL;
+
+// Generation of the table while this process uses it
+static uint32_t shared_table_generation = 0;
+
+// Other processes had the table mapped when this one opened it
+static int shared_table_has_peers = 0;
+
+// Lock file held by a lone process until it has cleaned the output directory
+static int shared_table_init_lock_fd = -1;
+
+/**
+ * @brief Builds the state word of a slot of the current generation
+ * 
+ * @param state SLOT_* value
+ * @return State word to store in the slot
+ */
+static uint32_t current_slot_state(uint32_t state) {
+    return (shared_table_generation << SLOT_STATE_BITS) | state;
+}
+
+/**
+ * @brief Maps the table of the output directory, retiring its entries if no other process uses it
+ * 
+ * Opening is serialized by an exclusive flock() on a separate lock file,
+ * so no process can slip in between another one's exclusive probe of
+ * the table and its shared lock. Every process holds a shared flock() on
+ * the table for as long as it runs; the descriptor is never closed. A
+ * process that then obtains the exclusive lock without waiting is the
+ * only live one: the entries refer to dumps of dead processes, so it
+ * bumps the header generation, which turns every older slot into an
+ * empty one, before downgrading to the shared lock. The slots are
+ * cleared only when the magic or layout is not valid. The lone process
+ * keeps the lock file until finish_shared_dedup_table_init(), so a
+ * process starting meanwhile cannot dump into the directory while it is
+ * being cleaned. A process that finds others holding the table joins it
+ * as is. Lookups and inserts do not lock.
+ * 
+ * @param output_directory Directory holding the dumped files
+ * @return 1 if the table is mapped, 0 if it is disabled or unavailable
+ */
+int init_shared_dedup_table(const char* output_directory) {
+    if (!should_enable_shared_dedup_table() || shared_table != NULL) return shared_table != NULL;
+    
+    char table_path[MAX_PATH_LENGTH];
+    char lock_path[MAX_PATH_LENGTH];
+    snprintf(table_path, sizeof(table_path), "%s/%s", output_directory, SHARED_DEDUP_FILENAME);
+    snprintf(lock_path, sizeof(lock_path), "%s/%s", output_directory, SHARED_DEDUP_LOCK_FILENAME);
+    size_t table_size = sizeof(SharedDedupHeader) + (size_t)SHARED_DEDUP_SLOT_COUNT * sizeof(SharedDedupSlot);
+    
+    // Held until this process holds its shared lock on the table
+    int lock_fd = open(lock_path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (lock_fd < 0 || flock(lock_fd, LOCK_EX) != 0) {
+        LOGW("Cannot lock shared dedup table %s: %s", lock_path, strerror(errno));
+        if (lock_fd >= 0) close(lock_fd);
+        return 0;
+    }
+    
+    int table_fd = open(table_path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (table_fd < 0) {
+        LOGW("Cannot open shared dedup table %s: %s", table_path, strerror(errno));
+        close(lock_fd);
+        return 0;
+    }
+    
+    // Only a process holding the lock file ever takes the exclusive lock, so this never waits
+    int alone = flock(table_fd, LOCK_EX | LOCK_NB) == 0;
+    if (!alone && flock(table_fd, LOCK_SH) != 0) {
+        LOGW("Cannot lock shared dedup table %s: %s", table_path, strerror(errno));
+        close(table_fd);
+        close(lock_fd);
+        return 0;
+    }
+    
+    struct stat table_status;
+    void* mapping = MAP_FAILED;
+    if (fstat(table_fd, &table_status) == 0 &&
+        ((size_t)table_status.st_size == table_size || (alone && ftruncate(table_fd, (off_t)table_size) == 0))) {
+        mapping = mmap(NULL, table_size, PROT_READ | PROT_WRITE, MAP_SHARED, table_fd, 0);
+    }
+    if (mapping == MAP_FAILED) {
+        LOGW("Cannot map shared dedup table %s: %s", table_path, strerror(errno));
+        close(table_fd);
+        close(lock_fd);
+        return 0;
+    }
+    
+    SharedDedupHeader* header = mapping;
+    int layout_valid = __atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) == SHARED_DEDUP_MAGIC &&
+                       header->slot_size == sizeof(SharedDedupSlot) &&
+                       header->slot_count == SHARED_DEDUP_SLOT_COUNT &&
+                       header->generation != 0;
+    if (alone && !layout_valid) {
+        // New file or one left by another build: nothing in it is usable
+        memset(mapping, 0, table_size);
+        header->slot_size = sizeof(SharedDedupSlot);
+        header->slot_count = SHARED_DEDUP_SLOT_COUNT;
+        header->generation = 1;
+        __atomic_store_n(&header->magic, SHARED_DEDUP_MAGIC, __ATOMIC_RELEASE);
+    } else if (alone) {
+        uint32_t generation = (header->generation + 1) & SLOT_GENERATION_MASK;
+        __atomic_store_n(&header->generation, generation != 0 ? generation : 1, __ATOMIC_RELEASE);
+    } else if (!layout_valid) {
+        // Laid out by another build of the library that is still running
+        LOGW("Shared dedup table %s is in use with another layout", table_path);
+        munmap(mapping, table_size);
+        close(table_fd);
+        close(lock_fd);
+        return 0;
+    }
+    if (alone) {
+        flock(table_fd, LOCK_SH);
+        shared_table_init_lock_fd = lock_fd;
+    } else {
+        close(lock_fd);
+    }
+    
+    // Holds digests only, but the scanner has no business reading it either
+    register_self_owned_range(mapping, table_size);
+    shared_slots = (SharedDedupSlot*)((char*)mapping + sizeof(SharedDedupHeader));
+    shared_table_generation = __atomic_load_n(&header->generation, __ATOMIC_ACQUIRE);
+    shared_table_has_peers = !alone;
+    __atomic_store_n(&shared_table, header, __ATOMIC_RELEASE);
+    LOGI("Shared dedup table mapped: %s (%d slots, generation %u, %s)", table_path, SHARED_DEDUP_SLOT_COUNT,
+         shared_table_generation, alone ? "entries retired" : "joined other processes");
+    return 1;
+}
+
+/**
+ * @brief Lets other processes open the table once the output directory is cleaned
+ * 
+ * Does nothing unless this process opened the table alone.
+ */
+void finish_shared_dedup_table_init(void) {
+    if (shared_table_init_lock_fd >= 0) {
+        close(shared_table_init_lock_fd);
+        shared_table_init_lock_fd = -1;
+    }
+}
+
+/**
+ * @brief Checks if other processes of the app had the table mapped when it was opened
+ * 
+ * Their dumps and manifest records in the output directory are live and
+ * must not be cleaned away.
+ * 
+ * @return 1 if other processes share the table, 0 if not or if there is no table
+ */
+int shared_dedup_table_has_peers(void) {
+    return __atomic_load_n(&shared_table, __ATOMIC_ACQUIRE) != NULL && shared_table_has_peers;
+}
+
+/**
+ * @brief Checks if the process that owns a pending slot is still running
+ * 
+ * @param owner_pid Owner recorded in the slot
+ * @return 1 if the process exists, 0 if it died
+ */
+static int slot_owner_alive(uint32_t owner_pid) {
+    return owner_pid == (uint32_t)getpid() || kill((pid_t)owner_pid, 0) == 0 || errno == EPERM;
+}
+
+/**
+ * @brief Fills a slot this process just moved to SLOT_WRITING and marks it pending
+ * 
+ * @param slot Slot to fill
+ * @param content_key 20-byte content key
+ * @param data_size Size of the content
+ */
+static void fill_claimed_slot(SharedDedupSlot* slot, const uint8_t* content_key, size_t data_size) {
+    memcpy(slot->content_key, content_key, sizeof(slot->content_key));
+    slot->data_size = (uint32_t)data_size;
+    slot->owner_pid = (uint32_t)getpid();
+    __atomic_store_n(&slot->path_id, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->state, current_slot_state(SLOT_PENDING), __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Claims a checksum for this process unless some process already dumped it
+ * 
+ * Linear probing from the first digest bytes. An empty slot, or one
+ * left by an older generation, is claimed with a compare-and-swap,
+ * filled, then marked pending; it is published only once the dump file
+ * is written. A slot another process is still filling is waited for
+ * briefly, so two processes racing on the same content do not both dump
+ * it. A pending slot counts as a duplicate while its owner runs; the
+ * pending slot of a process that died before publishing is taken over,
+ * so a crash never leaves content marked as dumped without a file. A
+ * writer that died between claim and fill leaves its slot in
+ * SLOT_WRITING, which lookups give up on after SHARED_DEDUP_SPIN_LIMIT
+ * yields.
+ * 
+ * @param content_key 20-byte content key (SHA-1, or the leading bytes of the tree hash content ID)
+ * @param data_size Size of the content
+ * @return SharedDedupResult of the claim
+ */
+SharedDedupResult claim_shared_dump_checksum(const uint8_t* content_key, size_t data_size) {
+    if (__atomic_load_n(&shared_table, __ATOMIC_ACQUIRE) == NULL) return SHARED_DEDUP_UNAVAILABLE;
+    
+    uint32_t first_slot;
+    memcpy(&first_slot, content_key, sizeof(first_slot));
+    for (uint32_t probe = 0; probe < SHARED_DEDUP_SLOT_COUNT; probe++) {
+        SharedDedupSlot* slot = &shared_slots[(first_slot + probe) & (SHARED_DEDUP_SLOT_COUNT - 1)];
+        uint32_t word = __atomic_load_n(&slot->state, __ATOMIC_ACQUIRE);
+        
+        if ((word >> SLOT_STATE_BITS) != shared_table_generation &&
+            __atomic_compare_exchange_n(&slot->state, &word, current_slot_state(SLOT_WRITING), 0,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            fill_claimed_slot(slot, content_key, data_size);
+            return SHARED_DEDUP_CLAIMED;
+        }
+        
+        // Lost the race for the slot or found it being filled: wait for the digest
+        for (int spin = 0; word == current_slot_state(SLOT_WRITING) && spin < SHARED_DEDUP_SPIN_LIMIT; spin++) {
+            sched_yield();
+            word = __atomic_load_n(&slot->state, __ATOMIC_ACQUIRE);
+        }
+        
+        if ((word == current_slot_state(SLOT_PUBLISHED) || word == current_slot_state(SLOT_PENDING)) &&
+            slot->data_size == (uint32_t)data_size && compare_sha1_digests(slot->content_key, content_key)) {
+            uint32_t owner_pid = slot->owner_pid;
+            if (word == current_slot_state(SLOT_PUBLISHED) || slot_owner_alive(owner_pid)) {
+                VLOGD("Duplicate found in shared dedup table (%s by pid %u, path id %08x)",
+                      word == current_slot_state(SLOT_PUBLISHED) ? "dumped" : "being dumped",
+                      owner_pid, __atomic_load_n(&slot->path_id, __ATOMIC_RELAXED));
+                return SHARED_DEDUP_DUPLICATE;
+            }
+            
+            // The owner died before its file was complete: dump the content again
+            if (__atomic_compare_exchange_n(&slot->state, &word, current_slot_state(SLOT_WRITING), 0,
+                                            __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                VLOGD("Taking over shared dedup slot of dead pid %u", owner_pid);
+                fill_claimed_slot(slot, content_key, data_size);
+                return SHARED_DEDUP_CLAIMED;
+            }
+            // Another process took it over first and dumps it now
+            return SHARED_DEDUP_DUPLICATE;
+        }
+    }
+    
+    LOGW("Shared dedup table is full");
+    return SHARED_DEDUP_UNAVAILABLE;
+}
+
+/**
+ * @brief Finds the pending slot this process holds for a content key
+ * 
+ * @param content_key 20-byte content key passed to claim_shared_dump_checksum()
+ * @return The slot, or NULL if this process holds none for the key
+ */
+static SharedDedupSlot* find_own_shared_slot(const uint8_t* content_key) {
+    if (__atomic_load_n(&shared_table, __ATOMIC_ACQUIRE) == NULL) return NULL;
+    
+    uint32_t first_slot;
+    memcpy(&first_slot, content_key, sizeof(first_slot));
+    for (uint32_t probe = 0; probe < SHARED_DEDUP_SLOT_COUNT; probe++) {
+        SharedDedupSlot* slot = &shared_slots[(first_slot + probe) & (SHARED_DEDUP_SLOT_COUNT - 1)];
+        uint32_t word = __atomic_load_n(&slot->state, __ATOMIC_ACQUIRE);
+        if ((word >> SLOT_STATE_BITS) != shared_table_generation) return NULL;
+        if (word == current_slot_state(SLOT_PENDING) && slot->owner_pid == (uint32_t)getpid() &&
+            compare_sha1_digests(slot->content_key, content_key)) {
+            return slot;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Publishes a claimed content key once its dump file is complete
+ * 
+ * Records the FNV-1a hash of the file name as the path id, so a process
+ * that finds the content already dumped can tell which file has it.
+ * 
+ * @param content_key 20-byte content key passed to claim_shared_dump_checksum()
+ * @param file_path Path of the dump file
+ */
+void publish_shared_dump_checksum(const uint8_t* content_key, const char* file_path) {
+    SharedDedupSlot* slot = find_own_shared_slot(content_key);
+    if (slot == NULL) return;
+    
+    const char* file_name = strrchr(file_path, '/');
+    file_name = file_name != NULL ? file_name + 1 : file_path;
+    uint32_t path_id = 2166136261u;
+    for (const char* c = file_name; *c != '\0'; c++) {
+        path_id = (path_id ^ (uint8_t)*c) * 16777619u;
+    }
+    // 0 marks a file not written yet
+    __atomic_store_n(&slot->path_id, path_id != 0 ? path_id : 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->state, current_slot_state(SLOT_PUBLISHED), __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Gives up a claim whose dump could not be written
+ * 
+ * The slot becomes a tombstone so the content can be claimed again in a
+ * later slot of the probe sequence.
+ * 
+ * @param content_key 20-byte content key passed to claim_shared_dump_checksum()
+ */
+void release_shared_dump_checksum(const uint8_t* content_key) {
+    SharedDedupSlot* slot = find_own_shared_slot(content_key);
+    if (slot != NULL) {
+        __atomic_store_n(&slot->state, current_slot_state(SLOT_RELEASED), __ATOMIC_RELEASE);
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef DEXDUMPER_SHARED_DEDUP_TABLE_H
+#define DEXDUMPER_SHARED_DEDUP_TABLE_H
+
+// Shared dedup table header - declares the checksum table shared by all processes of the app
+
+#include "common.h"
+#include "config.h"
+
+/**
+ * Cross-Process Deduplication:
+ * 
+ * Every process of an app (main, ":remote", ...) loads the library and
+ * dumps into the same output directory, but the dump registry lives in
+ * process memory, so each process used to find the others' dumps only by
+ * rehashing every file in the directory. The shared table is a file in
+ * the output directory mapped MAP_SHARED by every process: an open
+ * addressing hash table of fixed-size (content key, size, owner, path id) slots,
+ * keyed by the SHA-1 or, for dumps identified by the tree hash, the
+ * first 20 bytes of the content ID. A slot is claimed with a
+ * compare-and-swap on its state, stays pending with the owner's pid
+ * while the file is written and is published with a release store
+ * afterwards, so lookups and inserts take no lock and a duplicate dumped
+ * by another process is recognised in a few memory accesses. Every
+ * process holds a shared flock() on the table while it runs; a process
+ * that opens it with no other one holding it retires all entries by
+ * bumping the table generation.
+ */
+
+// Result of claiming a checksum in the shared table
+typedef enum {
+    SHARED_DEDUP_CLAIMED = 0,   // New content, this process dumps it
+    SHARED_DEDUP_DUPLICATE,     // Already dumped by this or another process
+    SHARED_DEDUP_UNAVAILABLE    // No table (disabled, unmappable or full), check the directory instead
+} SharedDedupResult;
+
+// Maps the table of the output directory, retiring its entries if no other process uses it
+int init_shared_dedup_table(const char* output_directory);
+
+// Lets other processes open the table once the output directory is cleaned
+void finish_shared_dedup_table_init(void);
+
+// Checks if other processes of the app had the table mapped when it was opened
+int shared_dedup_table_has_peers(void);
+
+// Claims a checksum for this process unless some process already dumped it
+SharedDedupResult claim_shared_dump_checksum(const uint8_t* content_key, size_t data_size);
+
+// Publishes a claimed content key once its dump file is complete
+void publish_shared_dump_checksum(const uint8_t* content_key, const char* file_path);
+
+// Gives up a claim whose dump could not be written
+void release_shared_dump_checksum(const uint8_t* content_key);
+
+#endif
@@ -1,4 +1,23 @@
 #include "signal_handler.h"
+#include "scan_statistics.h"
+#include <sys/uio.h>
+
+// MADV_POPULATE_READ appeared in Linux 5.14, older headers lack it
+#ifndef MADV_POPULATE_READ
+#define MADV_POPULATE_READ 22
+#endif
+
+#ifndef __NR_process_vm_readv
+#if defined(__aarch64__)
+#define __NR_process_vm_readv 270
+#elif defined(__arm__)
+#define __NR_process_vm_readv 376
+#elif defined(__x86_64__)
+#define __NR_process_vm_readv 310
+#elif defined(__i386__)
+#define __NR_process_vm_readv 347
+#endif
+#endif
 
 // Thread-local variables for signal handling recovery
 __thread sigjmp_buf signal_recovery_buffer;
@@ -9,6 +28,15 @@ pthread_mutex_t signal_handler_mutex = PTHREAD_MUTEX_INITIALIZER;
 int signal_handlers_installed = 0;
 stack_t signal_handler_stack = {0};
 
+// Backend read_memory_safely() copies with, chosen by startup calibration
+static volatile MemoryReaderBackend active_reader_backend = MEMORY_READER_SIGNAL_GUARD;
+
+// process_vm_readv() on the own process: -1 unknown, 0 unusable, 1 usable
+static volatile int vm_readv_support = -1;
+
+// Recovery point while probing process_vm_readv() under a seccomp policy that traps it
+static sigjmp_buf vm_readv_probe_recovery;
+
 /**
  * @brief Signal handler for memory access violations
  * 
@@ -138,19 +166,18 @@ int validate_memory_access(const void* memory_address, size_t memory_size) {
 }
 
 /**
- * @brief Safely reads memory with signal protection
+ * @brief Reads memory with signal protection
  * 
  * Copies memory from source to destination with protection against
- * segmentation faults and bus errors. Essential for scanning unknown
- * memory regions safely.
+ * segmentation faults and bus errors.
  * 
  * @param source_address Address to read from
  * @param destination_buffer Buffer to read into
  * @param read_size Number of bytes to read
  * @return 1 if read successful, 0 if memory inaccessible
  */
-int read_memory_safely(const void* source_address, void* destination_buffer, 
-                      size_t read_size) {
+static int read_memory_signal_guarded(const void* source_address, void* destination_buffer,
+                                      size_t read_size) {
     // Validate input parameters
     if (source_address == NULL || destination_buffer == NULL || read_size == 0) {
         return 0;
@@ -182,4 +209,181 @@ int read_memory_safely(const void* source_address, void* destination_buffer,
         recovery_buffer_ready = 0;
         return 0;
     }
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Copies memory of the own process with process_vm_readv()
+ * 
+ * The kernel does the copy, so an unmapped or unreadable page ends the
+ * transfer with EFAULT (or a short count) instead of raising a signal
+ * and no recovery point has to be set up.
+ * 
+ * @return 1 if every byte was copied, 0 otherwise
+ */
+static int read_memory_vm_readv(const void* source_address, void* destination_buffer, size_t read_size) {
+#ifdef __NR_process_vm_readv
+    struct iovec local_vector = { destination_buffer, read_size };
+    struct iovec remote_vector = { (void*)source_address, read_size };
+    long bytes_read = syscall(__NR_process_vm_readv, (long)getpid(), &local_vector, 1UL, &remote_vector, 1UL, 0UL);
+    return bytes_read == (long)read_size;
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief Copies memory with a given backend
+ * 
+ * @param reader_backend Backend to copy with
+ * @param source_address Address to read from
+ * @param destination_buffer Buffer to read into
+ * @param read_size Number of bytes to read
+ * @return 1 if read successful, 0 if memory inaccessible
+ */
+int read_memory_with_backend(MemoryReaderBackend reader_backend, const void* source_address,
+                             void* destination_buffer, size_t read_size) {
+    if (reader_backend == MEMORY_READER_VM_READV) {
+        if (source_address == NULL || destination_buffer == NULL || read_size == 0) return 0;
+        if ((uintptr_t)source_address < 0x1000) return 0; // Null page protection
+        return read_memory_vm_readv(source_address, destination_buffer, read_size);
+    }
+    return read_memory_signal_guarded(source_address, destination_buffer, read_size);
+}
+
+/**
+ * @brief Safely reads memory with signal protection
+ * 
+ * Copies memory from source to destination with protection against
+ * segmentation faults and bus errors. Essential for scanning unknown
+ * memory regions safely. Uses process_vm_readv() instead where startup
+ * calibration found it faster.
+ * 
+ * @param source_address Address to read from
+ * @param destination_buffer Buffer to read into
+ * @param read_size Number of bytes to read
+ * @return 1 if read successful, 0 if memory inaccessible
+ */
+int read_memory_safely(const void* source_address, void* destination_buffer, 
+                      size_t read_size) {
+    return read_memory_with_backend(active_reader_backend, source_address, destination_buffer, read_size);
+}
+
+/**
+ * @brief Leaves the process_vm_readv() probe when seccomp traps the system call
+ */
+static void vm_readv_probe_signal_handler(int signal_number) {
+    siglongjmp(vm_readv_probe_recovery, 1);
+}
+
+/**
+ * @brief Checks once whether process_vm_readv() works in this process
+ * 
+ * Some app sandboxes answer it with SIGSYS rather than an error, so the
+ * first call is made with SIGSYS caught; the previous disposition is
+ * restored afterwards.
+ * 
+ * @return 1 if the backend can be used, 0 otherwise
+ */
+int is_vm_readv_supported(void) {
+    if (vm_readv_support >= 0) return vm_readv_support;
+    
+    pthread_mutex_lock(&signal_handler_mutex);
+    if (vm_readv_support < 0) {
+        struct sigaction probe_action, previous_action;
+        memset(&probe_action, 0, sizeof(probe_action));
+        probe_action.sa_handler = vm_readv_probe_signal_handler;
+        sigemptyset(&probe_action.sa_mask);
+        sigaction(SIGSYS, &probe_action, &previous_action);
+        
+        static const char probe_source[8] = "dexprob";
+        char probe_destination[sizeof(probe_source)];
+        volatile int supported = 0;
+        if (sigsetjmp(vm_readv_probe_recovery, 1) == 0) {
+            supported = read_memory_vm_readv(probe_source, probe_destination, sizeof(probe_source)) &&
+                        memcmp(probe_source, probe_destination, sizeof(probe_source)) == 0;
+        }
+        sigaction(SIGSYS, &previous_action, NULL);
+        
+        if (!supported) LOGI("process_vm_readv unavailable, reading memory with signal guards");
+        vm_readv_support = supported;
+    }
+    pthread_mutex_unlock(&signal_handler_mutex);
+    return vm_readv_support;
+}
+
+/**
+ * @brief Selects the backend read_memory_safely() uses
+ * 
+ * process_vm_readv() is only selected where the probe succeeded.
+ * 
+ * @param reader_backend Backend to use from now on
+ */
+void set_memory_reader_backend(MemoryReaderBackend reader_backend) {
+    if (reader_backend == MEMORY_READER_VM_READV && !is_vm_readv_supported()) {
+        reader_backend = MEMORY_READER_SIGNAL_GUARD;
+    }
+    active_reader_backend = reader_backend;
+}
+
+// Kernel support for MADV_POPULATE_READ: -1 unknown, 0 missing, 1 present
+static volatile int populate_read_support = -1;
+
+/**
+ * @brief Probes once whether the kernel knows MADV_POPULATE_READ
+ * 
+ * EINVAL is also returned for mappings that cannot be populated (VM_IO,
+ * VM_PFNMAP), so the advice is tried on a page known to be ordinary: the
+ * one holding this flag.
+ */
+static int kernel_supports_populate_read(void) {
+    if (populate_read_support < 0) {
+        size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+        void* probe_page = (void*)((uintptr_t)&populate_read_support & ~(uintptr_t)(page_size - 1));
+        populate_read_support = madvise(probe_page, page_size, MADV_POPULATE_READ) == 0 ? 1 : 0;
+        if (!populate_read_support) {
+            LOGI("MADV_POPULATE_READ unavailable (%s), probing memory with signals", strerror(errno));
+        }
+    }
+    return populate_read_support;
+}
+
+/**
+ * @brief Prefaults a range for reading in one call
+ * 
+ * MADV_POPULATE_READ (Linux 5.14+) faults in every page of the range up
+ * front, with readahead batched for file-backed pages, instead of one
+ * fault per page as the scan cursor advances. Failures come back as
+ * errno rather than SIGSEGV/SIGBUS, which makes the call a cheap
+ * unreadable-range detector as well.
+ * 
+ * @param memory_address Start of the range (rounded down to a page)
+ * @param memory_size Size of the range in bytes
+ * @return PREFAULT_READABLE, PREFAULT_UNREADABLE, or PREFAULT_UNSUPPORTED
+ *         when the caller has to fall back to signal-guarded access
+ */
+PrefaultResult prefault_memory_range(const void* memory_address, size_t memory_size) {
+    if (memory_address == NULL || memory_size == 0) return PREFAULT_UNREADABLE;
+    if (!kernel_supports_populate_read()) return PREFAULT_UNSUPPORTED;
+    
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    uintptr_t range_start = (uintptr_t)memory_address & ~(uintptr_t)(page_size - 1);
+    uintptr_t range_end = (uintptr_t)memory_address + memory_size;
+    if (range_end < range_start) return PREFAULT_UNREADABLE;
+    
+    SCAN_STAT_ADD(prefault_calls, 1);
+    if (madvise((void*)range_start, range_end - range_start, MADV_POPULATE_READ) == 0) {
+        return PREFAULT_READABLE;
+    }
+    
+    switch (errno) {
+        case EFAULT:    // A page would have raised SIGSEGV or SIGBUS
+        case ENOMEM:    // Part of the range is not mapped
+#ifdef EHWPOISON
+        case EHWPOISON: // Poisoned page
+#endif
+            SCAN_STAT_ADD(prefault_unreadable, 1);
+            return PREFAULT_UNREADABLE;
+        default:        // EINVAL for VM_IO/VM_PFNMAP or PROT_NONE mappings, EINTR, ...
+            return PREFAULT_UNSUPPORTED;
+    }
+}
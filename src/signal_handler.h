@@ -14,6 +14,19 @@
  * Essential for scanning unknown process memory.
  */
 
+// Outcome of prefaulting a range with MADV_POPULATE_READ
+typedef enum {
+    PREFAULT_UNSUPPORTED = -1, // Kernel or mapping cannot prefault, probe with signals instead
+    PREFAULT_UNREADABLE = 0,   // Range is unmapped or reading it would fault
+    PREFAULT_READABLE = 1      // Every page of the range is mapped in and readable
+} PrefaultResult;
+
+// How read_memory_safely() copies memory
+typedef enum {
+    MEMORY_READER_SIGNAL_GUARD = 0, // memcpy() with SIGSEGV/SIGBUS recovery
+    MEMORY_READER_VM_READV = 1      // process_vm_readv() on the own process, faults come back as EFAULT
+} MemoryReaderBackend;
+
 // Installs signal handlers for memory access violations
 void install_memory_signal_handlers(void);
 
@@ -24,6 +37,19 @@ int validate_memory_access(const void* memory_address, size_t memory_size);
 int read_memory_safely(const void* source_address, void* destination_buffer, 
                       size_t read_size);
 
+// Copies memory with a given backend (used to benchmark the backends)
+int read_memory_with_backend(MemoryReaderBackend reader_backend, const void* source_address,
+                             void* destination_buffer, size_t read_size);
+
+// Checks once whether process_vm_readv() works in this process
+int is_vm_readv_supported(void);
+
+// Selects the backend read_memory_safely() uses
+void set_memory_reader_backend(MemoryReaderBackend reader_backend);
+
+// Prefaults a range for reading in one call, reporting errors instead of raising signals
+PrefaultResult prefault_memory_range(const void* memory_address, size_t memory_size);
+
 // Thread-local recovery context for signal handling
 extern __thread sigjmp_buf signal_recovery_buffer;
 extern __thread volatile sig_atomic_t recovery_buffer_ready;
@@ -0,0 +1,527 @@
+#include "xor_key_recovery.h"
+#include "dex_detector.h"
+#include "memory_scanner.h"
+#include "scan_statistics.h"
+#include "calibration.h"
+#include <zlib.h>
+
+// Candidate screening kernel: NEON on ARM, SSE2 on x86, scalar elsewhere or where calibration prefers it
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define XOR_SCREEN_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define XOR_SCREEN_SSE2 1
+#endif
+
+// Header bytes covered by the known-plaintext constraints
+#define KNOWN_PLAINTEXT_SPAN 128
+
+// Candidate offsets screened per vector
+#define SCREEN_LANES 16
+
+// Bytes decoded per step when checksumming a candidate
+#define CHECKSUM_WINDOW_SIZE 4096
+
+/**
+ * @brief DEX bytes that are the same in (almost) every version 035-039 file
+ * 
+ * The last version digit and most size/offset fields vary and are left
+ * out. d8 and dx always emit an empty link section and place the string
+ * ids right after the header; string data offsets stay below 16MB, so
+ * the high byte of each string id is zero. The string ids supply enough
+ * constraints for long keys, which the header alone leaves weak.
+ */
+static const struct {
+    uint8_t position; // Offset in the DEX header
+    uint8_t value;    // Plaintext byte at that offset
+} known_plaintext[] = {
+    { 0x00, 'd' }, { 0x01, 'e' }, { 0x02, 'x' }, { 0x03, '\n' }, { 0x04, '0' }, { 0x05, '3' },
+    { 0x07, 0x00 },
+    { 0x24, 0x70 }, { 0x25, 0x00 }, { 0x26, 0x00 }, { 0x27, 0x00 }, // header_size
+    { 0x28, 0x78 }, { 0x29, 0x56 }, { 0x2A, 0x34 }, { 0x2B, 0x12 }, // endian tag
+    { 0x2C, 0x00 }, { 0x2D, 0x00 }, { 0x2E, 0x00 }, { 0x2F, 0x00 }, // link_size
+    { 0x30, 0x00 }, { 0x31, 0x00 }, { 0x32, 0x00 }, { 0x33, 0x00 }, // link_off
+    { 0x3C, 0x70 }, { 0x3D, 0x00 }, { 0x3E, 0x00 }, { 0x3F, 0x00 }, // string_ids_off
+    { 0x73, 0x00 }, { 0x77, 0x00 }, { 0x7B, 0x00 }, { 0x7F, 0x00 }  // string id high bytes
+};
+
+#define KNOWN_PLAINTEXT_COUNT (sizeof(known_plaintext) / sizeof(known_plaintext[0]))
+
+// How the key is applied to the plaintext
+typedef enum {
+    KEY_MODE_XOR = 0, // cipher = plain ^ key
+    KEY_MODE_ADD,     // cipher = plain + key (a subtracting packer is ADD with the negated key)
+    KEY_MODE_COUNT
+} KeyMode;
+
+// Two known positions sharing a key byte: cipher difference must equal plaintext difference
+typedef struct {
+    uint8_t later;    // Later known position
+    uint8_t earlier;  // Earlier known position with the same key index
+    uint8_t expected; // Required difference of the two ciphertext bytes
+} KnownPlaintextPair;
+
+// Screening constraints for one key length and mode
+typedef struct {
+    KnownPlaintextPair pairs[KNOWN_PLAINTEXT_COUNT];
+    int pair_count;
+} KeyHypothesis;
+
+static KeyHypothesis key_hypotheses[KEY_MODE_COUNT][MAX_XOR_KEY_LENGTH + 1];
+static pthread_once_t key_hypotheses_once = PTHREAD_ONCE_INIT;
+
+// Key screening CPU time spent during the current pass, in microseconds
+static uint64_t screening_microseconds_this_pass = 0;
+static pthread_mutex_t screening_budget_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief Gets the CPU time used by the calling thread in microseconds
+ */
+static uint64_t thread_cpu_microseconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return (uint64_t)now.tv_sec * 1000000 + (uint64_t)now.tv_nsec / 1000;
+}
+
+/**
+ * @brief Resets the per-pass key screening time budget
+ */
+void reset_key_screening_budget(void) {
+    pthread_mutex_lock(&screening_budget_mutex);
+    screening_microseconds_this_pass = 0;
+    pthread_mutex_unlock(&screening_budget_mutex);
+}
+
+/**
+ * @brief Gets the key screening CPU time still available in this pass, in microseconds
+ */
+static uint64_t remaining_key_screening_budget(void) {
+    pthread_mutex_lock(&screening_budget_mutex);
+    uint64_t pass_budget = (uint64_t)XOR_SCAN_PASS_TIME_BUDGET_MS * 1000;
+    uint64_t remaining = screening_microseconds_this_pass < pass_budget ?
+                         pass_budget - screening_microseconds_this_pass : 0;
+    pthread_mutex_unlock(&screening_budget_mutex);
+    return remaining;
+}
+
+/**
+ * @brief Charges key screening CPU time against the per-pass budget
+ */
+static void charge_key_screening_budget(uint64_t microseconds) {
+    pthread_mutex_lock(&screening_budget_mutex);
+    screening_microseconds_this_pass += microseconds;
+    pthread_mutex_unlock(&screening_budget_mutex);
+}
+
+/**
+ * @brief Difference of two bytes under a key mode
+ */
+static uint8_t key_mode_difference(KeyMode mode, uint8_t later, uint8_t earlier) {
+    return mode == KEY_MODE_XOR ? (uint8_t)(later ^ earlier) : (uint8_t)(later - earlier);
+}
+
+/**
+ * @brief Builds the pair constraints of every key length and mode
+ * 
+ * Known positions whose distance is a multiple of the key length use the
+ * same key byte, so their ciphertext difference is fixed by the plaintext.
+ */
+static void build_key_hypotheses(void) {
+    for (int mode = 0; mode < KEY_MODE_COUNT; mode++) {
+        for (int key_length = 1; key_length <= MAX_XOR_KEY_LENGTH; key_length++) {
+            KeyHypothesis* hypothesis = &key_hypotheses[mode][key_length];
+            int last_position[MAX_XOR_KEY_LENGTH];
+            memset(last_position, -1, sizeof(last_position));
+            
+            for (size_t i = 0; i < KNOWN_PLAINTEXT_COUNT; i++) {
+                int key_index = known_plaintext[i].position % key_length;
+                if (last_position[key_index] >= 0) {
+                    KnownPlaintextPair* pair = &hypothesis->pairs[hypothesis->pair_count++];
+                    pair->later = known_plaintext[i].position;
+                    pair->earlier = known_plaintext[last_position[key_index]].position;
+                    pair->expected = key_mode_difference(mode, known_plaintext[i].value,
+                                                         known_plaintext[last_position[key_index]].value);
+                }
+                last_position[key_index] = (int)i;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Tests SCREEN_LANES consecutive candidate offsets against one hypothesis
+ * 
+ * @param block Ciphertext starting at the first candidate (needs
+ *              SCREEN_LANES + KNOWN_PLAINTEXT_SPAN readable bytes)
+ * @param hypothesis Pair constraints to check
+ * @param mode Key mode of the hypothesis
+ * @return Bit mask of candidate offsets satisfying every constraint
+ */
+static uint32_t screen_candidate_lanes(const uint8_t* block, const KeyHypothesis* hypothesis, KeyMode mode) {
+#if defined(XOR_SCREEN_NEON)
+    if (get_simd_kernel() == SIMD_KERNEL_VECTOR) {
+        uint8x16_t passing = vdupq_n_u8(0xFF);
+        for (int i = 0; i < hypothesis->pair_count; i++) {
+            const KnownPlaintextPair* pair = &hypothesis->pairs[i];
+            uint8x16_t later = vld1q_u8(block + pair->later);
+            uint8x16_t earlier = vld1q_u8(block + pair->earlier);
+            uint8x16_t difference = mode == KEY_MODE_XOR ? veorq_u8(later, earlier) : vsubq_u8(later, earlier);
+            passing = vandq_u8(passing, vceqq_u8(difference, vdupq_n_u8(pair->expected)));
+            
+            uint64x2_t wide = vreinterpretq_u64_u8(passing);
+            if ((vgetq_lane_u64(wide, 0) | vgetq_lane_u64(wide, 1)) == 0) return 0;
+        }
+        
+        uint8_t lanes[SCREEN_LANES];
+        vst1q_u8(lanes, passing);
+        uint32_t lane_mask = 0;
+        for (int lane = 0; lane < SCREEN_LANES; lane++) {
+            if (lanes[lane]) lane_mask |= 1u << lane;
+        }
+        return lane_mask;
+    }
+#elif defined(XOR_SCREEN_SSE2)
+    if (get_simd_kernel() == SIMD_KERNEL_VECTOR) {
+        __m128i passing = _mm_set1_epi8((char)0xFF);
+        for (int i = 0; i < hypothesis->pair_count; i++) {
+            const KnownPlaintextPair* pair = &hypothesis->pairs[i];
+            __m128i later = _mm_loadu_si128((const __m128i*)(block + pair->later));
+            __m128i earlier = _mm_loadu_si128((const __m128i*)(block + pair->earlier));
+            __m128i difference = mode == KEY_MODE_XOR ? _mm_xor_si128(later, earlier) : _mm_sub_epi8(later, earlier);
+            passing = _mm_and_si128(passing, _mm_cmpeq_epi8(difference, _mm_set1_epi8((char)pair->expected)));
+            if (_mm_movemask_epi8(passing) == 0) return 0;
+        }
+        return (uint32_t)_mm_movemask_epi8(passing);
+    }
+#endif
+    
+    uint32_t lane_mask = 0;
+    for (int lane = 0; lane < SCREEN_LANES; lane++) {
+        int passing = 1;
+        for (int i = 0; i < hypothesis->pair_count && passing; i++) {
+            const KnownPlaintextPair* pair = &hypothesis->pairs[i];
+            passing = key_mode_difference(mode, block[lane + pair->later],
+                                          block[lane + pair->earlier]) == pair->expected;
+        }
+        if (passing) lane_mask |= 1u << lane;
+    }
+    return lane_mask;
+}
+
+/**
+ * @brief Decodes bytes in place with a repeating key
+ * 
+ * @param data Bytes to decode
+ * @param data_size Number of bytes
+ * @param key_position Index of data[0] within the payload
+ * @param key Repeating key
+ * @param key_length Length of key
+ * @param mode Key mode
+ */
+static void decode_with_key(uint8_t* data, size_t data_size, size_t key_position,
+                            const uint8_t* key, size_t key_length, KeyMode mode) {
+    size_t key_index = key_position % key_length;
+    for (size_t i = 0; i < data_size; i++) {
+        data[i] = mode == KEY_MODE_XOR ? (uint8_t)(data[i] ^ key[key_index]) : (uint8_t)(data[i] - key[key_index]);
+        if (++key_index == key_length) key_index = 0;
+    }
+}
+
+/**
+ * @brief Fills key bytes the known plaintext leaves open
+ * 
+ * Zero is by far the most common byte in a DEX (index tables, padding,
+ * high bytes of small integers), so for each open key index the most
+ * frequent ciphertext byte is taken as the encryption of zero.
+ * 
+ * @return 1 on success, 0 if the sample could not be read
+ */
+static int fill_key_from_frequencies(const uint8_t* payload_start, size_t available_size,
+                                     uint8_t* key, const uint8_t* key_known, size_t key_length) {
+    // Open key indexes only exist for key lengths above 5 (positions 0-4 are known),
+    // so no counter can exceed the window size divided by 6
+    uint16_t frequencies[MAX_XOR_KEY_LENGTH][256];
+    memset(frequencies, 0, sizeof(frequencies));
+    
+    size_t sample_size = available_size < XOR_KEY_FREQUENCY_WINDOW ? available_size : XOR_KEY_FREQUENCY_WINDOW;
+    uint8_t sample[CHECKSUM_WINDOW_SIZE];
+    for (size_t offset = 0; offset < sample_size; offset += sizeof(sample)) {
+        size_t length = sample_size - offset < sizeof(sample) ? sample_size - offset : sizeof(sample);
+        if (!read_memory_safely(payload_start + offset, sample, length)) return 0;
+        
+        size_t key_index = offset % key_length;
+        for (size_t i = 0; i < length; i++) {
+            frequencies[key_index][sample[i]]++;
+            if (++key_index == key_length) key_index = 0;
+        }
+    }
+    
+    for (size_t key_index = 0; key_index < key_length; key_index++) {
+        if (key_known[key_index]) continue;
+        int most_frequent = 0;
+        for (int value = 1; value < 256; value++) {
+            if (frequencies[key_index][value] > frequencies[key_index][most_frequent]) most_frequent = value;
+        }
+        key[key_index] = (uint8_t)most_frequent; // Encryption of zero is the key byte in both modes
+    }
+    return 1;
+}
+
+/**
+ * @brief Confirms a decoded candidate with the DEX Adler-32 checksum
+ */
+static int verify_decoded_checksum(const uint8_t* payload_start, uint32_t file_size, uint32_t expected_checksum,
+                                   const uint8_t* key, size_t key_length, KeyMode mode) {
+    uLong checksum = adler32(0L, Z_NULL, 0);
+    uint8_t window[CHECKSUM_WINDOW_SIZE];
+    
+    // The checksum covers everything after the magic and the checksum field itself
+    for (size_t offset = 12; offset < file_size; offset += sizeof(window)) {
+        size_t length = file_size - offset < sizeof(window) ? file_size - offset : sizeof(window);
+        if (!read_memory_safely(payload_start + offset, window, length)) return 0;
+        decode_with_key(window, length, offset, key, key_length, mode);
+        checksum = adler32(checksum, window, (uInt)length);
+    }
+    return (uint32_t)checksum == expected_checksum;
+}
+
+/**
+ * @brief Fully verifies one screened candidate
+ * 
+ * Cheap checks on key bytes fixed by the known plaintext come first; only
+ * candidates passing them are charged to the verification budget and get
+ * the frequency sample, header validation and checksum.
+ * 
+ * @param block Ciphertext at the candidate (KNOWN_PLAINTEXT_SPAN bytes)
+ * @param payload_start Candidate address in scanned memory
+ * @param available_size Bytes from the candidate to the end of the region
+ * @param key_length Hypothesised key length
+ * @param mode Hypothesised key mode
+ * @param verifications_left In/out verification budget
+ * @param detection_result Output on success
+ * @return 1 if confirmed, 0 if rejected
+ */
+static int verify_candidate(const uint8_t* block, const uint8_t* payload_start, size_t available_size,
+                            size_t key_length, KeyMode mode, int* verifications_left,
+                            DexDetectionResult* detection_result) {
+    uint8_t key[MAX_XOR_KEY_LENGTH] = {0};
+    uint8_t key_known[MAX_XOR_KEY_LENGTH] = {0};
+    int key_is_zero = 1;
+    for (size_t i = 0; i < KNOWN_PLAINTEXT_COUNT; i++) {
+        size_t key_index = known_plaintext[i].position % key_length;
+        key[key_index] = key_mode_difference(mode, block[known_plaintext[i].position], known_plaintext[i].value);
+        key_known[key_index] = 1;
+        if (key[key_index] != 0) key_is_zero = 0;
+    }
+    
+    // A plain DEX fits every hypothesis with a zero key; the regular detector handles it
+    if (key_is_zero) return 0;
+    
+    // Decode the header as far as the key is known and reject impossible fields early
+    uint8_t header[KNOWN_PLAINTEXT_SPAN];
+    memcpy(header, block, sizeof(header));
+    decode_with_key(header, sizeof(header), 0, key, key_length, mode);
+    
+    int file_size_known = key_known[0x20 % key_length] && key_known[0x21 % key_length] &&
+                          key_known[0x22 % key_length] && key_known[0x23 % key_length];
+    uint32_t file_size = header[0x20] | (header[0x21] << 8) | (header[0x22] << 16) | ((uint32_t)header[0x23] << 24);
+    if (file_size_known && (file_size < DEX_MIN_FILE_SIZE || file_size > DEX_MAX_FILE_SIZE ||
+                            file_size > available_size)) {
+        return 0;
+    }
+    if (key_known[0x06 % key_length] && (header[0x06] < '5' || header[0x06] > '9')) return 0;
+    
+    if (*verifications_left <= 0) return 0;
+    (*verifications_left)--;
+    SCAN_STAT_ADD(xor_candidates_verified, 1);
+    
+    if (!fill_key_from_frequencies(payload_start, available_size, key, key_known, key_length)) return 0;
+    
+    memcpy(header, block, sizeof(header));
+    decode_with_key(header, sizeof(header), 0, key, key_length, mode);
+    file_size = header[0x20] | (header[0x21] << 8) | (header[0x22] << 16) | ((uint32_t)header[0x23] << 24);
+    
+    if (header[0x06] < '5' || header[0x06] > '9' || !validate_dex_header_structure(header, available_size, 0)) {
+        VLOGD("Decoded header at %p rejected (key length %zu)", payload_start, key_length);
+        return 0;
+    }
+    
+    uint32_t expected_checksum = header[0x08] | (header[0x09] << 8) | (header[0x0A] << 16) |
+                                 ((uint32_t)header[0x0B] << 24);
+    if (!verify_decoded_checksum(payload_start, file_size, expected_checksum, key, key_length, mode)) {
+        VLOGD("Decoded DEX at %p failed checksum (key length %zu)", payload_start, key_length);
+        return 0;
+    }
+    
+    detection_result->dex_address = (void*)payload_start;
+    detection_result->dex_size = file_size;
+    detection_result->detector_name = mode == KEY_MODE_XOR ? "xor-key" : "add-key";
+    detection_result->payload_encoding = mode == KEY_MODE_XOR ? PAYLOAD_ENCODING_XOR : PAYLOAD_ENCODING_ADD;
+    memcpy(detection_result->payload_key, key, key_length);
+    detection_result->payload_key_length = key_length;
+    SCAN_STAT_ADD(xor_keys_recovered, 1);
+    LOGI("Recovered %zu-byte %s key for obfuscated DEX at %p (%u bytes)", key_length,
+         mode == KEY_MODE_XOR ? "XOR" : "ADD", payload_start, file_size);
+    return 1;
+}
+
+/**
+ * @brief Screens a region for a DEX obfuscated with a repeating key
+ * 
+ * Every offset is screened against all key lengths and both modes. A key
+ * of length L also satisfies the constraints of every multiple of L, so
+ * the long (weakly constrained) lengths are screened first and a short
+ * length is only screened where all of its multiples passed.
+ * 
+ * @param region_start Start of memory region to scan
+ * @param region_size Size of memory region
+ * @param deadline_us Thread CPU time at which screening stops, in microseconds
+ * @param detection_result Output for detection results
+ * @return 1 if an obfuscated DEX was found, 0 otherwise
+ */
+static int screen_region_for_key(const void* region_start, size_t region_size, uint64_t deadline_us,
+                                 DexDetectionResult* detection_result) {
+    size_t scan_limit = (region_size > DEFAULT_SCAN_LIMIT) ? DEFAULT_SCAN_LIMIT : region_size;
+    int verifications_left = MAX_XOR_VERIFICATIONS_PER_REGION;
+    const uint8_t* region_bytes = region_start;
+    
+    // Chunk plus the header span of its last candidate plus padding for the last vector
+    uint8_t chunk[SCAN_CHUNK_SIZE + KNOWN_PLAINTEXT_SPAN + SCREEN_LANES];
+    
+    for (size_t chunk_start = 0; chunk_start < scan_limit; chunk_start += SCAN_CHUNK_SIZE) {
+        if (thread_cpu_microseconds() > deadline_us || verifications_left <= 0) {
+            SCAN_STAT_ADD(xor_budget_stops, 1);
+            VLOGD("Key screening budget exhausted at offset %zu of %p", chunk_start, region_start);
+            return 0;
+        }
+        
+        size_t read_length = region_size - chunk_start;
+        if (read_length > SCAN_CHUNK_SIZE + KNOWN_PLAINTEXT_SPAN) read_length = SCAN_CHUNK_SIZE + KNOWN_PLAINTEXT_SPAN;
+        if (read_length < KNOWN_PLAINTEXT_SPAN) break;
+        if (!read_memory_safely(region_bytes + chunk_start, chunk, read_length)) {
+            SCAN_STAT_ADD(read_faults, 1);
+            continue;
+        }
+        memset(chunk + read_length, 0, sizeof(chunk) - read_length);
+        
+        // Candidates need their whole known-plaintext span inside the chunk
+        size_t candidate_count = read_length - KNOWN_PLAINTEXT_SPAN + 1;
+        if (candidate_count > SCAN_CHUNK_SIZE) candidate_count = SCAN_CHUNK_SIZE;
+        if (candidate_count > scan_limit - chunk_start) candidate_count = scan_limit - chunk_start;
+        
+        for (size_t block_offset = 0; block_offset < candidate_count; block_offset += SCREEN_LANES) {
+            const uint8_t* block = chunk + block_offset;
+            
+            // Zero-filled and other uniform memory cannot hold a DEX, skip it without screening
+            if (block[0] == block[SCREEN_LANES + KNOWN_PLAINTEXT_SPAN - 2] &&
+                memcmp(block, block + 1, SCREEN_LANES + KNOWN_PLAINTEXT_SPAN - 2) == 0) {
+                continue;
+            }
+            
+            uint32_t lane_limit = candidate_count - block_offset >= SCREEN_LANES ?
+                                  (1u << SCREEN_LANES) - 1 : (1u << (candidate_count - block_offset)) - 1;
+            
+            for (int mode = 0; mode < KEY_MODE_COUNT; mode++) {
+                uint32_t lane_masks[MAX_XOR_KEY_LENGTH + 1];
+                uint32_t any_lanes = 0;
+                
+                for (int key_length = MAX_XOR_KEY_LENGTH; key_length > MAX_XOR_KEY_LENGTH / 2; key_length--) {
+                    lane_masks[key_length] = screen_candidate_lanes(block, &key_hypotheses[mode][key_length], mode) &
+                                             lane_limit;
+                    any_lanes |= lane_masks[key_length];
+                }
+                if (any_lanes == 0) continue;
+                
+                for (int key_length = MAX_XOR_KEY_LENGTH / 2; key_length >= 1; key_length--) {
+                    uint32_t inherited = lane_limit;
+                    for (int multiple = 2 * key_length; multiple <= MAX_XOR_KEY_LENGTH && inherited; multiple += key_length) {
+                        inherited &= lane_masks[multiple];
+                    }
+                    lane_masks[key_length] = inherited ?
+                        inherited & screen_candidate_lanes(block, &key_hypotheses[mode][key_length], mode) : 0;
+                }
+                
+                // Shortest key first: a key of length L also explains every multiple of L
+                for (int key_length = 1; key_length <= MAX_XOR_KEY_LENGTH; key_length++) {
+                    for (uint32_t lanes = lane_masks[key_length]; lanes; lanes &= lanes - 1) {
+                        size_t candidate_offset = chunk_start + block_offset + __builtin_ctz(lanes);
+                        if (verify_candidate(block + __builtin_ctz(lanes), region_bytes + candidate_offset,
+                                             region_size - candidate_offset, key_length, mode,
+                                             &verifications_left, detection_result)) {
+                            return 1;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Scans a high-priority region for a DEX obfuscated with a repeating key
+ * 
+ * Screening gets XOR_SCAN_TIME_BUDGET_MS of CPU time per region, and no
+ * more than the pass has left of XOR_SCAN_PASS_TIME_BUDGET_MS; once the
+ * pass budget is spent, regions are no longer screened.
+ * 
+ * @param region_start Start of memory region to scan
+ * @param region_size Size of memory region
+ * @param detection_result Output for detection results
+ * @return 1 if an obfuscated DEX was found, 0 otherwise
+ */
+int scan_for_xor_obfuscated_dex(const void* region_start, size_t region_size,
+                                DexDetectionResult* detection_result) {
+    if (region_size < DEX_MIN_FILE_SIZE) return 0;
+    
+    uint64_t budget_us = remaining_key_screening_budget();
+    if (budget_us == 0) {
+        SCAN_STAT_ADD(xor_budget_stops, 1);
+        VLOGD("Key screening pass budget exhausted, skipping %p", region_start);
+        return 0;
+    }
+    if (budget_us > (uint64_t)XOR_SCAN_TIME_BUDGET_MS * 1000) budget_us = (uint64_t)XOR_SCAN_TIME_BUDGET_MS * 1000;
+    pthread_once(&key_hypotheses_once, build_key_hypotheses);
+    
+    uint64_t start_us = thread_cpu_microseconds();
+    int found = screen_region_for_key(region_start, region_size, start_us + budget_us, detection_result);
+    charge_key_screening_budget(thread_cpu_microseconds() - start_us);
+    return found;
+}
+
+/**
+ * @brief Decrypts a detected XOR/ADD payload into a tracked buffer
+ * 
+ * @param detection_result Detection with a key-obfuscated payload encoding
+ * @param output_buffer Output: decrypted payload (release with release_decrypted_payload)
+ * @param output_size Output: payload size in bytes
+ * @return 1 on success, 0 on failure
+ */
+int decrypt_detected_payload(const DexDetectionResult* detection_result,
+                             void** output_buffer, size_t* output_size) {
+    if (detection_result->payload_key_length == 0 ||
+        detection_result->payload_key_length > MAX_XOR_KEY_LENGTH ||
+        (detection_result->payload_encoding != PAYLOAD_ENCODING_XOR &&
+         detection_result->payload_encoding != PAYLOAD_ENCODING_ADD)) {
+        return 0;
+    }
+    
+    uint8_t* decrypted = create_memory_copy(detection_result->dex_address, detection_result->dex_size);
+    if (!decrypted) return 0;
+    
+    decode_with_key(decrypted, detection_result->dex_size, 0, detection_result->payload_key,
+                    detection_result->payload_key_length,
+                    detection_result->payload_encoding == PAYLOAD_ENCODING_XOR ? KEY_MODE_XOR : KEY_MODE_ADD);
+    
+    *output_buffer = decrypted;
+    *output_size = detection_result->dex_size;
+    return 1;
+}
+
+/**
+ * @brief Releases a buffer returned by decrypt_detected_payload
+ */
+void release_decrypted_payload(void* output_buffer, size_t output_size) {
+    release_memory_copy(output_buffer, output_size);
+}
@@ -0,0 +1,35 @@
+#ifndef DEXDUMPER_XOR_KEY_RECOVERY_H
+#define DEXDUMPER_XOR_KEY_RECOVERY_H
+
+// XOR key recovery header - declares detection and decryption of key-obfuscated DEX
+
+#include "common.h"
+#include "config.h"
+
+/**
+ * Obfuscated DEX Support:
+ * 
+ * A common protection keeps the DEX XORed with (or byte-wise added to) a
+ * short repeating key. The DEX header is largely predictable ("dex\n03",
+ * the 0x70 header_size, the endian tag, empty link section), so
+ * every key length up to MAX_XOR_KEY_LENGTH can be tested against those
+ * known-plaintext constraints at each offset with SIMD compares. Hits get
+ * the remaining key bytes from byte frequencies and are confirmed by the
+ * decrypted header and the DEX Adler-32 checksum.
+ */
+
+// Resets the per-pass key screening time budget
+void reset_key_screening_budget(void);
+
+// Scans a high-priority region for a DEX obfuscated with a repeating key
+int scan_for_xor_obfuscated_dex(const void* region_start, size_t region_size,
+                                DexDetectionResult* detection_result);
+
+// Decrypts a detected XOR/ADD payload into a tracked buffer
+int decrypt_detected_payload(const DexDetectionResult* detection_result,
+                             void** output_buffer, size_t* output_size);
+
+// Releases a buffer returned by decrypt_detected_payload
+void release_decrypted_payload(void* output_buffer, size_t output_size);
+
+#endif